@@ -0,0 +1,111 @@
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#include <malloc.h>
+#define SQREW_HAS_MALLINFO2
+#endif
+
+static const char* churnScript =
+    "local keep = [];\n"
+    "for (local i = 0; i < 20000; ++i) {\n"
+    "    local t = { id = i, name = \"entry\" + i, tags = [i, i + 1, i + 2] };\n"
+    "    t.describe <- function() { return name + \":\" + id; };\n"
+    "    local text = t.describe() + \"/\" + (i * 3);\n"
+    "    if (i % 16 == 0) keep.append(t);\n"
+    "    if (keep.len() > 256) keep.remove(0);\n"
+    "}\n";
+
+static const char* keepScript =
+    "kept <- [];\n"
+    "for (local i = 0; i < 20000; ++i)\n"
+    "    kept.append({ id = i, name = \"kept\" + i, get = function() { return id; } });\n";
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count() / iterations;
+}
+
+static void churn(sqrew::Allocation allocation, int iterations)
+{
+    sqrew::Context context(1024, allocation);
+    context.initialize();
+
+    for (int i = 0; i < iterations; ++i)
+        context.executeBuffer(churnScript);
+}
+
+static double churnThreads(sqrew::Allocation allocation, int threadCount, int iterations)
+{
+    return measure(1, [&]()
+    {
+        std::vector<std::thread> threads;
+        for (int i = 0; i < threadCount; ++i)
+            threads.emplace_back(churn, allocation, iterations);
+        for (auto& thread: threads)
+            thread.join();
+    });
+}
+
+#if defined(SQREW_HAS_MALLINFO2)
+// What a heap context costs the C heap, next to what the VM asked for (as
+// counted by a pool context running the same script).
+static void heapFootprint()
+{
+    sqrew::Context heap;
+    heap.initialize();
+    const size_t before = mallinfo2().uordblks;
+    heap.executeBuffer(keepScript);
+    const size_t held = mallinfo2().uordblks - before;
+
+    sqrew::Context pooled(1024, sqrew::Allocation::Pool);
+    pooled.initialize();
+    const size_t requestedBefore = pooled.getAllocationStats().bytesLive;
+    pooled.executeBuffer(keepScript);
+    const size_t requested = pooled.getAllocationStats().bytesLive - requestedBefore;
+
+    std::cout << "heap mode, 20000 kept objects: " << held << " bytes held by malloc for " << requested << " bytes requested" << std::endl;
+}
+#endif
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int iterations = 10;
+    const int threadCount = static_cast<int>(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() : 2);
+
+    const double heap = measure(1, [&]() { churn(sqrew::Allocation::Heap, iterations); }) / iterations;
+    const double pool = measure(1, [&]() { churn(sqrew::Allocation::Pool, iterations); }) / iterations;
+
+    std::cout << "single context, heap: " << heap << " ms per run" << std::endl;
+    std::cout << "single context, pool: " << pool << " ms per run" << std::endl;
+
+    std::cout << threadCount << " contexts, heap: " << churnThreads(sqrew::Allocation::Heap, threadCount, iterations) << " ms" << std::endl;
+    std::cout << threadCount << " contexts, pool: " << churnThreads(sqrew::Allocation::Pool, threadCount, iterations) << " ms" << std::endl;
+
+#if defined(SQREW_HAS_MALLINFO2)
+    heapFootprint();
+#endif
+
+    sqrew::Context context(1024, sqrew::Allocation::Pool);
+    context.initialize();
+    context.executeBuffer(churnScript);
+
+    const auto stats = context.getAllocationStats();
+    std::cout << "live " << stats.bytesLive << " bytes, peak " << stats.bytesPeak
+              << " bytes, large " << stats.largeBytesLive << " bytes, reserved " << stats.bytesReserved << " bytes" << std::endl;
+
+    for (const auto& sizeClass: stats.sizeClasses)
+        std::cout << "  " << sizeClass.blockSize << " B: " << sizeClass.live << " live, " << sizeClass.allocations << " allocations" << std::endl;
+
+    return 0;
+}
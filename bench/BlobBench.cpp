@@ -0,0 +1,59 @@
+#include <sqrew/Context.h>
+#include <sqrew/Table.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <sqstdblob.h>
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::micro>(finish - start).count() / iterations;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int iterations = 2000;
+    const size_t packetSize = 4 * 1024 * 1024;
+
+    sqrew::Context context;
+    context.initialize();
+    context.executeBuffer("function header(packet) { packet.seek(0); return packet.readn('i'); }");
+
+    auto header = sqrew::Table::getRoot(context).getFunction<int>("header");
+    std::vector<unsigned char> packet(packetSize, 7);
+
+    auto v = context.getHandle();
+
+    const double create = measure(iterations, [&]()
+    {
+        auto data = sqstd_createblob(v, static_cast<SQInteger>(packet.size()));
+        std::memcpy(data, packet.data(), packet.size());
+        sq_pop(v, 1);
+    });
+
+    const double view = measure(iterations, [&]()
+    {
+        sqstd_createblobview(v, packet.data(), static_cast<SQInteger>(packet.size()), SQTrue, nullptr, nullptr);
+        sq_pop(v, 1);
+    });
+
+    const double handOver = measure(iterations, [&]()
+    {
+        header(sqrew::Span<const unsigned char>(packet.data(), packet.size()));
+    });
+
+    std::cout << "4 MB packet, sqstd_createblob + memcpy: " << create << " us" << std::endl;
+    std::cout << "4 MB packet, sqstd_createblobview: " << view << " us" << std::endl;
+    std::cout << "4 MB packet, Span argument to a script call: " << handOver << " us" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <sqrew/Context.h>
+#include <sqrew/Table.h>
+
+#include <chrono>
+#include <iostream>
+
+static const char* benchScript =
+    "const SIZE = 1048576;\n"
+    "payload <- blob(SIZE);\n"
+    "for (local i = 0; i < SIZE; i++) payload[i] = (i * 31 + 7) & 0x7F;\n"
+    "payload[SIZE - 1] = 0xFF;\n"
+    "numbers <- array(SIZE / 8, 0);\n"
+    "for (local i = 0; i < numbers.len(); i++) numbers[i] = i;\n"
+    "crcTable <- array(256, 0);\n"
+    "for (local n = 0; n < 256; n++) {\n"
+    "    local c = n;\n"
+    "    for (local k = 0; k < 8; k++) c = (c & 1) ? (0xEDB88320 ^ (c >>> 1)) : (c >>> 1);\n"
+    "    crcTable[n] = c;\n"
+    "}\n"
+    "function loopSum() { local s = 0; foreach (x in payload) s += x; return s; }\n"
+    "function nativeSum() { return payload.sum(); }\n"
+    "function loopMax() { local m = 0; foreach (x in payload) if (x > m) m = x; return m; }\n"
+    "function nativeMax() { return payload.max(); }\n"
+    "function loopFind() { foreach (i, x in payload) if (x == 0xFF) return i; return null; }\n"
+    "function nativeFind() { return payload.find(0xFF); }\n"
+    "function loopCrc() {\n"
+    "    local c = 0xFFFFFFFF;\n"
+    "    foreach (x in payload) c = crcTable[(c ^ x) & 0xFF] ^ (c >>> 8);\n"
+    "    return c ^ 0xFFFFFFFF;\n"
+    "}\n"
+    "function nativeCrc() { return payload.crc32(); }\n"
+    "function loopSwap4() {\n"
+    "    for (local i = 0; i + 4 <= SIZE; i += 4) {\n"
+    "        local a = payload[i], b = payload[i + 1];\n"
+    "        payload[i] = payload[i + 3]; payload[i + 1] = payload[i + 2];\n"
+    "        payload[i + 2] = b; payload[i + 3] = a;\n"
+    "    }\n"
+    "}\n"
+    "function nativeSwap4() { payload.swap4(); }\n"
+    "function loopFill() { for (local i = 0; i < SIZE; i++) payload[i] = 0x2A; }\n"
+    "function nativeFill() { payload.fill(0x2A); }\n"
+    "function loopArraySum() { local s = 0; foreach (x in numbers) s += x; return s; }\n"
+    "function nativeArraySum() { return numbers.sum(); }\n"
+    "function loopArrayAdd() { foreach (i, x in numbers) numbers[i] = x + 1; }\n"
+    "function nativeArrayAdd() { numbers.add(1); }\n";
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double>(finish - start).count() / iterations;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    sqrew::Context context;
+    context.initialize();
+    context.executeBuffer(benchScript, "bulk.nut");
+
+    auto root = sqrew::Table::getRoot(context);
+
+    const double megabytes = 1.0;
+    const double arrayMegabytes = 1.0 / 8 * 16; // elements are 16 byte objects
+
+    auto compare = [&](const char* name, const char* loop, const char* native, double size)
+    {
+        auto loopFunction = root.getFunction(loop);
+        auto nativeFunction = root.getFunction(native);
+
+        const double loopTime = measure(5, [&]() { loopFunction(); });
+        const double nativeTime = measure(50, [&]() { nativeFunction(); });
+
+        std::cout << name << ": script loop " << size / loopTime << " MB/s, native "
+                  << size / nativeTime << " MB/s (" << loopTime / nativeTime << "x)" << std::endl;
+    };
+
+    compare("blob sum", "loopSum", "nativeSum", megabytes);
+    compare("blob max", "loopMax", "nativeMax", megabytes);
+    compare("blob find", "loopFind", "nativeFind", megabytes);
+    compare("blob crc32", "loopCrc", "nativeCrc", megabytes);
+    compare("blob swap4", "loopSwap4", "nativeSwap4", megabytes);
+    compare("blob fill", "loopFill", "nativeFill", megabytes);
+    compare("array sum", "loopArraySum", "nativeArraySum", arrayMegabytes);
+    compare("array add", "loopArrayAdd", "nativeArrayAdd", arrayMegabytes);
+
+    return 0;
+}
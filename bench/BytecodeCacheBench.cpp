@@ -0,0 +1,64 @@
+#include <sqrew/BytecodeCache.h>
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+static sqrew::String makeScript(int functions)
+{
+    std::ostringstream script;
+    for (int i = 0; i < functions; ++i)
+    {
+        script << "function handler" << i << "(request) {\n"
+               << "    local result = { id = " << i << ", name = \"handler" << i << "\", items = [] };\n"
+               << "    for (local j = 0; j < request.count; ++j)\n"
+               << "        result.items.append(j * " << i << " + request.offset);\n"
+               << "    return result;\n"
+               << "}\n";
+    }
+    return script.str();
+}
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::micro>(finish - start).count() / iterations;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const auto script = makeScript(2000);
+    const int iterations = 20;
+
+    sqrew::Context context;
+    context.initialize();
+
+    const double compile = measure(iterations, [&]() { context.executeBuffer(script, "bench.nut"); });
+
+    auto cache = std::make_shared<sqrew::BytecodeCache>(".");
+    context.setBytecodeCache(cache);
+    context.executeBuffer(script, "bench.nut");
+
+    const double memory = measure(iterations, [&]() { context.executeBuffer(script, "bench.nut"); });
+
+    const double disk = measure(iterations, [&]()
+    {
+        context.setBytecodeCache(std::make_shared<sqrew::BytecodeCache>("."));
+        context.executeBuffer(script, "bench.nut");
+    });
+
+    std::cout << "script size:  " << script.size() / 1024 << " KB" << std::endl;
+    std::cout << "compile:      " << compile << " us" << std::endl;
+    std::cout << "memory hit:   " << memory << " us" << std::endl;
+    std::cout << "disk hit:     " << disk << " us" << std::endl;
+    std::cout << "memory hits:  " << cache->getStats().memoryHits << ", misses: " << cache->getStats().misses << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+#include <squirrel.h>
+#include <sqstdio.h>
+
+static sqrew::String makeScript(int functions)
+{
+    std::ostringstream script;
+    for (int i = 0; i < functions; ++i)
+    {
+        script << "function handler" << i << "(request) {\n"
+               << "    local result = { id = " << i << ", name = \"handler" << i << "\", tag = \"tag" << i % 97 << "\" };\n"
+               << "    foreach (key, value in request)\n"
+               << "        result[key + \"_" << i << "\"] <- value * " << i << " + 0.5;\n"
+               << "    return result;\n"
+               << "}\n";
+    }
+    return script.str();
+}
+
+static long getFileSize(const char* path)
+{
+    auto file = std::fopen(path, "rb");
+    if (file == nullptr)
+        return 0;
+
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fclose(file);
+    return size;
+}
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count() / iterations;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const char* path = "bench_bundle.cnut";
+    const int iterations = 5;
+
+    {
+        sqrew::Context context;
+        context.initialize();
+
+        const auto script = makeScript(20000);
+        auto v = context.getHandle();
+        sq_compilebuffer(v, script.c_str(), script.size(), "bundle.nut", SQTrue);
+        sqstd_writeclosuretofile(v, path);
+    }
+
+    sqrew::Context context;
+    context.initialize();
+    auto v = context.getHandle();
+
+    const double callback = measure(iterations, [&]()
+    {
+        sqrew::StackLock lock(context);
+        sq_pushroottable(v);
+        sqstd_loadfile(v, path, SQFalse);
+        sq_push(v, -2);
+        sq_call(v, 1, SQFalse, SQTrue);
+    });
+
+    const double mapped = measure(iterations, [&]()
+    {
+        context.executeBytecodeFile(path);
+    });
+
+    std::cout << "bundle size:         " << getFileSize(path) / (1024 * 1024) << " MB" << std::endl;
+    std::cout << "sqstd_loadfile:      " << callback << " ms" << std::endl;
+    std::cout << "executeBytecodeFile: " << mapped << " ms" << std::endl;
+
+    std::remove(path);
+    return 0;
+}
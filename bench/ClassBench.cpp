@@ -0,0 +1,65 @@
+#include <sqrew/Context.h>
+#include <sqrew/Interface.h>
+#include <sqrew/Class.h>
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+class BenchInterface: public sqrew::Interface
+{
+    void print(const sqrew::String& message) override
+    {
+        std::cout << message.c_str() << std::endl;
+    }
+};
+
+class Counter
+{
+public:
+    Counter(): value_(0) {}
+
+    int add(int delta) { value_ += delta; return value_; }
+    int get() const { return value_; }
+
+private:
+    int value_;
+};
+
+static double runScript(const sqrew::Context& context, const char* method, int iterations)
+{
+    std::ostringstream script;
+    script << "local c = Counter(); for (local i = 0; i < " << iterations << "; ++i) c." << method << "(1);";
+
+    auto start = std::chrono::high_resolution_clock::now();
+    context.executeBuffer(script.str());
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::nano>(finish - start).count() / iterations;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    sqrew::Context context;
+    context.initialize();
+    context.setInterface<BenchInterface>();
+
+    sqrew::Class<Counter>::expose(context, "Counter")
+        .setConstructor<>()
+        .setMethod("addDelegate", &Counter::add)
+        .setMethod<decltype(&Counter::add), &Counter::add>("addDirect");
+
+    const int iterations = 2000000;
+
+    runScript(context, "addDelegate", iterations / 10);
+    runScript(context, "addDirect", iterations / 10);
+
+    const double delegate = runScript(context, "addDelegate", iterations);
+    const double direct = runScript(context, "addDirect", iterations);
+
+    std::cout << "MethodDelegate: " << delegate << " ns/call" << std::endl;
+    std::cout << "direct thunk:   " << direct << " ns/call" << std::endl;
+    std::cout << "speedup:        " << delegate / direct << "x" << std::endl;
+
+    return 0;
+}
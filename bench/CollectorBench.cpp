@@ -0,0 +1,74 @@
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+
+#include <squirrel.h>
+
+// A long lived heap of 'count' small tables and arrays, the kind of state a
+// game keeps around, plus some cyclic garbage for the collector to find.
+static void populate(sqrew::Context& context, int count)
+{
+    const sqrew::String script =
+        "world <- [];\n"
+        "for (local i = 0; i < " + std::to_string(count) + "; ++i)\n"
+        "    world.append({ id = i, position = [i, i + 1, i + 2], tags = { visible = true } });\n"
+        "for (local i = 0; i < " + std::to_string(count / 10) + "; ++i) {\n"
+        "    local a = {}, b = { a = a };\n"
+        "    a.b <- b;\n"
+        "}\n";
+    context.executeBuffer(script, "populate.nut");
+}
+
+static void reportHistogram(const sqrew::CollectorStats& stats)
+{
+    for (size_t i = 0; i < sqrew::CollectorStats::PauseBuckets; ++i)
+    {
+        if (stats.pauseHistogram[i] == 0)
+            continue;
+
+        std::cout << "    < " << (1u << i) << " us: " << stats.pauseHistogram[i] << std::endl;
+    }
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    for (int count: { 10000, 100000, 500000 })
+    {
+        std::cout << count << " live objects" << std::endl;
+
+        {
+            sqrew::Context context;
+            context.initialize();
+            populate(context, count);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            sq_collectgarbage(context.getHandle());
+            auto finish = std::chrono::high_resolution_clock::now();
+
+            std::cout << "  full collection: " << std::chrono::duration<double, std::micro>(finish - start).count() << " us pause" << std::endl;
+        }
+
+        for (int budget: { 100, 1000 })
+        {
+            sqrew::Context context;
+            context.initialize();
+            populate(context, count);
+
+            // The script keeps running between steps, as it would between frames.
+            while (!context.collectStep(budget))
+                context.executeBuffer("world[0].id++;", "frame.nut");
+
+            const auto stats = context.getCollectorStats();
+
+            std::cout << "  incremental, " << budget << " us budget: " << stats.steps << " steps, "
+                      << stats.totalPauseMicros << " us total, longest pause " << stats.longestPauseMicros << " us, "
+                      << stats.objectsFreed << " objects freed" << std::endl;
+            reportHistogram(stats);
+        }
+    }
+
+    return 0;
+}
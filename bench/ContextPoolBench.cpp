@@ -0,0 +1,84 @@
+#include <sqrew/Context.h>
+#include <sqrew/ContextPool.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// A request handler: some table churn and arithmetic, the kind of work a
+// server hands to script per request.
+static const char* handlerScript =
+    "local result = { primes = [], total = 0 };\n"
+    "for (local n = 2; n < 500; ++n) {\n"
+    "    local prime = true;\n"
+    "    for (local d = 2; d * d <= n; ++d)\n"
+    "        if (n % d == 0) { prime = false; break; }\n"
+    "    if (prime) { result.primes.append(n); result.total += n; }\n"
+    "}\n";
+
+template<class FuncT>
+static double measure(FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    const int tasks = 20000;
+    const size_t cores = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+    const size_t maxWorkers = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : cores;
+
+    std::vector<size_t> workerCounts;
+    for (size_t workers = 1; workers < maxWorkers; workers *= 2)
+        workerCounts.push_back(workers);
+    workerCounts.push_back(maxWorkers);
+
+    std::cout << tasks << " requests, " << cores << " hardware threads" << std::endl;
+
+    double single = 0;
+    for (size_t workers: workerCounts)
+    {
+        sqrew::ContextPool pool(workers);
+        const auto program = pool.compile(handlerScript, "handler.nut");
+
+        // Give every worker a chance to load the program before timing starts.
+        for (size_t i = 0; i < workers * 4; ++i)
+            pool.submit(program);
+        pool.wait();
+
+        const double time = measure([&]()
+        {
+            for (int i = 0; i < tasks; ++i)
+                pool.submit(program);
+            pool.wait();
+        });
+
+        if (workers == 1)
+            single = time;
+
+        std::cout << "  " << workers << " workers: " << time << " ms, " << tasks / time * 1000 << " requests/s, "
+                  << single / time << "x" << std::endl;
+    }
+
+    // The same requests compiled by each worker from source instead.
+    {
+        sqrew::ContextPool pool(maxWorkers);
+
+        const double time = measure([&]()
+        {
+            for (int i = 0; i < tasks; ++i)
+                pool.submit([](sqrew::Context& context) { context.executeBuffer(handlerScript, "handler.nut"); });
+            pool.wait();
+        });
+
+        std::cout << "  " << maxWorkers << " workers, compiling every request: " << time << " ms" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <sqrew/Context.h>
+#include <sqrew/Class.h>
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include <squirrel.h>
+
+struct Point
+{
+    int x = 0;
+
+    int getX() const { return x; }
+    void setX(int value) { x = value; }
+};
+
+// The dispatch exposed fields used before they became native property
+// slots: a '_get'/'_set' metamethod looks the name up in a table of
+// accessors and calls the one it finds.
+static SQInteger legacyGet(HSQUIRRELVM v)
+{
+    sq_push(v, 2);
+    if (SQ_FAILED( sq_get(v, -2) ))
+        return sq_throwerror(v, _SC("the index does not exist"));
+
+    sq_push(v, 1);
+    sq_call(v, 1, SQTrue, SQTrue);
+    return 1;
+}
+
+static SQInteger legacySet(HSQUIRRELVM v)
+{
+    sq_push(v, 2);
+    if (SQ_FAILED( sq_get(v, -2) ))
+        return sq_throwerror(v, _SC("the index does not exist"));
+
+    sq_push(v, 1);
+    sq_push(v, 3);
+    sq_call(v, 2, SQFalse, SQTrue);
+    return 0;
+}
+
+static void addLegacyField(HSQUIRRELVM v, const SQChar* name, const SQChar* getter, const SQChar* setter)
+{
+    sq_pushroottable(v);
+    sq_pushstring(v, _SC("Point"), -1);
+    sq_get(v, -2);
+
+    const SQChar* accessors[] = { getter, setter };
+    const SQChar* metamethods[] = { _SC("_get"), _SC("_set") };
+    const SQFUNCTION dispatch[] = { legacyGet, legacySet };
+
+    for (int i = 0; i < 2; ++i)
+    {
+        sq_pushstring(v, metamethods[i], -1);
+        sq_newtable(v);
+
+        sq_pushstring(v, name, -1);
+        sq_pushstring(v, accessors[i], -1);
+        sq_get(v, -5);
+        sq_newslot(v, -3, SQFalse);
+
+        sq_newclosure(v, dispatch[i], 1);
+        sq_newslot(v, -3, SQFalse);
+    }
+
+    sq_pop(v, 2);
+}
+
+static double runScript(const sqrew::Context& context, const char* field, int iterations)
+{
+    std::ostringstream script;
+    script << "local p = Point(), sum = 0; for (local i = 0; i < " << iterations << "; ++i) { p." << field << " = i; sum += p." << field << "; }";
+
+    auto start = std::chrono::high_resolution_clock::now();
+    context.executeBuffer(script.str());
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    // every iteration does one write and one read
+    return std::chrono::duration<double, std::nano>(finish - start).count() / (2.0 * iterations);
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    sqrew::Context context;
+    context.initialize();
+
+    sqrew::Class<Point>::expose(context, "Point")
+        .setConstructor<>()
+        .setMethod("getX", &Point::getX)
+        .setMethod("setX", &Point::setX)
+        .setField("x", &Point::x);
+
+    addLegacyField(context.getHandle(), _SC("legacyX"), _SC("getX"), _SC("setX"));
+
+    const int iterations = 1000000;
+
+    runScript(context, "x", iterations / 10);
+    runScript(context, "legacyX", iterations / 10);
+
+    const double property = runScript(context, "x", iterations);
+    const double legacy = runScript(context, "legacyX", iterations);
+
+    std::cout << "_get/_set metamethods: " << legacy << " ns/access" << std::endl;
+    std::cout << "native property:       " << property << " ns/access" << std::endl;
+    std::cout << "speedup:               " << legacy / property << "x" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <sqrew/Context.h>
+#include <sqrew/Function.h>
+#include <sqrew/Table.h>
+
+#include <chrono>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::nano>(finish - start).count() / iterations;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    sqrew::Context context;
+    context.initialize();
+    context.executeBuffer("local ticks = 0; function on_tick(dt) { ticks += dt; return ticks; }");
+
+    const int iterations = 1000000;
+    auto root = sqrew::Table::getRoot(context);
+
+    const double resolved = measure(iterations, [&]()
+    {
+        for (int i = 0; i < iterations; ++i)
+            root.getFunction<int>("on_tick")(1);
+    });
+
+    auto onTick = root.getFunction<int>("on_tick");
+    onTick.reserveStack(64);
+
+    const double cached = measure(iterations, [&]()
+    {
+        for (int i = 0; i < iterations; ++i)
+            onTick(1);
+    });
+
+    std::vector<std::tuple<int>> arguments(iterations, std::make_tuple(1));
+
+    const double batch = measure(iterations, [&]()
+    {
+        onTick.callBatch(sqrew::makeSpan(arguments));
+    });
+
+    std::cout << "resolve per call: " << resolved << " ns/call" << std::endl;
+    std::cout << "cached handle:    " << cached << " ns/call" << std::endl;
+    std::cout << "batch:            " << batch << " ns/call" << std::endl;
+
+    return 0;
+}
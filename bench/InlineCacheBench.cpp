@@ -0,0 +1,72 @@
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include <squirrel.h>
+
+// '%s' picks the class of each entity; mixing classes makes the access
+// sites polymorphic, which a monomorphic cache can't serve.
+static const char* entityScript =
+    "class Entity {\n"
+    "    x = 0.0; y = 0.0; vx = 1.0; vy = 0.5; health = 100; alive = true;\n"
+    "    function step(dt) {\n"
+    "        x += vx * dt; y += vy * dt;\n"
+    "        if (x > 100.0) vx = -vx;\n"
+    "        if (y > 100.0) vy = -vy;\n"
+    "        if (health > 0 && alive) health -= 0;\n"
+    "    }\n"
+    "}\n"
+    "class Player extends Entity { score = 0; }\n"
+    "local entities = [];\n"
+    "for (local i = 0; i < 64; ++i) entities.append(%s);\n"
+    "local energy = 0.0;\n"
+    "for (local frame = 0; frame < 2000; ++frame) {\n"
+    "    foreach (e in entities) {\n"
+    "        e.step(0.016);\n"
+    "        energy += e.vx * e.vx + e.vy * e.vy + e[\"health\"];\n"
+    "    }\n"
+    "}\n";
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count() / iterations;
+}
+
+static void run(const char* name, const char* constructor, int iterations)
+{
+    std::vector<char> script(std::snprintf(nullptr, 0, entityScript, constructor) + 1);
+    std::snprintf(script.data(), script.size(), entityScript, constructor);
+
+    sqrew::Context context;
+    context.initialize();
+
+    const double time = measure(iterations, [&]()
+    {
+        context.executeBuffer(script.data(), "entities.nut");
+    });
+
+    SQUnsignedInteger hits, misses;
+    sq_getinlinecachestats(context.getHandle(), &hits, &misses);
+
+    std::cout << name << " entity update: " << time << " ms, inline cache " << hits << " hits, " << misses << " misses ("
+              << 100.0 * hits / (hits + misses) << "% hit rate)" << std::endl;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int iterations = 5;
+
+    run("monomorphic", "Entity()", iterations);
+    run("polymorphic", "i % 2 ? Entity() : Player()", iterations);
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <iostream>
+
+struct Workload
+{
+    const char* name;
+    const char* script;
+};
+
+static const Workload workloads[] =
+{
+    { "fib",
+      "function fib(n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }\n"
+      "fib(27);\n" },
+
+    { "loops",
+      "local sum = 0;\n"
+      "for (local i = 0; i < 3000000; ++i) {\n"
+      "    if (i % 3 == 0) sum += i; else sum -= 1;\n"
+      "}\n" },
+
+    { "table churn",
+      "local live = {};\n"
+      "for (local i = 0; i < 200000; ++i) {\n"
+      "    live[i % 1024] <- { x = i, y = i * 2, z = [i] };\n"
+      "    if (\"x\" in live[i % 1024]) live[i % 1024].x += 1;\n"
+      "}\n" },
+
+    { "string concat",
+      "local parts = [];\n"
+      "for (local i = 0; i < 100000; ++i) {\n"
+      "    local s = \"item\" + i + \":\" + (i * 7);\n"
+      "    if (i % 100 == 0) parts.append(s);\n"
+      "}\n" },
+
+    { "method calls",
+      "class Vec { x = 0; y = 0; constructor(a, b) { x = a; y = b; }\n"
+      "    function dot(o) { return x * o.x + y * o.y; }\n"
+      "    function scaled(k) { return Vec(x * k, y * k); } }\n"
+      "local a = Vec(1, 2), b = Vec(3, 4), acc = 0;\n"
+      "for (local i = 0; i < 300000; ++i) acc += a.dot(b) + a.scaled(2).dot(b);\n" },
+};
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count() / iterations;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int iterations = 5;
+
+#ifdef SQ_USE_COMPUTED_GOTO
+    std::cout << "dispatch: computed goto" << std::endl;
+#else
+    std::cout << "dispatch: switch" << std::endl;
+#endif
+
+    sqrew::Context context;
+    context.initialize();
+
+    for (const auto& workload: workloads)
+    {
+        const sqrew::String script = workload.script;
+
+        const double time = measure(iterations, [&]()
+        {
+            context.executeBuffer(script, workload.name);
+        });
+
+        std::cout << workload.name << ": " << time << " ms" << std::endl;
+    }
+
+    return 0;
+}
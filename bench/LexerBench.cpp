@@ -0,0 +1,93 @@
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <squirrel.h>
+#include <sqstdio.h>
+
+// Roughly the shape of a game script tree: comments, string tables,
+// small functions and classes.
+static sqrew::String makeScript(int functions)
+{
+    std::ostringstream out;
+    for (int i = 0; i < functions; ++i)
+    {
+        out << "// helper number " << i << ", kept around for the save format\n"
+            << "/* Computes a weighted score for the entity.\n"
+            << "   Arguments are documented in the design notes. */\n"
+            << "function computeWeightedScore_" << i << "(entity, weights, options) {\n"
+            << "    local total = 0, message = \"entity score for \" + entity.name + \": \";\n"
+            << "    foreach (key, weight in weights) {\n"
+            << "        if (key in entity.attributes) total += entity.attributes[key] * weight;\n"
+            << "    }\n"
+            << "    local labels = [\"poor\", \"average\", \"good\", \"excellent\", \"legendary\"];\n"
+            << "    return message + labels[total % 5] + \"\\n\";\n"
+            << "}\n\n"
+            << "class ScoreBoard_" << i << " {\n"
+            << "    entries = null;\n"
+            << "    constructor() { entries = {}; }\n"
+            << "    function record(name, value) { entries[name] <- value; }\n"
+            << "}\n\n";
+    }
+    return out.str();
+}
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count() / iterations;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int iterations = 10;
+
+    sqrew::Context context;
+    context.initialize();
+
+    auto v = context.getHandle();
+
+    const sqrew::String script = makeScript(4000);
+    const double megabytes = script.size() / (1024.0 * 1024.0);
+
+    {
+        std::ofstream file("lexer_bench.nut", std::ios::binary);
+        file << script;
+    }
+
+    const double buffered = measure(iterations, [&]()
+    {
+        sq_compilebuffer(v, script.c_str(), script.size(), "buffered", SQTrue);
+        sq_pop(v, 1);
+    });
+
+    const double loaded = measure(iterations, [&]()
+    {
+        sqstd_loadfile(v, "lexer_bench.nut", SQTrue);
+        sq_pop(v, 1);
+    });
+
+    // Also runs the script, which only defines functions and classes.
+    const double mapped = measure(iterations, [&]()
+    {
+        context.executeFile("lexer_bench.nut");
+    });
+
+    std::remove("lexer_bench.nut");
+
+    std::cout << "source: " << megabytes << " MB" << std::endl;
+    std::cout << "in-place buffer: " << buffered << " ms, " << (megabytes * 1000 / buffered) << " MB/s" << std::endl;
+    std::cout << "Context::executeFile: " << mapped << " ms, " << (megabytes * 1000 / mapped) << " MB/s" << std::endl;
+    std::cout << "sqstd_loadfile: " << loaded << " ms, " << (megabytes * 1000 / loaded) << " MB/s" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <sqrew/Context.h>
+#include <sqrew/ScriptLoader.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count() / iterations;
+}
+
+// A module the size of a typical gameplay script: a table of functions
+// registered under its own name.
+static void writeModule(const sqrew::String& path, int index)
+{
+    std::ofstream out(path, std::ios::binary);
+    out << "// generated module " << index << "\n"
+        << "module_" << index << " <- {\n";
+    for (int i = 0; i < 40; ++i)
+    {
+        out << "    function handler_" << i << "(event, state) {\n"
+            << "        local total = 0, label = \"module " << index << " handler " << i << "\";\n"
+            << "        foreach (key, value in state) {\n"
+            << "            if (typeof value == \"integer\") total += value * " << (i + 1) << ";\n"
+            << "        }\n"
+            << "        return event == null ? label : label + \": \" + total;\n"
+            << "    }\n";
+    }
+    out << "};\n";
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int iterations = 3;
+    const int fileCount = 1000;
+
+    std::vector<sqrew::String> paths;
+    for (int i = 0; i < fileCount; ++i)
+    {
+        paths.push_back("loader_bench_" + std::to_string(i) + ".nut");
+        writeModule(paths.back(), i);
+    }
+
+    sqrew::Context context;
+    context.initialize();
+
+    const double serial = measure(iterations, [&]()
+    {
+        for (const auto& path: paths)
+            context.executeFile(path);
+    });
+
+    std::cout << fileCount << " files, serial: " << serial << " ms" << std::endl;
+
+    const size_t hardware = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < hardware; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(hardware);
+
+    for (size_t threads: threadCounts)
+    {
+        sqrew::ScriptLoader loader(threads);
+        std::vector<sqrew::ScriptLoader::Result> results;
+
+        const double compile = measure(iterations, [&]()
+        {
+            results = loader.compile(paths);
+        });
+
+        const double merge = measure(iterations, [&]()
+        {
+            loader.execute(context, results);
+        });
+
+        std::cout << fileCount << " files, " << threads << " threads: " << (compile + merge) << " ms ("
+            << (serial / (compile + merge)) << "x), compile " << compile << " ms, merge " << merge << " ms" << std::endl;
+    }
+
+    for (const auto& path: paths)
+        std::remove(path.c_str());
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <sqrew/BytecodeCache.h>
+#include <sqrew/Context.h>
+#include <sqrew/Table.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count() / iterations;
+}
+
+// Modules come in chains of ten, each requiring the next one.
+static void writeModule(const sqrew::String& path, int index)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (index % 10 != 9)
+        out << "local next = require(\"module_bench_" << (index + 1) << "\");\n";
+    for (int i = 0; i < 20; ++i)
+    {
+        out << "function handler_" << i << "(event, state) {\n"
+            << "    local total = 0, label = \"module " << index << " handler " << i << "\";\n"
+            << "    foreach (key, value in state) {\n"
+            << "        if (typeof value == \"integer\") total += value * " << (i + 1) << ";\n"
+            << "    }\n"
+            << "    return event == null ? label : label + \": \" + total;\n"
+            << "}\n";
+    }
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int iterations = 3;
+    const int moduleCount = 1000;
+    const int touched = 2; // chains the lazy startup actually uses
+
+    std::vector<sqrew::String> paths;
+    for (int i = 0; i < moduleCount; ++i)
+    {
+        paths.push_back("module_bench_" + std::to_string(i) + ".nut");
+        writeModule(paths.back(), i);
+    }
+
+    for (int cached = 0; cached < 2; ++cached)
+    {
+        auto cache = cached ? std::make_shared<sqrew::BytecodeCache>() : nullptr;
+
+        auto startup = [&](int count)
+        {
+            sqrew::Context context;
+            context.initialize();
+            context.setBytecodeCache(cache);
+            context.setModulePaths({ "." });
+
+            for (int i = 0; i < count; i += 10)
+                context.require("module_bench_" + std::to_string(i));
+        };
+
+        // Fills the cache, so the cached runs measure hits only.
+        if (cached)
+            startup(moduleCount);
+
+        const double eager = measure(iterations, [&]() { startup(moduleCount); });
+        const double lazy = measure(iterations, [&]() { startup(touched * 10); });
+
+        const char* label = cached ? "bytecode cache" : "compiled";
+        std::cout << moduleCount << " modules, " << label << ", eager: " << eager << " ms" << std::endl;
+        std::cout << moduleCount << " modules, " << label << ", lazy (" << touched * 10 << " touched): " << lazy
+            << " ms (" << (eager / lazy) << "x)" << std::endl;
+    }
+
+    for (const auto& path: paths)
+        std::remove(path.c_str());
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <squirrel.h>
+
+struct Workload
+{
+    const char* name;
+    const char* script;
+};
+
+static const Workload workloads[] =
+{
+    { "fib",
+      "function fib(n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }\n"
+      "fib(27);\n" },
+
+    { "loops",
+      "local sum = 0;\n"
+      "for (local i = 0; i < 3000000; ++i) {\n"
+      "    if (i % 3 == 0) sum += i; else sum -= 1;\n"
+      "}\n" },
+
+    { "string concat",
+      "local parts = [];\n"
+      "for (local i = 0; i < 100000; ++i) {\n"
+      "    local s = \"item\" + i + \":\" + (i * 7);\n"
+      "    if (i % 100 == 0) parts.append(s);\n"
+      "}\n" },
+
+    { "method calls",
+      "class Vec { x = 0; y = 0; constructor(a, b) { x = a; y = b; }\n"
+      "    function dot(o) { return x * o.x + y * o.y; }\n"
+      "    function scaled(k) { return Vec(x * k, y * k); } }\n"
+      "local a = Vec(1, 2), b = Vec(3, 4), acc = 0;\n"
+      "for (local i = 0; i < 300000; ++i) acc += a.dot(b) + a.scaled(2).dot(b);\n" },
+
+    { "constants",
+      "const Width = 640;\n"
+      "const Height = 480;\n"
+      "local debug = false, acc = 0;\n"
+      "for (local i = 0; i < 1000000; ++i) {\n"
+      "    local area = Width * Height, half = Width / 2 + Height / 2;\n"
+      "    if (debug) acc -= 1;\n"
+      "    if (i > 1024 * 1024) break;\n"
+      "    acc += (area >> 4) - half + (1 << 3);\n"
+      "}\n" },
+};
+
+static const char* const levelNames[] = { "none", "basic", "full" };
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count() / iterations;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int iterations = 5;
+
+    sqrew::Context context;
+    context.initialize();
+
+    auto v = context.getHandle();
+
+    for (const auto& workload: workloads)
+    {
+        const sqrew::String script = workload.script;
+        double baseline = 0;
+
+        for (int level = 0; level < 3; ++level)
+        {
+            context.setOptimizationLevel(static_cast<sqrew::OptimizationLevel>(level));
+
+            HSQOBJECT closure;
+            const double compileTime = measure(iterations, [&]()
+            {
+                sq_compilebuffer(v, script.c_str(), script.size(), workload.name, SQTrue);
+                sq_pop(v, 1);
+            });
+
+            sq_compilebuffer(v, script.c_str(), script.size(), workload.name, SQTrue);
+            sq_getstackobj(v, -1, &closure);
+            sq_addref(v, &closure);
+            sq_pop(v, 1);
+
+            const double runTime = measure(iterations, [&]()
+            {
+                sq_pushobject(v, closure);
+                sq_pushroottable(v);
+                sq_call(v, 1, SQFalse, SQTrue);
+                sq_pop(v, 1);
+            });
+
+            sq_release(v, &closure);
+
+            if (level == 0)
+                baseline = runTime;
+
+            std::cout << workload.name << ", " << levelNames[level] << ": " << runTime << " ms ("
+                << (baseline / runTime) << "x), compile " << compileTime << " ms" << std::endl;
+        }
+    }
+
+    return 0;
+}
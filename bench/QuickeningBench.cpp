@@ -0,0 +1,111 @@
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <squirrel.h>
+
+struct Workload
+{
+    const char* name;
+    const char* script;
+};
+
+static const Workload workloads[] =
+{
+    { "matrix multiply",
+      "local n = 60;\n"
+      "local a = array(n * n), b = array(n * n), c = array(n * n, 0.0);\n"
+      "for (local i = 0; i < n * n; i++) { a[i] = (i % 7) * 0.5; b[i] = (i % 5) * 0.25; }\n"
+      "for (local i = 0; i < n; i++)\n"
+      "    for (local j = 0; j < n; j++) {\n"
+      "        local sum = 0.0;\n"
+      "        for (local k = 0; k < n; k++) sum = sum + a[i * n + k] * b[k * n + j];\n"
+      "        c[i * n + j] = sum;\n"
+      "    }\n" },
+
+    { "mandelbrot",
+      "local size = 80, inside = 0;\n"
+      "for (local y = 0; y < size; y++)\n"
+      "    for (local x = 0; x < size; x++) {\n"
+      "        local cr = x * 3.0 / size - 2.0, ci = y * 2.0 / size - 1.0;\n"
+      "        local zr = 0.0, zi = 0.0, i = 0;\n"
+      "        while (i < 100 && zr * zr + zi * zi < 4.0) {\n"
+      "            local t = zr * zr - zi * zi + cr;\n"
+      "            zi = 2.0 * zr * zi + ci;\n"
+      "            zr = t;\n"
+      "            i = i + 1;\n"
+      "        }\n"
+      "        if (i == 100) inside++;\n"
+      "    }\n" },
+
+    { "prefix sums",
+      "local n = 200000;\n"
+      "local values = array(n);\n"
+      "for (local i = 0; i < n; i++) values[i] = (i * 7) % 13;\n"
+      "for (local round = 0; round < 5; round++) {\n"
+      "    local sum = 0;\n"
+      "    for (local i = 0; i < n; i++) { sum = sum + values[i]; values[i] = sum - round; }\n"
+      "}\n" },
+};
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count() / iterations;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int iterations = 5;
+
+    sqrew::Context context;
+    context.initialize();
+
+    auto v = context.getHandle();
+
+    for (const auto& workload: workloads)
+    {
+        const sqrew::String script = workload.script;
+        double generic = 0;
+
+        for (int quicken = 0; quicken < 2; ++quicken)
+        {
+            // A fresh closure each time, so no site starts out quickened.
+            sq_enablequickening(v, quicken ? SQTrue : SQFalse);
+            sq_compilebuffer(v, script.c_str(), script.size(), workload.name, SQTrue);
+
+            HSQOBJECT closure;
+            sq_getstackobj(v, -1, &closure);
+            sq_addref(v, &closure);
+            sq_pop(v, 1);
+
+            const double time = measure(iterations, [&]()
+            {
+                sq_pushobject(v, closure);
+                sq_pushroottable(v);
+                sq_call(v, 1, SQFalse, SQTrue);
+                sq_pop(v, 1);
+            });
+
+            sq_release(v, &closure);
+
+            if (!quicken)
+            {
+                generic = time;
+                std::cout << workload.name << ", generic: " << time << " ms" << std::endl;
+            }
+            else
+            {
+                std::cout << workload.name << ", quickened: " << time << " ms (" << (generic / time) << "x)" << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <sqrew/Class.h>
+#include <sqrew/Context.h>
+#include <sqrew/Scheduler.h>
+#include <sqrew/Table.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+// Answers every request on its own thread after a fixed latency, like a
+// remote service would.
+class Backend
+{
+public:
+    explicit Backend(int latencyMicros)
+        : latency_(latencyMicros)
+        , stopping_(false)
+        , thread_(&Backend::serve, this)
+    {}
+
+    ~Backend()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wakeup_.notify_one();
+        thread_.join();
+    }
+
+    sqrew::Future<int> fetch(int key)
+    {
+        sqrew::Promise<int> promise;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            requests_.push_back({ Clock::now() + latency_, key, promise });
+        }
+        wakeup_.notify_one();
+        return promise.getFuture();
+    }
+
+private:
+    struct Request
+    {
+        Clock::time_point due;
+        int key;
+        sqrew::Promise<int> promise;
+    };
+
+    std::chrono::microseconds latency_;
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::deque<Request> requests_;
+    bool stopping_;
+    std::thread thread_;
+
+    void serve()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_)
+        {
+            if (requests_.empty())
+            {
+                wakeup_.wait(lock);
+                continue;
+            }
+
+            if (Clock::now() < requests_.front().due)
+            {
+                wakeup_.wait_until(lock, requests_.front().due);
+                continue;
+            }
+
+            auto request = requests_.front();
+            requests_.pop_front();
+
+            lock.unlock();
+            request.promise.resolve(request.key * 2);
+            lock.lock();
+        }
+    }
+};
+
+// What script sees of the backend; exposed classes have to be copyable.
+class Service
+{
+public:
+    explicit Service(Backend& backend)
+        : backend_(&backend)
+    {}
+
+    sqrew::Future<int> fetch(int key) { return backend_->fetch(key); }
+
+private:
+    Backend* backend_;
+};
+
+static const char* handlerScript =
+    "total <- 0;\n"
+    "function handle(service, key) {\n"
+    "    local user = service.fetch(key);\n"
+    "    local orders = service.fetch(user + 1);\n"
+    "    total += user + orders;\n"
+    "}\n";
+
+template<class FuncT>
+static double measure(FuncT func)
+{
+    auto start = Clock::now();
+    func();
+    auto finish = Clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count();
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    sqrew::Context context;
+    context.initialize();
+
+    sqrew::Class<Service>::expose(context, "Service")
+        .setMethod("fetch", &Service::fetch);
+
+    context.executeBuffer(handlerScript, "handler.nut");
+    auto handle = sqrew::Table::getRoot(context).getFunction("handle");
+
+    const int latency = 1000;
+    Backend backend(latency);
+    Service service(backend);
+
+    std::cout << "backend latency " << latency << " us, 2 calls per request" << std::endl;
+
+    {
+        const int requests = 200;
+        const double time = measure([&]()
+        {
+            for (int i = 0; i < requests; ++i)
+                handle(&service, i);
+        });
+
+        std::cout << "  blocking, " << requests << " requests: " << time << " ms, "
+                  << requests / time * 1000 << " requests/s" << std::endl;
+    }
+
+    for (int requests: { 200, 2000, 20000 })
+    {
+        sqrew::Scheduler scheduler(context);
+
+        const double time = measure([&]()
+        {
+            for (int i = 0; i < requests; ++i)
+                scheduler.spawn(handle, &service, i);
+            scheduler.run();
+        });
+
+        std::cout << "  scheduler, " << requests << " requests: " << time << " ms, "
+                  << requests / time * 1000 << " requests/s, "
+                  << scheduler.getStats().suspensions << " suspensions" << std::endl;
+    }
+
+    return 0;
+}
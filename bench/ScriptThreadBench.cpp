@@ -0,0 +1,78 @@
+#include <sqrew/Context.h>
+#include <sqrew/ScriptThreadPool.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <squirrel.h>
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::nano>(finish - start).count() / iterations;
+}
+
+// Runs the request handler on 'thread', as a per-request script thread would.
+static void handle(HSQUIRRELVM thread, const HSQOBJECT& handler)
+{
+    sq_pushobject(thread, handler);
+    sq_pushroottable(thread);
+    sq_pushinteger(thread, 42);
+    sq_call(thread, 2, SQFalse, SQTrue);
+    sq_pop(thread, 1);
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int iterations = 200000;
+    const SQInteger stackSize = 256;
+
+    sqrew::Context context;
+    context.initialize();
+    context.executeBuffer("function handler(id) { return id + 1; }");
+
+    auto v = context.getHandle();
+
+    HSQOBJECT handler;
+    sq_pushroottable(v);
+    sq_pushstring(v, "handler", -1);
+    sq_get(v, -2);
+    sq_getstackobj(v, -1, &handler);
+    sq_addref(v, &handler);
+    sq_pop(v, 2);
+
+    auto spawn = [&](bool run)
+    {
+        auto thread = sq_newthread(v, stackSize);
+        if (run)
+            handle(thread, handler);
+        sq_pop(v, 1);
+    };
+
+    sqrew::ScriptThreadPool threads(context, 1, stackSize);
+
+    auto reuse = [&](bool run)
+    {
+        HSQOBJECT reference;
+        auto thread = threads.acquire(reference);
+        if (run)
+            handle(thread, handler);
+        threads.release(reference);
+    };
+
+    std::cout << "sq_newthread, spawn only: " << measure(iterations, [&]() { spawn(false); }) << " ns" << std::endl;
+    std::cout << "sq_newthread, spawn and call: " << measure(iterations, [&]() { spawn(true); }) << " ns" << std::endl;
+    std::cout << "pooled, spawn only: " << measure(iterations, [&]() { reuse(false); }) << " ns" << std::endl;
+    std::cout << "pooled, spawn and call: " << measure(iterations, [&]() { reuse(true); }) << " ns" << std::endl;
+
+    const auto stats = threads.getStats();
+    std::cout << stats.created << " threads created, " << stats.reused << " reused" << std::endl;
+
+    sq_release(v, &handler);
+    return 0;
+}
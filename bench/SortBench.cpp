@@ -0,0 +1,83 @@
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Shapes of a leaderboard being re-sorted: fully random, already sorted
+// after a few score updates, or arriving in reverse order.
+struct Shape
+{
+    const char* name;
+    const char* generator;
+};
+
+static const Shape shapes[] =
+{
+    { "random", "rnd(1000000)" },
+    { "sorted", "i" },
+    { "reversed", "n - i" },
+    { "nearly sorted", "rnd(100) == 0 ? rnd(n) : i" },
+    { "few unique", "rnd(8)" },
+};
+
+struct Kind
+{
+    const char* name;
+    const char* wrap; // turns the generated integer 'x' into an element
+    const char* compare; // empty for the default ordering
+};
+
+static const Kind kinds[] =
+{
+    { "integers", "x", "" },
+    { "floats", "x * 0.25", "" },
+    { "strings", "format(\"player%08d\", x)", "" },
+    { "integers, compare function", "x", "@(a, b) b <=> a" },
+    { "tables, compare function", "{ score = x }", "@(a, b) a.score <=> b.score" },
+};
+
+template<class FuncT>
+static double measure(FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    const int count = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    sqrew::Context context;
+    context.initialize();
+
+    for (const auto& kind: kinds)
+    {
+        std::cout << kind.name << " (" << count << " elements)" << std::endl;
+
+        for (const auto& shape: shapes)
+        {
+            const sqrew::String script =
+                "local seed = 12345;\n"
+                "local rnd = function(m) { seed = (seed * 1103515245 + 12345) & 0x7fffffff; return seed % m; };\n"
+                "local n = " + std::to_string(count) + ";\n"
+                "data <- array(n);\n"
+                "for (local i = 0; i < n; ++i) { local x = " + shape.generator + "; data[i] = " + kind.wrap + "; }\n"
+                "compare <- " + (kind.compare[0] ? kind.compare : "null") + ";\n";
+            context.executeBuffer(script, "data.nut");
+
+            const double time = measure([&]()
+            {
+                context.executeBuffer("local copy = clone data; compare ? copy.sort(compare) : copy.sort();", "sort.nut");
+            });
+
+            std::cout << "  " << shape.name << ": " << time << " ms" << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <sqrew/Context.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <squirrel.h>
+
+// Keys share a long prefix and differ only in characters the old sampling
+// hash skipped: for 96 character keys it read every third character, so the
+// digits are written to positions that aren't multiples of three.
+static std::vector<std::string> makeAdversarialKeys(size_t count)
+{
+    const std::string prefix = "com.example.services.inventory.generated.identifiers.v2/warehouse/";
+
+    std::vector<std::string> keys;
+    keys.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string key = prefix;
+        key.resize(96, '_');
+
+        size_t value = i;
+        for (size_t pos = prefix.size(); pos < key.size(); ++pos)
+        {
+            if (pos % 3 == 0)
+                continue;
+            key[pos] = static_cast<char>('a' + value % 26);
+            value /= 26;
+        }
+
+        keys.push_back(key);
+    }
+
+    return keys;
+}
+
+// Realistic keys: JSON paths ending in a generated id.
+static std::vector<std::string> makeJsonKeys(size_t count)
+{
+    std::vector<std::string> keys;
+    keys.reserve(count);
+
+    char buffer[128];
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::snprintf(buffer, sizeof(buffer), "response.data.items[%zu].attributes.id-%08zx-%04zx", i % 1000, i * 2654435761u, i);
+        keys.push_back(buffer);
+    }
+
+    return keys;
+}
+
+static SQHash legacyHash(const char* s, size_t l)
+{
+    SQHash h = static_cast<SQHash>(l);
+    size_t step = (l >> 5) | 1;
+    for (; l >= step; l -= step)
+        h = h ^ ((h << 5) + (h >> 2) + static_cast<unsigned short>(*(s++)));
+    return h;
+}
+
+// Chain statistics the old string table would have ended up with, growing
+// at the same load factor of one string per slot.
+static void reportLegacy(const std::vector<std::string>& keys)
+{
+    size_t slots = 4;
+    while (slots < keys.size())
+        slots *= 2;
+
+    std::vector<size_t> chains(slots);
+    for (const auto& key: keys)
+        ++chains[legacyHash(key.data(), key.size()) & (slots - 1)];
+
+    double probes = 0;
+    size_t used = 0;
+    for (auto chain: chains)
+    {
+        used += chain != 0;
+        probes += 0.5 * chain * (chain + 1);
+    }
+
+    std::cout << "  legacy sampled hash: " << slots << " slots, " << used << " used, longest chain "
+              << *std::max_element(chains.begin(), chains.end()) << ", " << probes / keys.size() << " compares per lookup" << std::endl;
+}
+
+static void run(const std::vector<std::string>& keys, SQFloat loadFactor)
+{
+    sqrew::Context context;
+    auto v = context.getHandle();
+
+    sq_setstringtableloadfactor(v, loadFactor);
+
+    // The array keeps every string alive, so each push interns a new one.
+    sq_newarray(v, 0);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto& key: keys)
+    {
+        sq_pushstring(v, key.data(), static_cast<SQInteger>(key.size()));
+        sq_arrayappend(v, -2);
+    }
+    auto middle = std::chrono::high_resolution_clock::now();
+
+    // Interning the same keys again is a pure lookup.
+    for (const auto& key: keys)
+    {
+        sq_pushstring(v, key.data(), static_cast<SQInteger>(key.size()));
+        sq_pop(v, 1);
+    }
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    SQStringTableStats stats;
+    sq_getstringtablestats(v, &stats);
+
+    const double insert = std::chrono::duration<double, std::nano>(middle - start).count() / keys.size();
+    const double lookup = std::chrono::duration<double, std::nano>(finish - middle).count() / keys.size();
+
+    std::cout << "  load factor " << loadFactor << ": insert " << insert << " ns, lookup " << lookup << " ns per key, "
+              << stats.slots << " slots, " << stats.used_slots << " used, longest chain " << stats.longest_chain
+              << ", " << static_cast<double>(stats.strings) / stats.used_slots << " strings per used slot" << std::endl;
+
+    sq_pop(v, 1);
+}
+
+static void runAll(const char* name, const std::vector<std::string>& keys)
+{
+    std::cout << name << " (" << keys.size() << " keys)" << std::endl;
+
+    reportLegacy(keys);
+    for (SQFloat loadFactor: { 0.5f, 1.0f, 2.0f, 4.0f })
+        run(keys, loadFactor);
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+
+    runAll("adversarial prefixes", makeAdversarialKeys(count));
+    runAll("json paths", makeJsonKeys(count));
+
+    return 0;
+}
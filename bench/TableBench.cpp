@@ -0,0 +1,119 @@
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+
+struct Workload
+{
+    const char* name;
+    const char* script;
+};
+
+static const Workload workloads[] =
+{
+    { "global lookups",
+      "width <- 640; height <- 480; scale <- 2; offset <- 7; gravity <- 9; friction <- 3; limit <- 1000; step <- 1;\n"
+      "function update() {\n"
+      "    local sum = 0;\n"
+      "    for (local i = 0; i < 100000; ++i)\n"
+      "        sum += width + height * scale - offset + gravity * friction + limit - step;\n"
+      "    return sum;\n"
+      "}\n"
+      "for (local n = 0; n < 10; ++n) update();\n" },
+
+    { "getk on tables",
+      "local p = { x = 1, y = 2, z = 3, w = 4, name = \"p\", alive = true, hp = 100, mp = 50 };\n"
+      "local sum = 0;\n"
+      "for (local i = 0; i < 1000000; ++i)\n"
+      "    sum += p.x + p.y + p.z + p.w + p.hp + p.mp;\n" },
+
+    { "integer keys",
+      "local t = {};\n"
+      "for (local i = 0; i < 200000; ++i) t[i * 7] <- i;\n"
+      "local sum = 0;\n"
+      "for (local n = 0; n < 5; ++n)\n"
+      "    for (local i = 0; i < 200000; ++i) sum += t[i * 7];\n" },
+
+    { "newslot churn",
+      "local keys = [];\n"
+      "for (local i = 0; i < 4096; ++i) keys.append(\"key\" + i);\n"
+      "for (local n = 0; n < 50; ++n) {\n"
+      "    local t = {};\n"
+      "    foreach (k in keys) t[k] <- n;\n"
+      "    foreach (i, k in keys) if (i % 2) delete t[k];\n"
+      "    foreach (k in keys) t[k] <- n;\n"
+      "}\n" },
+
+    { "small tables",
+      "for (local i = 0; i < 300000; ++i) {\n"
+      "    local t = { a = i, b = i + 1, c = i + 2 };\n"
+      "    t.d <- t.a + t.b + t.c;\n"
+      "}\n" },
+};
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count() / iterations;
+}
+
+// Bytes held by 'count' live tables of 'slots' entries each, measured with
+// the context's pool so that only script allocations are counted.
+static void measureMemory(int count, int slots)
+{
+    sqrew::Context context(1024, sqrew::Allocation::Pool);
+    context.initialize();
+
+    context.executeBuffer("kept <- [];", "setup.nut");
+    const auto before = context.getAllocationStats().bytesLive;
+
+    const sqrew::String script =
+        "for (local i = 0; i < " + std::to_string(count) + "; ++i) {\n"
+        "    local t = {};\n"
+        "    for (local k = 0; k < " + std::to_string(slots) + "; ++k) t[k] <- k;\n"
+        "    kept.append(t);\n"
+        "}\n";
+    context.executeBuffer(script, "memory.nut");
+
+    const auto after = context.getAllocationStats().bytesLive;
+
+    std::cout << "memory, " << slots << " slots: " << static_cast<double>(after - before) / count << " bytes per table" << std::endl;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int iterations = 5;
+
+#ifdef SQ_SWISS_TABLE
+    std::cout << "table engine: open addressing" << std::endl;
+#else
+    std::cout << "table engine: chained" << std::endl;
+#endif
+
+    sqrew::Context context;
+    context.initialize();
+
+    for (const auto& workload: workloads)
+    {
+        const sqrew::String script = workload.script;
+
+        const double time = measure(iterations, [&]()
+        {
+            context.executeBuffer(script, workload.name);
+        });
+
+        std::cout << workload.name << ": " << time << " ms" << std::endl;
+    }
+
+    for (int slots: { 2, 8, 30, 200, 1000 })
+        measureMemory(200000 / slots, slots);
+
+    return 0;
+}
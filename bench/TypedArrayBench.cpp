@@ -0,0 +1,76 @@
+#include <sqrew/Context.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+static const char* benchScript =
+    "function fillArray(a) { local n = a.len(); for (local i = 0; i < n; i++) a[i] = i * 0.5; }\n"
+    "function sumLoop(a) { local s = 0.0; foreach (x in a) s += x; return s; }\n"
+    "function scaleLoop(a) { local n = a.len(); for (local i = 0; i < n; i++) a[i] = a[i] * 1.5; }\n"
+    "function sumNative(a) { return a.sum(); }\n"
+    "function scaleNative(a) { a.mul(1.5); }\n";
+
+template<class FuncT>
+static double measure(int iterations, FuncT func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    auto finish = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(finish - start).count() / iterations;
+}
+
+// Bytes held by one array of 'count' elements, measured with the context's
+// pool so that only script allocations are counted.
+static double measureMemory(const char* constructor, int count)
+{
+    sqrew::Context context(1024, sqrew::Allocation::Pool);
+    context.initialize();
+
+    context.executeBuffer("kept <- null;", "setup.nut");
+    const auto before = context.getAllocationStats().bytesLive;
+
+    context.executeBuffer("kept = " + sqrew::String(constructor) + "(" + std::to_string(count) + ", 0.0);", "memory.nut");
+    const auto after = context.getAllocationStats().bytesLive;
+
+    return static_cast<double>(after - before) / count;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    const int count = 1000000;
+    const int iterations = 5;
+
+    std::cout << count << " elements" << std::endl;
+    for (auto constructor: { "array", "float32array", "float64array" })
+        std::cout << "memory, " << constructor << ": " << measureMemory(constructor, count) << " bytes per element" << std::endl;
+
+    sqrew::Context context;
+    context.initialize();
+    context.executeBuffer(benchScript, "typed.nut");
+
+    const sqrew::String setup =
+        "values <- {\n"
+        "    array = array(" + std::to_string(count) + ", 0.0),\n"
+        "    float32array = float32array(" + std::to_string(count) + "),\n"
+        "    float64array = float64array(" + std::to_string(count) + ")\n"
+        "};\n";
+    context.executeBuffer(setup, "setup.nut");
+
+    for (auto name: { "array", "float32array", "float64array" })
+    {
+        std::cout << name << ":" << std::endl;
+
+        for (auto function: { "fillArray", "sumLoop", "scaleLoop", "sumNative", "scaleNative" })
+        {
+            const sqrew::String call = sqrew::String(function) + "(values." + name + ");";
+            const double time = measure(iterations, [&]() { context.executeBuffer(call, "call.nut"); });
+
+            std::cout << "  " << function << ": " << time << " ms" << std::endl;
+        }
+    }
+
+    return 0;
+}
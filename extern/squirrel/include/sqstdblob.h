@@ -6,7 +6,11 @@
 extern "C" {
 #endif
 
+typedef void (*SQBLOBRELEASEHOOK)(SQUserPointer buf,SQInteger size,SQUserPointer userdata);
+
 SQUIRREL_API SQUserPointer sqstd_createblob(HSQUIRRELVM v, SQInteger size);
+SQUIRREL_API SQRESULT sqstd_createblobview(HSQUIRRELVM v,SQUserPointer buf,SQInteger size,SQBool readonly,SQBLOBRELEASEHOOK release,SQUserPointer userdata);
+SQUIRREL_API SQBool sqstd_isblobreadonly(HSQUIRRELVM v,SQInteger idx);
 SQUIRREL_API SQRESULT sqstd_getblob(HSQUIRRELVM v,SQInteger idx,SQUserPointer *ptr);
 SQUIRREL_API SQInteger sqstd_getblobsize(HSQUIRRELVM v,SQInteger idx);
 
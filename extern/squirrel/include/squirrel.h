@@ -105,6 +105,7 @@ struct SQClass;
 struct SQInstance;
 struct SQDelegable;
 struct SQOuter;
+struct SQTypedArray;
 
 #ifdef _UNICODE
 #define SQUNICODE
@@ -193,6 +194,11 @@ typedef char SQChar;
 #define SQUIRREL_EOB 0
 #define SQ_BYTECODE_STREAM_TAG	0xFAFA
 
+/* optimization levels of sq_setoptimizationlevel */
+#define SQ_OPT_NONE		0	/* code as emitted by the compiler */
+#define SQ_OPT_BASIC	1	/* constant folding, dead store and redundant line elimination */
+#define SQ_OPT_FULL		2	/* also superinstructions; drops every line op */
+
 #define SQOBJECT_REF_COUNTED	0x08000000
 #define SQOBJECT_NUMERIC		0x04000000
 #define SQOBJECT_DELEGABLE		0x02000000
@@ -221,6 +227,7 @@ typedef char SQChar;
 #define _RT_INSTANCE		0x00008000
 #define _RT_WEAKREF			0x00010000
 #define _RT_OUTER			0x00020000
+#define _RT_TYPEDARRAY		0x00040000
 
 typedef enum tagSQObjectType{
 	OT_NULL =			(_RT_NULL|SQOBJECT_CANBEFALSE),
@@ -240,9 +247,16 @@ typedef enum tagSQObjectType{
 	OT_CLASS =			(_RT_CLASS|SQOBJECT_REF_COUNTED),
 	OT_INSTANCE =		(_RT_INSTANCE|SQOBJECT_REF_COUNTED|SQOBJECT_DELEGABLE),
 	OT_WEAKREF =		(_RT_WEAKREF|SQOBJECT_REF_COUNTED),
-	OT_OUTER =			(_RT_OUTER|SQOBJECT_REF_COUNTED) //internal usage only
+	OT_OUTER =			(_RT_OUTER|SQOBJECT_REF_COUNTED), //internal usage only
+	OT_TYPEDARRAY =		(_RT_TYPEDARRAY|SQOBJECT_REF_COUNTED)
 }SQObjectType;
 
+typedef enum tagSQTypedArrayType{
+	SQTA_INT32 = 0,
+	SQTA_FLOAT32 = 1,
+	SQTA_FLOAT64 = 2
+}SQTypedArrayType;
+
 #define ISREFCOUNTED(t) (t&SQOBJECT_REF_COUNTED)
 
 
@@ -266,6 +280,7 @@ typedef union tagSQObjectValue
 	struct SQClass *pClass;
 	struct SQInstance *pInstance;
 	struct SQWeakRef *pWeakRef;
+	struct SQTypedArray *pTypedArray;
 	SQRawObjectVal raw;
 }SQObjectValue;
 
@@ -281,6 +296,31 @@ typedef struct  tagSQMemberHandle{
 	SQInteger _index;
 }SQMemberHandle;
 
+#define SQ_ALLOCATOR_GRANULARITY 16
+#define SQ_ALLOCATOR_CLASSES 64
+
+typedef struct tagSQAllocatorStats{
+	SQUnsignedInteger bytes_live;
+	SQUnsignedInteger bytes_peak;
+	SQUnsignedInteger large_bytes_live;
+	SQUnsignedInteger bytes_reserved;
+	SQUnsignedInteger class_live[SQ_ALLOCATOR_CLASSES];
+	SQUnsignedInteger class_allocs[SQ_ALLOCATOR_CLASSES];
+}SQAllocatorStats;
+
+typedef struct tagSQStringTableStats{
+	SQUnsignedInteger slots;
+	SQUnsignedInteger strings;
+	SQUnsignedInteger used_slots;
+	SQUnsignedInteger longest_chain;
+}SQStringTableStats;
+
+typedef struct tagSQCollectorStats{
+	SQUnsignedInteger cycles; /* incremental cycles completed */
+	SQUnsignedInteger freed; /* objects finalized by them */
+	SQBool collecting; /* a cycle is in progress */
+}SQCollectorStats;
+
 typedef struct tagSQStackInfos{
 	const SQChar* funcname;
 	const SQChar* source;
@@ -288,6 +328,7 @@ typedef struct tagSQStackInfos{
 }SQStackInfos;
 
 typedef struct SQVM* HSQUIRRELVM;
+typedef struct SQAllocator* HSQALLOCATOR;
 typedef SQObject HSQOBJECT;
 typedef SQMemberHandle HSQMEMBERHANDLE;
 typedef SQInteger (*SQFUNCTION)(HSQUIRRELVM);
@@ -330,12 +371,18 @@ SQUIRREL_API SQRESULT sq_suspendvm(HSQUIRRELVM v);
 SQUIRREL_API SQRESULT sq_wakeupvm(HSQUIRRELVM v,SQBool resumedret,SQBool retval,SQBool raiseerror,SQBool throwerror);
 SQUIRREL_API SQInteger sq_getvmstate(HSQUIRRELVM v);
 SQUIRREL_API SQInteger sq_getversion();
+SQUIRREL_API void sq_sethashseed(SQUnsignedInteger seed);
+SQUIRREL_API void sq_setstringtableloadfactor(HSQUIRRELVM v,SQFloat factor);
+SQUIRREL_API void sq_getstringtablestats(HSQUIRRELVM v,SQStringTableStats *stats);
 
 /*compiler*/
 SQUIRREL_API SQRESULT sq_compile(HSQUIRRELVM v,SQLEXREADFUNC read,SQUserPointer p,const SQChar *sourcename,SQBool raiseerror);
 SQUIRREL_API SQRESULT sq_compilebuffer(HSQUIRRELVM v,const SQChar *s,SQInteger size,const SQChar *sourcename,SQBool raiseerror);
 SQUIRREL_API void sq_enabledebuginfo(HSQUIRRELVM v, SQBool enable);
 SQUIRREL_API void sq_notifyallexceptions(HSQUIRRELVM v, SQBool enable);
+SQUIRREL_API void sq_setoptimizationlevel(HSQUIRRELVM v, SQInteger level);
+SQUIRREL_API SQInteger sq_getoptimizationlevel(HSQUIRRELVM v);
+SQUIRREL_API void sq_enablequickening(HSQUIRRELVM v, SQBool enable);
 SQUIRREL_API void sq_setcompilererrorhandler(HSQUIRRELVM v,SQCOMPILERERROR f);
 
 /*stack operations*/
@@ -354,6 +401,7 @@ SQUIRREL_API SQUserPointer sq_newuserdata(HSQUIRRELVM v,SQUnsignedInteger size);
 SQUIRREL_API void sq_newtable(HSQUIRRELVM v);
 SQUIRREL_API void sq_newtableex(HSQUIRRELVM v,SQInteger initialcapacity);
 SQUIRREL_API void sq_newarray(HSQUIRRELVM v,SQInteger size);
+SQUIRREL_API SQUserPointer sq_newtypedarray(HSQUIRRELVM v,SQTypedArrayType type,SQInteger size);
 SQUIRREL_API void sq_newclosure(HSQUIRRELVM v,SQFUNCTION func,SQUnsignedInteger nfreevars);
 SQUIRREL_API SQRESULT sq_setparamscheck(HSQUIRRELVM v,SQInteger nparamscheck,const SQChar *typemask);
 SQUIRREL_API SQRESULT sq_bindenv(HSQUIRRELVM v,SQInteger idx);
@@ -417,12 +465,14 @@ SQUIRREL_API SQRESULT sq_rawset(HSQUIRRELVM v,SQInteger idx);
 SQUIRREL_API SQRESULT sq_rawdeleteslot(HSQUIRRELVM v,SQInteger idx,SQBool pushval);
 SQUIRREL_API SQRESULT sq_newmember(HSQUIRRELVM v,SQInteger idx,SQBool bstatic);
 SQUIRREL_API SQRESULT sq_rawnewmember(HSQUIRRELVM v,SQInteger idx,SQBool bstatic);
+SQUIRREL_API SQRESULT sq_newproperty(HSQUIRRELVM v,SQInteger idx);
 SQUIRREL_API SQRESULT sq_arrayappend(HSQUIRRELVM v,SQInteger idx);
 SQUIRREL_API SQRESULT sq_arraypop(HSQUIRRELVM v,SQInteger idx,SQBool pushval); 
 SQUIRREL_API SQRESULT sq_arrayresize(HSQUIRRELVM v,SQInteger idx,SQInteger newsize); 
 SQUIRREL_API SQRESULT sq_arrayreverse(HSQUIRRELVM v,SQInteger idx); 
 SQUIRREL_API SQRESULT sq_arrayremove(HSQUIRRELVM v,SQInteger idx,SQInteger itemidx);
 SQUIRREL_API SQRESULT sq_arrayinsert(HSQUIRRELVM v,SQInteger idx,SQInteger destpos);
+SQUIRREL_API SQRESULT sq_gettypedarray(HSQUIRRELVM v,SQInteger idx,SQUserPointer *data,SQInteger *size,SQTypedArrayType *type);
 SQUIRREL_API SQRESULT sq_setdelegate(HSQUIRRELVM v,SQInteger idx);
 SQUIRREL_API SQRESULT sq_getdelegate(HSQUIRRELVM v,SQInteger idx);
 SQUIRREL_API SQRESULT sq_clone(HSQUIRRELVM v,SQInteger idx);
@@ -459,15 +509,24 @@ SQUIRREL_API SQRESULT sq_getobjtypetag(const HSQOBJECT *o,SQUserPointer * typeta
 /*GC*/
 SQUIRREL_API SQInteger sq_collectgarbage(HSQUIRRELVM v);
 SQUIRREL_API SQRESULT sq_resurrectunreachable(HSQUIRRELVM v);
+SQUIRREL_API SQBool sq_collectstep(HSQUIRRELVM v,SQInteger work);
+SQUIRREL_API void sq_getcollectorstats(HSQUIRRELVM v,SQCollectorStats *stats);
+SQUIRREL_API void sq_getinlinecachestats(HSQUIRRELVM v,SQUnsignedInteger *hits,SQUnsignedInteger *misses);
 
 /*serialization*/
 SQUIRREL_API SQRESULT sq_writeclosure(HSQUIRRELVM vm,SQWRITEFUNC writef,SQUserPointer up);
 SQUIRREL_API SQRESULT sq_readclosure(HSQUIRRELVM vm,SQREADFUNC readf,SQUserPointer up);
+SQUIRREL_API SQRESULT sq_readclosurebuffer(HSQUIRRELVM vm,const void *buffer,SQInteger size);
 
 /*mem allocation*/
 SQUIRREL_API void *sq_malloc(SQUnsignedInteger size);
 SQUIRREL_API void *sq_realloc(void* p,SQUnsignedInteger oldsize,SQUnsignedInteger newsize);
 SQUIRREL_API void sq_free(void *p,SQUnsignedInteger size);
+SQUIRREL_API HSQALLOCATOR sq_newallocator();
+SQUIRREL_API void sq_releaseallocator(HSQALLOCATOR a);
+SQUIRREL_API HSQALLOCATOR sq_setallocator(HSQALLOCATOR a);
+SQUIRREL_API HSQALLOCATOR sq_getallocator();
+SQUIRREL_API void sq_getallocatorstats(HSQALLOCATOR a,SQAllocatorStats *stats);
 
 /*debug*/
 SQUIRREL_API SQRESULT sq_stackinfos(HSQUIRRELVM v,SQInteger level,SQStackInfos *si);
@@ -478,6 +537,7 @@ SQUIRREL_API void sq_setnativedebughook(HSQUIRRELVM v,SQDEBUGHOOK hook);
 #define sq_isnumeric(o) ((o)._type&SQOBJECT_NUMERIC)
 #define sq_istable(o) ((o)._type==OT_TABLE)
 #define sq_isarray(o) ((o)._type==OT_ARRAY)
+#define sq_istypedarray(o) ((o)._type==OT_TYPEDARRAY)
 #define sq_isfunction(o) ((o)._type==OT_FUNCPROTO)
 #define sq_isclosure(o) ((o)._type==OT_CLOSURE)
 #define sq_isgenerator(o) ((o)._type==OT_GENERATOR)
@@ -6,6 +6,7 @@
 #include <sqstdblob.h>
 #include "sqstdstream.h"
 #include "sqstdblobimpl.h"
+#include "sqstdbulk.h"
 
 #define SQSTD_BLOB_TYPE_TAG (SQSTD_STREAM_TYPE_TAG | 0x00000002)
 
@@ -19,6 +20,10 @@
 	if(!self || !self->IsValid())  \
 		return sq_throwerror(v,_SC("the blob is invalid"));
 
+#define CHECK_WRITABLE(v) \
+	if(self->IsReadOnly()) \
+		return sq_throwerror(v,_SC("the blob is read-only"));
+
 
 static SQInteger _blob_resize(HSQUIRRELVM v)
 {
@@ -38,36 +43,166 @@ static void __swap_dword(unsigned int *n)
 			((*n&0x000000FF)<<24));
 }
 
-static void __swap_word(unsigned short *n)
+static SQInteger _blob_swap4(HSQUIRRELVM v)
 {
-	*n=(unsigned short)((*n>>8)&0x00FF)| ((*n<<8)&0xFF00);
+	SETUP_BLOB(v);
+	CHECK_WRITABLE(v);
+	sqstd_bulkkernels()->swap4((unsigned char *)self->GetBuf(),self->Len()>>2);
+	return 0;
 }
 
-static SQInteger _blob_swap4(HSQUIRRELVM v)
+static SQInteger _blob_swap2(HSQUIRRELVM v)
 {
 	SETUP_BLOB(v);
-	SQInteger num=(self->Len()-(self->Len()%4))>>2;
-	unsigned int *t=(unsigned int *)self->GetBuf();
-	for(SQInteger i = 0; i < num; i++) {
-		__swap_dword(&t[i]);
-	}
+	CHECK_WRITABLE(v);
+	sqstd_bulkkernels()->swap2((unsigned char *)self->GetBuf(),self->Len()>>1);
 	return 0;
 }
 
-static SQInteger _blob_swap2(HSQUIRRELVM v)
+//reads the optional [start,[end]] arguments from 'idx'; negative values count from the end
+static SQInteger _blob_getrange(HSQUIRRELVM v,SQBlob *self,SQInteger idx,SQInteger &start,SQInteger &end)
+{
+	SQInteger len = self->Len();
+	start = 0;
+	end = len;
+	if(sq_gettop(v) >= idx) sq_getinteger(v,idx,&start);
+	if(sq_gettop(v) > idx) sq_getinteger(v,idx+1,&end);
+	if(start < 0) start += len;
+	if(end < 0) end += len;
+	if(start < 0 || end > len || start > end)
+		return sq_throwerror(v,_SC("range out of bounds"));
+	return SQ_OK;
+}
+
+#define SETUP_RANGE(v,idx) \
+	SQInteger start,end; \
+	if(SQ_FAILED(_blob_getrange(v,self,idx,start,end))) \
+		return SQ_ERROR; \
+	unsigned char *buf = (unsigned char *)self->GetBuf();
+
+static SQInteger _blob_find(HSQUIRRELVM v)
 {
 	SETUP_BLOB(v);
-	SQInteger num=(self->Len()-(self->Len()%2))>>1;
-	unsigned short *t = (unsigned short *)self->GetBuf();
-	for(SQInteger i = 0; i < num; i++) {
-		__swap_word(&t[i]);
+	SETUP_RANGE(v,3);
+	const unsigned char *needle = NULL;
+	SQInteger size = 0;
+	unsigned char byte;
+	switch(sq_gettype(v,2)) {
+		case OT_INTEGER: {
+			SQInteger i;
+			sq_getinteger(v,2,&i);
+			byte = (unsigned char)i;
+			needle = &byte;
+			size = 1;
+			}
+			break;
+		case OT_STRING: {
+			const SQChar *str;
+			sq_getstring(v,2,&str);
+			needle = (const unsigned char *)str;
+			size = sq_getsize(v,2) * sizeof(SQChar);
+			}
+			break;
+		default: {
+			SQUserPointer p;
+			if(SQ_FAILED(sqstd_getblob(v,2,&p)))
+				return sq_throwerror(v,_SC("the pattern must be a byte, a string or a blob"));
+			needle = (const unsigned char *)p;
+			size = sqstd_getblobsize(v,2);
+			}
+			break;
+	}
+	if(size == 0) {
+		sq_pushinteger(v,start);
+		return 1;
 	}
+	const SQBulkKernels *k = sqstd_bulkkernels();
+	while(end - start >= size) {
+		SQInteger i = k->find(buf + start,end - start - size + 1,needle[0]);
+		if(i < 0) break;
+		start += i;
+		if(memcmp(buf + start + 1,needle + 1,size - 1) == 0) {
+			sq_pushinteger(v,start);
+			return 1;
+		}
+		start++;
+	}
+	return 0;
+}
+
+static SQInteger _blob_fill(HSQUIRRELVM v)
+{
+	SETUP_BLOB(v);
+	CHECK_WRITABLE(v);
+	SETUP_RANGE(v,3);
+	SQInteger val;
+	sq_getinteger(v,2,&val);
+	memset(buf + start,(unsigned char)val,end - start);
 	return 0;
 }
 
+//copy(offset,src,[start,[end]]) copies a range of 'src' (which may be this blob) to 'offset'
+static SQInteger _blob_copy(HSQUIRRELVM v)
+{
+	SETUP_BLOB(v);
+	CHECK_WRITABLE(v);
+	SQInteger offset;
+	sq_getinteger(v,2,&offset);
+	SQBlob *src = NULL;
+	if(SQ_FAILED(sq_getinstanceup(v,3,(SQUserPointer*)&src,(SQUserPointer)SQSTD_BLOB_TYPE_TAG)) || !src || !src->IsValid())
+		return sq_throwerror(v,_SC("the source must be a blob"));
+	SQInteger start,end;
+	if(SQ_FAILED(_blob_getrange(v,src,4,start,end)))
+		return SQ_ERROR;
+	if(offset < 0 || offset + (end - start) > self->Len())
+		return sq_throwerror(v,_SC("range out of bounds"));
+	memmove((unsigned char *)self->GetBuf() + offset,(unsigned char *)src->GetBuf() + start,end - start);
+	return 0;
+}
+
+static SQInteger _blob_sum(HSQUIRRELVM v)
+{
+	SETUP_BLOB(v);
+	SETUP_RANGE(v,2);
+	sq_pushinteger(v,sqstd_bulkkernels()->sum(buf + start,end - start));
+	return 1;
+}
+
+static SQInteger _blob_min(HSQUIRRELVM v)
+{
+	SETUP_BLOB(v);
+	SETUP_RANGE(v,2);
+	if(start == end) return 0;
+	unsigned char lo,hi;
+	sqstd_bulkkernels()->minmax(buf + start,end - start,&lo,&hi);
+	sq_pushinteger(v,lo);
+	return 1;
+}
+
+static SQInteger _blob_max(HSQUIRRELVM v)
+{
+	SETUP_BLOB(v);
+	SETUP_RANGE(v,2);
+	if(start == end) return 0;
+	unsigned char lo,hi;
+	sqstd_bulkkernels()->minmax(buf + start,end - start,&lo,&hi);
+	sq_pushinteger(v,hi);
+	return 1;
+}
+
+static SQInteger _blob_crc32(HSQUIRRELVM v)
+{
+	SETUP_BLOB(v);
+	SETUP_RANGE(v,2);
+	SQUnsignedInteger32 crc = ~sqstd_bulkkernels()->crc32(0xFFFFFFFFu,buf + start,end - start);
+	sq_pushinteger(v,(SQInteger)crc);
+	return 1;
+}
+
 static SQInteger _blob__set(HSQUIRRELVM v)
 {
 	SETUP_BLOB(v);
+	CHECK_WRITABLE(v);
 	SQInteger idx,val;
 	sq_getinteger(v,2,&idx);
 	sq_getinteger(v,3,&val);
@@ -167,6 +302,13 @@ static SQRegFunction _blob_methods[] = {
 	_DECL_BLOB_FUNC(resize,2,_SC("xn")),
 	_DECL_BLOB_FUNC(swap2,1,_SC("x")),
 	_DECL_BLOB_FUNC(swap4,1,_SC("x")),
+	_DECL_BLOB_FUNC(find,-2,_SC("xi|s|xnn")),
+	_DECL_BLOB_FUNC(fill,-2,_SC("xnnn")),
+	_DECL_BLOB_FUNC(copy,-3,_SC("xnxnn")),
+	_DECL_BLOB_FUNC(sum,-1,_SC("xnn")),
+	_DECL_BLOB_FUNC(min,-1,_SC("xnn")),
+	_DECL_BLOB_FUNC(max,-1,_SC("xnn")),
+	_DECL_BLOB_FUNC(crc32,-1,_SC("xnn")),
 	_DECL_BLOB_FUNC(_set,3,_SC("xnn")),
 	_DECL_BLOB_FUNC(_get,2,_SC("xn")),
 	_DECL_BLOB_FUNC(_typeof,1,_SC("x")),
@@ -250,7 +392,7 @@ SQInteger sqstd_getblobsize(HSQUIRRELVM v,SQInteger idx)
 	return blob->Len();
 }
 
-SQUserPointer sqstd_createblob(HSQUIRRELVM v, SQInteger size)
+static SQBlob *_createblob(HSQUIRRELVM v, SQInteger size)
 {
 	SQInteger top = sq_gettop(v);
 	sq_pushregistrytable(v);
@@ -263,13 +405,38 @@ SQUserPointer sqstd_createblob(HSQUIRRELVM v, SQInteger size)
 		if(SQ_SUCCEEDED(sq_call(v,2,SQTrue,SQFalse))
 			&& SQ_SUCCEEDED(sq_getinstanceup(v,-1,(SQUserPointer *)&blob,(SQUserPointer)SQSTD_BLOB_TYPE_TAG))) {
 			sq_remove(v,-2);
-			return blob->GetBuf();
+			return blob;
 		}
 	}
 	sq_settop(v,top);
 	return NULL;
 }
 
+SQUserPointer sqstd_createblob(HSQUIRRELVM v, SQInteger size)
+{
+	SQBlob *blob = _createblob(v,size);
+	return blob ? blob->GetBuf() : NULL;
+}
+
+//the blob reads and writes 'buf' in place; 'release' is invoked when the blob is collected.
+//if the blob cannot be created the hook is not invoked and the caller keeps the buffer.
+SQRESULT sqstd_createblobview(HSQUIRRELVM v,SQUserPointer buf,SQInteger size,SQBool readonly,SQBLOBRELEASEHOOK release,SQUserPointer userdata)
+{
+	if(!buf || size < 0) return sq_throwerror(v,_SC("invalid blob view"));
+	SQBlob *blob = _createblob(v,0);
+	if(!blob) return SQ_ERROR;
+	blob->Attach((unsigned char *)buf,size,readonly?true:false,release,userdata);
+	return SQ_OK;
+}
+
+SQBool sqstd_isblobreadonly(HSQUIRRELVM v,SQInteger idx)
+{
+	SQBlob *blob;
+	if(SQ_FAILED(sq_getinstanceup(v,idx,(SQUserPointer *)&blob,(SQUserPointer)SQSTD_BLOB_TYPE_TAG)))
+		return SQFalse;
+	return blob->IsReadOnly() ? SQTrue : SQFalse;
+}
+
 SQRESULT sqstd_register_bloblib(HSQUIRRELVM v)
 {
 	return declare_stream(v,_SC("blob"),(SQUserPointer)SQSTD_BLOB_TYPE_TAG,_SC("std_blob"),_blob_methods,bloblib_funcs);
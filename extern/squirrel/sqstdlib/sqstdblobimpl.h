@@ -11,12 +11,33 @@ struct SQBlob : public SQStream
 		memset(_buf, 0, _size);
 		_ptr = 0;
 		_owns = true;
+		_readonly = false;
+		_release = NULL;
+		_releaseuserdata = NULL;
 	}
 	virtual ~SQBlob() {
-		sq_free(_buf, _allocated);
+		if(_owns)
+			sq_free(_buf, _allocated);
+		else if(_release)
+			_release(_buf, _size, _releaseuserdata);
+	}
+	//turns the blob into a view of an external buffer; the size of a view is fixed
+	void Attach(unsigned char *buf, SQInteger size, bool readonly, SQBLOBRELEASEHOOK release, SQUserPointer userdata) {
+		if(_owns)
+			sq_free(_buf, _allocated);
+		_buf = buf;
+		_size = size;
+		_allocated = size;
+		_ptr = 0;
+		_owns = false;
+		_readonly = readonly;
+		_release = release;
+		_releaseuserdata = userdata;
 	}
 	SQInteger Write(void *buffer, SQInteger size) {
+		if(_readonly) return 0;
 		if(!CanAdvance(size)) {
+			if(!_owns) return 0;
 			GrowBufOf(_ptr + size - _size);
 		}
 		memcpy(&_buf[_ptr], buffer, size);
@@ -97,12 +118,16 @@ struct SQBlob : public SQStream
 	SQInteger Tell() { return _ptr; }
 	SQInteger Len() { return _size; }
 	SQUserPointer GetBuf(){ return _buf; }
+	bool IsReadOnly() { return _readonly; }
 private:
 	SQInteger _size;
 	SQInteger _allocated;
 	SQInteger _ptr;
 	unsigned char *_buf;
 	bool _owns;
+	bool _readonly;
+	SQBLOBRELEASEHOOK _release;
+	SQUserPointer _releaseuserdata;
 };
 
 #endif //_SQSTD_BLOBIMPL_H_
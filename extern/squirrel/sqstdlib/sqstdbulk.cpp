@@ -0,0 +1,354 @@
+/* see copyright notice in squirrel.h */
+#include <squirrel.h>
+#include <string.h>
+#include "sqstdbulk.h"
+
+#if !defined(SQSTD_BULK_SCALAR) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SQSTD_BULK_X86
+#include <immintrin.h>
+#endif
+
+//PLAIN C
+
+static SQUnsignedInteger32 _crc_table[8][256];
+
+static void _crc_init()
+{
+	for(SQUnsignedInteger32 n = 0; n < 256; n++) {
+		SQUnsignedInteger32 c = n;
+		for(int k = 0; k < 8; k++)
+			c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+		_crc_table[0][n] = c;
+	}
+	for(SQUnsignedInteger32 n = 0; n < 256; n++) {
+		SQUnsignedInteger32 c = _crc_table[0][n];
+		for(int k = 1; k < 8; k++) {
+			c = _crc_table[0][c & 0xFF] ^ (c >> 8);
+			_crc_table[k][n] = c;
+		}
+	}
+}
+
+static SQInteger _find_c(const unsigned char *buf,SQInteger len,unsigned char value)
+{
+	const void *p = memchr(buf,value,(size_t)len);
+	return p ? (const unsigned char *)p - buf : -1;
+}
+
+static SQInteger _sum_c(const unsigned char *buf,SQInteger len)
+{
+	SQInteger sum = 0;
+	for(SQInteger i = 0; i < len; i++)
+		sum += buf[i];
+	return sum;
+}
+
+static void _minmax_c(const unsigned char *buf,SQInteger len,unsigned char *min,unsigned char *max)
+{
+	unsigned char lo = 0xFF, hi = 0;
+	for(SQInteger i = 0; i < len; i++) {
+		if(buf[i] < lo) lo = buf[i];
+		if(buf[i] > hi) hi = buf[i];
+	}
+	*min = lo;
+	*max = hi;
+}
+
+//slicing by 8
+static SQUnsignedInteger32 _crc32_c(SQUnsignedInteger32 crc,const unsigned char *buf,SQInteger len)
+{
+	while(len >= 8) {
+		SQUnsignedInteger32 lo = crc ^ (buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((SQUnsignedInteger32)buf[3] << 24));
+		SQUnsignedInteger32 hi = buf[4] | (buf[5] << 8) | (buf[6] << 16) | ((SQUnsignedInteger32)buf[7] << 24);
+		crc = _crc_table[7][lo & 0xFF] ^ _crc_table[6][(lo >> 8) & 0xFF]
+			^ _crc_table[5][(lo >> 16) & 0xFF] ^ _crc_table[4][lo >> 24]
+			^ _crc_table[3][hi & 0xFF] ^ _crc_table[2][(hi >> 8) & 0xFF]
+			^ _crc_table[1][(hi >> 16) & 0xFF] ^ _crc_table[0][hi >> 24];
+		buf += 8;
+		len -= 8;
+	}
+	while(len-- > 0)
+		crc = _crc_table[0][(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+static void _swap2_c(unsigned char *buf,SQInteger count)
+{
+	for(SQInteger i = 0; i < count; i++, buf += 2) {
+		unsigned char t = buf[0]; buf[0] = buf[1]; buf[1] = t;
+	}
+}
+
+static void _swap4_c(unsigned char *buf,SQInteger count)
+{
+	for(SQInteger i = 0; i < count; i++, buf += 4) {
+		unsigned char t = buf[0]; buf[0] = buf[3]; buf[3] = t;
+		t = buf[1]; buf[1] = buf[2]; buf[2] = t;
+	}
+}
+
+#ifdef SQSTD_BULK_X86
+
+//SSE
+
+__attribute__((target("sse2")))
+static SQInteger _sum_sse2(const unsigned char *buf,SQInteger len)
+{
+	__m128i zero = _mm_setzero_si128(), acc = zero;
+	SQInteger i = 0;
+	for(; i + 16 <= len; i += 16)
+		acc = _mm_add_epi64(acc,_mm_sad_epu8(_mm_loadu_si128((const __m128i *)(buf + i)),zero));
+	long long lanes[2];
+	_mm_storeu_si128((__m128i *)lanes,acc);
+	return (SQInteger)(lanes[0] + lanes[1]) + _sum_c(buf + i,len - i);
+}
+
+__attribute__((target("sse2")))
+static void _minmax_sse2(const unsigned char *buf,SQInteger len,unsigned char *min,unsigned char *max)
+{
+	SQInteger i = 0;
+	unsigned char lo = 0xFF, hi = 0;
+	if(len >= 16) {
+		__m128i vlo = _mm_set1_epi8((char)0xFF), vhi = _mm_setzero_si128();
+		for(; i + 16 <= len; i += 16) {
+			__m128i x = _mm_loadu_si128((const __m128i *)(buf + i));
+			vlo = _mm_min_epu8(vlo,x);
+			vhi = _mm_max_epu8(vhi,x);
+		}
+		unsigned char l[16], h[16];
+		_mm_storeu_si128((__m128i *)l,vlo);
+		_mm_storeu_si128((__m128i *)h,vhi);
+		for(int k = 0; k < 16; k++) {
+			if(l[k] < lo) lo = l[k];
+			if(h[k] > hi) hi = h[k];
+		}
+	}
+	unsigned char tlo, thi;
+	_minmax_c(buf + i,len - i,&tlo,&thi);
+	*min = tlo < lo ? tlo : lo;
+	*max = thi > hi ? thi : hi;
+}
+
+__attribute__((target("ssse3")))
+static void _swap2_ssse3(unsigned char *buf,SQInteger count)
+{
+	const __m128i mask = _mm_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+	SQInteger i = 0;
+	for(; i + 8 <= count; i += 8) {
+		__m128i *p = (__m128i *)(buf + i * 2);
+		_mm_storeu_si128(p,_mm_shuffle_epi8(_mm_loadu_si128(p),mask));
+	}
+	_swap2_c(buf + i * 2,count - i);
+}
+
+__attribute__((target("ssse3")))
+static void _swap4_ssse3(unsigned char *buf,SQInteger count)
+{
+	const __m128i mask = _mm_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+	SQInteger i = 0;
+	for(; i + 4 <= count; i += 4) {
+		__m128i *p = (__m128i *)(buf + i * 4);
+		_mm_storeu_si128(p,_mm_shuffle_epi8(_mm_loadu_si128(p),mask));
+	}
+	_swap4_c(buf + i * 4,count - i);
+}
+
+/*
+	Folds 64 bytes per step with carry-less multiplies, then reduces to
+	32 bits (Gopal et al., "Fast CRC Computation for Generic Polynomials
+	Using PCLMULQDQ Instruction"). 'len' must be a multiple of 16, >= 64.
+*/
+__attribute__((target("sse4.1,pclmul")))
+static SQUnsignedInteger32 _crc32_fold(SQUnsignedInteger32 crc,const unsigned char *buf,SQInteger len)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596LL,0x0154442bd4LL);
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009eLL,0x01751997d0LL);
+	const __m128i k5k0 = _mm_set_epi64x(0,0x0163cd6124LL);
+	const __m128i poly = _mm_set_epi64x(0x01f7011641LL,0x01db710641LL);
+	const __m128i mask32 = _mm_setr_epi32(~0,0,~0,0);
+
+	__m128i x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(buf + 0x00)),_mm_cvtsi32_si128((int)crc));
+	__m128i x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+	__m128i x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+	__m128i x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+	__m128i x5, x6, x7, x8;
+	buf += 64;
+	len -= 64;
+
+	while(len >= 64) {
+		x5 = _mm_clmulepi64_si128(x1,k1k2,0x00);
+		x6 = _mm_clmulepi64_si128(x2,k1k2,0x00);
+		x7 = _mm_clmulepi64_si128(x3,k1k2,0x00);
+		x8 = _mm_clmulepi64_si128(x4,k1k2,0x00);
+		x1 = _mm_clmulepi64_si128(x1,k1k2,0x11);
+		x2 = _mm_clmulepi64_si128(x2,k1k2,0x11);
+		x3 = _mm_clmulepi64_si128(x3,k1k2,0x11);
+		x4 = _mm_clmulepi64_si128(x4,k1k2,0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1,x5),_mm_loadu_si128((const __m128i *)(buf + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2,x6),_mm_loadu_si128((const __m128i *)(buf + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3,x7),_mm_loadu_si128((const __m128i *)(buf + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4,x8),_mm_loadu_si128((const __m128i *)(buf + 0x30)));
+		buf += 64;
+		len -= 64;
+	}
+
+	//fold the four lanes into one
+	x5 = _mm_clmulepi64_si128(x1,k3k4,0x00);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1,k3k4,0x11),x2),x5);
+	x5 = _mm_clmulepi64_si128(x1,k3k4,0x00);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1,k3k4,0x11),x3),x5);
+	x5 = _mm_clmulepi64_si128(x1,k3k4,0x00);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1,k3k4,0x11),x4),x5);
+
+	while(len >= 16) {
+		x5 = _mm_clmulepi64_si128(x1,k3k4,0x00);
+		x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1,k3k4,0x11),_mm_loadu_si128((const __m128i *)buf)),x5);
+		buf += 16;
+		len -= 16;
+	}
+
+	//128 to 64 bits
+	x2 = _mm_clmulepi64_si128(x1,k3k4,0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1,8),x2);
+	x2 = _mm_srli_si128(x1,4);
+	x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1,mask32),k5k0,0x00),x2);
+
+	//Barrett reduction to 32 bits
+	x2 = _mm_clmulepi64_si128(_mm_and_si128(x1,mask32),poly,0x10);
+	x2 = _mm_clmulepi64_si128(_mm_and_si128(x2,mask32),poly,0x00);
+	x1 = _mm_xor_si128(x1,x2);
+
+	return (SQUnsignedInteger32)_mm_extract_epi32(x1,1);
+}
+
+static SQUnsignedInteger32 _crc32_pclmul(SQUnsignedInteger32 crc,const unsigned char *buf,SQInteger len)
+{
+	if(len >= 64) {
+		SQInteger chunk = len & ~(SQInteger)15;
+		crc = _crc32_fold(crc,buf,chunk);
+		buf += chunk;
+		len -= chunk;
+	}
+	return _crc32_c(crc,buf,len);
+}
+
+//AVX2
+
+__attribute__((target("avx2")))
+static SQInteger _find_avx2(const unsigned char *buf,SQInteger len,unsigned char value)
+{
+	const __m256i needle = _mm256_set1_epi8((char)value);
+	SQInteger i = 0;
+	for(; i + 32 <= len; i += 32) {
+		unsigned int bits = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(buf + i)),needle));
+		if(bits)
+			return i + __builtin_ctz(bits);
+	}
+	SQInteger rest = _find_c(buf + i,len - i,value);
+	return rest < 0 ? -1 : i + rest;
+}
+
+__attribute__((target("avx2")))
+static SQInteger _sum_avx2(const unsigned char *buf,SQInteger len)
+{
+	__m256i zero = _mm256_setzero_si256(), acc = zero;
+	SQInteger i = 0;
+	for(; i + 32 <= len; i += 32)
+		acc = _mm256_add_epi64(acc,_mm256_sad_epu8(_mm256_loadu_si256((const __m256i *)(buf + i)),zero));
+	long long lanes[4];
+	_mm256_storeu_si256((__m256i *)lanes,acc);
+	return (SQInteger)(lanes[0] + lanes[1] + lanes[2] + lanes[3]) + _sum_sse2(buf + i,len - i);
+}
+
+__attribute__((target("avx2")))
+static void _minmax_avx2(const unsigned char *buf,SQInteger len,unsigned char *min,unsigned char *max)
+{
+	SQInteger i = 0;
+	unsigned char lo = 0xFF, hi = 0;
+	if(len >= 32) {
+		__m256i vlo = _mm256_set1_epi8((char)0xFF), vhi = _mm256_setzero_si256();
+		for(; i + 32 <= len; i += 32) {
+			__m256i x = _mm256_loadu_si256((const __m256i *)(buf + i));
+			vlo = _mm256_min_epu8(vlo,x);
+			vhi = _mm256_max_epu8(vhi,x);
+		}
+		unsigned char l[32], h[32];
+		_mm256_storeu_si256((__m256i *)l,vlo);
+		_mm256_storeu_si256((__m256i *)h,vhi);
+		for(int k = 0; k < 32; k++) {
+			if(l[k] < lo) lo = l[k];
+			if(h[k] > hi) hi = h[k];
+		}
+	}
+	unsigned char tlo, thi;
+	_minmax_sse2(buf + i,len - i,&tlo,&thi);
+	*min = tlo < lo ? tlo : lo;
+	*max = thi > hi ? thi : hi;
+}
+
+__attribute__((target("avx2")))
+static void _swap2_avx2(unsigned char *buf,SQInteger count)
+{
+	const __m256i mask = _mm256_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14,
+		1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14);
+	SQInteger i = 0;
+	for(; i + 16 <= count; i += 16) {
+		__m256i *p = (__m256i *)(buf + i * 2);
+		_mm256_storeu_si256(p,_mm256_shuffle_epi8(_mm256_loadu_si256(p),mask));
+	}
+	_swap2_ssse3(buf + i * 2,count - i);
+}
+
+__attribute__((target("avx2")))
+static void _swap4_avx2(unsigned char *buf,SQInteger count)
+{
+	const __m256i mask = _mm256_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12,
+		3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+	SQInteger i = 0;
+	for(; i + 8 <= count; i += 8) {
+		__m256i *p = (__m256i *)(buf + i * 4);
+		_mm256_storeu_si256(p,_mm256_shuffle_epi8(_mm256_loadu_si256(p),mask));
+	}
+	_swap4_ssse3(buf + i * 4,count - i);
+}
+
+#endif // SQSTD_BULK_X86
+
+static SQBulkKernels _select_kernels()
+{
+	SQBulkKernels k;
+	_crc_init();
+	k.find = _find_c;
+	k.sum = _sum_c;
+	k.minmax = _minmax_c;
+	k.crc32 = _crc32_c;
+	k.swap2 = _swap2_c;
+	k.swap4 = _swap4_c;
+#ifdef SQSTD_BULK_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("sse2")) {
+		k.sum = _sum_sse2;
+		k.minmax = _minmax_sse2;
+	}
+	if(__builtin_cpu_supports("ssse3")) {
+		k.swap2 = _swap2_ssse3;
+		k.swap4 = _swap4_ssse3;
+	}
+	if(__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("pclmul"))
+		k.crc32 = _crc32_pclmul;
+	if(__builtin_cpu_supports("avx2")) {
+		k.find = _find_avx2;
+		k.sum = _sum_avx2;
+		k.minmax = _minmax_avx2;
+		k.swap2 = _swap2_avx2;
+		k.swap4 = _swap4_avx2;
+	}
+#endif
+	return k;
+}
+
+const SQBulkKernels *sqstd_bulkkernels()
+{
+	static const SQBulkKernels kernels = _select_kernels();
+	return &kernels;
+}
@@ -0,0 +1,25 @@
+/*	see copyright notice in squirrel.h */
+#ifndef _SQSTD_BULK_H_
+#define _SQSTD_BULK_H_
+
+/*
+	Byte kernels behind the blob bulk methods. Each entry is picked once, on
+	first use, from the widest implementation the cpu supports (AVX2, SSE,
+	then plain C); define SQSTD_BULK_SCALAR to always use the plain C ones.
+*/
+struct SQBulkKernels
+{
+	//index of the first 'value' in buf[0..len), or -1
+	SQInteger (*find)(const unsigned char *buf,SQInteger len,unsigned char value);
+	SQInteger (*sum)(const unsigned char *buf,SQInteger len);
+	void (*minmax)(const unsigned char *buf,SQInteger len,unsigned char *min,unsigned char *max);
+	//'crc' is the running value, ~0 before the first chunk (zlib polynomial, not inverted on return)
+	SQUnsignedInteger32 (*crc32)(SQUnsignedInteger32 crc,const unsigned char *buf,SQInteger len);
+	//reverse the bytes of 'count' 16 and 32 bits words in place
+	void (*swap2)(unsigned char *buf,SQInteger count);
+	void (*swap4)(unsigned char *buf,SQInteger count);
+};
+
+const SQBulkKernels *sqstd_bulkkernels();
+
+#endif /*_SQSTD_BULK_H_*/
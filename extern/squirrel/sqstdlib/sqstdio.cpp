@@ -337,6 +337,24 @@ SQInteger file_write(SQUserPointer file,SQUserPointer p,SQInteger size)
 	return sqstd_fwrite(p,1,size,(SQFILE)file);
 }
 
+#ifndef SQUNICODE
+//reads the rest of the file in one go so the lexer can scan it in place
+static SQRESULT _io_compile_plain(HSQUIRRELVM v,SQFILE file,const SQChar *filename,SQBool printerror)
+{
+	SQInteger start = sqstd_ftell(file);
+	if(start < 0 || sqstd_fseek(file,0,SQ_SEEK_END) != 0) return sq_throwerror(v,_SC("io error"));
+	SQInteger size = sqstd_ftell(file) - start;
+	if(size < 0 || sqstd_fseek(file,start,SQ_SEEK_SET) != 0) return sq_throwerror(v,_SC("io error"));
+	if(size == 0) return sq_compilebuffer(v,_SC(""),0,filename,printerror);
+	SQChar *source = (SQChar *)sq_malloc(size);
+	if(!source) return sq_throwerror(v,_SC("out of memory"));
+	SQInteger read = sqstd_fread(source,1,size,file);
+	SQRESULT ret = sq_compilebuffer(v,source,read,filename,printerror);
+	sq_free(source,size);
+	return ret;
+}
+#endif
+
 SQRESULT sqstd_loadfile(HSQUIRRELVM v,const SQChar *filename,SQBool printerror)
 {
 	SQFILE file = sqstd_fopen(filename,_SC("rb"));
@@ -382,6 +400,13 @@ SQRESULT sqstd_loadfile(HSQUIRRELVM v,const SQChar *filename,SQBool printerror)
 					break;//UTF-8 ;
 				default: sqstd_fseek(file,0,SQ_SEEK_SET); break; // ascii
 			}
+#ifndef SQUNICODE
+			if(func == _io_file_lexfeed_PLAIN) {
+				SQRESULT ret = _io_compile_plain(v,file,filename,printerror);
+				sqstd_fclose(file);
+				return ret;
+			}
+#endif
 			IOBuffer buffer;
 			buffer.ptr = 0;
 			buffer.size = 0;
@@ -6,6 +6,7 @@
 #include "sqstring.h"
 #include "sqtable.h"
 #include "sqarray.h"
+#include "sqtypedarray.h"
 #include "sqfuncproto.h"
 #include "sqclosure.h"
 #include "squserdata.h"
@@ -123,11 +124,27 @@ SQInteger sq_getversion()
 	return SQUIRREL_VERSION_NUMBER;
 }
 
+void sq_sethashseed(SQUnsignedInteger seed)
+{
+	_sq_hashseed = seed;
+}
+
+void sq_setstringtableloadfactor(HSQUIRRELVM v,SQFloat factor)
+{
+	if(factor > 0)
+		_ss(v)->_stringtable->SetLoadFactor(factor);
+}
+
+void sq_getstringtablestats(HSQUIRRELVM v,SQStringTableStats *stats)
+{
+	_ss(v)->_stringtable->GetStats(stats);
+}
+
 SQRESULT sq_compile(HSQUIRRELVM v,SQLEXREADFUNC read,SQUserPointer p,const SQChar *sourcename,SQBool raiseerror)
 {
 	SQObjectPtr o;
 #ifndef NO_COMPILER
-	if(Compile(v, read, p, sourcename, o, raiseerror?true:false, _ss(v)->_debuginfo)) {
+	if(Compile(v, read, p, sourcename, o, raiseerror?true:false, _ss(v)->_debuginfo, _ss(v)->_optimizationlevel)) {
 		v->Push(SQClosure::Create(_ss(v), _funcproto(o), _table(v->_roottable)->GetWeakRef(OT_TABLE)));
 		return SQ_OK;
 	}
@@ -147,6 +164,21 @@ void sq_notifyallexceptions(HSQUIRRELVM v, SQBool enable)
 	_ss(v)->_notifyallexceptions = enable?true:false;
 }
 
+void sq_setoptimizationlevel(HSQUIRRELVM v, SQInteger level)
+{
+	_ss(v)->_optimizationlevel = level;
+}
+
+SQInteger sq_getoptimizationlevel(HSQUIRRELVM v)
+{
+	return _ss(v)->_optimizationlevel;
+}
+
+void sq_enablequickening(HSQUIRRELVM v, SQBool enable)
+{
+	_ss(v)->_quickening = enable?true:false;
+}
+
 void sq_addref(HSQUIRRELVM v,HSQOBJECT *po)
 {
 	if(!ISREFCOUNTED(type(*po))) return;
@@ -273,6 +305,14 @@ void sq_newarray(HSQUIRRELVM v,SQInteger size)
 	v->Push(SQArray::Create(_ss(v), size));	
 }
 
+SQUserPointer sq_newtypedarray(HSQUIRRELVM v,SQTypedArrayType type,SQInteger size)
+{
+	SQTypedArray *a = SQTypedArray::Create(type, size);
+	if(!a) return NULL;
+	v->Push(a);
+	return a->Data();
+}
+
 SQRESULT sq_newclass(HSQUIRRELVM v,SQBool hasbase)
 {
 	SQClass *baseclass = NULL;
@@ -371,6 +411,17 @@ SQRESULT sq_arrayinsert(HSQUIRRELVM v,SQInteger idx,SQInteger destpos)
 	return ret;
 }
 
+SQRESULT sq_gettypedarray(HSQUIRRELVM v,SQInteger idx,SQUserPointer *data,SQInteger *size,SQTypedArrayType *type)
+{
+	SQObjectPtr *o = NULL;
+	_GETSAFE_OBJ(v, idx, OT_TYPEDARRAY,o);
+	SQTypedArray *a = _typedarray(*o);
+	if(data) *data = a->Data();
+	if(size) *size = a->Size();
+	if(type) *type = a->ElementType();
+	return SQ_OK;
+}
+
 void sq_newclosure(HSQUIRRELVM v,SQFUNCTION func,SQUnsignedInteger nfreevars)
 {
 	SQNativeClosure *nc = SQNativeClosure::Create(_ss(v), func,nfreevars);
@@ -682,6 +733,7 @@ SQInteger sq_getsize(HSQUIRRELVM v, SQInteger idx)
 	case OT_STRING:		return _string(o)->_len;
 	case OT_TABLE:		return _table(o)->CountUsed();
 	case OT_ARRAY:		return _array(o)->Size();
+	case OT_TYPEDARRAY:	return _typedarray(o)->Size();
 	case OT_USERDATA:	return _userdata(o)->_size;
 	case OT_INSTANCE:	return _instance(o)->_class->_udsize;
 	case OT_CLASS:		return _class(o)->_udsize;
@@ -914,6 +966,18 @@ SQRESULT sq_rawnewmember(HSQUIRRELVM v,SQInteger idx,SQBool bstatic)
 	return SQ_OK; 
 }
 
+/* pops key, getter and setter; a null accessor keeps the one already set */
+SQRESULT sq_newproperty(HSQUIRRELVM v,SQInteger idx)
+{
+	SQObjectPtr &self = stack_get(v, idx);
+	if(type(self) != OT_CLASS) return sq_throwerror(v, _SC("new property only works with classes"));
+	if(type(v->GetUp(-3)) == OT_NULL) return sq_throwerror(v, _SC("null key"));
+	if(!_class(self)->NewProperty(_ss(v),v->GetUp(-3),v->GetUp(-2),v->GetUp(-1)))
+		return sq_throwerror(v, _SC("the member already exists and isn't a property"));
+	v->Pop(3);
+	return SQ_OK;
+}
+
 SQRESULT sq_setdelegate(HSQUIRRELVM v,SQInteger idx)
 {
 	SQObjectPtr &self = stack_get(v, idx);
@@ -1206,6 +1270,22 @@ SQRESULT sq_readclosure(HSQUIRRELVM v,SQREADFUNC r,SQUserPointer up)
 	return SQ_OK;
 }
 
+SQRESULT sq_readclosurebuffer(HSQUIRRELVM v,const void *buffer,SQInteger size)
+{
+	SQObjectPtr closure;
+
+	unsigned short tag;
+	if(size < 2)
+		return sq_throwerror(v,_SC("io error"));
+	memcpy(&tag,buffer,2);
+	if(tag != SQ_BYTECODE_STREAM_TAG)
+		return sq_throwerror(v,_SC("invalid stream"));
+	if(!SQClosure::LoadBuffer(v,(const unsigned char *)buffer + 2,size - 2,closure))
+		return SQ_ERROR;
+	v->Push(closure);
+	return SQ_OK;
+}
+
 SQChar *sq_getscratchpad(HSQUIRRELVM v,SQInteger minsize)
 {
 	return _ss(v)->GetScratchPad(minsize);
@@ -1230,6 +1310,36 @@ SQInteger sq_collectgarbage(HSQUIRRELVM v)
 #endif
 }
 
+/* scans or sweeps about 'work' objects; returns SQTrue when a cycle ends */
+SQBool sq_collectstep(HSQUIRRELVM v,SQInteger work)
+{
+#ifndef NO_GARBAGE_COLLECTOR
+	return _ss(v)->CollectStep(work > 0 ? work : 1) ? SQTrue : SQFalse;
+#else
+	return SQTrue;
+#endif
+}
+
+void sq_getcollectorstats(HSQUIRRELVM v,SQCollectorStats *stats)
+{
+#ifndef NO_GARBAGE_COLLECTOR
+	SQSharedState *ss = _ss(v);
+	stats->cycles = ss->_gccycles;
+	stats->freed = ss->_gcfreed;
+	stats->collecting = ss->_gcphase != SQ_GC_IDLE ? SQTrue : SQFalse;
+#else
+	stats->cycles = 0;
+	stats->freed = 0;
+	stats->collecting = SQFalse;
+#endif
+}
+
+void sq_getinlinecachestats(HSQUIRRELVM v,SQUnsignedInteger *hits,SQUnsignedInteger *misses)
+{
+	*hits = _ss(v)->_inlinecachehits;
+	*misses = _ss(v)->_inlinecachemisses;
+}
+
 SQRESULT sq_getcallee(HSQUIRRELVM v)
 {
 	if(v->_callsstacksize > 1)
@@ -1277,6 +1387,7 @@ SQRESULT sq_setfreevariable(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger nval)
 	case OT_CLOSURE:{
 		SQFunctionProto *fp = _closure(self)->_function;
 		if(((SQUnsignedInteger)fp->_noutervalues) > nval){
+			SQ_GC_BARRIER(_ss(v),stack_get(v,-1));
 			*(_outer(_closure(self)->_outervalues[nval])->_valptr) = stack_get(v,-1);
 		}
 		else return sq_throwerror(v,_SC("invalid free var index"));
@@ -1284,6 +1395,7 @@ SQRESULT sq_setfreevariable(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger nval)
 		break;
 	case OT_NATIVECLOSURE:
 		if(_nativeclosure(self)->_noutervalues > nval){
+			SQ_GC_BARRIER(_ss(v),stack_get(v,-1));
 			_nativeclosure(self)->_outervalues[nval] = stack_get(v,-1);
 		}
 		else return sq_throwerror(v,_SC("invalid free var index"));
@@ -1403,6 +1515,7 @@ SQRESULT sq_setbyhandle(HSQUIRRELVM v,SQInteger idx,const HSQMEMBERHANDLE *handl
 	if(SQ_FAILED(_getmemberbyhandle(v,self,handle,val))) {
 		return SQ_ERROR;
 	}
+	SQ_GC_BARRIER(_ss(v),newval);
 	*val = newval;
 	v->Pop();
 	return SQ_OK;
@@ -1431,7 +1544,7 @@ SQRESULT sq_createinstance(HSQUIRRELVM v,SQInteger idx)
 {
 	SQObjectPtr *o = NULL;
 	_GETSAFE_OBJ(v, idx, OT_CLASS,o);
-	v->Push(_class(*o)->CreateInstance());
+	v->Push(_class(*o)->CreateInstance(_ss(v)));
 	return SQ_OK;
 }
 
@@ -1461,6 +1574,7 @@ SQRESULT sq_getdefaultdelegate(HSQUIRRELVM v,SQObjectType t)
 	switch(t) {
 	case OT_TABLE: v->Push(ss->_table_default_delegate); break;
 	case OT_ARRAY: v->Push(ss->_array_default_delegate); break;
+	case OT_TYPEDARRAY: v->Push(ss->_typedarray_default_delegate); break;
 	case OT_STRING: v->Push(ss->_string_default_delegate); break;
 	case OT_INTEGER: case OT_FLOAT: v->Push(ss->_number_default_delegate); break;
 	case OT_GENERATOR: v->Push(ss->_generator_default_delegate); break;
@@ -1491,26 +1605,18 @@ SQRESULT sq_next(HSQUIRRELVM v,SQInteger idx)
 	return SQ_ERROR;
 }
 
-struct BufState{
-	const SQChar *buf;
-	SQInteger ptr;
-	SQInteger size;
-};
-
-SQInteger buf_lexfeed(SQUserPointer file)
+SQRESULT sq_compilebuffer(HSQUIRRELVM v,const SQChar *s,SQInteger size,const SQChar *sourcename,SQBool raiseerror)
 {
-	BufState *buf=(BufState*)file;
-	if(buf->size<(buf->ptr+1))
-		return 0;
-	return buf->buf[buf->ptr++];
-}
-
-SQRESULT sq_compilebuffer(HSQUIRRELVM v,const SQChar *s,SQInteger size,const SQChar *sourcename,SQBool raiseerror) {
-	BufState buf;
-	buf.buf = s;
-	buf.size = size;
-	buf.ptr = 0;
-	return sq_compile(v, buf_lexfeed, &buf, sourcename, raiseerror);
+	SQObjectPtr o;
+#ifndef NO_COMPILER
+	if(Compile(v, s, size, sourcename, o, raiseerror?true:false, _ss(v)->_debuginfo, _ss(v)->_optimizationlevel)) {
+		v->Push(SQClosure::Create(_ss(v), _funcproto(o), _table(v->_roottable)->GetWeakRef(OT_TABLE)));
+		return SQ_OK;
+	}
+	return SQ_ERROR;
+#else
+	return sq_throwerror(v,_SC("this is a no compiler build"));
+#endif
 }
 
 void sq_move(HSQUIRRELVM dest,HSQUIRRELVM src,SQInteger idx)
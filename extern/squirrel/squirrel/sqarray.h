@@ -35,6 +35,7 @@ public:
 	bool Set(const SQInteger nidx,const SQObjectPtr &val)
 	{
 		if(nidx>=0 && nidx<(SQInteger)_values.size()){
+			SQ_GC_BARRIER(_sharedstate,val);
 			_values[nidx]=val;
 			return true;
 		}
@@ -61,15 +62,16 @@ public:
 		SQObjectPtr _null;
 		Resize(size,_null);
 	}
-	void Resize(SQInteger size,SQObjectPtr &fill) { _values.resize(size,fill); ShrinkIfNeeded(); }
+	void Resize(SQInteger size,SQObjectPtr &fill) { SQ_GC_BARRIER(_sharedstate,fill); _values.resize(size,fill); ShrinkIfNeeded(); }
 	void Reserve(SQInteger size) { _values.reserve(size); }
-	void Append(const SQObject &o){_values.push_back(o);}
+	void Append(const SQObject &o){SQ_GC_BARRIER(_sharedstate,o); _values.push_back(o);}
 	void Extend(const SQArray *a);
 	SQObjectPtr &Top(){return _values.top();}
 	void Pop(){_values.pop_back(); ShrinkIfNeeded(); }
 	bool Insert(SQInteger idx,const SQObject &val){
 		if(idx < 0 || idx > (SQInteger)_values.size())
 			return false;
+		SQ_GC_BARRIER(_sharedstate,val);
 		_values.insert(idx,val);
 		return true;
 	}
@@ -6,9 +6,11 @@
 #include "sqstring.h"
 #include "sqtable.h"
 #include "sqarray.h"
+#include "sqtypedarray.h"
 #include "sqfuncproto.h"
 #include "sqclosure.h"
 #include "sqclass.h"
+#include "sqsort.h"
 #include <stdlib.h>
 #include <stdarg.h>
 #include <ctype.h>
@@ -245,6 +247,54 @@ static SQInteger base_array(HSQUIRRELVM v)
 	return 1;
 }
 
+//int32array(size,[fill]) or int32array(array), and the same for float32 and float64
+static SQInteger _base_typedarray(HSQUIRRELVM v,SQTypedArrayType t)
+{
+	SQObjectPtr &init = stack_get(v,2);
+	if(sq_isnumeric(init)) {
+		SQInteger size = tointeger(init);
+		if(size < 0) return sq_throwerror(v,_SC("negative size"));
+		if(size > SQTypedArray::MaxSize(t)) return sq_throwerror(v,_SC("size too big"));
+		if(sq_gettop(v) > 2 && !sq_isnumeric(stack_get(v,3)))
+			return sq_throwerror(v,_SC("the fill value must be a number"));
+		SQTypedArray *a = SQTypedArray::Create(t,size);
+		if(!a) return sq_throwerror(v,_SC("out of memory"));
+		if(sq_gettop(v) > 2) {
+			for(SQInteger i = 0; i < size; i++)
+				a->SetAt(i,stack_get(v,3));
+		}
+		v->Push(a);
+		return 1;
+	}
+	SQInteger size = sq_getsize(v,2);
+	SQTypedArray *a = SQTypedArray::Create(t,size);
+	if(!a) return sq_throwerror(v,_SC("out of memory"));
+	v->Push(a);
+	SQObjectPtr val;
+	for(SQInteger i = 0; i < size; i++) {
+		if(type(init) == OT_ARRAY) val = _array(init)->_values[i];
+		else _typedarray(init)->GetAt(i,val);
+		if(!sq_isnumeric(val)) return sq_throwerror(v,_SC("the array contains non numeric values"));
+		a->SetAt(i,val);
+	}
+	return 1;
+}
+
+static SQInteger base_int32array(HSQUIRRELVM v)
+{
+	return _base_typedarray(v,SQTA_INT32);
+}
+
+static SQInteger base_float32array(HSQUIRRELVM v)
+{
+	return _base_typedarray(v,SQTA_FLOAT32);
+}
+
+static SQInteger base_float64array(HSQUIRRELVM v)
+{
+	return _base_typedarray(v,SQTA_FLOAT64);
+}
+
 static SQInteger base_type(HSQUIRRELVM v)
 {
 	SQObjectPtr &o = stack_get(v,2);
@@ -279,6 +329,9 @@ static SQRegFunction base_funcs[]={
 	{_SC("newthread"),base_newthread,2, _SC(".c")},
 	{_SC("suspend"),base_suspend,-1, NULL},
 	{_SC("array"),base_array,-2, _SC(".n")},
+	{_SC("int32array"),base_int32array,-2, _SC(".n|a|dn")},
+	{_SC("float32array"),base_float32array,-2, _SC(".n|a|dn")},
+	{_SC("float64array"),base_float64array,-2, _SC(".n|a|dn")},
 	{_SC("type"),base_type,2, NULL},
 	{_SC("callee"),base_callee,0,NULL},
 	{_SC("dummy"),base_dummy,0,NULL},
@@ -644,98 +697,278 @@ static SQInteger array_find(HSQUIRRELVM v)
 }
 
 
-bool _sort_compare(HSQUIRRELVM v,SQObjectPtr &a,SQObjectPtr &b,SQInteger func,SQInteger &ret)
+/*
+	Bulk numeric operations. Elements are tagged objects rather than packed
+	numbers, so these are plain native loops: they save the per-element
+	dispatch of the equivalent script loop. Integers stay integers and a
+	float on either side makes a float, as with the arithmetic operators.
+*/
+static bool _array_isnumeric(SQArray *a,bool &allints)
+{
+	SQInteger n = a->Size();
+	SQObject *vals = a->_values._vals;
+	allints = true;
+	for(SQInteger i = 0; i < n; i++) {
+		SQObjectType t = type(vals[i]);
+		if(t == OT_FLOAT) allints = false;
+		else if(t != OT_INTEGER) return false;
+	}
+	return true;
+}
+
+#define SETUP_NUMERIC_ARRAY(v,a,allints) \
+	SQArray *a = _array(stack_get(v,1)); \
+	bool allints; \
+	if(!_array_isnumeric(a,allints)) \
+		return sq_throwerror(v,_SC("the array contains non numeric values"));
+
+static SQInteger array_sum(HSQUIRRELVM v)
 {
-	if(func < 0) {
-		if(!v->ObjCmp(a,b,ret)) return false;
+	SETUP_NUMERIC_ARRAY(v,a,allints);
+	SQInteger n = a->Size();
+	SQObject *vals = a->_values._vals;
+	if(allints) {
+		SQInteger sum = 0;
+		for(SQInteger i = 0; i < n; i++)
+			sum += _integer(vals[i]);
+		v->Push(sum);
 	}
 	else {
-		SQInteger top = sq_gettop(v);
-		sq_push(v, func);
-		sq_pushroottable(v);
-		v->Push(a);
-		v->Push(b);
-		if(SQ_FAILED(sq_call(v, 3, SQTrue, SQFalse))) {
-			if(!sq_isstring( v->_lasterror)) 
-				v->Raise_Error(_SC("compare func failed"));
-			return false;
+		SQFloat sum = 0;
+		for(SQInteger i = 0; i < n; i++)
+			sum += tofloat(vals[i]);
+		v->Push(sum);
+	}
+	return 1;
+}
+
+static SQInteger _array_extreme(HSQUIRRELVM v,bool greatest)
+{
+	SETUP_NUMERIC_ARRAY(v,a,allints);
+	SQInteger n = a->Size();
+	if(n == 0) return 0;
+	SQObject *vals = a->_values._vals;
+	SQInteger best = 0;
+	if(allints) {
+		for(SQInteger i = 1; i < n; i++)
+			if(greatest ? _integer(vals[i]) > _integer(vals[best]) : _integer(vals[i]) < _integer(vals[best]))
+				best = i;
+	}
+	else {
+		for(SQInteger i = 1; i < n; i++)
+			if(greatest ? tofloat(vals[i]) > tofloat(vals[best]) : tofloat(vals[i]) < tofloat(vals[best]))
+				best = i;
+	}
+	v->Push(a->_values[best]);
+	return 1;
+}
+
+static SQInteger array_min(HSQUIRRELVM v)
+{
+	return _array_extreme(v,false);
+}
+
+static SQInteger array_max(HSQUIRRELVM v)
+{
+	return _array_extreme(v,true);
+}
+
+//fill(value,[start,[end]])
+static SQInteger array_fill(HSQUIRRELVM v)
+{
+	SQArray *a = _array(stack_get(v,1));
+	SQObjectPtr &val = stack_get(v,2);
+	SQInteger n = a->Size();
+	SQInteger start = 0, end = n;
+	if(sq_gettop(v) > 2) start = tointeger(stack_get(v,3));
+	if(sq_gettop(v) > 3) end = tointeger(stack_get(v,4));
+	if(start < 0) start += n;
+	if(end < 0) end += n;
+	if(start < 0 || end > n || start > end)
+		return sq_throwerror(v,_SC("range out of bounds"));
+	SQ_GC_BARRIER(_ss(v),val);
+	for(SQInteger i = start; i < end; i++)
+		a->_values[i] = val;
+	return 0;
+}
+
+static void _arith_numbers(SQInteger op,const SQObject &a,const SQObject &b,SQObjectPtr &res)
+{
+	if(type(a) == OT_INTEGER && type(b) == OT_INTEGER) {
+		SQInteger x = _integer(a), y = _integer(b);
+		switch(op) {
+			case '+': res = x + y; break;
+			case '-': res = x - y; break;
+			default: res = x * y; break;
 		}
-		if(SQ_FAILED(sq_getinteger(v, -1, &ret))) {
-			v->Raise_Error(_SC("numeric value expected as return value of the compare function"));
-			return false;
+	}
+	else {
+		SQFloat x = tofloat(a), y = tofloat(b);
+		switch(op) {
+			case '+': res = x + y; break;
+			case '-': res = x - y; break;
+			default: res = x * y; break;
 		}
-		sq_settop(v, top);
-		return true;
 	}
-	return true;
 }
 
-bool _hsort_sift_down(HSQUIRRELVM v,SQArray *arr, SQInteger root, SQInteger bottom, SQInteger func)
+//applies 'op' in place with either a number or an array of the same size
+static SQInteger _array_arith(HSQUIRRELVM v,SQInteger op)
+{
+	SETUP_NUMERIC_ARRAY(v,a,allints);
+	SQObjectPtr &other = stack_get(v,2);
+	SQInteger n = a->Size();
+	SQObjectPtr *vals = a->_values._vals;
+	SQObject *rhs = NULL;
+	if(type(other) == OT_ARRAY) {
+		bool otherints;
+		if(_array(other)->Size() != n)
+			return sq_throwerror(v,_SC("the arrays have different sizes"));
+		if(!_array_isnumeric(_array(other),otherints))
+			return sq_throwerror(v,_SC("the array contains non numeric values"));
+		rhs = _array(other)->_values._vals;
+	}
+	else if(!sq_isnumeric(other))
+		return sq_throwerror(v,_SC("the operand must be a number or an array"));
+	for(SQInteger i = 0; i < n; i++)
+		_arith_numbers(op,vals[i],rhs ? rhs[i] : (const SQObject &)other,vals[i]);
+	v->Push(stack_get(v,1));
+	return 1;
+}
+
+static SQInteger array_add(HSQUIRRELVM v)
+{
+	return _array_arith(v,'+');
+}
+
+static SQInteger array_sub(HSQUIRRELVM v)
+{
+	return _array_arith(v,'-');
+}
+
+static SQInteger array_mul(HSQUIRRELVM v)
 {
-	SQInteger maxChild;
-	SQInteger done = 0;
-	SQInteger ret;
-	SQInteger root2;
-	while (((root2 = root * 2) <= bottom) && (!done))
+	return _array_arith(v,'*');
+}
+
+struct SQSortIntLess {
+	bool operator()(const SQObject &a,const SQObject &b,bool &lt) { lt = _integer(a) < _integer(b); return true; }
+};
+struct SQSortFloatLess {
+	bool operator()(const SQObject &a,const SQObject &b,bool &lt) { lt = _float(a) < _float(b); return true; }
+};
+struct SQSortStringLess {
+	bool operator()(const SQObject &a,const SQObject &b,bool &lt) { lt = _string(a) != _string(b) && scstrcmp(_stringval(a),_stringval(b)) < 0; return true; }
+};
+
+/* default ordering, may call _cmp metamethods */
+struct SQSortCmpLess {
+	SQSortCmpLess(SQVM *v) : _v(v) {}
+	bool operator()(const SQObject &a,const SQObject &b,bool &lt)
 	{
-		if (root2 == bottom) {
-			maxChild = root2;
-		}
-		else {
-			if(!_sort_compare(v,arr->_values[root2],arr->_values[root2 + 1],func,ret))
-				return false;
-			if (ret > 0) {
-				maxChild = root2;
-			}
-			else {
-				maxChild = root2 + 1;
-			}
-		}
+		SQInteger ret;
+		if(!_v->ObjCmp(SQObjectPtr(a),SQObjectPtr(b),ret)) return false;
+		lt = ret < 0;
+		return true;
+	}
+	SQVM *_v;
+};
 
-		if(!_sort_compare(v,arr->_values[root],arr->_values[maxChild],func,ret))
+/* user compare function, called straight through the VM rather than sq_call */
+struct SQSortFuncLess {
+	SQSortFuncLess(SQVM *v,const SQObjectPtr &func) : _v(v), _func(func) {}
+	bool operator()(const SQObject &a,const SQObject &b,bool &lt)
+	{
+		SQObjectPtr res;
+		_v->Push(_v->_roottable);
+		_v->Push(a);
+		_v->Push(b);
+		if(!_v->Call(_func,3,_v->_top-3,res,SQFalse)) {
+			_v->Pop(3);
+			if(!sq_isstring(_v->_lasterror))
+				_v->Raise_Error(_SC("compare func failed"));
 			return false;
-		if (ret < 0) {
-			if (root == maxChild) {
-                v->Raise_Error(_SC("inconsistent compare function"));
-                return false; // We'd be swapping ourselve. The compare function is incorrect
-            }
-
-			_Swap(arr->_values[root],arr->_values[maxChild]);
-			root = maxChild;
 		}
-		else {
-			done = 1;
+		_v->Pop(3);
+		if(!sq_isnumeric(res)) {
+			_v->Raise_Error(_SC("numeric value expected as return value of the compare function"));
+			return false;
 		}
+		lt = tointeger(res) < 0;
+		return true;
 	}
+	SQVM *_v;
+	SQObjectPtr _func;
+};
+
+/*
+	Arrays of integers, floats or strings alone are sorted in place with no
+	VM calls, so nothing else can run and the scratch pad can hold the merge
+	buffer.
+*/
+static bool _sort_homogeneous(HSQUIRRELVM v,SQArray *arr)
+{
+	SQInteger n = arr->Size();
+	SQObject *a = arr->_values._vals;
+	SQObjectType t = type(a[0]);
+	if(t != OT_INTEGER && t != OT_FLOAT && t != OT_STRING)
+		return false;
+	for(SQInteger i = 1; i < n; i++)
+		if(type(a[i]) != t) return false;
+	SQObject *tmp = (SQObject *)_ss(v)->GetScratchPad((n / 2 + 1) * sizeof(SQObject));
+	if(t == OT_INTEGER) { SQSortIntLess less; sq_mergesort(a,n,tmp,less); }
+	else if(t == OT_FLOAT) { SQSortFloatLess less; sq_mergesort(a,n,tmp,less); }
+	else { SQSortStringLess less; sq_mergesort(a,n,tmp,less); }
 	return true;
 }
 
-bool _hsort(HSQUIRRELVM v,SQObjectPtr &arr, SQInteger l, SQInteger r,SQInteger func)
+/*
+	Anything else may run script code while comparing, so a copy is sorted:
+	the compare function can't see or resize the array being sorted, the
+	copy keeps every element alive and the array is left untouched when the
+	comparison fails.
+*/
+static bool _sort_generic(HSQUIRRELVM v,SQArray *arr,SQInteger func)
 {
-	SQArray *a = _array(arr);
-	SQInteger i;
-	SQInteger array_size = a->Size();
-	for (i = (array_size / 2); i >= 0; i--) {
-		if(!_hsort_sift_down(v,a, i, array_size - 1,func)) return false;
+	SQInteger n = arr->Size();
+	SQArray *work = arr->Clone();
+	v->Push(SQObjectPtr(work));
+	SQObject *tmp = (SQObject *)SQ_MALLOC((n / 2 + 1) * sizeof(SQObject));
+	bool ok;
+	if(func < 0) {
+		SQSortCmpLess less(v);
+		ok = sq_mergesort(work->_values._vals,n,tmp,less);
 	}
-
-	for (i = array_size-1; i >= 1; i--)
-	{
-		_Swap(a->_values[0],a->_values[i]);
-		if(!_hsort_sift_down(v,a, 0, i-1,func)) return false;
+	else {
+		SQSortFuncLess less(v,stack_get(v,func));
+		ok = sq_mergesort(work->_values._vals,n,tmp,less);
 	}
-	return true;
+	SQ_FREE(tmp,(n / 2 + 1) * sizeof(SQObject));
+	if(ok && arr->Size() != n) {
+		v->Raise_Error(_SC("array resized during sort"));
+		ok = false;
+	}
+	if(ok) {
+		for(SQInteger i = 0; i < n; i++) {
+			SQ_GC_BARRIER(_ss(v),work->_values[i]);
+			_Swap(arr->_values[i],work->_values[i]);
+		}
+	}
+	v->Pop();
+	return ok;
 }
 
 static SQInteger array_sort(HSQUIRRELVM v)
 {
 	SQInteger func = -1;
 	SQObjectPtr &o = stack_get(v,1);
-	if(_array(o)->Size() > 1) {
+	SQArray *arr = _array(o);
+	if(arr->Size() > 1) {
 		if(sq_gettop(v) == 2) func = 2;
-		if(!_hsort(v, o, 0, _array(o)->Size()-1, func))
+		if(func < 0 && _sort_homogeneous(v,arr))
+			return 0;
+		if(!_sort_generic(v,arr,func))
 			return SQ_ERROR;
-
 	}
 	return 0;
 }
@@ -783,6 +1016,216 @@ SQRegFunction SQSharedState::_array_default_delegate_funcz[]={
 	{_SC("reduce"),array_reduce,2, _SC("ac")}, 
 	{_SC("filter"),array_filter,2, _SC("ac")},
 	{_SC("find"),array_find,2, _SC("a.")},
+	{_SC("sum"),array_sum,1, _SC("a")},
+	{_SC("min"),array_min,1, _SC("a")},
+	{_SC("max"),array_max,1, _SC("a")},
+	{_SC("fill"),array_fill,-2, _SC("a.nn")},
+	{_SC("add"),array_add,2, _SC("an|a")},
+	{_SC("sub"),array_sub,2, _SC("an|a")},
+	{_SC("mul"),array_mul,2, _SC("an|a")},
+	{0,0}
+};
+
+//TYPEDARRAY DEFAULT DELEGATE///////////////////////////////////
+
+static SQInteger typedarray_elementtype(HSQUIRRELVM v)
+{
+	v->Push(SQString::Create(_ss(v),SQTypedArray::TypeName(_typedarray(stack_get(v,1))->ElementType()),-1));
+	return 1;
+}
+
+template<typename T,typename A>
+static A _typed_sum(const T *vals,SQInteger n)
+{
+	A sum = 0;
+	for(SQInteger i = 0; i < n; i++)
+		sum += vals[i];
+	return sum;
+}
+
+static SQInteger typedarray_sum(HSQUIRRELVM v)
+{
+	SQTypedArray *a = _typedarray(stack_get(v,1));
+	switch(a->ElementType()) {
+		case SQTA_INT32: v->Push(_typed_sum<SQInt32,SQInteger>(a->Int32s(),a->Size())); break;
+		case SQTA_FLOAT32: v->Push((SQFloat)_typed_sum<float,double>(a->Float32s(),a->Size())); break;
+		default: v->Push((SQFloat)_typed_sum<double,double>(a->Float64s(),a->Size())); break;
+	}
+	return 1;
+}
+
+template<typename T>
+static SQInteger _typed_extreme(const T *vals,SQInteger n,bool greatest)
+{
+	SQInteger best = 0;
+	for(SQInteger i = 1; i < n; i++)
+		if(greatest ? vals[i] > vals[best] : vals[i] < vals[best])
+			best = i;
+	return best;
+}
+
+static SQInteger _typedarray_extreme(HSQUIRRELVM v,bool greatest)
+{
+	SQTypedArray *a = _typedarray(stack_get(v,1));
+	if(a->Size() == 0) return 0;
+	SQInteger best;
+	switch(a->ElementType()) {
+		case SQTA_INT32: best = _typed_extreme(a->Int32s(),a->Size(),greatest); break;
+		case SQTA_FLOAT32: best = _typed_extreme(a->Float32s(),a->Size(),greatest); break;
+		default: best = _typed_extreme(a->Float64s(),a->Size(),greatest); break;
+	}
+	SQObjectPtr val;
+	a->GetAt(best,val);
+	v->Push(val);
+	return 1;
+}
+
+static SQInteger typedarray_min(HSQUIRRELVM v)
+{
+	return _typedarray_extreme(v,false);
+}
+
+static SQInteger typedarray_max(HSQUIRRELVM v)
+{
+	return _typedarray_extreme(v,true);
+}
+
+//fill(value,[start,[end]])
+static SQInteger typedarray_fill(HSQUIRRELVM v)
+{
+	SQTypedArray *a = _typedarray(stack_get(v,1));
+	SQInteger n = a->Size();
+	SQInteger start = 0, end = n;
+	if(sq_gettop(v) > 2) start = tointeger(stack_get(v,3));
+	if(sq_gettop(v) > 3) end = tointeger(stack_get(v,4));
+	if(start < 0) start += n;
+	if(end < 0) end += n;
+	if(start < 0 || end > n || start > end)
+		return sq_throwerror(v,_SC("range out of bounds"));
+	if(start == end) return 0;
+	a->SetAt(start,stack_get(v,2));
+	SQInteger size = SQTypedArray::ElementSize(a->ElementType());
+	unsigned char *data = (unsigned char *)a->Data();
+	for(SQInteger i = start + 1; i < end; i++)
+		memcpy(data + i * size,data + start * size,size);
+	return 0;
+}
+
+template<typename T>
+static void _typed_arith(T *vals,SQInteger n,SQInteger op,const T *other)
+{
+	switch(op) {
+		case '+': for(SQInteger i = 0; i < n; i++) vals[i] = vals[i] + other[i]; break;
+		case '-': for(SQInteger i = 0; i < n; i++) vals[i] = vals[i] - other[i]; break;
+		default: for(SQInteger i = 0; i < n; i++) vals[i] = vals[i] * other[i]; break;
+	}
+}
+
+template<typename T>
+static void _typed_arith(T *vals,SQInteger n,SQInteger op,T scalar)
+{
+	switch(op) {
+		case '+': for(SQInteger i = 0; i < n; i++) vals[i] = vals[i] + scalar; break;
+		case '-': for(SQInteger i = 0; i < n; i++) vals[i] = vals[i] - scalar; break;
+		default: for(SQInteger i = 0; i < n; i++) vals[i] = vals[i] * scalar; break;
+	}
+}
+
+/*
+	applies 'op' in place with a number, an array or a typedarray of the
+	same size. Same typed operands and numbers that keep the element type
+	run on the packed values; anything else goes element by element with
+	the arithmetic operators' rules and is then stored back.
+*/
+static SQInteger _typedarray_arith(HSQUIRRELVM v,SQInteger op)
+{
+	SQTypedArray *a = _typedarray(stack_get(v,1));
+	SQObjectPtr &other = stack_get(v,2);
+	SQInteger n = a->Size();
+	SQTypedArrayType t = a->ElementType();
+	if(type(other) == OT_TYPEDARRAY || type(other) == OT_ARRAY) {
+		if(sq_getsize(v,2) != n)
+			return sq_throwerror(v,_SC("the arrays have different sizes"));
+	}
+	if(type(other) == OT_TYPEDARRAY && _typedarray(other)->ElementType() == t) {
+		SQTypedArray *b = _typedarray(other);
+		switch(t) {
+			case SQTA_INT32: _typed_arith((SQUnsignedInteger32 *)a->Int32s(),n,op,(const SQUnsignedInteger32 *)b->Int32s()); break;
+			case SQTA_FLOAT32: _typed_arith(a->Float32s(),n,op,(const float *)b->Float32s()); break;
+			default: _typed_arith(a->Float64s(),n,op,(const double *)b->Float64s()); break;
+		}
+	}
+	else if(type(other) == OT_INTEGER && t == SQTA_INT32) {
+		_typed_arith((SQUnsignedInteger32 *)a->Int32s(),n,op,(SQUnsignedInteger32)_integer(other));
+	}
+	else if(sq_isnumeric(other) && t != SQTA_INT32) {
+		if(t == SQTA_FLOAT32) _typed_arith(a->Float32s(),n,op,(float)tofloat(other));
+		else _typed_arith(a->Float64s(),n,op,type(other) == OT_INTEGER ? (double)_integer(other) : (double)_float(other));
+	}
+	else {
+		//checked up front so a bad element leaves the array untouched
+		if(type(other) == OT_ARRAY) {
+			for(SQInteger i = 0; i < n; i++) {
+				if(!sq_isnumeric(_array(other)->_values[i]))
+					return sq_throwerror(v,_SC("the array contains non numeric values"));
+			}
+		}
+		SQObjectPtr x,y,res;
+		for(SQInteger i = 0; i < n; i++) {
+			if(type(other) == OT_ARRAY) y = _array(other)->_values[i];
+			else if(type(other) == OT_TYPEDARRAY) _typedarray(other)->GetAt(i,y);
+			else y = other;
+			a->GetAt(i,x);
+			_arith_numbers(op,x,y,res);
+			a->SetAt(i,res);
+		}
+	}
+	v->Push(stack_get(v,1));
+	return 1;
+}
+
+static SQInteger typedarray_add(HSQUIRRELVM v)
+{
+	return _typedarray_arith(v,'+');
+}
+
+static SQInteger typedarray_sub(HSQUIRRELVM v)
+{
+	return _typedarray_arith(v,'-');
+}
+
+static SQInteger typedarray_mul(HSQUIRRELVM v)
+{
+	return _typedarray_arith(v,'*');
+}
+
+static SQInteger typedarray_toarray(HSQUIRRELVM v)
+{
+	SQTypedArray *a = _typedarray(stack_get(v,1));
+	SQInteger n = a->Size();
+	SQArray *arr = SQArray::Create(_ss(v),n);
+	SQObjectPtr val;
+	for(SQInteger i = 0; i < n; i++) {
+		a->GetAt(i,val);
+		arr->_values[i] = val;
+	}
+	v->Push(arr);
+	return 1;
+}
+
+SQRegFunction SQSharedState::_typedarray_default_delegate_funcz[]={
+	{_SC("len"),default_delegate_len,1, _SC("d")},
+	{_SC("elementtype"),typedarray_elementtype,1, _SC("d")},
+	{_SC("sum"),typedarray_sum,1, _SC("d")},
+	{_SC("min"),typedarray_min,1, _SC("d")},
+	{_SC("max"),typedarray_max,1, _SC("d")},
+	{_SC("fill"),typedarray_fill,-2, _SC("dnnn")},
+	{_SC("add"),typedarray_add,2, _SC("dn|a|d")},
+	{_SC("sub"),typedarray_sub,2, _SC("dn|a|d")},
+	{_SC("mul"),typedarray_mul,2, _SC("dn|a|d")},
+	{_SC("toarray"),typedarray_toarray,1, _SC("d")},
+	{_SC("weakref"),obj_delegate_weakref,1, NULL },
+	{_SC("tostring"),default_delegate_tostring,1, _SC(".")},
 	{0,0}
 };
 
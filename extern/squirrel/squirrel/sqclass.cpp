@@ -18,11 +18,13 @@ SQClass::SQClass(SQSharedState *ss,SQClass *base)
 	_udsize = 0;
 	_locked = false;
 	_constructoridx = -1;
+	_version = ++ss->_classversion;
 	if(_base) {
 		_constructoridx = _base->_constructoridx;
 		_udsize = _base->_udsize;
 		_defaultvalues.copy(base->_defaultvalues);
 		_methods.copy(base->_methods);
+		_properties.copy(base->_properties);
 		_COPY_VECTOR(_metamethods,base->_metamethods,MT_LAST);
 		__ObjAddRef(_base);
 	}
@@ -37,6 +39,7 @@ void SQClass::Finalize() {
 	_attributes.Null();
 	_defaultvalues.resize(0);
 	_methods.resize(0);
+	_properties.resize(0);
 	_NULL_SQOBJECT_VECTOR(_metamethods,MT_LAST);
 	__ObjRelease(_members);
 	if(_base) {
@@ -56,6 +59,7 @@ bool SQClass::NewSlot(SQSharedState *ss,const SQObjectPtr &key,const SQObjectPtr
 	bool belongs_to_static_table = type(val) == OT_CLOSURE || type(val) == OT_NATIVECLOSURE || bstatic;
 	if(_locked && !belongs_to_static_table) 
 		return false; //the class already has an instance so cannot be modified
+	Touch(ss);
 	if(_members->Get(key,temp) && _isfield(temp)) //overrides the default value
 	{
 		_defaultvalues[_member_idx(temp)].val = val;
@@ -98,9 +102,27 @@ bool SQClass::NewSlot(SQSharedState *ss,const SQObjectPtr &key,const SQObjectPtr
 	return true;
 }
 
-SQInstance *SQClass::CreateInstance()
+bool SQClass::NewProperty(SQSharedState *ss,const SQObjectPtr &key,const SQObjectPtr &getter,const SQObjectPtr &setter)
 {
-	if(!_locked) Lock();
+	SQObjectPtr temp;
+	if(_members->Get(key,temp)) {
+		if(!_isproperty(temp)) return false;
+	}
+	else {
+		temp = _make_property_idx(_properties.size());
+		_members->NewSlot(key,temp);
+		_properties.push_back(SQClassProperty());
+	}
+	SQClassProperty &p = _properties[_member_idx(temp)];
+	if(type(getter) != OT_NULL) p.getter = getter;
+	if(type(setter) != OT_NULL) p.setter = setter;
+	Touch(ss);
+	return true;
+}
+
+SQInstance *SQClass::CreateInstance(SQSharedState *ss)
+{
+	if(!_locked) Lock(ss);
 	return SQInstance::Create(_opt_ss(this),this);
 }
 
@@ -112,6 +134,9 @@ SQInteger SQClass::Next(const SQObjectPtr &refpos, SQObjectPtr &outkey, SQObject
 		if(_ismethod(oval)) {
 			outval = _methods[_member_idx(oval)].val;
 		}
+		else if(_isproperty(oval)) {
+			outval = _properties[_member_idx(oval)].getter;
+		}
 		else {
 			SQObjectPtr &o = _defaultvalues[_member_idx(oval)].val;
 			outval = _realval(o);
@@ -126,6 +151,8 @@ bool SQClass::SetAttributes(const SQObjectPtr &key,const SQObjectPtr &val)
 	if(_members->Get(key,idx)) {
 		if(_isfield(idx))
 			_defaultvalues[_member_idx(idx)].attrs = val;
+		else if(_isproperty(idx))
+			_properties[_member_idx(idx)].attrs = val;
 		else
 			_methods[_member_idx(idx)].attrs = val;
 		return true;
@@ -137,7 +164,10 @@ bool SQClass::GetAttributes(const SQObjectPtr &key,SQObjectPtr &outval)
 {
 	SQObjectPtr idx;
 	if(_members->Get(key,idx)) {
-		outval = (_isfield(idx)?_defaultvalues[_member_idx(idx)].attrs:_methods[_member_idx(idx)].attrs);
+		if(_isproperty(idx))
+			outval = _properties[_member_idx(idx)].attrs;
+		else
+			outval = (_isfield(idx)?_defaultvalues[_member_idx(idx)].attrs:_methods[_member_idx(idx)].attrs);
 		return true;
 	}
 	return false;
@@ -11,13 +11,25 @@ struct SQClassMember {
 
 typedef sqvector<SQClassMember> SQClassMemberVec;
 
+/* a member whose reads and writes call native accessors on the instance */
+struct SQClassProperty {
+	SQObjectPtr getter;
+	SQObjectPtr setter;
+	SQObjectPtr attrs;
+};
+
+typedef sqvector<SQClassProperty> SQClassPropertyVec;
+
 #define MEMBER_TYPE_METHOD 0x01000000
 #define MEMBER_TYPE_FIELD 0x02000000
+#define MEMBER_TYPE_PROPERTY 0x04000000
 
 #define _ismethod(o) (_integer(o)&MEMBER_TYPE_METHOD)
 #define _isfield(o) (_integer(o)&MEMBER_TYPE_FIELD)
+#define _isproperty(o) (_integer(o)&MEMBER_TYPE_PROPERTY)
 #define _make_method_idx(i) ((SQInteger)(MEMBER_TYPE_METHOD|i))
 #define _make_field_idx(i) ((SQInteger)(MEMBER_TYPE_FIELD|i))
+#define _make_property_idx(i) ((SQInteger)(MEMBER_TYPE_PROPERTY|i))
 #define _member_type(o) (_integer(o)&0xFF000000)
 #define _member_idx(o) (_integer(o)&0x00FFFFFF)
 
@@ -32,8 +44,12 @@ public:
 	}
 	~SQClass();
 	bool NewSlot(SQSharedState *ss, const SQObjectPtr &key,const SQObjectPtr &val,bool bstatic);
+	bool NewProperty(SQSharedState *ss, const SQObjectPtr &key,const SQObjectPtr &getter,const SQObjectPtr &setter);
 	bool Get(const SQObjectPtr &key,SQObjectPtr &val) {
 		if(_members->Get(key,val)) {
+			if(_isproperty(val)) {
+				return false;
+			}
 			if(_isfield(val)) {
 				SQObjectPtr &o = _defaultvalues[_member_idx(val)].val;
 				val = _realval(o);
@@ -55,7 +71,9 @@ public:
 	}
 	bool SetAttributes(const SQObjectPtr &key,const SQObjectPtr &val);
 	bool GetAttributes(const SQObjectPtr &key,SQObjectPtr &outval);
-	void Lock() { _locked = true; if(_base) _base->Lock(); }
+	void Lock(SQSharedState *ss) { _locked = true; Touch(ss); if(_base) _base->Lock(ss); }
+	/* invalidates inline caches holding members of this class */
+	void Touch(SQSharedState *ss) { _version = ++ss->_classversion; }
 	void Release() { 
 		if (_hook) { _hook(_typetag,0);}
 		sq_delete(this, SQClass);	
@@ -66,11 +84,12 @@ public:
 	SQObjectType GetType() {return OT_CLASS;}
 #endif
 	SQInteger Next(const SQObjectPtr &refpos, SQObjectPtr &outkey, SQObjectPtr &outval);
-	SQInstance *CreateInstance();
+	SQInstance *CreateInstance(SQSharedState *ss);
 	SQTable *_members;
 	SQClass *_base;
 	SQClassMemberVec _defaultvalues;
 	SQClassMemberVec _methods;
+	SQClassPropertyVec _properties;
 	SQObjectPtr _metamethods[MT_LAST];
 	SQObjectPtr _attributes;
 	SQUserPointer _typetag;
@@ -78,6 +97,7 @@ public:
 	bool _locked;
 	SQInteger _constructoridx;
 	SQInteger _udsize;
+	SQUnsignedInteger _version;
 };
 
 #define calcinstancesize(_theclass_) \
@@ -110,22 +130,28 @@ public:
 		return newinst;
 	}
 	~SQInstance();
+	/* properties need a VM to call their accessors, see SQVM::Get */
 	bool Get(const SQObjectPtr &key,SQObjectPtr &val)  {
-		if(_class->_members->Get(key,val)) {
-			if(_isfield(val)) {
-				SQObjectPtr &o = _values[_member_idx(val)];
-				val = _realval(o);
-			}
-			else {
-				val = _class->_methods[_member_idx(val)].val;
-			}
+		if(_class->_members->Get(key,val) && !_isproperty(val)) {
+			GetMember(_integer(val),val);
 			return true;
 		}
 		return false;
 	}
+	/* 'member' is the tagged index of a field or method in the class _members table */
+	void GetMember(SQInteger member,SQObjectPtr &val) {
+		if(member & MEMBER_TYPE_FIELD) {
+			SQObjectPtr &o = _values[member & 0x00FFFFFF];
+			val = _realval(o);
+		}
+		else {
+			val = _class->_methods[member & 0x00FFFFFF].val;
+		}
+	}
 	bool Set(const SQObjectPtr &key,const SQObjectPtr &val) {
 		SQObjectPtr idx;
 		if(_class->_members->Get(key,idx) && _isfield(idx)) {
+			SQ_GC_BARRIER(_sharedstate,val);
             _values[_member_idx(idx)] = val;
 			return true;
 		}
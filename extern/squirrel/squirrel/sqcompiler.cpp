@@ -10,6 +10,7 @@
 #include "sqfuncproto.h"
 #include "sqcompiler.h"
 #include "sqfuncstate.h"
+#include "sqoptimizer.h"
 #include "sqlexer.h"
 #include "sqvm.h"
 #include "sqtable.h"
@@ -70,12 +71,22 @@ struct SQScope {
 class SQCompiler
 {
 public:
-	SQCompiler(SQVM *v, SQLEXREADFUNC rg, SQUserPointer up, const SQChar* sourcename, bool raiseerror, bool lineinfo)
+	SQCompiler(SQVM *v, SQLEXREADFUNC rg, SQUserPointer up, const SQChar* sourcename, bool raiseerror, bool lineinfo, SQInteger optlevel)
 	{
-		_vm=v;
 		_lex.Init(_ss(v), rg, up,ThrowError,this);
+		Init(v, sourcename, raiseerror, lineinfo, optlevel);
+	}
+	SQCompiler(SQVM *v, const SQChar *buf, SQInteger size, const SQChar* sourcename, bool raiseerror, bool lineinfo, SQInteger optlevel)
+	{
+		_lex.Init(_ss(v), buf, size,ThrowError,this);
+		Init(v, sourcename, raiseerror, lineinfo, optlevel);
+	}
+	void Init(SQVM *v, const SQChar* sourcename, bool raiseerror, bool lineinfo, SQInteger optlevel)
+	{
+		_vm=v;
 		_sourcename = SQString::Create(_ss(v), sourcename);
 		_lineinfo = lineinfo;_raiseerror = raiseerror;
+		_optlevel = optlevel;
 		_scope.outers = 0;
 		_scope.stacksize = 0;
 		compilererror = NULL;
@@ -86,12 +97,11 @@ public:
 	}
 	void Error(const SQChar *s, ...)
 	{
-		static SQChar temp[256];
 		va_list vl;
 		va_start(vl, s);
-		scvsprintf(temp, s, vl);
+		scvsprintf(_errorbuf, s, vl);
 		va_end(vl);
-		compilererror = temp;
+		compilererror = _errorbuf;
 		longjmp(_errorjmp,1);
 	}
 	void Lex(){	_token = _lex.Lex();}
@@ -184,6 +194,7 @@ public:
 			_fs->AddLineInfos(_lex._currentline, _lineinfo, true);
 			_fs->AddInstruction(_OP_RETURN, 0xFF);
 			_fs->SetStackSize(0);
+			Optimize(_fs, _optlevel);
 			o =_fs->BuildProto();
 #ifdef _DEBUG_DUMP
 			_fs->Dump(_funcproto(o));
@@ -1452,6 +1463,7 @@ public:
 		funcstate->AddLineInfos(_lex._prevtoken == _SC('\n')?_lex._lasttokenline:_lex._currentline, _lineinfo, true);
         funcstate->AddInstruction(_OP_RETURN, -1);
 		funcstate->SetStackSize(0);
+		Optimize(funcstate, _optlevel);
 
 		SQFunctionProto *func = funcstate->BuildProto();
 #ifdef _DEBUG_DUMP
@@ -1488,18 +1500,26 @@ private:
 	SQLexer _lex;
 	bool _lineinfo;
 	bool _raiseerror;
+	SQInteger _optlevel;
 	SQInteger _debugline;
 	SQInteger _debugop;
 	SQExpState   _es;
 	SQScope _scope;
 	SQChar *compilererror;
+	SQChar _errorbuf[256]; //per compiler, so VMs can compile on several threads
 	jmp_buf _errorjmp;
 	SQVM *_vm;
 };
 
-bool Compile(SQVM *vm,SQLEXREADFUNC rg, SQUserPointer up, const SQChar *sourcename, SQObjectPtr &out, bool raiseerror, bool lineinfo)
+bool Compile(SQVM *vm,SQLEXREADFUNC rg, SQUserPointer up, const SQChar *sourcename, SQObjectPtr &out, bool raiseerror, bool lineinfo, SQInteger optlevel)
+{
+	SQCompiler p(vm, rg, up, sourcename, raiseerror, lineinfo, optlevel);
+	return p.Compile(out);
+}
+
+bool Compile(SQVM *vm,const SQChar *buf, SQInteger size, const SQChar *sourcename, SQObjectPtr &out, bool raiseerror, bool lineinfo, SQInteger optlevel)
 {
-	SQCompiler p(vm, rg, up, sourcename, raiseerror, lineinfo);
+	SQCompiler p(vm, buf, size, sourcename, raiseerror, lineinfo, optlevel);
 	return p.Compile(out);
 }
 
@@ -73,5 +73,6 @@ struct SQVM;
 
 
 typedef void(*CompilerErrorFunc)(void *ud, const SQChar *s);
-bool Compile(SQVM *vm, SQLEXREADFUNC rg, SQUserPointer up, const SQChar *sourcename, SQObjectPtr &out, bool raiseerror, bool lineinfo);
+bool Compile(SQVM *vm, SQLEXREADFUNC rg, SQUserPointer up, const SQChar *sourcename, SQObjectPtr &out, bool raiseerror, bool lineinfo, SQInteger optlevel);
+bool Compile(SQVM *vm, const SQChar *buf, SQInteger size, const SQChar *sourcename, SQObjectPtr &out, bool raiseerror, bool lineinfo, SQInteger optlevel);
 #endif //_SQCOMPILER_H_
@@ -48,6 +48,15 @@ struct SQLocalVarInfo
 
 struct SQLineInfo { SQInteger _line;SQInteger _op; };
 
+/* monomorphic cache of an instance member lookup, one per instruction */
+struct SQInlineCache
+{
+	SQClass *_class;
+	SQUnsignedInteger _version;
+	SQObjectPtr _key;
+	SQInteger _member;
+};
+
 typedef sqvector<SQOuterVar> SQOuterVarVec;
 typedef sqvector<SQLocalVarInfo> SQLocalVarInfoVec;
 typedef sqvector<SQLineInfo> SQLineInfoVec;
@@ -100,6 +109,10 @@ public:
 		return f;
 	}
 	void Release(){ 
+		if(_inlinecaches) {
+			_DESTRUCT_VECTOR(SQInlineCache,_ninstructions,_inlinecaches);
+			sq_vm_free(_inlinecaches,_ninstructions*sizeof(SQInlineCache));
+		}
 		_DESTRUCT_VECTOR(SQObjectPtr,_nliterals,_literals);
 		_DESTRUCT_VECTOR(SQObjectPtr,_nparameters,_parameters);
 		_DESTRUCT_VECTOR(SQObjectPtr,_nfunctions,_functions);
@@ -113,8 +126,18 @@ public:
 	
 	const SQChar* GetLocal(SQVM *v,SQUnsignedInteger stackbase,SQUnsignedInteger nseq,SQUnsignedInteger nop);
 	SQInteger GetLine(SQInstruction *curr);
+	SQInlineCache &GetInlineCache(SQInteger pc)
+	{
+		if(!_inlinecaches) {
+			_inlinecaches = (SQInlineCache *)sq_vm_malloc(_ninstructions*sizeof(SQInlineCache));
+			_CONSTRUCT_VECTOR(SQInlineCache,_ninstructions,_inlinecaches);
+		}
+		return _inlinecaches[pc];
+	}
 	bool Save(SQVM *v,SQUserPointer up,SQWRITEFUNC write);
 	static bool Load(SQVM *v,SQUserPointer up,SQREADFUNC read,SQObjectPtr &ret);
+	template<typename READER>
+	static bool Load(READER &reader,SQObjectPtr &ret);
 #ifndef NO_GARBAGE_COLLECTOR
 	void Mark(SQCollectable **chain);
 	void Finalize(){ _NULL_SQOBJECT_VECTOR(_literals,_nliterals); }
@@ -146,6 +169,8 @@ public:
 
 	SQInteger _ndefaultparams;
 	SQInteger *_defaultparams;
+
+	SQInlineCache *_inlinecaches;
 	
 	SQInteger _ninstructions;
 	SQInstruction _instructions[1];
@@ -73,6 +73,17 @@ SQInstructionDesc g_InstrDesc[]={
 	{_SC("_OP_NEWSLOTA")},
 	{_SC("_OP_GETBASE")},
 	{_SC("_OP_CLOSE")},
+	{_SC("_OP_JCMPK")},
+	{_SC("_OP_CALLK")},
+	{_SC("_OP_INCLJMP")},
+	{_SC("_OP_ADD_II")},
+	{_SC("_OP_ADD_FF")},
+	{_SC("_OP_SUB_II")},
+	{_SC("_OP_SUB_FF")},
+	{_SC("_OP_MUL_II")},
+	{_SC("_OP_MUL_FF")},
+	{_SC("_OP_JCMP_II")},
+	{_SC("_OP_JCMP_FF")},
 	{_SC("_OP_JCMP")}
 };
 #endif
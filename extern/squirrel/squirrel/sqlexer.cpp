@@ -4,6 +4,7 @@
 #include "sqpcheader.h"
 #include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
 #include "sqtable.h"
 #include "sqstring.h"
 #include "sqcompiler.h"
@@ -16,6 +17,8 @@
 #define INIT_TEMP_STRING() { _longstr.resize(0);}
 #define APPEND_CHAR(c) { _longstr.push_back(c);}
 #define TERMINATE_BUFFER() {_longstr.push_back(_SC('\0'));}
+#define APPEND_RANGE(b,e) { SQUnsignedInteger n = _longstr.size(); _longstr.resize(n + ((e) - (b))); memcpy(&_longstr[n], (b), ((e) - (b)) * sizeof(SQChar)); }
+#define IS_ID_CHAR(c) (scisalnum((LexChar)(c)) || (c) == _SC('_'))
 #define ADD_KEYWORD(key,id) _keywords->NewSlot( SQString::Create(ss, _SC(#key)) ,SQInteger(id))
 
 SQLexer::SQLexer(){}
@@ -24,7 +27,55 @@ SQLexer::~SQLexer()
 	_keywords->Release();
 }
 
+static const SQChar *ScanChar(const SQChar *s,const SQChar *end,SQChar c)
+{
+#ifdef SQUNICODE
+	while(s < end && *s != c) s++;
+	return s;
+#else
+	const SQChar *r = (const SQChar *)memchr(s, c, end - s);
+	return r ? r : end;
+#endif
+}
+
+static SQInteger CountChar(const SQChar *s,const SQChar *end,SQChar c)
+{
+	SQInteger n = 0;
+	while((s = ScanChar(s, end, c)) < end) { n++; s++; }
+	return n;
+}
+
 void SQLexer::Init(SQSharedState *ss, SQLEXREADFUNC rg, SQUserPointer up,CompilerErrorFunc efunc,void *ed)
+{
+	InitKeywords(ss, efunc, ed);
+	_readf = rg;
+	_up = up;
+	_bufpos = _bufend = NULL;
+	_lasttokenline = _currentline = 1;
+	_currentcolumn = 0;
+	_prevtoken = -1;
+	_reached_eof = SQFalse;
+	Next();
+}
+
+void SQLexer::Init(SQSharedState *ss, const SQChar *buf, SQInteger size,CompilerErrorFunc efunc,void *ed)
+{
+	InitKeywords(ss, efunc, ed);
+	_readf = NULL;
+	_up = NULL;
+	static const SQChar empty = 0;
+	if(!buf) { buf = &empty; size = 0; }
+	//the source ends at the first NUL, like it does for a read function returning 0
+	_bufpos = buf;
+	_bufend = ScanChar(buf, buf + size, 0);
+	_lasttokenline = _currentline = 1;
+	_currentcolumn = 0;
+	_prevtoken = -1;
+	_reached_eof = SQFalse;
+	Next();
+}
+
+void SQLexer::InitKeywords(SQSharedState *ss,CompilerErrorFunc efunc,void *ed)
 {
 	_errfunc = efunc;
 	_errtarget = ed;
@@ -65,14 +116,6 @@ void SQLexer::Init(SQSharedState *ss, SQLEXREADFUNC rg, SQUserPointer up,Compile
 	ADD_KEYWORD(static,TK_STATIC);
 	ADD_KEYWORD(enum,TK_ENUM);
 	ADD_KEYWORD(const,TK_CONST);
-
-	_readf = rg;
-	_up = up;
-	_lasttokenline = _currentline = 1;
-	_currentcolumn = 0;
-	_prevtoken = -1;
-	_reached_eof = SQFalse;
-	Next();
 }
 
 void SQLexer::Error(const SQChar *err)
@@ -82,6 +125,15 @@ void SQLexer::Error(const SQChar *err)
 
 void SQLexer::Next()
 {
+	if(_bufend) {
+		if(_bufpos < _bufend) {
+			_currdata = (LexChar)*_bufpos++;
+			return;
+		}
+		_currdata = SQUIRREL_EOB;
+		_reached_eof = SQTrue;
+		return;
+	}
 	SQInteger t = _readf(_up);
 	if(t > MAX_CHAR) Error(_SC("Invalid character"));
 	if(t != 0) {
@@ -92,6 +144,14 @@ void SQLexer::Next()
 	_reached_eof = SQTrue;
 }
 
+//buffer mode only: drops the characters up to 'to' as if NEXT() had been
+//called for each of them; the following NEXT() loads *to
+void SQLexer::Skip(const SQChar *to)
+{
+	_currentcolumn += to - _bufpos;
+	_bufpos = to;
+}
+
 const SQChar *SQLexer::Tok2Str(SQInteger tok)
 {
 	SQObjectPtr itr, key, val;
@@ -106,6 +166,24 @@ const SQChar *SQLexer::Tok2Str(SQInteger tok)
 
 void SQLexer::LexBlockComment()
 {
+	if(_bufend) {
+		if(IS_EOB()) Error(_SC("missing \"*/\" in comment"));
+		const SQChar *s = _bufpos - 1;
+		for(;;) {
+			const SQChar *star = ScanChar(s, _bufend, _SC('*'));
+			_currentline += CountChar(s, star, _SC('\n'));
+			if(star + 1 >= _bufend) {
+				Skip(_bufend);
+				NEXT();
+				Error(_SC("missing \"*/\" in comment"));
+			}
+			s = star + 1;
+			if(*s == _SC('/')) break;
+		}
+		Skip(s + 1);
+		NEXT();
+		return;
+	}
 	bool done = false;
 	while(!done) {
 		switch(CUR_CHAR) {
@@ -118,6 +196,11 @@ void SQLexer::LexBlockComment()
 }
 void SQLexer::LexLineComment()
 {
+	if(_bufend) {
+		if(!IS_EOB()) Skip(ScanChar(_bufpos, _bufend, _SC('\n')));
+		NEXT();
+		return;
+	}
 	do { NEXT(); } while (CUR_CHAR != _SC('\n') && (!IS_EOB()));
 }
 
@@ -126,7 +209,14 @@ SQInteger SQLexer::Lex()
 	_lasttokenline = _currentline;
 	while(CUR_CHAR != SQUIRREL_EOB) {
 		switch(CUR_CHAR){
-		case _SC('\t'): case _SC('\r'): case _SC(' '): NEXT(); continue;
+		case _SC('\t'): case _SC('\r'): case _SC(' '):
+			if(_bufend) {
+				const SQChar *s = _bufpos;
+				while(s < _bufend && (*s == _SC(' ') || *s == _SC('\t') || *s == _SC('\r'))) s++;
+				Skip(s);
+			}
+			NEXT();
+			continue;
 		case _SC('\n'):
 			_currentline++;
 			_prevtoken=_curtoken;
@@ -279,7 +369,7 @@ SQInteger SQLexer::Lex()
 SQInteger SQLexer::GetIDType(const SQChar *s,SQInteger len)
 {
 	SQObjectPtr t;
-	if(_keywords->GetStr(s,len, t)) {
+	if(_keywords->GetStr(s,len,_sharedstate->_hashseed,t)) {
 		return SQInteger(_integer(t));
 	}
 	return TK_IDENTIFIER;
@@ -342,6 +432,14 @@ SQInteger SQLexer::ReadString(SQInteger ndelim,bool verbatim)
 				}
 				break;
 			default:
+				if(_bufend) {
+					const SQChar *s = _bufpos - 1, *e = _bufpos;
+					while(e < _bufend && *e != ndelim && *e != _SC('\\') && *e != _SC('\n')) e++;
+					APPEND_RANGE(s, e);
+					Skip(e);
+					NEXT();
+					break;
+				}
 				APPEND_CHAR(CUR_CHAR);
 				NEXT();
 			}
@@ -476,10 +574,19 @@ SQInteger SQLexer::ReadID()
 {
 	SQInteger res;
 	INIT_TEMP_STRING();
-	do {
-		APPEND_CHAR(CUR_CHAR);
+	if(_bufend) {
+		const SQChar *s = _bufpos - 1, *e = _bufpos;
+		while(e < _bufend && IS_ID_CHAR(*e)) e++;
+		APPEND_RANGE(s, e);
+		Skip(e);
 		NEXT();
-	} while(scisalnum(CUR_CHAR) || CUR_CHAR == _SC('_'));
+	}
+	else {
+		do {
+			APPEND_CHAR(CUR_CHAR);
+			NEXT();
+		} while(IS_ID_CHAR(CUR_CHAR));
+	}
 	TERMINATE_BUFFER();
 	res = GetIDType(&_longstr[0],_longstr.size() - 1);
 	if(res == TK_IDENTIFIER || res == TK_CONSTRUCTOR) {
@@ -13,6 +13,7 @@ struct SQLexer
 	SQLexer();
 	~SQLexer();
 	void Init(SQSharedState *ss,SQLEXREADFUNC rg,SQUserPointer up,CompilerErrorFunc efunc,void *ed);
+	void Init(SQSharedState *ss,const SQChar *buf,SQInteger size,CompilerErrorFunc efunc,void *ed);
 	void Error(const SQChar *err);
 	SQInteger Lex();
 	const SQChar *Tok2Str(SQInteger tok);
@@ -24,6 +25,8 @@ private:
 	void LexLineComment();
 	SQInteger ReadID();
 	void Next();
+	void Skip(const SQChar *to);
+	void InitKeywords(SQSharedState *ss,CompilerErrorFunc efunc,void *ed);
 	SQInteger _curtoken;
 	SQTable *_keywords;
 	SQBool _reached_eof;
@@ -37,6 +40,9 @@ public:
 	SQFloat _fvalue;
 	SQLEXREADFUNC _readf;
 	SQUserPointer _up;
+	//buffer mode: _bufpos points past _currdata, no NUL before _bufend
+	const SQChar *_bufpos;
+	const SQChar *_bufend;
 	LexChar _currdata;
 	SQSharedState *_sharedstate;
 	sqvector<SQChar> _longstr;
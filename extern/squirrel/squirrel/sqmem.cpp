@@ -2,8 +2,293 @@
 	see copyright notice in squirrel.h
 */
 #include "sqpcheader.h"
-void *sq_vm_malloc(SQUnsignedInteger size){	return malloc(size); }
+#include <atomic>
+#include <mutex>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
 
-void *sq_vm_realloc(void *p, SQUnsignedInteger oldsize, SQUnsignedInteger size){ return realloc(p, size); }
+/*
+	Blocks carry no header: every SQ_FREE/SQ_REALLOC already knows the size.
+	With no allocator current, memory comes straight from the system heap.
+	Small blocks allocated while a pool is current are carved out of slab
+	aligned slabs, and a process wide slab map names the pool owning each
+	slab. Blocks can be freed while another pool (or none) is current; they
+	always return to their owner.
+	Large blocks are plain heap blocks, counted by whichever pool is current
+	when they are allocated, resized and freed.
+*/
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define SQ_THREAD_LOCAL __declspec(thread)
+#else
+#define SQ_THREAD_LOCAL thread_local
+#endif
+
+#define SQ_ALLOCATOR_MAXSMALL (SQ_ALLOCATOR_CLASSES*SQ_ALLOCATOR_GRANULARITY)
+#define SQ_ALLOCATOR_SLABSHIFT 16
+#define SQ_ALLOCATOR_SLABSIZE ((SQUnsignedInteger)1 << SQ_ALLOCATOR_SLABSHIFT)
+#define SQ_ALLOCATOR_SLABHEADER SQ_ALLOCATOR_GRANULARITY
+
+/* the slab map covers 48 bit addresses (32 on 32 bit targets) with a root and a leaf level */
+#define SQ_SLABMAP_LEAFBITS 16
+#define SQ_SLABMAP_ADDRESSBITS (sizeof(void *) == 8 ? 48 : 32)
+#define SQ_SLABMAP_ROOTSIZE ((size_t)1 << (SQ_SLABMAP_ADDRESSBITS - SQ_ALLOCATOR_SLABSHIFT - SQ_SLABMAP_LEAFBITS))
+
+struct SQFreeBlock {
+	SQFreeBlock *_next;
+};
+
+struct SQSlab {
+	SQSlab *_next;
+};
+
+struct SQSlabMapLeaf {
+	std::atomic<SQAllocator *> _owners[(size_t)1 << SQ_SLABMAP_LEAFBITS];
+};
+
+static std::atomic<SQSlabMapLeaf *> _slab_map[SQ_SLABMAP_ROOTSIZE];
+static std::mutex _slab_map_mutex;
+
+static std::atomic<SQAllocator *> *SlabMapEntry(const void *p, bool create)
+{
+	size_t slab = (size_t)p >> SQ_ALLOCATOR_SLABSHIFT;
+	size_t root = slab >> SQ_SLABMAP_LEAFBITS;
+	if(root >= SQ_SLABMAP_ROOTSIZE) return NULL;
+	SQSlabMapLeaf *leaf = _slab_map[root].load(std::memory_order_acquire);
+	if(!leaf && create) {
+		leaf = new (std::nothrow) SQSlabMapLeaf();
+		if(!leaf) return NULL;
+		_slab_map[root].store(leaf, std::memory_order_release);
+	}
+	return leaf ? &leaf->_owners[slab & (((size_t)1 << SQ_SLABMAP_LEAFBITS) - 1)] : NULL;
+}
+
+static void *AllocSlab()
+{
+#if defined(_WIN32)
+	return _aligned_malloc(SQ_ALLOCATOR_SLABSIZE, SQ_ALLOCATOR_SLABSIZE);
+#else
+	void *slab;
+	return posix_memalign(&slab, SQ_ALLOCATOR_SLABSIZE, SQ_ALLOCATOR_SLABSIZE) == 0 ? slab : NULL;
+#endif
+}
+
+static void FreeSlab(void *slab)
+{
+#if defined(_WIN32)
+	_aligned_free(slab);
+#else
+	free(slab);
+#endif
+}
+
+struct SQAllocator
+{
+	SQAllocator()
+	{
+		memset(&_stats,0,sizeof(_stats));
+		memset(_freelists,0,sizeof(_freelists));
+		_slabs = NULL;
+		_cursor = _end = NULL;
+		_blocks = 0;
+		_released = false;
+	}
+	~SQAllocator()
+	{
+		std::lock_guard<std::mutex> lock(_slab_map_mutex);
+		while(_slabs) {
+			SQSlab *next = _slabs->_next;
+			SlabMapEntry(_slabs, false)->store(NULL, std::memory_order_relaxed);
+			FreeSlab(_slabs);
+			_slabs = next;
+		}
+	}
+	static SQInteger SizeClass(SQUnsignedInteger size)
+	{
+		if(size > SQ_ALLOCATOR_MAXSMALL) return -1;
+		return size ? (SQInteger)((size - 1) / SQ_ALLOCATOR_GRANULARITY) : 0;
+	}
+	/* the pool owning a block of 'size' bytes, NULL for heap blocks */
+	static SQAllocator *Owner(const void *p, SQUnsignedInteger size)
+	{
+		if(size > SQ_ALLOCATOR_MAXSMALL) return NULL;
+		std::atomic<SQAllocator *> *entry = SlabMapEntry(p, false);
+		return entry ? entry->load(std::memory_order_relaxed) : NULL;
+	}
+	void *Alloc(SQUnsignedInteger size)
+	{
+		SQInteger sc = SizeClass(size);
+		void *block;
+		SQFreeBlock *fb = _freelists[sc];
+		if(fb) {
+			_freelists[sc] = fb->_next;
+			block = fb;
+		}
+		else {
+			block = Carve((sc + 1) * SQ_ALLOCATOR_GRANULARITY);
+			/* no slab to carve from: the block lives on the heap */
+			if(!block) return malloc(size);
+		}
+		_stats.class_live[sc]++;
+		_stats.class_allocs[sc]++;
+		_blocks++;
+		Track(0, size);
+		return block;
+	}
+	/* returns true if the allocator was released and this was its last block */
+	bool Free(void *block, SQUnsignedInteger size)
+	{
+		SQInteger sc = SizeClass(size);
+		SQFreeBlock *fb = (SQFreeBlock *)block;
+		fb->_next = _freelists[sc];
+		_freelists[sc] = fb;
+		_stats.class_live[sc]--;
+		Track(size, 0);
+		return --_blocks == 0 && _released;
+	}
+	void Track(SQUnsignedInteger oldsize, SQUnsignedInteger size)
+	{
+		_stats.bytes_live = (_stats.bytes_live > oldsize ? _stats.bytes_live - oldsize : 0) + size;
+		if(_stats.bytes_live > _stats.bytes_peak) _stats.bytes_peak = _stats.bytes_live;
+	}
+	/* a heap block changed from 'oldsize' to 'size' bytes while this pool was current */
+	void TrackLarge(SQUnsignedInteger oldsize, SQUnsignedInteger size)
+	{
+		if(oldsize <= SQ_ALLOCATOR_MAXSMALL) oldsize = 0;
+		if(size <= SQ_ALLOCATOR_MAXSMALL) size = 0;
+		if(oldsize == size) return;
+		_stats.large_bytes_live = (_stats.large_bytes_live > oldsize ? _stats.large_bytes_live - oldsize : 0) + size;
+		Track(oldsize, size);
+	}
+	void *Carve(SQUnsignedInteger chunk)
+	{
+		if(!_cursor || _cursor + chunk > _end) {
+			/* the tail of the previous slab is recycled into the freelists it fits */
+			while(_cursor && _end - _cursor >= SQ_ALLOCATOR_GRANULARITY) {
+				SQUnsignedInteger left = (SQUnsignedInteger)(_end - _cursor);
+				SQInteger sc = SizeClass(left < SQ_ALLOCATOR_MAXSMALL ? left : SQ_ALLOCATOR_MAXSMALL);
+				SQUnsignedInteger piece = (sc + 1) * SQ_ALLOCATOR_GRANULARITY;
+				if(piece > left) { sc--; piece -= SQ_ALLOCATOR_GRANULARITY; }
+				SQFreeBlock *fb = (SQFreeBlock *)_cursor;
+				fb->_next = _freelists[sc];
+				_freelists[sc] = fb;
+				_cursor += piece;
+			}
+			_cursor = _end = NULL;
+			SQSlab *slab = (SQSlab *)AllocSlab();
+			if(!slab) return NULL;
+			{
+				std::lock_guard<std::mutex> lock(_slab_map_mutex);
+				std::atomic<SQAllocator *> *entry = SlabMapEntry(slab, true);
+				if(!entry) {
+					FreeSlab(slab);
+					return NULL;
+				}
+				entry->store(this, std::memory_order_relaxed);
+				slab->_next = _slabs;
+				_slabs = slab;
+			}
+			_stats.bytes_reserved += SQ_ALLOCATOR_SLABSIZE;
+			_cursor = (unsigned char *)slab + SQ_ALLOCATOR_SLABHEADER;
+			_end = (unsigned char *)slab + SQ_ALLOCATOR_SLABSIZE;
+		}
+		void *ret = _cursor;
+		_cursor += chunk;
+		return ret;
+	}
+
+	SQAllocatorStats _stats;
+	SQFreeBlock *_freelists[SQ_ALLOCATOR_CLASSES];
+	SQSlab *_slabs;
+	unsigned char *_cursor;
+	unsigned char *_end;
+	SQUnsignedInteger _blocks;
+	bool _released;
+};
+
+static SQ_THREAD_LOCAL SQAllocator *_current_allocator = NULL;
+
+void *sq_vm_malloc(SQUnsignedInteger size)
+{
+	SQAllocator *current = _current_allocator;
+	if(!current) return malloc(size);
+	if(size <= SQ_ALLOCATOR_MAXSMALL) return current->Alloc(size);
+	void *p = malloc(size);
+	if(p) current->TrackLarge(0, size);
+	return p;
+}
+
+void sq_vm_free(void *p, SQUnsignedInteger size)
+{
+	if(!p) return;
+	SQAllocator *owner = SQAllocator::Owner(p, size);
+	if(owner) {
+		if(owner->Free(p, size)) delete owner;
+		return;
+	}
+	free(p);
+	if(_current_allocator) _current_allocator->TrackLarge(size, 0);
+}
+
+void *sq_vm_realloc(void *p, SQUnsignedInteger oldsize, SQUnsignedInteger size)
+{
+	if(!p) return sq_vm_malloc(size);
+	SQAllocator *owner = SQAllocator::Owner(p, oldsize);
+	if(!owner) {
+		void *newp = realloc(p, size);
+		if(newp && _current_allocator) _current_allocator->TrackLarge(oldsize, size);
+		return newp;
+	}
+	if(SQAllocator::SizeClass(size) == SQAllocator::SizeClass(oldsize)) {
+		owner->Track(oldsize, size);
+		return p;
+	}
+	/* grown or shrunk across a class: small blocks stay in the pool that owns them */
+	void *newp;
+	if(size <= SQ_ALLOCATOR_MAXSMALL) {
+		newp = owner->Alloc(size);
+	}
+	else {
+		newp = malloc(size);
+		if(newp && _current_allocator) _current_allocator->TrackLarge(0, size);
+	}
+	if(!newp) return NULL;
+	memcpy(newp, p, (size < oldsize ? size : oldsize));
+	if(owner->Free(p, oldsize)) delete owner;
+	return newp;
+}
+
+HSQALLOCATOR sq_newallocator()
+{
+	return new SQAllocator();
+}
+
+void sq_releaseallocator(HSQALLOCATOR a)
+{
+	if(_current_allocator == a) _current_allocator = NULL;
+	if(a->_blocks == 0) {
+		delete a;
+	}
+	else {
+		/* blocks still referenced elsewhere keep the pool alive until freed */
+		a->_released = true;
+	}
+}
+
+HSQALLOCATOR sq_setallocator(HSQALLOCATOR a)
+{
+	HSQALLOCATOR prev = _current_allocator;
+	_current_allocator = a;
+	return prev;
+}
+
+HSQALLOCATOR sq_getallocator()
+{
+	return _current_allocator;
+}
 
-void sq_vm_free(void *p, SQUnsignedInteger size){	free(p); }
+void sq_getallocatorstats(HSQALLOCATOR a, SQAllocatorStats *stats)
+{
+	*stats = a->_stats;
+}
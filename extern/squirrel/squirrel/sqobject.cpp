@@ -36,6 +36,7 @@ const SQChar *IdType2Name(SQObjectType type)
 	case _RT_INSTANCE: return _SC("instance");
 	case _RT_WEAKREF: return _SC("weakref");
 	case _RT_OUTER: return _SC("outer");
+	case _RT_TYPEDARRAY: return _SC("typedarray");
 	default:
 		return NULL;
 	}
@@ -88,6 +89,11 @@ SQWeakRef *SQRefCounted::GetWeakRef(SQObjectType type)
 		sq_new(_weakref,SQWeakRef);
 		_weakref->_obj._type = type;
 		_weakref->_obj._unVal.pRefCounted = this;
+#ifndef NO_GARBAGE_COLLECTOR
+		_weakref->_sharedstate = NULL;
+		if(type != OT_STRING && type != OT_WEAKREF)
+			static_cast<SQCollectable *>(this)->_sharedstate->AddWeakRef(_weakref);
+#endif
 	}
 	return _weakref;
 }
@@ -104,6 +110,9 @@ void SQWeakRef::Release() {
 	if(ISREFCOUNTED(_obj._type)) { 
 		_obj._unVal.pRefCounted->_weakref = NULL;
 	} 
+#ifndef NO_GARBAGE_COLLECTOR
+	if(_sharedstate) _sharedstate->RemoveWeakRef(this);
+#endif
 	sq_delete(this,SQWeakRef);
 }
 
@@ -122,7 +131,7 @@ bool SQDelegable::SetDelegate(SQTable *mt)
 		if (temp->_delegate == this) return false; //cycle detected
 		temp = temp->_delegate;
 	}
-	if (mt)	__ObjAddRef(mt);
+	if (mt)	{ __ObjAddRef(mt); SQ_GC_SHADE(_sharedstate,mt); }
 	__ObjRelease(_delegate);
 	_delegate = mt;
 	return true;
@@ -287,12 +296,67 @@ bool WriteTag(HSQUIRRELVM v,SQWRITEFUNC write,SQUserPointer up,SQUnsignedInteger
 	return SafeWrite(v,write,up,&tag,sizeof(tag));
 }
 
-bool CheckTag(HSQUIRRELVM v,SQWRITEFUNC read,SQUserPointer up,SQUnsignedInteger32 tag)
+//reads a closure stream through a user supplied SQREADFUNC
+struct SQCallbackReader
+{
+	SQCallbackReader(SQVM *v,SQUserPointer up,SQREADFUNC read):_v(v),_up(up),_read(read){}
+	bool Read(SQUserPointer dest,SQInteger size) { return SafeRead(_v,_read,_up,dest,size); }
+	bool Fits(SQInteger count,SQInteger) { return count >= 0; }
+	bool ReadString(SQObjectPtr &o,SQInteger len)
+	{
+		_CHECK_IO(Read(_ss(_v)->GetScratchPad(rsl(len)),rsl(len)));
+		o=SQString::Create(_ss(_v),_ss(_v)->GetScratchPad(-1),len);
+		return true;
+	}
+	SQVM *_v;
+	SQUserPointer _up;
+	SQREADFUNC _read;
+};
+
+//reads a closure stream straight out of a contiguous (e.g. memory mapped) buffer;
+//strings are hashed in place and only copied if they are not interned yet
+struct SQBufferReader
+{
+	SQBufferReader(SQVM *v,const void *buffer,SQInteger size):_v(v),_cur((const unsigned char *)buffer),_end(_cur+size){}
+	bool Read(SQUserPointer dest,SQInteger size)
+	{
+		if(!Fits(size,1)) return false;
+		memcpy(dest,_cur,size);
+		_cur+=size;
+		return true;
+	}
+	bool Fits(SQInteger count,SQInteger elemsize)
+	{
+		if(count < 0 || count > (_end - _cur) / elemsize) {
+			_v->Raise_Error(_SC("io error, the origin stream could be corrupted/trucated"));
+			return false;
+		}
+		return true;
+	}
+	bool ReadString(SQObjectPtr &o,SQInteger len)
+	{
+		_CHECK_IO(Fits(len,sizeof(SQChar)));
+#ifdef SQUNICODE
+		memcpy(_ss(_v)->GetScratchPad(rsl(len)),_cur,rsl(len));
+		o=SQString::Create(_ss(_v),_ss(_v)->GetScratchPad(-1),len);
+#else
+		o=SQString::Create(_ss(_v),(const SQChar *)_cur,len);
+#endif
+		_cur+=rsl(len);
+		return true;
+	}
+	SQVM *_v;
+	const unsigned char *_cur;
+	const unsigned char *_end;
+};
+
+template<typename READER>
+bool CheckTag(READER &reader,SQUnsignedInteger32 tag)
 {
 	SQUnsignedInteger32 t;
-	_CHECK_IO(SafeRead(v,read,up,&t,sizeof(t)));
+	_CHECK_IO(reader.Read(&t,sizeof(t)));
 	if(t != tag){
-		v->Raise_Error(_SC("invalid or corrupted closure stream"));
+		reader._v->Raise_Error(_SC("invalid or corrupted closure stream"));
 		return false;
 	}
 	return true;
@@ -320,32 +384,33 @@ bool WriteObject(HSQUIRRELVM v,SQUserPointer up,SQWRITEFUNC write,SQObjectPtr &o
 	return true;
 }
 
-bool ReadObject(HSQUIRRELVM v,SQUserPointer up,SQREADFUNC read,SQObjectPtr &o)
+template<typename READER>
+bool ReadObject(READER &reader,SQObjectPtr &o)
 {
 	SQUnsignedInteger32 _type;
-	_CHECK_IO(SafeRead(v,read,up,&_type,sizeof(_type)));
+	_CHECK_IO(reader.Read(&_type,sizeof(_type)));
 	SQObjectType t = (SQObjectType)_type;
 	switch(t){
 	case OT_STRING:{
 		SQInteger len;
-		_CHECK_IO(SafeRead(v,read,up,&len,sizeof(SQInteger)));
-		_CHECK_IO(SafeRead(v,read,up,_ss(v)->GetScratchPad(rsl(len)),rsl(len)));
-		o=SQString::Create(_ss(v),_ss(v)->GetScratchPad(-1),len);
+		_CHECK_IO(reader.Read(&len,sizeof(SQInteger)));
+		_CHECK_IO(reader.Fits(len,sizeof(SQChar)));
+		_CHECK_IO(reader.ReadString(o,len));
 				   }
 		break;
 	case OT_INTEGER:{
 		SQInteger i;
-		_CHECK_IO(SafeRead(v,read,up,&i,sizeof(SQInteger))); o = i; break;
+		_CHECK_IO(reader.Read(&i,sizeof(SQInteger))); o = i; break;
 					}
 	case OT_FLOAT:{
 		SQFloat f;
-		_CHECK_IO(SafeRead(v,read,up,&f,sizeof(SQFloat))); o = f; break;
+		_CHECK_IO(reader.Read(&f,sizeof(SQFloat))); o = f; break;
 				  }
 	case OT_NULL:
 		o.Null();
 		break;
 	default:
-		v->Raise_Error(_SC("cannot serialize a %s"),IdType2Name(t));
+		reader._v->Raise_Error(_SC("cannot serialize a %s"),IdType2Name(t));
 		return false;
 	}
 	return true;
@@ -362,24 +427,39 @@ bool SQClosure::Save(SQVM *v,SQUserPointer up,SQWRITEFUNC write)
 	return true;
 }
 
-bool SQClosure::Load(SQVM *v,SQUserPointer up,SQREADFUNC read,SQObjectPtr &ret)
+template<typename READER>
+static bool LoadClosure(READER &reader,SQObjectPtr &ret)
 {
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_HEAD));
-	_CHECK_IO(CheckTag(v,read,up,sizeof(SQChar)));
-	_CHECK_IO(CheckTag(v,read,up,sizeof(SQInteger)));
-	_CHECK_IO(CheckTag(v,read,up,sizeof(SQFloat)));
+	SQVM *v = reader._v;
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_HEAD));
+	_CHECK_IO(CheckTag(reader,sizeof(SQChar)));
+	_CHECK_IO(CheckTag(reader,sizeof(SQInteger)));
+	_CHECK_IO(CheckTag(reader,sizeof(SQFloat)));
 	SQObjectPtr func;
-	_CHECK_IO(SQFunctionProto::Load(v,up,read,func));
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_TAIL));
+	_CHECK_IO(SQFunctionProto::Load(reader,func));
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_TAIL));
 	ret = SQClosure::Create(_ss(v),_funcproto(func),_table(v->_roottable)->GetWeakRef(OT_TABLE));
 	//FIXME: load an root for this closure
 	return true;
 }
 
+bool SQClosure::Load(SQVM *v,SQUserPointer up,SQREADFUNC read,SQObjectPtr &ret)
+{
+	SQCallbackReader reader(v,up,read);
+	return LoadClosure(reader,ret);
+}
+
+bool SQClosure::LoadBuffer(SQVM *v,const void *buffer,SQInteger size,SQObjectPtr &ret)
+{
+	SQBufferReader reader(v,buffer,size);
+	return LoadClosure(reader,ret);
+}
+
 SQFunctionProto::SQFunctionProto(SQSharedState *ss)
 {
 	_stacksize=0;
 	_bgenerator=false;
+	_inlinecaches=NULL;
 	INIT_CHAIN();ADD_TO_CHAIN(&_ss(this)->_gc_chain,this);
 }
 
@@ -439,7 +519,11 @@ bool SQFunctionProto::Save(SQVM *v,SQUserPointer up,SQWRITEFUNC write)
 	_CHECK_IO(SafeWrite(v,write,up,_defaultparams,sizeof(SQInteger)*ndefaultparams));
 
 	_CHECK_IO(WriteTag(v,write,up,SQ_CLOSURESTREAM_PART));
-	_CHECK_IO(SafeWrite(v,write,up,_instructions,sizeof(SQInstruction)*ninstructions));
+	//quickened opcodes only make sense to the vm that rewrote them
+	SQInstructionVec generic;
+	generic.resize(ninstructions);
+	for(i=0;i<ninstructions;i++) generic[i] = GenericInstruction(_instructions[i]);
+	_CHECK_IO(SafeWrite(v,write,up,&generic[0],sizeof(SQInstruction)*ninstructions));
 
 	_CHECK_IO(WriteTag(v,write,up,SQ_CLOSURESTREAM_PART));
 	for(i=0;i<nfunctions;i++){
@@ -451,27 +535,33 @@ bool SQFunctionProto::Save(SQVM *v,SQUserPointer up,SQWRITEFUNC write)
 	return true;
 }
 
-bool SQFunctionProto::Load(SQVM *v,SQUserPointer up,SQREADFUNC read,SQObjectPtr &ret)
+template<typename READER>
+bool SQFunctionProto::Load(READER &reader,SQObjectPtr &ret)
 {
+	SQVM *v = reader._v;
 	SQInteger i, nliterals,nparameters;
 	SQInteger noutervalues ,nlocalvarinfos ;
 	SQInteger nlineinfos,ninstructions ,nfunctions,ndefaultparams ;
 	SQObjectPtr sourcename, name;
 	SQObjectPtr o;
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_PART));
-	_CHECK_IO(ReadObject(v, up, read, sourcename));
-	_CHECK_IO(ReadObject(v, up, read, name));
-	
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_PART));
-	_CHECK_IO(SafeRead(v,read,up, &nliterals, sizeof(nliterals)));
-	_CHECK_IO(SafeRead(v,read,up, &nparameters, sizeof(nparameters)));
-	_CHECK_IO(SafeRead(v,read,up, &noutervalues, sizeof(noutervalues)));
-	_CHECK_IO(SafeRead(v,read,up, &nlocalvarinfos, sizeof(nlocalvarinfos)));
-	_CHECK_IO(SafeRead(v,read,up, &nlineinfos, sizeof(nlineinfos)));
-	_CHECK_IO(SafeRead(v,read,up, &ndefaultparams, sizeof(ndefaultparams)));
-	_CHECK_IO(SafeRead(v,read,up, &ninstructions, sizeof(ninstructions)));
-	_CHECK_IO(SafeRead(v,read,up, &nfunctions, sizeof(nfunctions)));
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_PART));
+	_CHECK_IO(ReadObject(reader, sourcename));
+	_CHECK_IO(ReadObject(reader, name));
 	
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_PART));
+	_CHECK_IO(reader.Read(&nliterals, sizeof(nliterals)));
+	_CHECK_IO(reader.Read(&nparameters, sizeof(nparameters)));
+	_CHECK_IO(reader.Read(&noutervalues, sizeof(noutervalues)));
+	_CHECK_IO(reader.Read(&nlocalvarinfos, sizeof(nlocalvarinfos)));
+	_CHECK_IO(reader.Read(&nlineinfos, sizeof(nlineinfos)));
+	_CHECK_IO(reader.Read(&ndefaultparams, sizeof(ndefaultparams)));
+	_CHECK_IO(reader.Read(&ninstructions, sizeof(ninstructions)));
+	_CHECK_IO(reader.Read(&nfunctions, sizeof(nfunctions)));
+	_CHECK_IO(reader.Fits(nliterals,sizeof(SQUnsignedInteger32)) && reader.Fits(nparameters,sizeof(SQUnsignedInteger32)));
+	_CHECK_IO(reader.Fits(noutervalues,sizeof(SQUnsignedInteger)) && reader.Fits(nlocalvarinfos,sizeof(SQUnsignedInteger)));
+	_CHECK_IO(reader.Fits(nlineinfos,sizeof(SQLineInfo)) && reader.Fits(ndefaultparams,sizeof(SQInteger)));
+	_CHECK_IO(reader.Fits(ninstructions,sizeof(SQInstruction)) && reader.Fits(nfunctions,sizeof(SQUnsignedInteger32)));
+
 
 	SQFunctionProto *f = SQFunctionProto::Create(_opt_ss(v),ninstructions,nliterals,nparameters,
 			nfunctions,noutervalues,nlineinfos,nlocalvarinfos,ndefaultparams);
@@ -479,71 +569,98 @@ bool SQFunctionProto::Load(SQVM *v,SQUserPointer up,SQREADFUNC read,SQObjectPtr
 	f->_sourcename = sourcename;
 	f->_name = name;
 
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_PART));
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_PART));
 
 	for(i = 0;i < nliterals; i++){
-		_CHECK_IO(ReadObject(v, up, read, o));
+		_CHECK_IO(ReadObject(reader, o));
 		f->_literals[i] = o;
 	}
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_PART));
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_PART));
 
 	for(i = 0; i < nparameters; i++){
-		_CHECK_IO(ReadObject(v, up, read, o));
+		_CHECK_IO(ReadObject(reader, o));
 		f->_parameters[i] = o;
 	}
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_PART));
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_PART));
 
 	for(i = 0; i < noutervalues; i++){
 		SQUnsignedInteger type;
 		SQObjectPtr name;
-		_CHECK_IO(SafeRead(v,read,up, &type, sizeof(SQUnsignedInteger)));
-		_CHECK_IO(ReadObject(v, up, read, o));
-		_CHECK_IO(ReadObject(v, up, read, name));
+		_CHECK_IO(reader.Read(&type, sizeof(SQUnsignedInteger)));
+		_CHECK_IO(ReadObject(reader, o));
+		_CHECK_IO(ReadObject(reader, name));
 		f->_outervalues[i] = SQOuterVar(name,o, (SQOuterType)type);
 	}
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_PART));
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_PART));
 
 	for(i = 0; i < nlocalvarinfos; i++){
 		SQLocalVarInfo lvi;
-		_CHECK_IO(ReadObject(v, up, read, lvi._name));
-		_CHECK_IO(SafeRead(v,read,up, &lvi._pos, sizeof(SQUnsignedInteger)));
-		_CHECK_IO(SafeRead(v,read,up, &lvi._start_op, sizeof(SQUnsignedInteger)));
-		_CHECK_IO(SafeRead(v,read,up, &lvi._end_op, sizeof(SQUnsignedInteger)));
+		_CHECK_IO(ReadObject(reader, lvi._name));
+		_CHECK_IO(reader.Read(&lvi._pos, sizeof(SQUnsignedInteger)));
+		_CHECK_IO(reader.Read(&lvi._start_op, sizeof(SQUnsignedInteger)));
+		_CHECK_IO(reader.Read(&lvi._end_op, sizeof(SQUnsignedInteger)));
 		f->_localvarinfos[i] = lvi;
 	}
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_PART));
-	_CHECK_IO(SafeRead(v,read,up, f->_lineinfos, sizeof(SQLineInfo)*nlineinfos));
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_PART));
+	_CHECK_IO(reader.Read(f->_lineinfos, sizeof(SQLineInfo)*nlineinfos));
 
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_PART));
-	_CHECK_IO(SafeRead(v,read,up, f->_defaultparams, sizeof(SQInteger)*ndefaultparams));
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_PART));
+	_CHECK_IO(reader.Read(f->_defaultparams, sizeof(SQInteger)*ndefaultparams));
 
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_PART));
-	_CHECK_IO(SafeRead(v,read,up, f->_instructions, sizeof(SQInstruction)*ninstructions));
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_PART));
+	_CHECK_IO(reader.Read(f->_instructions, sizeof(SQInstruction)*ninstructions));
 
-	_CHECK_IO(CheckTag(v,read,up,SQ_CLOSURESTREAM_PART));
+	_CHECK_IO(CheckTag(reader,SQ_CLOSURESTREAM_PART));
 	for(i = 0; i < nfunctions; i++){
-		_CHECK_IO(_funcproto(o)->Load(v, up, read, o));
+		_CHECK_IO(Load(reader, o));
 		f->_functions[i] = o;
 	}
-	_CHECK_IO(SafeRead(v,read,up, &f->_stacksize, sizeof(f->_stacksize)));
-	_CHECK_IO(SafeRead(v,read,up, &f->_bgenerator, sizeof(f->_bgenerator)));
-	_CHECK_IO(SafeRead(v,read,up, &f->_varparams, sizeof(f->_varparams)));
+	_CHECK_IO(reader.Read(&f->_stacksize, sizeof(f->_stacksize)));
+	_CHECK_IO(reader.Read(&f->_bgenerator, sizeof(f->_bgenerator)));
+	_CHECK_IO(reader.Read(&f->_varparams, sizeof(f->_varparams)));
 	
 	ret = f;
 	return true;
 }
 
+bool SQFunctionProto::Load(SQVM *v,SQUserPointer up,SQREADFUNC read,SQObjectPtr &ret)
+{
+	SQCallbackReader reader(v,up,read);
+	return Load(reader,ret);
+}
+
 #ifndef NO_GARBAGE_COLLECTOR
 
-#define START_MARK() 	if(!(_uiRef&MARK_FLAG)){ \
-		_uiRef|=MARK_FLAG;
+/*
+	chain == NULL only shades the object: it is marked and pushed to the
+	gray stack. chain == SQ_GC_SCAN runs the body on a gray object with a
+	NULL chain, which shades its children and leaves it black. Any other
+	chain marks the whole graph at once and moves it there.
+*/
+#define START_MARK() 	if(chain == NULL) { \
+		if(!(_uiRef&MARK_FLAG)) { \
+			_uiRef|=MARK_FLAG; \
+			_sharedstate->_gcgray.push_back(this); \
+		} \
+	} \
+	else if(chain == SQ_GC_SCAN || !(_uiRef&MARK_FLAG)) { \
+		SQCollectable **_parentchain = chain; \
+		if(chain == SQ_GC_SCAN) chain = NULL; \
+		else _uiRef|=MARK_FLAG;
+
+#define END_MARK() if(_parentchain != SQ_GC_SCAN) { \
+			RemoveFromChain(&_sharedstate->_gc_chain, this); \
+			AddToChain(chain, this); \
+		} \
+	}
 
-#define END_MARK() RemoveFromChain(&_sharedstate->_gc_chain, this); \
-		AddToChain(chain, this); }
+/* stores into these aren't covered by the write barrier */
+#define RESCAN_MARK() if(!chain) _sharedstate->_gcrescan.push_back(this);
 
 void SQVM::Mark(SQCollectable **chain)
 {
 	START_MARK()
+		RESCAN_MARK()
 		SQSharedState::MarkObject(_lasterror,chain);
 		SQSharedState::MarkObject(_errorhandler,chain);
 		SQSharedState::MarkObject(_debughook_closure,chain);
@@ -567,8 +684,14 @@ void SQTable::Mark(SQCollectable **chain)
 		if(_delegate) _delegate->Mark(chain);
 		SQInteger len = _numofnodes;
 		for(SQInteger i = 0; i < len; i++){
+#ifdef SQ_SWISS_TABLE
+			if(!SQ_CTRL_ISFULL(_ctrl[i])) continue;
+			SQSharedState::MarkObject(_keys[i], chain);
+			SQSharedState::MarkObject(_vals[i], chain);
+#else
 			SQSharedState::MarkObject(_nodes[i].key, chain);
 			SQSharedState::MarkObject(_nodes[i].val, chain);
+#endif
 		}
 	END_MARK()
 }
@@ -576,6 +699,7 @@ void SQTable::Mark(SQCollectable **chain)
 void SQClass::Mark(SQCollectable **chain)
 {
 	START_MARK()
+		RESCAN_MARK()
 		_members->Mark(chain);
 		if(_base) _base->Mark(chain);
 		SQSharedState::MarkObject(_attributes, chain);
@@ -587,6 +711,11 @@ void SQClass::Mark(SQCollectable **chain)
 			SQSharedState::MarkObject(_methods[j].val, chain);
 			SQSharedState::MarkObject(_methods[j].attrs, chain);
 		}
+		for(SQUnsignedInteger p =0; p< _properties.size(); p++) {
+			SQSharedState::MarkObject(_properties[p].getter, chain);
+			SQSharedState::MarkObject(_properties[p].setter, chain);
+			SQSharedState::MarkObject(_properties[p].attrs, chain);
+		}
 		for(SQUnsignedInteger k =0; k< MT_LAST; k++) {
 			SQSharedState::MarkObject(_metamethods[k], chain);
 		}
@@ -607,6 +736,7 @@ void SQInstance::Mark(SQCollectable **chain)
 void SQGenerator::Mark(SQCollectable **chain)
 {
 	START_MARK()
+		RESCAN_MARK()
 		for(SQUnsignedInteger i = 0; i < _stack.size(); i++) SQSharedState::MarkObject(_stack[i], chain);
 		SQSharedState::MarkObject(_closure, chain);
 	END_MARK()
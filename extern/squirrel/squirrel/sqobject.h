@@ -16,6 +16,8 @@
 
 struct SQSharedState;
 
+typedef unsigned long long SQHash64; //string hashes are computed in 64 bits on every platform
+
 enum SQMetaMethod{
 	MT_ADD=0,
 	MT_SUB=1,
@@ -99,6 +101,13 @@ struct SQWeakRef : SQRefCounted
 {
 	void Release();
 	SQObject _obj;
+#ifndef NO_GARBAGE_COLLECTOR
+	/* weak references to collectable objects are listed in their shared state,
+	   so an incremental collection can clear the ones to unreachable objects */
+	SQSharedState *_sharedstate;
+	SQWeakRef *_next;
+	SQWeakRef *_prev;
+#endif
 };
 
 #define _realval(o) (type((o)) != OT_WEAKREF?(SQObject)o:_weakref(o)->_obj)
@@ -149,6 +158,7 @@ struct SQObjectPtr;
 #define _delegable(obj) ((SQDelegable *)(obj)._unVal.pDelegable)
 #define _weakref(obj) ((obj)._unVal.pWeakRef)
 #define _outer(obj) ((obj)._unVal.pOuter)
+#define _typedarray(obj) ((obj)._unVal.pTypedArray)
 #define _refcounted(obj) ((obj)._unVal.pRefCounted)
 #define _rawval(obj) ((obj)._unVal.raw)
 
@@ -236,6 +246,7 @@ struct SQObjectPtr : public SQObject
 	_REF_TYPE_DECL(OT_WEAKREF,SQWeakRef,pWeakRef)
 	_REF_TYPE_DECL(OT_THREAD,SQVM,pThread)
 	_REF_TYPE_DECL(OT_FUNCPROTO,SQFunctionProto,pFunctionProto)
+	_REF_TYPE_DECL(OT_TYPEDARRAY,SQTypedArray,pTypedArray)
 	
 	_SCALAR_TYPE_DECL(OT_INTEGER,SQInteger,nInteger)
 	_SCALAR_TYPE_DECL(OT_FLOAT,SQFloat,fFloat)
@@ -311,6 +322,13 @@ inline void _Swap(SQObject &a,SQObject &b)
 /////////////////////////////////////////////////////////////////////////////////////
 #ifndef NO_GARBAGE_COLLECTOR
 #define MARK_FLAG 0x80000000
+/*
+	Mark(chain) moves the object and everything it reaches to 'chain'
+	(stop-the-world collection). The incremental collector instead calls
+	Mark(NULL) to shade a white object gray and Mark(SQ_GC_SCAN) to
+	blacken a gray one, shading its children.
+*/
+#define SQ_GC_SCAN ((SQCollectable **)1)
 struct SQCollectable : public SQRefCounted {
 	SQCollectable *_next;
 	SQCollectable *_prev;
@@ -100,6 +100,17 @@ enum SQOpcode
 	_OP_NEWSLOTA=			0x3A,
 	_OP_GETBASE=			0x3B,
 	_OP_CLOSE=				0x3C,
+	_OP_JCMPK=				0x3D,
+	_OP_CALLK=				0x3E,
+	_OP_INCLJMP=			0x3F,
+	_OP_ADD_II=				0x40,
+	_OP_ADD_FF=				0x41,
+	_OP_SUB_II=				0x42,
+	_OP_SUB_FF=				0x43,
+	_OP_MUL_II=				0x44,
+	_OP_MUL_FF=				0x45,
+	_OP_JCMP_II=			0x46,
+	_OP_JCMP_FF=			0x47,
 };							  
 
 struct SQInstructionDesc {	  
@@ -123,10 +134,38 @@ struct SQInstruction
 	unsigned char _arg3;
 };
 
+/*
+	ADD, SUB, MUL and JCMP rewrite themselves at run time into the _II/_FF
+	variant matching their operands, and back on a mismatch. The number of
+	times a site fell back is kept in the high bits of arg3; past
+	QUICKEN_MAX_DEOPTS it stays generic.
+*/
+#define QUICKEN_DEOPT_SHIFT		3
+#define QUICKEN_MAX_DEOPTS		4
+#define QUICKEN_ARG3_MASK		0x07
+
+//the instruction as the compiler emitted it
+inline SQInstruction GenericInstruction(SQInstruction i)
+{
+	switch(i.op) {
+	case _OP_ADD_II: case _OP_ADD_FF: i.op = _OP_ADD; break;
+	case _OP_SUB_II: case _OP_SUB_FF: i.op = _OP_SUB; break;
+	case _OP_MUL_II: case _OP_MUL_FF: i.op = _OP_MUL; break;
+	case _OP_JCMP_II: case _OP_JCMP_FF: i.op = _OP_JCMP; break;
+	case _OP_ADD: case _OP_SUB: case _OP_MUL: case _OP_JCMP: break;
+	default: return i;
+	}
+	i._arg3 &= QUICKEN_ARG3_MASK;
+	return i;
+}
+
 #include "squtils.h"
 typedef sqvector<SQInstruction> SQInstructionVec;
 
 #define NEW_SLOT_ATTRIBUTES_FLAG	0x01
 #define NEW_SLOT_STATIC_FLAG		0x02
 
+//set in the nargs operand of _OP_CALLK when the call result is not stored
+#define CALLK_DISCARD_RESULT		0x80
+
 #endif // _SQOPCODES_H_
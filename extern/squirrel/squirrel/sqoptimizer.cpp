@@ -0,0 +1,862 @@
+/*
+	see copyright notice in squirrel.h
+*/
+#include "sqpcheader.h"
+#ifndef NO_COMPILER
+#include <math.h>
+#include "sqcompiler.h"
+#include "sqstring.h"
+#include "sqfuncproto.h"
+#include "sqtable.h"
+#include "sqopcodes.h"
+#include "sqfuncstate.h"
+#include "sqoptimizer.h"
+
+#define MAX_REGISTERS (MAX_FUNC_STACKSIZE + 1)
+#define MIN_INTEGER ((SQInteger)((SQUnsignedInteger)1 << (sizeof(SQInteger) * 8 - 1)))
+
+//one bit per stack register of a function
+struct SQRegSet
+{
+	void Clear() { memset(_bits,0,sizeof(_bits)); }
+	void Fill() { memset(_bits,0xFF,sizeof(_bits)); }
+	void Add(SQInteger r) { if(r >= 0 && r < MAX_REGISTERS) _bits[r >> 5] |= (1u << (r & 31)); }
+	void AddRange(SQInteger r,SQInteger n) { for(SQInteger i = 0; i < n; i++) Add(r + i); }
+	void Remove(SQInteger r) { if(r >= 0 && r < MAX_REGISTERS) _bits[r >> 5] &= ~(1u << (r & 31)); }
+	bool Has(SQInteger r) const { return r >= 0 && r < MAX_REGISTERS && (_bits[r >> 5] & (1u << (r & 31))) != 0; }
+	bool Intersects(const SQRegSet &o) const {
+		for(SQInteger i = 0; i < MAX_REGISTERS / 32; i++) if(_bits[i] & o._bits[i]) return true;
+		return false;
+	}
+	void Union(const SQRegSet &o) { for(SQInteger i = 0; i < MAX_REGISTERS / 32; i++) _bits[i] |= o._bits[i]; }
+	void Subtract(const SQRegSet &o) { for(SQInteger i = 0; i < MAX_REGISTERS / 32; i++) _bits[i] &= ~o._bits[i]; }
+	bool operator==(const SQRegSet &o) const { return memcmp(_bits,o._bits,sizeof(_bits)) == 0; }
+	SQUnsignedInteger32 _bits[MAX_REGISTERS / 32];
+};
+
+typedef sqvector<SQRegSet> SQRegSetVec;
+typedef sqvector<bool> SQBoolVec;
+
+//the instruction 'pc' jumps to, or -1 for instructions that never jump
+static SQInteger JumpTarget(const SQInstruction &i,SQInteger pc)
+{
+	switch(i.op) {
+	case _OP_JMP: case _OP_JCMP: case _OP_JCMPK: case _OP_JZ: case _OP_AND: case _OP_OR:
+	case _OP_PUSHTRAP: case _OP_FOREACH: case _OP_INCLJMP:
+		return pc + 1 + i._arg1;
+	case _OP_POSTFOREACH:
+		return pc + i._arg1;
+	default:
+		return -1;
+	}
+}
+
+static bool IsFalseConstant(const SQObjectPtr &o)
+{
+	switch(type(o)) {
+	case OT_NULL: return true;
+	case OT_INTEGER: case OT_BOOL: return _integer(o) == 0;
+	case OT_FLOAT: return _float(o) == SQFloat(0.0);
+	default: return false;
+	}
+}
+
+static bool CanBeLiteral(const SQObjectPtr &o)
+{
+	switch(type(o)) {
+	case OT_INTEGER: case OT_FLOAT: case OT_BOOL: case OT_STRING: return true;
+	default: return false;
+	}
+}
+
+//loads that can be moved above a member lookup without changing what the script sees;
+//a _get metamethod run by the lookup may write outers, so those are never moved
+static bool IsHoistable(SQInteger op)
+{
+	switch(op) {
+	case _OP_LOAD: case _OP_LOADINT: case _OP_LOADFLOAT: case _OP_LOADBOOL: case _OP_DLOAD:
+	case _OP_LOADNULLS: case _OP_LOADROOT: case _OP_MOVE: case _OP_DMOVE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//same rules as SQVM::IsEqual
+static bool IsEqualConstant(const SQObjectPtr &a,const SQObjectPtr &b)
+{
+	if(type(a) == type(b)) return _rawval(a) == _rawval(b);
+	if(sq_isnumeric(a) && sq_isnumeric(b)) return tofloat(a) == tofloat(b);
+	return false;
+}
+
+//same rules as SQVM::ObjCmp, restricted to numbers and strings
+static bool FoldCompare(SQInteger op,const SQObjectPtr &a,const SQObjectPtr &b,SQObjectPtr &res)
+{
+	SQObjectType ta = type(a), tb = type(b);
+	SQInteger r;
+	if(ta == tb && _rawval(a) == _rawval(b) && (sq_isnumeric(a) || ta == OT_STRING)) r = 0;
+	else if(ta == OT_INTEGER && tb == OT_INTEGER) r = _integer(a) < _integer(b) ? -1 : 1;
+	else if(ta == OT_FLOAT && tb == OT_FLOAT) r = _float(a) < _float(b) ? -1 : 1;
+	else if(ta == OT_INTEGER && tb == OT_FLOAT) r = _integer(a) == _float(b) ? 0 : (_integer(a) < _float(b) ? -1 : 1);
+	else if(ta == OT_FLOAT && tb == OT_INTEGER) r = _float(a) == _integer(b) ? 0 : (_float(a) < _integer(b) ? -1 : 1);
+	else if(ta == OT_STRING && tb == OT_STRING) r = scstrcmp(_stringval(a),_stringval(b));
+	else return false;
+	switch(op) {
+	case CMP_G: res = (r > 0); return true;
+	case CMP_GE: res = (r >= 0); return true;
+	case CMP_L: res = (r < 0); return true;
+	case CMP_LE: res = (r <= 0); return true;
+	case CMP_3W: res = r; return true;
+	}
+	return false;
+}
+
+static bool FoldBitwise(SQInteger op,SQInteger x,SQInteger y,SQObjectPtr &res)
+{
+	switch(op) {
+	case BW_AND: res = x & y; return true;
+	case BW_OR: res = x | y; return true;
+	case BW_XOR: res = x ^ y; return true;
+	}
+	//shift counts out of range behave as the cpu does, leave them to the vm
+	if(y < 0 || y >= (SQInteger)(sizeof(SQInteger) * 8)) return false;
+	switch(op) {
+	case BW_SHIFTL: res = (SQInteger)((SQUnsignedInteger)x << y); return true;
+	case BW_SHIFTR: res = x >> y; return true;
+	case BW_USHIFTR: res = (SQInteger)((SQUnsignedInteger)x >> y); return true;
+	}
+	return false;
+}
+
+static bool FoldUnary(SQInteger op,const SQObjectPtr &o,SQObjectPtr &res)
+{
+	if(type(o) == OT_INTEGER) {
+		res = op == _OP_NEG ? (SQInteger)(0 - (SQUnsignedInteger)_integer(o)) : ~_integer(o);
+		return true;
+	}
+	if(op == _OP_NEG && type(o) == OT_FLOAT) {
+		res = -_float(o);
+		return true;
+	}
+	return false;
+}
+
+class SQOptimizer
+{
+public:
+	SQOptimizer(SQFuncState *fs,SQInteger level) : _fs(fs), _code(fs->_instructions), _level(level), _hastraps(false) {}
+	void Run()
+	{
+		SQInteger n = _code.size();
+		_removed.resize(n,false);
+		for(SQInteger pc = 0; pc < n; pc++) {
+			if(_code[pc].op == _OP_PUSHTRAP) _hastraps = true;
+		}
+		CollectLiterals();
+		CollectCaptured();
+		FoldConstants();
+		RemoveUnreachable();
+		RemoveLines();
+		//a store inside a try block may be read by the catch block, liveness does not follow those edges
+		if(!_hastraps) while(EliminateDeadStores());
+		if(_level >= SQ_OPT_FULL) {
+			FuseInstructions();
+			if(!_hastraps) while(EliminateDeadStores());
+		}
+		Compact();
+	}
+private:
+	void CollectLiterals()
+	{
+		_literals.resize(_fs->_nliterals);
+		SQObjectPtr refidx,key,val;
+		SQInteger idx;
+		while((idx = _table(_fs->_literals)->Next(false,refidx,key,val)) != -1) {
+			_literals[_integer(val)] = key;
+			refidx = idx;
+		}
+	}
+	SQInteger GetLiteral(const SQObjectPtr &o)
+	{
+		SQInteger idx = _fs->GetConstant(o);
+		if(idx >= (SQInteger)_literals.size()) _literals.resize(idx + 1);
+		_literals[idx] = o;
+		return idx;
+	}
+	//locals of this function that a nested closure refers to; any call can change them
+	void CollectCaptured()
+	{
+		_captured.Clear();
+		for(SQUnsignedInteger f = 0; f < _fs->_functions.size(); f++) {
+			SQFunctionProto *proto = _funcproto(_fs->_functions[f]);
+			for(SQInteger o = 0; o < proto->_noutervalues; o++) {
+				if(proto->_outervalues[o]._type == otLOCAL) _captured.Add(_integer(proto->_outervalues[o]._src));
+			}
+		}
+	}
+	void Remove(SQInteger pc) { _removed[pc] = true; }
+	SQInteger Successors(SQInteger pc,SQInteger *succ)
+	{
+		const SQInstruction &i = _code[pc];
+		if(_removed[pc]) {
+			succ[0] = pc + 1;
+			return 1;
+		}
+		switch(i.op) {
+		case _OP_JMP: case _OP_INCLJMP:
+			succ[0] = JumpTarget(i,pc);
+			return 1;
+		case _OP_RETURN: case _OP_THROW:
+			return 0;
+		case _OP_FOREACH: //pc + 1 resumes generators, pc + 2 is the loop body
+			succ[0] = pc + 1;
+			succ[1] = pc + 2;
+			succ[2] = JumpTarget(i,pc);
+			return 3;
+		default: {
+			SQInteger target = JumpTarget(i,pc);
+			succ[0] = pc + 1;
+			if(target == -1) return 1;
+			succ[1] = target;
+			return 2;
+			}
+		}
+	}
+	//first instruction of every basic block; a removed leader passes the mark to the next one
+	void ComputeLeaders()
+	{
+		SQInteger n = _code.size(), succ[3];
+		_leaders.resize(0);
+		_leaders.resize(n,false);
+		if(n > 0) _leaders[0] = true;
+		for(SQInteger pc = 0; pc < n; pc++) {
+			if(_removed[pc]) continue;
+			SQInteger ns = Successors(pc,succ);
+			if(ns == 1 && succ[0] == pc + 1) continue;
+			for(SQInteger s = 0; s < ns; s++) {
+				if(succ[s] < n) _leaders[succ[s]] = true;
+			}
+		}
+		for(SQInteger pc = 0; pc < n - 1; pc++) {
+			if(_removed[pc] && _leaders[pc]) _leaders[pc + 1] = true;
+		}
+	}
+	void ClosureUses(const SQInstruction &i,SQRegSet &uses)
+	{
+		SQFunctionProto *proto = _funcproto(_fs->_functions[i._arg1]);
+		for(SQInteger o = 0; o < proto->_noutervalues; o++) {
+			if(proto->_outervalues[o]._type == otLOCAL) uses.Add(_integer(proto->_outervalues[o]._src));
+		}
+		for(SQInteger p = 0; p < proto->_ndefaultparams; p++) uses.Add(proto->_defaultparams[p]);
+	}
+	//registers an instruction reads and the ones it always overwrites
+	void Effects(const SQInstruction &i,SQRegSet &uses,SQRegSet &defs)
+	{
+		uses.Clear();
+		defs.Clear();
+		switch(i.op) {
+		case _OP_LINE: case _OP_JMP: case _OP_POPTRAP: case _OP_CLOSE: case _OP_PUSHTRAP:
+			break;
+		case _OP_LOAD: case _OP_LOADINT: case _OP_LOADFLOAT: case _OP_LOADBOOL:
+		case _OP_LOADROOT: case _OP_GETBASE: case _OP_GETOUTER:
+			defs.Add(i._arg0);
+			break;
+		case _OP_DLOAD:
+			defs.Add(i._arg0);
+			defs.Add(i._arg2);
+			break;
+		case _OP_LOADNULLS:
+			defs.AddRange(i._arg0,i._arg1);
+			break;
+		case _OP_MOVE:
+			uses.Add(i._arg1);
+			defs.Add(i._arg0);
+			break;
+		case _OP_DMOVE:
+			uses.Add(i._arg1);
+			uses.Add(i._arg3);
+			defs.Add(i._arg0);
+			defs.Add(i._arg2);
+			break;
+		case _OP_CALL: case _OP_TAILCALL:
+			uses.Add(i._arg1);
+			uses.AddRange(i._arg2,i._arg3);
+			if(i._arg0 != 0xFF) defs.Add(i._arg0);
+			break;
+		case _OP_PREPCALL:
+			uses.Add(i._arg1);
+			uses.Add(i._arg2);
+			defs.Add(i._arg0);
+			defs.Add(i._arg3);
+			break;
+		case _OP_PREPCALLK:
+			uses.Add(i._arg2);
+			defs.Add(i._arg0);
+			defs.Add(i._arg3);
+			break;
+		case _OP_GETK:
+			uses.Add(i._arg2);
+			defs.Add(i._arg0);
+			break;
+		case _OP_GET: case _OP_ADD: case _OP_SUB: case _OP_MUL: case _OP_DIV: case _OP_MOD:
+		case _OP_BITW: case _OP_CMP: case _OP_EXISTS: case _OP_INSTANCEOF: case _OP_DELETE:
+		case _OP_INC: case _OP_PINC:
+			uses.Add(i._arg1);
+			uses.Add(i._arg2);
+			defs.Add(i._arg0);
+			break;
+		case _OP_EQ: case _OP_NE:
+			uses.Add(i._arg2);
+			if(i._arg3 == 0) uses.Add(i._arg1);
+			defs.Add(i._arg0);
+			break;
+		case _OP_SET: case _OP_NEWSLOT:
+			uses.Add(i._arg1);
+			uses.Add(i._arg2);
+			uses.Add(i._arg3);
+			if(i._arg0 != 0xFF) defs.Add(i._arg0);
+			break;
+		case _OP_NEWSLOTA:
+			uses.Add(i._arg1);
+			uses.Add(i._arg2);
+			uses.Add(i._arg3);
+			if(i._arg0 & NEW_SLOT_ATTRIBUTES_FLAG) uses.Add(i._arg2 - 1);
+			break;
+		case _OP_RETURN:
+			if(i._arg0 != 0xFF) uses.Add(i._arg1);
+			break;
+		case _OP_JCMP:
+			uses.Add(i._arg0);
+			uses.Add(i._arg2);
+			break;
+		case _OP_JZ: case _OP_POSTFOREACH: case _OP_THROW: case _OP_INCLJMP:
+			uses.Add(i._arg0);
+			break;
+		case _OP_SETOUTER:
+			uses.Add(i._arg2);
+			if(i._arg0 != 0xFF) defs.Add(i._arg0);
+			break;
+		case _OP_NEWOBJ:
+			if(i._arg3 == NOT_CLASS) {
+				if(i._arg1 != -1) uses.Add(i._arg1);
+				if(i._arg2 != MAX_FUNC_STACKSIZE) uses.Add(i._arg2);
+			}
+			defs.Add(i._arg0);
+			break;
+		case _OP_APPENDARRAY:
+			uses.Add(i._arg0);
+			if(i._arg2 == AAT_STACK) uses.Add(i._arg1);
+			break;
+		case _OP_COMPARITH:
+			uses.Add(((SQUnsignedInteger)i._arg1 & 0xFFFF0000) >> 16);
+			uses.Add(i._arg1 & 0x0000FFFF);
+			uses.Add(i._arg2);
+			defs.Add(i._arg0);
+			break;
+		case _OP_INCL: case _OP_AND: case _OP_OR:
+			uses.Add(i.op == _OP_INCL ? i._arg1 : i._arg2);
+			break;
+		case _OP_PINCL: case _OP_NEG: case _OP_NOT: case _OP_BWNOT: case _OP_CLONE:
+		case _OP_TYPEOF: case _OP_RESUME:
+			uses.Add(i._arg1);
+			defs.Add(i._arg0);
+			break;
+		case _OP_CLOSURE:
+			ClosureUses(i,uses);
+			defs.Add(i._arg0);
+			break;
+		case _OP_FOREACH:
+			uses.Add(i._arg0);
+			uses.AddRange(i._arg2,3);
+			break;
+		case _OP_JCMPK:
+			uses.Add(i._arg2);
+			break;
+		case _OP_CALLK:
+			uses.Add(i._arg2);
+			uses.AddRange(i._arg0 + 2,(i._arg3 & ~CALLK_DISCARD_RESULT) - 1);
+			defs.Add(i._arg0);
+			defs.Add(i._arg0 + 1);
+			break;
+		default: //yield saves the whole frame
+			uses.Fill();
+			break;
+		}
+	}
+	//registers an instruction may change besides its defs, including the callee frame of a call
+	void AddClobbers(const SQInstruction &i,SQRegSet &defs)
+	{
+		switch(i.op) {
+		case _OP_CALL: case _OP_TAILCALL: defs.AddRange(i._arg2,MAX_REGISTERS - i._arg2); break;
+		case _OP_CALLK: defs.AddRange(i._arg0,MAX_REGISTERS - i._arg0); break;
+		case _OP_FOREACH: defs.AddRange(i._arg2,3); break;
+		case _OP_AND: case _OP_OR: case _OP_INCLJMP: defs.Add(i._arg0); break;
+		case _OP_INCL: case _OP_PINCL: defs.Add(i._arg1); break;
+		case _OP_YIELD: case _OP_RESUME: defs.Fill(); break;
+		default: break;
+		}
+	}
+	void SetConstant(SQRegSet &known,SQInteger r,const SQObjectPtr &val)
+	{
+		if(r < 0 || r >= MAX_REGISTERS) return;
+		_consts[r] = val;
+		known.Add(r);
+	}
+	void CopyConstant(SQRegSet &known,SQInteger dst,SQInteger src)
+	{
+		if(known.Has(src)) SetConstant(known,dst,_consts[src]);
+		else known.Remove(dst);
+	}
+	SQObjectPtr LoadedValue(const SQInstruction &i)
+	{
+		switch(i.op) {
+		case _OP_LOADINT:
+#ifndef _SQ64
+			return SQObjectPtr((SQInteger)i._arg1);
+#else
+			return SQObjectPtr((SQInteger)((SQUnsignedInteger32)i._arg1));
+#endif
+		case _OP_LOADFLOAT: {
+			SQFloat f = 0;
+			memcpy(&f,&i._arg1,sizeof(SQInt32));
+			return SQObjectPtr(f);
+			}
+		case _OP_LOADBOOL: return SQObjectPtr(i._arg1 ? true : false);
+		default: return _literals[i._arg1];
+		}
+	}
+	//replaces the instruction at 'pc' with the cheapest load of 'val', as the compiler would emit it
+	void EmitLoad(SQInteger pc,SQInteger target,const SQObjectPtr &val)
+	{
+		SQInstruction &i = _code[pc];
+		switch(type(val)) {
+		case OT_NULL:
+			i = SQInstruction(_OP_LOADNULLS,target,1);
+			return;
+		case OT_BOOL:
+			i = SQInstruction(_OP_LOADBOOL,target,_integer(val));
+			return;
+		case OT_INTEGER:
+			if((_integer(val) & (~((SQInteger)0xFFFFFFFF))) == 0) {
+				i = SQInstruction(_OP_LOADINT,target,_integer(val));
+				return;
+			}
+			break;
+		case OT_FLOAT:
+			if(sizeof(SQFloat) == sizeof(SQInt32)) {
+				SQFloat f = _float(val);
+				SQInt32 bits;
+				memcpy(&bits,&f,sizeof(bits));
+				i = SQInstruction(_OP_LOADFLOAT,target,bits);
+				return;
+			}
+			break;
+		default:
+			break;
+		}
+		i = SQInstruction(_OP_LOAD,target,GetLiteral(val));
+	}
+	bool FoldArith(const SQInstruction &i,const SQObjectPtr &a,const SQObjectPtr &b,SQObjectPtr &res)
+	{
+		SQInteger tmask = type(a) | type(b);
+		if(tmask == OT_INTEGER) {
+			SQInteger x = _integer(a), y = _integer(b);
+			switch(i.op) {
+			case _OP_ADD: res = (SQInteger)((SQUnsignedInteger)x + (SQUnsignedInteger)y); return true;
+			case _OP_SUB: res = (SQInteger)((SQUnsignedInteger)x - (SQUnsignedInteger)y); return true;
+			case _OP_MUL: res = (SQInteger)((SQUnsignedInteger)x * (SQUnsignedInteger)y); return true;
+			case _OP_DIV: case _OP_MOD:
+				//the script still gets its 'division by zero' error at run time
+				if(y == 0 || (y == -1 && x == MIN_INTEGER)) return false;
+				res = i.op == _OP_DIV ? x / y : x % y;
+				return true;
+			case _OP_BITW:
+				return FoldBitwise(i._arg3,x,y,res);
+			}
+			return false;
+		}
+		if(i.op != _OP_BITW && (tmask == OT_FLOAT || tmask == (OT_FLOAT | OT_INTEGER))) {
+			SQFloat x = tofloat(a), y = tofloat(b);
+			switch(i.op) {
+			case _OP_ADD: res = x + y; return true;
+			case _OP_SUB: res = x - y; return true;
+			case _OP_MUL: res = x * y; return true;
+			case _OP_DIV: res = x / y; return true;
+			case _OP_MOD: res = SQFloat(fmod((double)x,(double)y)); return true;
+			}
+			return false;
+		}
+		if(i.op == _OP_ADD && tmask == OT_STRING) {
+			SQInteger la = _string(a)->_len, lb = _string(b)->_len;
+			SQChar *s = _fs->_sharedstate->GetScratchPad(rsl(la + lb + 1));
+			memcpy(s,_stringval(a),rsl(la));
+			memcpy(s + la,_stringval(b),rsl(lb));
+			res = _fs->CreateString(s,la + lb);
+			return true;
+		}
+		return false;
+	}
+	void FoldEquality(SQRegSet &known,SQInteger pc)
+	{
+		SQInstruction &i = _code[pc];
+		bool literal = i._arg3 != 0;
+		if(known.Has(i._arg2) && (literal || known.Has(i._arg1))) {
+			bool res = IsEqualConstant(_consts[i._arg2],literal ? _literals[i._arg1] : _consts[i._arg1]);
+			if(i.op == _OP_NE) res = !res;
+			SQInteger target = i._arg0;
+			EmitLoad(pc,target,SQObjectPtr(res));
+			SetConstant(known,target,SQObjectPtr(res));
+			return;
+		}
+		//compare against the literal table instead of a register loaded with a constant
+		if(!literal) {
+			if(known.Has(i._arg1) && CanBeLiteral(_consts[i._arg1])) {
+				i._arg1 = (SQInt32)GetLiteral(_consts[i._arg1]);
+				i._arg3 = MAX_FUNC_STACKSIZE;
+			}
+			else if(known.Has(i._arg2) && CanBeLiteral(_consts[i._arg2])) {
+				SQInteger lit = GetLiteral(_consts[i._arg2]);
+				i._arg2 = (unsigned char)i._arg1;
+				i._arg1 = (SQInt32)lit;
+				i._arg3 = MAX_FUNC_STACKSIZE;
+			}
+		}
+		known.Remove(i._arg0);
+	}
+	//JCMP against a register holding a constant becomes JCMPK, which reads the literal directly
+	void MakeCompareLiteral(const SQRegSet &known,SQInstruction &i)
+	{
+		if(i._arg3 == CMP_3W || !known.Has(i._arg0) || !CanBeLiteral(_consts[i._arg0])) return;
+		SQInteger lit = GetLiteral(_consts[i._arg0]);
+		if(lit > 0xFF) return;
+		i = SQInstruction(_OP_JCMPK,lit,i._arg1,i._arg2,i._arg3);
+	}
+	void FoldConstants()
+	{
+		SQInteger n = _code.size();
+		SQRegSet known, uses, defs;
+		SQObjectPtr res;
+		ComputeLeaders();
+		known.Clear();
+		for(SQInteger pc = 0; pc < n; pc++) {
+			if(_removed[pc]) continue;
+			if(_leaders[pc]) known.Clear();
+			SQInstruction &i = _code[pc];
+			switch(i.op) {
+			case _OP_LINE:
+				continue;
+			case _OP_LOAD: case _OP_LOADINT: case _OP_LOADFLOAT: case _OP_LOADBOOL:
+				SetConstant(known,i._arg0,LoadedValue(i));
+				continue;
+			case _OP_DLOAD:
+				SetConstant(known,i._arg0,_literals[i._arg1]);
+				SetConstant(known,i._arg2,_literals[i._arg3]);
+				continue;
+			case _OP_LOADNULLS:
+				for(SQInteger r = 0; r < i._arg1; r++) SetConstant(known,i._arg0 + r,SQObjectPtr());
+				continue;
+			case _OP_MOVE:
+				CopyConstant(known,i._arg0,i._arg1);
+				continue;
+			case _OP_DMOVE:
+				CopyConstant(known,i._arg0,i._arg1);
+				CopyConstant(known,i._arg2,i._arg3);
+				continue;
+			case _OP_LOADROOT: case _OP_GETBASE: case _OP_GETOUTER:
+				known.Remove(i._arg0);
+				continue;
+			case _OP_ADD: case _OP_SUB: case _OP_MUL: case _OP_DIV: case _OP_MOD: case _OP_BITW:
+				if(known.Has(i._arg2) && known.Has(i._arg1) && FoldArith(i,_consts[i._arg2],_consts[i._arg1],res)) {
+					SQInteger target = i._arg0;
+					EmitLoad(pc,target,res);
+					SetConstant(known,target,res);
+					continue;
+				}
+				break;
+			case _OP_NEG: case _OP_BWNOT:
+				if(known.Has(i._arg1) && FoldUnary(i.op,_consts[i._arg1],res)) {
+					SQInteger target = i._arg0;
+					EmitLoad(pc,target,res);
+					SetConstant(known,target,res);
+					continue;
+				}
+				break;
+			case _OP_NOT:
+				if(known.Has(i._arg1)) {
+					SQInteger target = i._arg0;
+					res = IsFalseConstant(_consts[i._arg1]);
+					EmitLoad(pc,target,res);
+					SetConstant(known,target,res);
+				}
+				else known.Remove(i._arg0);
+				continue;
+			case _OP_EQ: case _OP_NE:
+				FoldEquality(known,pc);
+				continue;
+			case _OP_CMP:
+				if(known.Has(i._arg2) && known.Has(i._arg1) && FoldCompare(i._arg3,_consts[i._arg2],_consts[i._arg1],res)) {
+					SQInteger target = i._arg0;
+					EmitLoad(pc,target,res);
+					SetConstant(known,target,res);
+					continue;
+				}
+				break;
+			case _OP_JZ:
+				if(known.Has(i._arg0)) {
+					if(IsFalseConstant(_consts[i._arg0])) i = SQInstruction(_OP_JMP,0,i._arg1);
+					else Remove(pc);
+				}
+				continue;
+			case _OP_JCMP:
+				if(known.Has(i._arg2) && known.Has(i._arg0) && FoldCompare(i._arg3,_consts[i._arg2],_consts[i._arg0],res)) {
+					if(IsFalseConstant(res)) i = SQInstruction(_OP_JMP,0,i._arg1);
+					else Remove(pc);
+					continue;
+				}
+				if(_level >= SQ_OPT_FULL) MakeCompareLiteral(known,i);
+				break;
+			default:
+				break;
+			}
+			//anything else may call back into scripts, which can change the captured locals
+			Effects(i,uses,defs);
+			AddClobbers(i,defs);
+			known.Subtract(defs);
+			known.Subtract(_captured);
+		}
+	}
+	void RemoveUnreachable()
+	{
+		SQInteger n = _code.size(), succ[3];
+		SQBoolVec reached;
+		SQIntVec pending;
+		reached.resize(n,false);
+		reached[0] = true;
+		pending.push_back(0);
+		while(pending.size()) {
+			SQInteger pc = pending.back();
+			pending.pop_back();
+			SQInteger ns = Successors(pc,succ);
+			for(SQInteger s = 0; s < ns; s++) {
+				if(succ[s] < n && !reached[succ[s]]) {
+					reached[succ[s]] = true;
+					pending.push_back(succ[s]);
+				}
+			}
+		}
+		for(SQInteger pc = 0; pc < n; pc++) {
+			if(!reached[pc]) Remove(pc);
+		}
+	}
+	void RemoveLines()
+	{
+		SQInteger n = _code.size(), lastline = -1;
+		ComputeLeaders();
+		for(SQInteger pc = 0; pc < n; pc++) {
+			if(_removed[pc]) continue;
+			if(_leaders[pc]) lastline = -1;
+			if(_code[pc].op != _OP_LINE) continue;
+			if(_level >= SQ_OPT_FULL || _code[pc]._arg1 == lastline) Remove(pc);
+			else lastline = _code[pc]._arg1;
+		}
+	}
+	void ComputeLiveness(SQRegSetVec &liveout)
+	{
+		SQInteger n = _code.size(), succ[3];
+		SQRegSet empty, in, uses, defs;
+		SQRegSetVec livein;
+		empty.Clear();
+		livein.resize(n,empty);
+		liveout.resize(n,empty);
+		bool changed = true;
+		while(changed) {
+			changed = false;
+			for(SQInteger pc = n - 1; pc >= 0; pc--) {
+				SQRegSet &out = liveout[pc];
+				SQInteger ns = Successors(pc,succ);
+				for(SQInteger s = 0; s < ns; s++) {
+					if(succ[s] < n) out.Union(livein[succ[s]]);
+				}
+				in = out;
+				if(!_removed[pc]) {
+					Effects(_code[pc],uses,defs);
+					in.Subtract(defs);
+					in.Union(uses);
+				}
+				if(!(in == livein[pc])) {
+					livein[pc] = in;
+					changed = true;
+				}
+			}
+		}
+	}
+	bool IsDead(const SQRegSet &live,SQInteger r) { return !live.Has(r) && !_captured.Has(r); }
+	bool EliminateDeadStores()
+	{
+		SQRegSetVec liveout;
+		bool changed = false;
+		ComputeLiveness(liveout);
+		for(SQInteger pc = 0; pc < (SQInteger)_code.size(); pc++) {
+			if(_removed[pc]) continue;
+			SQInstruction &i = _code[pc];
+			const SQRegSet &live = liveout[pc];
+			switch(i.op) {
+			case _OP_MOVE:
+				if(i._arg0 == i._arg1 || IsDead(live,i._arg0)) { Remove(pc); changed = true; }
+				break;
+			case _OP_LOAD: case _OP_LOADINT: case _OP_LOADFLOAT: case _OP_LOADBOOL:
+			case _OP_LOADROOT: case _OP_GETBASE: case _OP_GETOUTER:
+				if(IsDead(live,i._arg0)) { Remove(pc); changed = true; }
+				break;
+			case _OP_DLOAD:
+				if(IsDead(live,i._arg0) && IsDead(live,i._arg2)) { Remove(pc); changed = true; }
+				else if(IsDead(live,i._arg0)) { i = SQInstruction(_OP_LOAD,i._arg2,i._arg3); changed = true; }
+				else if(IsDead(live,i._arg2)) { i = SQInstruction(_OP_LOAD,i._arg0,i._arg1); changed = true; }
+				break;
+			case _OP_DMOVE:
+				if(IsDead(live,i._arg0) && IsDead(live,i._arg2)) { Remove(pc); changed = true; }
+				else if(IsDead(live,i._arg2)) { i = SQInstruction(_OP_MOVE,i._arg0,i._arg1); changed = true; }
+				//the second move may read what the first one wrote
+				else if(IsDead(live,i._arg0) && i._arg3 != i._arg0) { i = SQInstruction(_OP_MOVE,i._arg2,i._arg3); changed = true; }
+				break;
+			case _OP_LOADNULLS: {
+				bool dead = true;
+				for(SQInteger r = 0; r < i._arg1 && dead; r++) dead = IsDead(live,i._arg0 + r);
+				if(dead) { Remove(pc); changed = true; }
+				}
+				break;
+			case _OP_PINCL:
+				if(i._arg0 != i._arg1 && IsDead(live,i._arg0)) { i.op = _OP_INCL; changed = true; }
+				break;
+			default:
+				break;
+			}
+		}
+		return changed;
+	}
+	//next kept instruction of the same basic block, -1 if the block ends first
+	SQInteger NextInBlock(SQInteger pc)
+	{
+		for(SQInteger next = pc + 1; next < (SQInteger)_code.size(); next++) {
+			if(_leaders[next]) return -1;
+			if(!_removed[next]) return next;
+		}
+		return -1;
+	}
+	//the loop increment followed by the jump back to the condition
+	void FuseIncrementJump(SQInteger pc)
+	{
+		SQInteger next = NextInBlock(pc);
+		if(next == -1 || _code[next].op != _OP_JMP) return;
+		SQInteger target = JumpTarget(_code[next],next);
+		SQInstruction &i = _code[pc];
+		i = SQInstruction(_OP_INCLJMP,i._arg1,target - (pc + 1),0,i._arg3);
+		Remove(next);
+	}
+	//a method lookup and its call; the argument loads in between move above the lookup
+	void FuseCall(SQInteger pc)
+	{
+		SQInstruction prep = _code[pc];
+		if(prep._arg3 != prep._arg0 + 1) return;
+		SQRegSet written, touched, uses, defs;
+		written.Clear();
+		written.Add(prep._arg0);
+		written.Add(prep._arg3);
+		touched = written;
+		touched.Add(prep._arg2);
+		touched.Union(_captured);
+		SQIntVec moved;
+		SQInteger next = pc;
+		for(;;) {
+			next = NextInBlock(next);
+			if(next == -1) return;
+			const SQInstruction &i = _code[next];
+			if(i.op == _OP_CALL) break;
+			if(_hastraps || !IsHoistable(i.op)) return;
+			Effects(i,uses,defs);
+			//captured locals can be changed by the lookup through a closure
+			if(uses.Intersects(written) || uses.Intersects(_captured) || defs.Intersects(touched)) return;
+			moved.push_back(next);
+		}
+		SQInstruction call = _code[next];
+		if(call._arg1 != prep._arg0 || call._arg2 != prep._arg3 || (call._arg0 != prep._arg0 && call._arg0 != 0xFF)
+			|| call._arg3 < 1 || call._arg3 >= CALLK_DISCARD_RESULT) return;
+		SQInteger slot = pc;
+		for(SQUnsignedInteger m = 0; m < moved.size(); m++) {
+			_code[slot] = _code[moved[m]];
+			slot = moved[m];
+		}
+		SQInteger nargs = call._arg3 | (call._arg0 == 0xFF ? CALLK_DISCARD_RESULT : 0);
+		_code[slot] = SQInstruction(_OP_CALLK,prep._arg0,prep._arg1,prep._arg2,nargs);
+		Remove(next);
+	}
+	void FuseInstructions()
+	{
+		SQInteger n = _code.size();
+		ComputeLeaders();
+		for(SQInteger pc = 0; pc < n; pc++) {
+			if(_removed[pc]) continue;
+			switch(_code[pc].op) {
+			case _OP_INCL: FuseIncrementJump(pc); break;
+			case _OP_PREPCALLK: FuseCall(pc); break;
+			default: break;
+			}
+		}
+	}
+	//drops removed instructions and moves jump offsets, line infos and local ranges to the new positions
+	void Compact()
+	{
+		SQInteger n = _code.size(), kept = 0;
+		SQIntVec newpos;
+		newpos.resize(n + 1);
+		for(SQInteger pc = 0; pc < n; pc++) {
+			newpos[pc] = kept;
+			if(!_removed[pc]) kept++;
+		}
+		newpos[n] = kept;
+		if(kept == n) return;
+		for(SQInteger pc = 0; pc < n; pc++) {
+			if(_removed[pc]) continue;
+			SQInstruction i = _code[pc];
+			SQInteger target = JumpTarget(i,pc);
+			if(target >= 0 && target <= n) {
+				i._arg1 = (SQInt32)(newpos[target] - newpos[pc] - (i.op == _OP_POSTFOREACH ? 0 : 1));
+			}
+			_code[newpos[pc]] = i;
+		}
+		_code.resize(kept);
+		SQLineInfoVec &lines = _fs->_lineinfos;
+		for(SQUnsignedInteger l = 0; l < lines.size(); l++) {
+			if(lines[l]._op >= 0 && lines[l]._op <= n) lines[l]._op = newpos[lines[l]._op];
+		}
+		//a line whose instructions are all gone starts where the next one does
+		for(SQInteger l = (SQInteger)lines.size() - 1; l > 0; l--) {
+			if(lines[l - 1]._op == lines[l]._op) lines.remove(l - 1);
+		}
+		for(SQUnsignedInteger v = 0; v < _fs->_localvarinfos.size(); v++) {
+			SQLocalVarInfo &lvi = _fs->_localvarinfos[v];
+			if(lvi._start_op <= (SQUnsignedInteger)n) lvi._start_op = newpos[lvi._start_op];
+			if(lvi._end_op <= (SQUnsignedInteger)n) lvi._end_op = newpos[lvi._end_op];
+		}
+	}
+
+	SQFuncState *_fs;
+	SQInstructionVec &_code;
+	SQInteger _level;
+	bool _hastraps;
+	SQBoolVec _removed;
+	SQBoolVec _leaders;
+	SQObjectPtrVec _literals; //indexed by literal number
+	SQRegSet _captured;
+	SQObjectPtr _consts[MAX_REGISTERS]; //values of the registers FoldConstants knows
+};
+
+void Optimize(SQFuncState *fs,SQInteger level)
+{
+	if(level <= SQ_OPT_NONE || fs->_instructions.size() == 0) return;
+	SQOptimizer optimizer(fs,level);
+	optimizer.Run();
+}
+
+#endif
@@ -0,0 +1,16 @@
+/*	see copyright notice in squirrel.h */
+#ifndef _SQOPTIMIZER_H_
+#define _SQOPTIMIZER_H_
+
+struct SQFuncState;
+
+/*
+	Rewrites the instructions of a compiled function right before its proto
+	is built. SQ_OPT_BASIC folds constant expressions and branches, drops
+	unreachable code, stores nobody reads and repeated line ops; SQ_OPT_FULL
+	also fuses common instruction pairs into superinstructions and removes
+	every line op, so the debug hook gets no line events.
+*/
+void Optimize(SQFuncState *fs,SQInteger level);
+
+#endif //_SQOPTIMIZER_H_
@@ -0,0 +1,222 @@
+/*	see copyright notice in squirrel.h */
+#ifndef _SQSORT_H_
+#define _SQSORT_H_
+/*
+	Stable natural merge sort, after the run handling of Tim Peters' timsort.
+	The array is split into runs that are already ascending (descending runs
+	are reversed), short runs are extended with a binary insertion sort and
+	the runs are merged pairwise while keeping their lengths balanced. Before
+	a merge the prefix of the left run and the suffix of the right run that
+	are already in place are skipped, so presorted input costs about n
+	compares.
+	Elements are moved as raw SQObjects, which keeps reference counts
+	untouched since the result is a permutation of the input. LESS is called
+	as less(a,b,res) and returns false when the comparison raised an error;
+	the array is then still a permutation of the input.
+*/
+
+#define SQ_SORT_MINMERGE 32
+#define SQ_SORT_MAXRUNS 85
+
+template<typename LESS>
+struct SQMergeSort
+{
+	SQMergeSort(SQObject *a,SQInteger n,SQObject *tmp,LESS &less) : _a(a), _n(n), _tmp(tmp), _less(less), _nruns(0) {}
+
+	/* 'tmp' must hold n/2 elements */
+	bool Sort()
+	{
+		SQInteger minrun = MinRun(_n);
+		SQInteger lo = 0;
+		while(lo < _n) {
+			SQInteger run;
+			if(!CountRun(lo,run)) return false;
+			if(run < minrun) {
+				SQInteger force = _n - lo < minrun ? _n - lo : minrun;
+				if(!InsertionSort(lo,lo + force,lo + run)) return false;
+				run = force;
+			}
+			_base[_nruns] = lo;
+			_len[_nruns] = run;
+			_nruns++;
+			if(!MergeCollapse()) return false;
+			lo += run;
+		}
+		while(_nruns > 1) {
+			SQInteger n = _nruns - 2;
+			if(n > 0 && _len[n - 1] < _len[n + 1]) n--;
+			if(!MergeAt(n)) return false;
+		}
+		return true;
+	}
+
+private:
+	static SQInteger MinRun(SQInteger n)
+	{
+		SQInteger r = 0;
+		while(n >= SQ_SORT_MINMERGE) {
+			r |= n & 1;
+			n >>= 1;
+		}
+		return n + r;
+	}
+
+	/* length of the run starting at lo; a strictly descending one is reversed */
+	bool CountRun(SQInteger lo,SQInteger &run)
+	{
+		SQInteger hi = lo + 1;
+		bool lt;
+		if(hi == _n) { run = 1; return true; }
+		if(!_less(_a[hi],_a[lo],lt)) return false;
+		hi++;
+		if(lt) {
+			while(hi < _n) {
+				if(!_less(_a[hi],_a[hi - 1],lt)) return false;
+				if(!lt) break;
+				hi++;
+			}
+			for(SQInteger i = lo, j = hi - 1; i < j; i++, j--) {
+				SQObject t = _a[i]; _a[i] = _a[j]; _a[j] = t;
+			}
+		}
+		else {
+			while(hi < _n) {
+				if(!_less(_a[hi],_a[hi - 1],lt)) return false;
+				if(lt) break;
+				hi++;
+			}
+		}
+		run = hi - lo;
+		return true;
+	}
+
+	/* sorts [lo,hi) knowing that [lo,start) is sorted already */
+	bool InsertionSort(SQInteger lo,SQInteger hi,SQInteger start)
+	{
+		bool lt;
+		for(; start < hi; start++) {
+			SQObject pivot = _a[start];
+			SQInteger l = lo, r = start;
+			while(l < r) {
+				SQInteger m = l + ((r - l) >> 1);
+				if(!_less(pivot,_a[m],lt)) return false;
+				if(lt) r = m;
+				else l = m + 1;
+			}
+			for(SQInteger i = start; i > l; i--) _a[i] = _a[i - 1];
+			_a[l] = pivot;
+		}
+		return true;
+	}
+
+	/* first position in [lo,hi) whose element is greater than key */
+	bool UpperBound(const SQObject &key,SQInteger lo,SQInteger hi,SQInteger &pos)
+	{
+		bool lt;
+		while(lo < hi) {
+			SQInteger m = lo + ((hi - lo) >> 1);
+			if(!_less(key,_a[m],lt)) return false;
+			if(lt) hi = m;
+			else lo = m + 1;
+		}
+		pos = lo;
+		return true;
+	}
+
+	/* first position in [lo,hi) whose element is not less than key */
+	bool LowerBound(const SQObject &key,SQInteger lo,SQInteger hi,SQInteger &pos)
+	{
+		bool lt;
+		while(lo < hi) {
+			SQInteger m = lo + ((hi - lo) >> 1);
+			if(!_less(_a[m],key,lt)) return false;
+			if(lt) lo = m + 1;
+			else hi = m;
+		}
+		pos = lo;
+		return true;
+	}
+
+	bool MergeCollapse()
+	{
+		while(_nruns > 1) {
+			SQInteger n = _nruns - 2;
+			if((n > 0 && _len[n - 1] <= _len[n] + _len[n + 1]) || (n > 1 && _len[n - 2] <= _len[n - 1] + _len[n])) {
+				if(_len[n - 1] < _len[n + 1]) n--;
+			}
+			else if(_len[n] > _len[n + 1]) {
+				break;
+			}
+			if(!MergeAt(n)) return false;
+		}
+		return true;
+	}
+
+	bool MergeAt(SQInteger i)
+	{
+		SQInteger base1 = _base[i], len1 = _len[i];
+		SQInteger base2 = _base[i + 1], len2 = _len[i + 1];
+		_len[i] = len1 + len2;
+		for(SQInteger k = i + 1; k < _nruns - 1; k++) {
+			_base[k] = _base[k + 1];
+			_len[k] = _len[k + 1];
+		}
+		_nruns--;
+
+		SQInteger skip;
+		if(!UpperBound(_a[base2],base1,base1 + len1,skip)) return false;
+		len1 -= skip - base1;
+		base1 = skip;
+		if(len1 == 0) return true;
+		SQInteger end;
+		if(!LowerBound(_a[base1 + len1 - 1],base2,base2 + len2,end)) return false;
+		len2 = end - base2;
+		if(len2 == 0) return true;
+		return len1 <= len2 ? MergeLo(base1,len1,base2,len2) : MergeHi(base1,len1,base2,len2);
+	}
+
+	bool MergeLo(SQInteger base1,SQInteger len1,SQInteger base2,SQInteger len2)
+	{
+		memcpy(_tmp,_a + base1,len1 * sizeof(SQObject));
+		SQInteger i = 0, j = base2, k = base1, end2 = base2 + len2;
+		bool ok = true, lt;
+		while(i < len1 && j < end2) {
+			if(!_less(_a[j],_tmp[i],lt)) { ok = false; break; }
+			if(lt) _a[k++] = _a[j++];
+			else _a[k++] = _tmp[i++];
+		}
+		memcpy(_a + k,_tmp + i,(len1 - i) * sizeof(SQObject));
+		return ok;
+	}
+
+	bool MergeHi(SQInteger base1,SQInteger len1,SQInteger base2,SQInteger len2)
+	{
+		memcpy(_tmp,_a + base2,len2 * sizeof(SQObject));
+		SQInteger i = len2 - 1, j = base1 + len1 - 1, k = base2 + len2 - 1;
+		bool ok = true, lt;
+		while(i >= 0 && j >= base1) {
+			if(!_less(_tmp[i],_a[j],lt)) { ok = false; break; }
+			if(lt) _a[k--] = _a[j--];
+			else _a[k--] = _tmp[i--];
+		}
+		memcpy(_a + k - i,_tmp,(i + 1) * sizeof(SQObject));
+		return ok;
+	}
+
+	SQObject *_a;
+	SQInteger _n;
+	SQObject *_tmp;
+	LESS &_less;
+	SQInteger _nruns;
+	SQInteger _base[SQ_SORT_MAXRUNS];
+	SQInteger _len[SQ_SORT_MAXRUNS];
+};
+
+template<typename LESS>
+inline bool sq_mergesort(SQObject *a,SQInteger n,SQObject *tmp,LESS &less)
+{
+	SQMergeSort<LESS> s(a,n,tmp,less);
+	return s.Sort();
+}
+
+#endif //_SQSORT_H_
@@ -18,6 +18,8 @@
 //SQObjectPtr _one_((SQInteger)1);
 //SQObjectPtr _minusone_((SQInteger)-1);
 
+SQHash64 _sq_hashseed = 0;
+
 SQSharedState::SQSharedState()
 {
 	_compilererrorhandler = NULL;
@@ -25,6 +27,12 @@ SQSharedState::SQSharedState()
 	_errorfunc = NULL;
 	_debuginfo = false;
 	_notifyallexceptions = false;
+	_optimizationlevel = SQ_OPT_NONE;
+	_quickening = true;
+	_classversion = 0;
+	_hashseed = _sq_hashseed;
+	_inlinecachehits = 0;
+	_inlinecachemisses = 0;
 }
 
 #define newsysstring(s) {	\
@@ -51,6 +59,7 @@ bool CompileTypemask(SQIntVec &res,const SQChar *typemask)
 				case 's': mask |= _RT_STRING; break;
 				case 't': mask |= _RT_TABLE; break;
 				case 'a': mask |= _RT_ARRAY; break;
+				case 'd': mask |= _RT_TYPEDARRAY; break;
 				case 'u': mask |= _RT_USERDATA; break;
 				case 'c': mask |= (_RT_CLOSURE | _RT_NATIVECLOSURE); break;
 				case 'b': mask |= _RT_BOOL; break;
@@ -101,6 +110,11 @@ void SQSharedState::Init()
 	_scratchpadsize=0;
 #ifndef NO_GARBAGE_COLLECTOR
 	_gc_chain=NULL;
+	_gcphase=SQ_GC_IDLE;
+	_gcsweep=NULL;
+	_weakrefs=NULL;
+	_gccycles=0;
+	_gcfreed=0;
 #endif
 	_stringtable = (SQStringTable*)SQ_MALLOC(sizeof(SQStringTable));
 	new (_stringtable) SQStringTable(this);
@@ -150,6 +164,7 @@ void SQSharedState::Init()
 	_consts = SQTable::Create(this,0);
 	_table_default_delegate = CreateDefaultDelegate(this,_table_default_delegate_funcz);
 	_array_default_delegate = CreateDefaultDelegate(this,_array_default_delegate_funcz);
+	_typedarray_default_delegate = CreateDefaultDelegate(this,_typedarray_default_delegate_funcz);
 	_string_default_delegate = CreateDefaultDelegate(this,_string_default_delegate_funcz);
 	_number_default_delegate = CreateDefaultDelegate(this,_number_default_delegate_funcz);
 	_closure_default_delegate = CreateDefaultDelegate(this,_closure_default_delegate_funcz);
@@ -163,6 +178,9 @@ void SQSharedState::Init()
 
 SQSharedState::~SQSharedState()
 {
+#ifndef NO_GARBAGE_COLLECTOR
+	AbortCollection();
+#endif
 	_constructoridx.Null();
 	_table(_registry)->Finalize();
 	_table(_consts)->Finalize();
@@ -178,6 +196,7 @@ SQSharedState::~SQSharedState()
 	_root_vm.Null();
 	_table_default_delegate.Null();
 	_array_default_delegate.Null();
+	_typedarray_default_delegate.Null();
 	_string_default_delegate.Null();
 	_number_default_delegate.Null();
 	_closure_default_delegate.Null();
@@ -206,6 +225,7 @@ SQSharedState::~SQSharedState()
 		_gc_chain->_uiRef++;
 		_gc_chain->Release();
 	}
+	while(_weakrefs) RemoveWeakRef(_weakrefs);
 #endif
 
 	sq_delete(_types,SQObjectPtrVec);
@@ -229,7 +249,7 @@ SQInteger SQSharedState::GetMetaMethodIdxByName(const SQObjectPtr &name)
 
 #ifndef NO_GARBAGE_COLLECTOR
 
-void SQSharedState::MarkObject(SQObjectPtr &o,SQCollectable **chain)
+void SQSharedState::MarkObject(const SQObject &o,SQCollectable **chain)
 {
 	switch(type(o)){
 	case OT_TABLE:_table(o)->Mark(chain);break;
@@ -260,6 +280,7 @@ void SQSharedState::RunMark(SQVM *vm,SQCollectable **tchain)
 	MarkObject(_metamethodsmap,tchain);
 	MarkObject(_table_default_delegate,tchain);
 	MarkObject(_array_default_delegate,tchain);
+	MarkObject(_typedarray_default_delegate,tchain);
 	MarkObject(_string_default_delegate,tchain);
 	MarkObject(_number_default_delegate,tchain);
 	MarkObject(_generator_default_delegate,tchain);
@@ -276,6 +297,8 @@ SQInteger SQSharedState::ResurrectUnreachable(SQVM *vm)
 	SQInteger n=0;
 	SQCollectable *tchain=NULL;
 
+	FinishCollection();
+
 	RunMark(vm,&tchain);
 
 	SQCollectable *resurrected = _gc_chain;
@@ -331,6 +354,8 @@ SQInteger SQSharedState::CollectGarbage(SQVM *vm)
 	SQInteger n = 0;
 	SQCollectable *tchain = NULL;
 
+	FinishCollection();
+
 	RunMark(vm,&tchain);
 
 	SQCollectable *t = _gc_chain;
@@ -357,6 +382,134 @@ SQInteger SQSharedState::CollectGarbage(SQVM *vm)
 	
 	return n;
 }
+
+/*
+	Incremental tri-color collection. White objects are unmarked, gray ones
+	are marked and waiting in _gcgray, black ones are marked and scanned.
+	Marking starts from the roots and scans gray objects a few at a time;
+	stores into heap objects go through SQ_GC_BARRIER meanwhile. Stacks
+	(threads, generators) and classes are scanned without barriers, so once
+	the gray stack is empty they are rescanned together with the roots in one
+	atomic step. Weak references to objects still white are cleared there,
+	so nothing can reach them again; the sweep then walks _gc_chain a few
+	objects at a time, finalizing white objects and unmarking black ones.
+	Objects allocated after marking ends are added in front of the sweep
+	cursor and are left alone.
+	A marked object can't be released by its reference count (MARK_FLAG
+	keeps _uiRef above zero), so the sweep releases the ones that dropped to
+	zero while marked.
+*/
+bool SQSharedState::CollectStep(SQInteger work)
+{
+	if(_gcphase == SQ_GC_IDLE) {
+		_gcphase = SQ_GC_MARK;
+		RunMark(NULL,NULL);
+	}
+	while(_gcphase == SQ_GC_MARK && work > 0) {
+		if(_gcgray.size() == 0) {
+			FinishMark();
+			break;
+		}
+		SQCollectable *c = _gcgray.top();
+		_gcgray.pop_back();
+		c->Mark(SQ_GC_SCAN);
+		work--;
+	}
+	while(_gcphase == SQ_GC_SWEEP && work > 0) {
+		SQCollectable *t = _gcsweep;
+		if(!t) {
+			_gcphase = SQ_GC_IDLE;
+			_gccycles++;
+			return true;
+		}
+		SQCollectable *nx = t->_next;
+		if(nx) nx->_uiRef++;
+		if(t->_uiRef & MARK_FLAG) {
+			t->UnMark();
+		}
+		else {
+			t->Finalize();
+			_gcfreed++;
+		}
+		if(--t->_uiRef == 0)
+			t->Release();
+		_gcsweep = nx;
+		work--;
+	}
+	return false;
+}
+
+void SQSharedState::FinishMark()
+{
+	RunMark(NULL,NULL);
+	SQInteger nrescan = _gcrescan.size();
+	for(SQInteger i = 0; i < nrescan; i++)
+		_gcrescan[i]->Mark(SQ_GC_SCAN);
+	while(_gcgray.size()) {
+		SQCollectable *c = _gcgray.top();
+		_gcgray.pop_back();
+		c->Mark(SQ_GC_SCAN);
+	}
+	_gcrescan.resize(0);
+	ClearWeakRefs();
+	_gcphase = SQ_GC_SWEEP;
+	_gcsweep = _gc_chain;
+	if(_gcsweep) _gcsweep->_uiRef++;
+}
+
+void SQSharedState::FinishCollection()
+{
+	while(_gcphase != SQ_GC_IDLE)
+		CollectStep(SQ_GC_WORKALL);
+}
+
+void SQSharedState::AbortCollection()
+{
+	if(_gcphase == SQ_GC_IDLE)
+		return;
+	/* objects already finalized by the sweep can still be referenced by
+	   garbage it hasn't reached yet, so a sweep is always completed */
+	if(_gcphase == SQ_GC_SWEEP) {
+		FinishCollection();
+		return;
+	}
+	_gcgray.resize(0);
+	_gcrescan.resize(0);
+	for(SQCollectable *t = _gc_chain; t; t = t->_next)
+		t->UnMark();
+	_gcphase = SQ_GC_IDLE;
+}
+
+void SQSharedState::ClearWeakRefs()
+{
+	for(SQWeakRef *w = _weakrefs; w; w = w->_next) {
+		if(!ISREFCOUNTED(type(w->_obj)))
+			continue;
+		SQCollectable *c = static_cast<SQCollectable *>(w->_obj._unVal.pRefCounted);
+		if(!(c->_uiRef & MARK_FLAG)) {
+			c->_weakref = NULL;
+			w->_obj._type = OT_NULL;
+			w->_obj._unVal.pRefCounted = NULL;
+		}
+	}
+}
+
+void SQSharedState::AddWeakRef(SQWeakRef *w)
+{
+	w->_sharedstate = this;
+	w->_prev = NULL;
+	w->_next = _weakrefs;
+	if(_weakrefs) _weakrefs->_prev = w;
+	_weakrefs = w;
+}
+
+void SQSharedState::RemoveWeakRef(SQWeakRef *w)
+{
+	if(w->_prev) w->_prev->_next = w->_next;
+	else _weakrefs = w->_next;
+	if(w->_next) w->_next->_prev = w->_prev;
+	w->_sharedstate = NULL;
+}
 #endif
 
 #ifndef NO_GARBAGE_COLLECTOR
@@ -568,10 +721,38 @@ void RefTable::AllocNodes(SQUnsignedInteger size)
 SQStringTable::SQStringTable(SQSharedState *ss)
 {
 	_sharedstate = ss;
+	_loadfactor = 1;
 	AllocNodes(4);
 	_slotused = 0;
 }
 
+void SQStringTable::SetLoadFactor(SQFloat factor)
+{
+	_loadfactor = factor;
+	_maxslotused = (SQUnsignedInteger)(_numofslots * _loadfactor);
+	SQUnsignedInteger size = _numofslots;
+	while(_slotused > _maxslotused) {
+		size *= 2;
+		_maxslotused = (SQUnsignedInteger)(size * _loadfactor);
+	}
+	if(size != _numofslots)
+		Resize(size);
+}
+
+void SQStringTable::GetStats(SQStringTableStats *stats)
+{
+	stats->slots = _numofslots;
+	stats->strings = _slotused;
+	stats->used_slots = 0;
+	stats->longest_chain = 0;
+	for(SQUnsignedInteger i = 0; i < _numofslots; i++) {
+		SQUnsignedInteger chain = 0;
+		for(SQString *s = _strings[i]; s; s = s->_next) chain++;
+		if(chain) stats->used_slots++;
+		if(chain > stats->longest_chain) stats->longest_chain = chain;
+	}
+}
+
 SQStringTable::~SQStringTable()
 {
 	SQ_FREE(_strings,sizeof(SQString*)*_numofslots);
@@ -581,6 +762,7 @@ SQStringTable::~SQStringTable()
 void SQStringTable::AllocNodes(SQInteger size)
 {
 	_numofslots = size;
+	_maxslotused = (SQUnsignedInteger)(_numofslots * _loadfactor);
 	_strings = (SQString**)SQ_MALLOC(sizeof(SQString*)*_numofslots);
 	memset(_strings,0,sizeof(SQString*)*_numofslots);
 }
@@ -589,7 +771,7 @@ SQString *SQStringTable::Add(const SQChar *news,SQInteger len)
 {
 	if(len<0)
 		len = (SQInteger)scstrlen(news);
-	SQHash newhash = ::_hashstr(news,len);
+	SQHash newhash = ::_hashstr(news,len,_sharedstate->_hashseed);
 	SQHash h = newhash&(_numofslots-1);
 	SQString *s;
 	for (s = _strings[h]; s; s = s->_next){
@@ -607,7 +789,7 @@ SQString *SQStringTable::Add(const SQChar *news,SQInteger len)
 	t->_next = _strings[h];
 	_strings[h] = t;
 	_slotused++;
-	if (_slotused > _numofslots)  /* too crowded? */
+	if (_slotused > _maxslotused)  /* too crowded? */
 		Resize(_numofslots*2);
 	return t;
 }
@@ -15,12 +15,16 @@ struct SQStringTable
 	~SQStringTable();
 	SQString *Add(const SQChar *,SQInteger len);
 	void Remove(SQString *);
+	void SetLoadFactor(SQFloat factor);
+	void GetStats(SQStringTableStats *stats);
 private:
 	void Resize(SQInteger size);
 	void AllocNodes(SQInteger size);
 	SQString **_strings;
 	SQUnsignedInteger _numofslots;
 	SQUnsignedInteger _slotused;
+	SQUnsignedInteger _maxslotused; //grows the table past this many strings
+	SQFloat _loadfactor;
 	SQSharedState *_sharedstate;
 };
 
@@ -68,7 +72,16 @@ public:
 	SQInteger CollectGarbage(SQVM *vm);
 	void RunMark(SQVM *vm,SQCollectable **tchain);
 	SQInteger ResurrectUnreachable(SQVM *vm);
-	static void MarkObject(SQObjectPtr &o,SQCollectable **chain);
+	static void MarkObject(const SQObject &o,SQCollectable **chain);
+	bool CollectStep(SQInteger work);
+	void FinishCollection();
+	void AbortCollection();
+	void AddWeakRef(SQWeakRef *w);
+	void RemoveWeakRef(SQWeakRef *w);
+private:
+	void FinishMark();
+	void ClearWeakRefs();
+public:
 #endif
 	SQObjectPtrVec *_metamethods;
 	SQObjectPtr _metamethodsmap;
@@ -81,12 +94,22 @@ public:
 	SQObjectPtr _constructoridx;
 #ifndef NO_GARBAGE_COLLECTOR
 	SQCollectable *_gc_chain;
+	/* incremental collection state, see CollectStep() */
+	SQInteger _gcphase;
+	sqvector<SQCollectable*> _gcgray;
+	sqvector<SQCollectable*> _gcrescan; //scanned threads, generators and classes
+	SQCollectable *_gcsweep; //next object to sweep, pinned by a reference
+	SQWeakRef *_weakrefs;
+	SQUnsignedInteger _gccycles;
+	SQUnsignedInteger _gcfreed;
 #endif
 	SQObjectPtr _root_vm;
 	SQObjectPtr _table_default_delegate;
 	static SQRegFunction _table_default_delegate_funcz[];
 	SQObjectPtr _array_default_delegate;
 	static SQRegFunction _array_default_delegate_funcz[];
+	SQObjectPtr _typedarray_default_delegate;
+	static SQRegFunction _typedarray_default_delegate_funcz[];
 	SQObjectPtr _string_default_delegate;
 	static SQRegFunction _string_default_delegate_funcz[];
 	SQObjectPtr _number_default_delegate;
@@ -109,16 +132,43 @@ public:
 	SQPRINTFUNCTION _errorfunc;
 	bool _debuginfo;
 	bool _notifyallexceptions;
+	SQInteger _optimizationlevel;
+	bool _quickening;
+	SQUnsignedInteger _classversion;
+	SQHash64 _hashseed;
+	SQUnsignedInteger _inlinecachehits;
+	SQUnsignedInteger _inlinecachemisses;
 private:
 	SQChar *_scratchpad;
 	SQInteger _scratchpadsize;
 };
 
+#ifndef NO_GARBAGE_COLLECTOR
+#define SQ_GC_IDLE 0
+#define SQ_GC_MARK 1
+#define SQ_GC_SWEEP 2
+#define SQ_GC_WORKALL ((SQInteger)(((SQUnsignedInteger)-1)>>1))
+/*
+	Write barrier: while the incremental collector is marking, a value
+	stored into a heap object is shaded so that a black object never points
+	to a white one. Stacks are rescanned when marking ends instead.
+*/
+#define SQ_GC_BARRIER(ss,o) { if((ss)->_gcphase == SQ_GC_MARK) SQSharedState::MarkObject(o,NULL); }
+#define SQ_GC_SHADE(ss,c) { if((ss)->_gcphase == SQ_GC_MARK) (c)->Mark(NULL); }
+#else
+#define SQ_GC_BARRIER(ss,o) ((void)0)
+#define SQ_GC_SHADE(ss,c) ((void)0)
+#endif
+
+//seed given to the string hash of shared states created from now on
+extern SQHash64 _sq_hashseed;
+
 #define _sp(s) (_sharedstate->GetScratchPad(s))
 #define _spval (_sharedstate->GetScratchPad(-1))
 
 #define _table_ddel		_table(_sharedstate->_table_default_delegate) 
 #define _array_ddel		_table(_sharedstate->_array_default_delegate) 
+#define _typedarray_ddel	_table(_sharedstate->_typedarray_default_delegate) 
 #define _string_ddel	_table(_sharedstate->_string_default_delegate) 
 #define _number_ddel	_table(_sharedstate->_number_default_delegate) 
 #define _generator_ddel	_table(_sharedstate->_generator_default_delegate) 
@@ -2,13 +2,76 @@
 #ifndef _SQSTRING_H_
 #define _SQSTRING_H_
 
-inline SQHash _hashstr (const SQChar *s, size_t l)
+/*
+	wyhash-style string hash: every byte of the key is consumed, 8 at a time,
+	through a folded 64x64->128 multiply. Keys longer than 48 bytes run three
+	independent lanes so the multiplies overlap. The seed comes from the
+	shared state (see sq_sethashseed), so all the strings of a VM agree.
+*/
+#define SQ_HASH_SECRET0 0xa0761d6478bd642fULL
+#define SQ_HASH_SECRET1 0xe7037ed1a0b428dbULL
+#define SQ_HASH_SECRET2 0x8ebc6af09c88c6e3ULL
+#define SQ_HASH_SECRET3 0x589965cc75374cc3ULL
+
+inline void _hashmum(SQHash64 &a, SQHash64 &b)
+{
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 r = (unsigned __int128)a * b;
+	a = (SQHash64)r; b = (SQHash64)(r >> 64);
+#else
+	SQHash64 ha = a >> 32, hb = b >> 32, la = (unsigned int)a, lb = (unsigned int)b;
+	SQHash64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	SQHash64 t = rl + (rm0 << 32), c = t < rl;
+	SQHash64 lo = t + (rm1 << 32); c += lo < t;
+	a = lo; b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+inline SQHash64 _hashmix(SQHash64 a, SQHash64 b) { _hashmum(a, b); return a ^ b; }
+
+inline SQHash64 _hashread8(const unsigned char *p) { SQHash64 v; memcpy(&v, p, 8); return v; }
+inline SQHash64 _hashread4(const unsigned char *p) { unsigned int v; memcpy(&v, p, 4); return v; }
+
+inline SQHash _hashstr (const SQChar *s, size_t l, SQHash64 seed)
 {
-		SQHash h = (SQHash)l;  /* seed */
-		size_t step = (l>>5)|1;  /* if string is too long, don't hash all its chars */
-		for (; l>=step; l-=step)
-			h = h ^ ((h<<5)+(h>>2)+(unsigned short)*(s++));
-		return h;
+	const unsigned char *p = (const unsigned char *)s;
+	size_t len = l * sizeof(SQChar);
+	SQHash64 a, b;
+	seed ^= _hashmix(seed ^ SQ_HASH_SECRET0, SQ_HASH_SECRET1);
+	if(len <= 16) {
+		if(len >= 4) {
+			size_t mid = (len >> 3) << 2;
+			a = (_hashread4(p) << 32) | _hashread4(p + mid);
+			b = (_hashread4(p + len - 4) << 32) | _hashread4(p + len - 4 - mid);
+		}
+		else if(len > 0) {
+			a = ((SQHash64)p[0] << 16) | ((SQHash64)p[len >> 1] << 8) | p[len - 1];
+			b = 0;
+		}
+		else a = b = 0;
+	}
+	else {
+		size_t i = len;
+		if(i > 48) {
+			SQHash64 see1 = seed, see2 = seed;
+			do {
+				seed = _hashmix(_hashread8(p) ^ SQ_HASH_SECRET1, _hashread8(p + 8) ^ seed);
+				see1 = _hashmix(_hashread8(p + 16) ^ SQ_HASH_SECRET2, _hashread8(p + 24) ^ see1);
+				see2 = _hashmix(_hashread8(p + 32) ^ SQ_HASH_SECRET3, _hashread8(p + 40) ^ see2);
+				p += 48; i -= 48;
+			} while(i > 48);
+			seed ^= see1 ^ see2;
+		}
+		while(i > 16) {
+			seed = _hashmix(_hashread8(p) ^ SQ_HASH_SECRET1, _hashread8(p + 8) ^ seed);
+			i -= 16; p += 16;
+		}
+		a = _hashread8(p + i - 16);
+		b = _hashread8(p + i - 8);
+	}
+	a ^= SQ_HASH_SECRET1; b ^= seed;
+	_hashmum(a, b);
+	return (SQHash)_hashmix(a ^ SQ_HASH_SECRET0 ^ len, b ^ SQ_HASH_SECRET1);
 }
 
 struct SQString : public SQRefCounted
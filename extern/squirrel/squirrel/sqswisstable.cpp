@@ -0,0 +1,210 @@
+/*
+see copyright notice in squirrel.h
+*/
+#include "sqpcheader.h"
+#include "sqvm.h"
+#include "sqtable.h"
+
+#ifdef SQ_SWISS_TABLE
+
+SQTable::SQTable(SQSharedState *ss,SQInteger nInitialSize)
+{
+	SQInteger pow2size=MINPOWER2;
+	while(MaxLoad(pow2size)<nInitialSize)pow2size=pow2size<<1;
+	AllocNodes(pow2size);
+	_delegate = NULL;
+	INIT_CHAIN();
+	ADD_TO_CHAIN(&_sharedstate->_gc_chain,this);
+}
+
+/* one block holds the keys, then the values, then the control bytes */
+void SQTable::AllocNodes(SQInteger nSize)
+{
+	SQInteger bytes = nSize * 2 * sizeof(SQObjectPtr) + nSize + SQ_TABLE_GROUP;
+	SQObjectPtr *keys = (SQObjectPtr *)SQ_MALLOC(bytes);
+	for(SQInteger i = 0; i < nSize * 2; i++)
+		new (&keys[i]) SQObjectPtr;
+	_keys = keys;
+	_vals = keys + nSize;
+	_ctrl = (unsigned char *)(keys + nSize * 2);
+	memset(_ctrl, SQ_CTRL_EMPTY, nSize + SQ_TABLE_GROUP);
+	_numofnodes = nSize;
+	_usednodes = 0;
+	_growthleft = MaxLoad(nSize);
+}
+
+void SQTable::FreeNodes(SQObjectPtr *keys, SQInteger nSize)
+{
+	for(SQInteger i = 0; i < nSize * 2; i++)
+		keys[i].~SQObjectPtr();
+	SQ_FREE(keys, nSize * 2 * sizeof(SQObjectPtr) + nSize + SQ_TABLE_GROUP);
+}
+
+void SQTable::Rehash(SQInteger nSize)
+{
+	SQInteger oldsize = _numofnodes;
+	SQObjectPtr *oldkeys = _keys;
+	SQObjectPtr *oldvals = _vals;
+	unsigned char *oldctrl = _ctrl;
+	AllocNodes(nSize);
+	for(SQInteger i = 0; i < oldsize; i++) {
+		if(SQ_CTRL_ISFULL(oldctrl[i])) {
+			/* keys are known to be unique, so only a free slot is looked for */
+			SQHash64 hash = HashSlot(oldkeys[i]);
+			SQInteger n = _FindFree(hash);
+			_SetCtrl(n, (unsigned char)(hash & 0x7F));
+			_keys[n] = oldkeys[i];
+			_vals[n] = oldvals[i];
+			_usednodes++;
+			_growthleft--;
+		}
+	}
+	FreeNodes(oldkeys, oldsize);
+}
+
+SQInteger SQTable::_FindFree(SQHash64 hash)
+{
+	SQInteger mask = _numofnodes - 1;
+	SQInteger pos = (SQInteger)(hash >> 7) & mask;
+	SQInteger stride = 0;
+	for(;;) {
+		SQTableGroup g(_ctrl + pos);
+		SQHash64 m = g.MatchFree();
+		if(m)
+			return (pos + SQTableGroup::Index(m)) & mask;
+		stride += SQ_TABLE_GROUP;
+		pos = (pos + stride) & mask;
+	}
+}
+
+void SQTable::Remove(const SQObjectPtr &key)
+{
+	SQInteger i = _Get(key, HashSlot(key));
+	if (i >= 0) {
+		_keys[i].Null();
+		_vals[i].Null();
+		_usednodes--;
+		/* a lookup in a table no bigger than a group sees every slot before it
+		   stops at an empty one, so the slot can be reused right away */
+		if(_numofnodes <= SQ_TABLE_GROUP) {
+			_SetCtrl(i, SQ_CTRL_EMPTY);
+			_growthleft++;
+		}
+		else {
+			_SetCtrl(i, SQ_CTRL_DELETED);
+		}
+		if(_usednodes <= _numofnodes / 4 && _numofnodes > MINPOWER2)
+			Rehash(_numofnodes / 2);
+	}
+}
+
+SQTable *SQTable::Clone()
+{
+	SQTable *nt=Create(_opt_ss(this),MaxLoad(_numofnodes));
+	assert(nt->_numofnodes == _numofnodes);
+	memcpy(nt->_ctrl, _ctrl, _numofnodes + SQ_TABLE_GROUP);
+	for(SQInteger i = 0; i < _numofnodes; i++) {
+		if(SQ_CTRL_ISFULL(_ctrl[i])) {
+			nt->_keys[i] = _keys[i];
+			nt->_vals[i] = _vals[i];
+		}
+	}
+	nt->_usednodes = _usednodes;
+	nt->_growthleft = _growthleft;
+	nt->SetDelegate(_delegate);
+	return nt;
+}
+
+bool SQTable::Get(const SQObjectPtr &key,SQObjectPtr &val)
+{
+	if(type(key) == OT_NULL)
+		return false;
+	SQInteger i = _Get(key, HashSlot(key));
+	if (i >= 0) {
+		val = _realval(_vals[i]);
+		return true;
+	}
+	return false;
+}
+
+bool SQTable::NewSlot(const SQObjectPtr &key,const SQObjectPtr &val)
+{
+	assert(type(key) != OT_NULL);
+	SQ_GC_BARRIER(_sharedstate,key);
+	SQ_GC_BARRIER(_sharedstate,val);
+	SQHash64 hash = HashSlot(key);
+	SQInteger i = _Get(key, hash);
+	if (i >= 0) {
+		_vals[i] = val;
+		return false;
+	}
+	i = _FindFree(hash);
+	if(_growthleft == 0 && _ctrl[i] != SQ_CTRL_DELETED) {
+		/* full: grow, unless most of the used slots are tombstones */
+		Rehash(_usednodes + 1 > MaxLoad(_numofnodes) / 2 ? _numofnodes * 2 : _numofnodes);
+		i = _FindFree(hash);
+	}
+	if(_ctrl[i] == SQ_CTRL_EMPTY)
+		_growthleft--;
+	_SetCtrl(i, (unsigned char)(hash & 0x7F));
+	_keys[i] = key;
+	_vals[i] = val;
+	_usednodes++;
+	return true;
+}
+
+SQInteger SQTable::Next(bool getweakrefs,const SQObjectPtr &refpos, SQObjectPtr &outkey, SQObjectPtr &outval)
+{
+	SQInteger idx = (SQInteger)TranslateIndex(refpos);
+	while (idx < _numofnodes) {
+		if(SQ_CTRL_ISFULL(_ctrl[idx])) {
+			//first found
+			outkey = _keys[idx];
+			outval = getweakrefs?(SQObject)_vals[idx]:_realval(_vals[idx]);
+			//return idx for the next iteration
+			return ++idx;
+		}
+		++idx;
+	}
+	//nothing to iterate anymore
+	return -1;
+}
+
+bool SQTable::Set(const SQObjectPtr &key, const SQObjectPtr &val)
+{
+	SQInteger i = _Get(key, HashSlot(key));
+	if (i >= 0) {
+		SQ_GC_BARRIER(_sharedstate,val);
+		_vals[i] = val;
+		return true;
+	}
+	return false;
+}
+
+void SQTable::_ClearNodes()
+{
+	for(SQInteger i = 0; i < _numofnodes; i++) {
+		if(SQ_CTRL_ISFULL(_ctrl[i])) {
+			_keys[i].Null();
+			_vals[i].Null();
+		}
+	}
+	memset(_ctrl, SQ_CTRL_EMPTY, _numofnodes + SQ_TABLE_GROUP);
+	_usednodes = 0;
+	_growthleft = MaxLoad(_numofnodes);
+}
+
+void SQTable::Finalize()
+{
+	_ClearNodes();
+	SetDelegate(NULL);
+}
+
+void SQTable::Clear()
+{
+	_ClearNodes();
+	if(_numofnodes > MINPOWER2)
+		Rehash(_numofnodes / 2);
+}
+
+#endif //SQ_SWISS_TABLE
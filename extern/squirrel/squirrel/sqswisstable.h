@@ -0,0 +1,181 @@
+/*	see copyright notice in squirrel.h */
+#ifndef _SQSWISSTABLE_H_
+#define _SQSWISSTABLE_H_
+/*
+	Open addressing table engine, selected with SQ_SWISS_TABLE.
+	Keys, values and one control byte per slot live in three separate
+	arrays. A control byte is either EMPTY, DELETED or the low 7 bits of the
+	key hash, so a probe compares a whole group of control bytes at once and
+	only touches the keys whose bits matched.
+	Tables smaller than a group are served by the first group alone: the
+	control bytes past the end mirror the start of the array.
+*/
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SQ_TABLE_GROUP 16
+#else
+#define SQ_TABLE_GROUP 8
+#endif
+
+#define SQ_CTRL_EMPTY ((unsigned char)0x80)
+#define SQ_CTRL_DELETED ((unsigned char)0xFE)
+#define SQ_CTRL_ISFULL(c) ((c) < 0x80)
+
+inline SQInteger _sqctz(SQHash64 m)
+{
+#if defined(_MSC_VER)
+	unsigned long r;
+#if defined(_M_X64)
+	_BitScanForward64(&r, m);
+#else
+	if((unsigned int)m) _BitScanForward(&r, (unsigned int)m);
+	else { _BitScanForward(&r, (unsigned int)(m >> 32)); r += 32; }
+#endif
+	return (SQInteger)r;
+#else
+	return (SQInteger)__builtin_ctzll(m);
+#endif
+}
+
+#if SQ_TABLE_GROUP == 16
+struct SQTableGroup
+{
+	SQTableGroup(const unsigned char *ctrl) { _ctrl = _mm_loadu_si128((const __m128i *)ctrl); }
+	SQHash64 Match(unsigned char h2) const { return (SQHash64)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8((char)h2), _ctrl)); }
+	SQHash64 MatchEmpty() const { return Match(SQ_CTRL_EMPTY); }
+	/* EMPTY and DELETED are the only control bytes below -1 */
+	SQHash64 MatchFree() const { return (SQHash64)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), _ctrl)); }
+	static SQInteger Index(SQHash64 m) { return _sqctz(m); }
+	__m128i _ctrl;
+};
+#else
+/* portable fallback: 8 control bytes in a word, one result bit per byte at bit 7 */
+#define SQ_GROUP_LSBS 0x0101010101010101ULL
+#define SQ_GROUP_MSBS 0x8080808080808080ULL
+struct SQTableGroup
+{
+	SQTableGroup(const unsigned char *ctrl)
+	{
+		/* assembled byte by byte so that byte i maps to bit 8*i+7 on any endianness */
+		_ctrl = 0;
+		for(SQInteger i = 0; i < 8; i++) _ctrl |= (SQHash64)ctrl[i] << (8 * i);
+	}
+	/* may report full slots that don't match; the key compare filters them */
+	SQHash64 Match(unsigned char h2) const { SQHash64 x = _ctrl ^ (SQ_GROUP_LSBS * h2); return (x - SQ_GROUP_LSBS) & ~x & SQ_GROUP_MSBS; }
+	SQHash64 MatchEmpty() const { return _ctrl & ~(_ctrl << 6) & SQ_GROUP_MSBS; }
+	SQHash64 MatchFree() const { return _ctrl & ~(_ctrl << 7) & SQ_GROUP_MSBS; }
+	static SQInteger Index(SQHash64 m) { return _sqctz(m) >> 3; }
+	SQHash64 _ctrl;
+};
+#endif
+
+/*
+	The probe position is the raw hash, as in the chained engine, so runs of
+	integer keys stay next to each other in memory. The 7 control bits come
+	from a multiplicative hash, which sets them even for keys that only
+	differ above them.
+*/
+inline SQHash64 _slothash(SQHash h) { return ((SQHash64)h << 7) | (((SQHash64)h * 0x9E3779B97F4A7C15ULL) >> 57); }
+inline SQHash64 HashSlot(const SQObjectPtr &key) { return _slothash(HashObj(key)); }
+
+struct SQTable : public SQDelegable
+{
+private:
+	SQObjectPtr *_keys;
+	SQObjectPtr *_vals;
+	unsigned char *_ctrl;
+	SQInteger _numofnodes;
+	SQInteger _usednodes;
+	SQInteger _growthleft; //free slots left before a rehash; tombstones aren't free
+
+///////////////////////////
+	void AllocNodes(SQInteger nSize);
+	void FreeNodes(SQObjectPtr *keys, SQInteger nSize);
+	void Rehash(SQInteger nSize);
+	SQTable(SQSharedState *ss, SQInteger nInitialSize);
+	void _ClearNodes();
+	static SQInteger MaxLoad(SQInteger nSize) { return nSize < 8 ? nSize - 1 : nSize - nSize / 8; }
+	inline void _SetCtrl(SQInteger i, unsigned char c)
+	{
+		_ctrl[i] = c;
+		for(SQInteger m = i + _numofnodes; m < _numofnodes + SQ_TABLE_GROUP; m += _numofnodes)
+			_ctrl[m] = c;
+	}
+	SQInteger _FindFree(SQHash64 hash);
+public:
+	static SQTable* Create(SQSharedState *ss,SQInteger nInitialSize)
+	{
+		SQTable *newtable = (SQTable*)SQ_MALLOC(sizeof(SQTable));
+		new (newtable) SQTable(ss, nInitialSize);
+		newtable->_delegate = NULL;
+		return newtable;
+	}
+	void Finalize();
+	SQTable *Clone();
+	~SQTable()
+	{
+		SetDelegate(NULL);
+		REMOVE_FROM_CHAIN(&_sharedstate->_gc_chain, this);
+		FreeNodes(_keys, _numofnodes);
+	}
+#ifndef NO_GARBAGE_COLLECTOR
+	void Mark(SQCollectable **chain);
+	SQObjectType GetType() {return OT_TABLE;}
+#endif
+	inline SQInteger _Get(const SQObjectPtr &key,SQHash64 hash)
+	{
+		SQInteger mask = _numofnodes - 1;
+		SQInteger pos = (SQInteger)(hash >> 7) & mask;
+		SQInteger stride = 0;
+		for(;;) {
+			SQTableGroup g(_ctrl + pos);
+			for(SQHash64 m = g.Match((unsigned char)(hash & 0x7F)); m; m &= m - 1) {
+				SQInteger i = (pos + SQTableGroup::Index(m)) & mask;
+				if(_rawval(_keys[i]) == _rawval(key) && type(_keys[i]) == type(key))
+					return i;
+			}
+			if(g.MatchEmpty())
+				return -1;
+			stride += SQ_TABLE_GROUP;
+			pos = (pos + stride) & mask;
+		}
+	}
+	//for compiler use
+	inline bool GetStr(const SQChar* key,SQInteger keylen,SQHash64 seed,SQObjectPtr &val)
+	{
+		SQHash64 hash = _slothash(_hashstr(key,keylen,seed));
+		SQInteger mask = _numofnodes - 1;
+		SQInteger pos = (SQInteger)(hash >> 7) & mask;
+		SQInteger stride = 0;
+		for(;;) {
+			SQTableGroup g(_ctrl + pos);
+			for(SQHash64 m = g.Match((unsigned char)(hash & 0x7F)); m; m &= m - 1) {
+				SQInteger i = (pos + SQTableGroup::Index(m)) & mask;
+				if(type(_keys[i]) == OT_STRING && (scstrcmp(_stringval(_keys[i]),key) == 0)) {
+					val = _realval(_vals[i]);
+					return true;
+				}
+			}
+			if(g.MatchEmpty())
+				return false;
+			stride += SQ_TABLE_GROUP;
+			pos = (pos + stride) & mask;
+		}
+	}
+	bool Get(const SQObjectPtr &key,SQObjectPtr &val);
+	void Remove(const SQObjectPtr &key);
+	bool Set(const SQObjectPtr &key, const SQObjectPtr &val);
+	//returns true if a new slot has been created false if it was already present
+	bool NewSlot(const SQObjectPtr &key,const SQObjectPtr &val);
+	SQInteger Next(bool getweakrefs,const SQObjectPtr &refpos, SQObjectPtr &outkey, SQObjectPtr &outval);
+
+	SQInteger CountUsed(){ return _usednodes;}
+	void Clear();
+	void Release()
+	{
+		sq_delete(this, SQTable);
+	}
+};
+
+#endif //_SQSWISSTABLE_H_
@@ -7,6 +7,8 @@ see copyright notice in squirrel.h
 #include "sqfuncproto.h"
 #include "sqclosure.h"
 
+#ifndef SQ_SWISS_TABLE
+
 SQTable::SQTable(SQSharedState *ss,SQInteger nInitialSize)
 {
 	SQInteger pow2size=MINPOWER2;
@@ -119,6 +121,8 @@ bool SQTable::Get(const SQObjectPtr &key,SQObjectPtr &val)
 bool SQTable::NewSlot(const SQObjectPtr &key,const SQObjectPtr &val)
 {
 	assert(type(key) != OT_NULL);
+	SQ_GC_BARRIER(_sharedstate,key);
+	SQ_GC_BARRIER(_sharedstate,val);
 	SQHash h = HashObj(key) & (_numofnodes - 1);
 	_HashNode *n = _Get(key, h);
 	if (n) {
@@ -196,6 +200,7 @@ bool SQTable::Set(const SQObjectPtr &key, const SQObjectPtr &val)
 {
 	_HashNode *n = _Get(key, HashObj(key) & (_numofnodes - 1));
 	if (n) {
+		SQ_GC_BARRIER(_sharedstate,val);
 		n->val = val;
 		return true;
 	}
@@ -219,3 +224,5 @@ void SQTable::Clear()
 	_usednodes = 0;
 	Rehash(true);
 }
+
+#endif //SQ_SWISS_TABLE
@@ -22,6 +22,10 @@ inline SQHash HashObj(const SQObjectPtr &key)
 	}
 }
 
+#ifdef SQ_SWISS_TABLE
+#include "sqswisstable.h"
+#else
+
 struct SQTable : public SQDelegable 
 {
 private:
@@ -74,9 +78,9 @@ public:
 		return NULL;
 	}
 	//for compiler use
-	inline bool GetStr(const SQChar* key,SQInteger keylen,SQObjectPtr &val)
+	inline bool GetStr(const SQChar* key,SQInteger keylen,SQHash64 seed,SQObjectPtr &val)
 	{
-		SQHash hash = _hashstr(key,keylen);
+		SQHash hash = _hashstr(key,keylen,seed);
 		_HashNode *n = &_nodes[hash & (_numofnodes - 1)];
 		_HashNode *res = NULL;
 		do{
@@ -107,4 +111,6 @@ public:
 	
 };
 
+#endif //SQ_SWISS_TABLE
+
 #endif //_SQTABLE_H_
@@ -0,0 +1,95 @@
+/*	see copyright notice in squirrel.h */
+#ifndef _SQTYPEDARRAY_H_
+#define _SQTYPEDARRAY_H_
+
+/*
+	Fixed size array of packed int32, float32 or float64 values stored
+	right after the header. It holds no references, so it is refcounted
+	but never needs to be traced by the collector.
+*/
+struct SQTypedArray : public SQRefCounted
+{
+private:
+	SQTypedArray(SQTypedArrayType elemtype,SQInteger size) : _elemtype(elemtype), _size(size) {}
+	~SQTypedArray() {}
+	static SQInteger HeaderSize() { return (sizeof(SQTypedArray) + 7) & ~7; } //keeps float64 elements aligned
+public:
+	//NULL if 'size' is out of range or the memory can't be allocated
+	static SQTypedArray* Create(SQTypedArrayType elemtype,SQInteger size){
+		if(size < 0 || size > MaxSize(elemtype)) return NULL;
+		SQTypedArray *a = (SQTypedArray*)SQ_MALLOC(HeaderSize() + size * ElementSize(elemtype));
+		if(!a) return NULL;
+		new (a) SQTypedArray(elemtype,size);
+		memset(a->Data(),0,size * ElementSize(elemtype));
+		return a;
+	}
+	static SQInteger ElementSize(SQTypedArrayType elemtype){
+		return elemtype == SQTA_FLOAT64 ? 8 : 4;
+	}
+	static SQInteger MaxSize(SQTypedArrayType elemtype){
+		return (SQ_MAX_ALLOC - HeaderSize()) / ElementSize(elemtype);
+	}
+	static const SQChar *TypeName(SQTypedArrayType elemtype){
+		switch(elemtype) {
+			case SQTA_INT32: return _SC("int32");
+			case SQTA_FLOAT32: return _SC("float32");
+			default: return _SC("float64");
+		}
+	}
+	void Release(){
+		SQInteger bytes = HeaderSize() + _size * ElementSize(_elemtype);
+		this->~SQTypedArray();
+		SQ_FREE(this,bytes);
+	}
+	SQUserPointer Data() { return (unsigned char *)this + HeaderSize(); }
+	SQInt32 *Int32s() { return (SQInt32 *)Data(); }
+	float *Float32s() { return (float *)Data(); }
+	double *Float64s() { return (double *)Data(); }
+	SQInteger Size() const { return _size; }
+	SQTypedArrayType ElementType() const { return _elemtype; }
+	//the caller checks the bounds
+	void GetAt(SQInteger idx,SQObjectPtr &val){
+		switch(_elemtype) {
+			case SQTA_INT32: val = (SQInteger)Int32s()[idx]; break;
+			case SQTA_FLOAT32: val = (SQFloat)Float32s()[idx]; break;
+			default: val = (SQFloat)Float64s()[idx]; break;
+		}
+	}
+	//'val' must be numeric; integers wrap to 32 bits like a C cast
+	void SetAt(SQInteger idx,const SQObject &val){
+		switch(_elemtype) {
+			case SQTA_INT32: Int32s()[idx] = (SQInt32)(SQUnsignedInteger32)tointeger(val); break;
+			case SQTA_FLOAT32: Float32s()[idx] = (float)(type(val) == OT_INTEGER ? (double)_integer(val) : _float(val)); break;
+			default: Float64s()[idx] = type(val) == OT_INTEGER ? (double)_integer(val) : (double)_float(val); break;
+		}
+	}
+	bool Get(const SQInteger nidx,SQObjectPtr &val){
+		if(nidx < 0 || nidx >= _size) return false;
+		GetAt(nidx,val);
+		return true;
+	}
+	bool Set(const SQInteger nidx,const SQObject &val){
+		if(nidx < 0 || nidx >= _size) return false;
+		SetAt(nidx,val);
+		return true;
+	}
+	SQInteger Next(const SQObjectPtr &refpos,SQObjectPtr &outkey,SQObjectPtr &outval){
+		SQInteger idx = type(refpos) == OT_NULL ? 0 : tointeger(refpos);
+		if(idx < 0 || idx >= _size) return -1;
+		outkey = idx;
+		GetAt(idx,outval);
+		return idx + 1;
+	}
+	//NULL if the memory can't be allocated
+	SQTypedArray *Clone(){
+		SQTypedArray *anew = Create(_elemtype,_size);
+		if(!anew) return NULL;
+		memcpy(anew->Data(),Data(),_size * ElementSize(_elemtype));
+		return anew;
+	}
+
+	SQTypedArrayType _elemtype;
+	SQInteger _size;
+};
+
+#endif //_SQTYPEDARRAY_H_
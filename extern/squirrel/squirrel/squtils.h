@@ -11,6 +11,8 @@ void sq_vm_free(void *p,SQUnsignedInteger size);
 #define SQ_MALLOC(__size) sq_vm_malloc((__size));
 #define SQ_FREE(__ptr,__size) sq_vm_free((__ptr),(__size));
 #define SQ_REALLOC(__ptr,__oldsize,__size) sq_vm_realloc((__ptr),(__oldsize),(__size));
+//largest size worth asking SQ_MALLOC for; leaves room for size arithmetic without overflowing
+#define SQ_MAX_ALLOC ((SQInteger)(((SQUnsignedInteger)-1) >> 2))
 
 #define sq_aligning(v) (((size_t)(v) + (SQ_ALIGNMENT-1)) & (~(SQ_ALIGNMENT-1)))
 
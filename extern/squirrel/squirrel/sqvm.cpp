@@ -12,6 +12,7 @@
 #include "sqtable.h"
 #include "squserdata.h"
 #include "sqarray.h"
+#include "sqtypedarray.h"
 #include "sqclass.h"
 
 #define TOP() (_stack._vals[_top-1])
@@ -59,6 +60,35 @@ bool SQVM::BW_OP(SQUnsignedInteger op,SQObjectPtr &trg,const SQObjectPtr &o1,con
 	} \
 }
 
+//turns the running instruction into its _II or _FF variant when both operands have that type
+#define _QUICKEN_(iiop,ffop,o1,o2) \
+{ \
+	if(_ss(this)->_quickening && (arg3 >> QUICKEN_DEOPT_SHIFT) < QUICKEN_MAX_DEOPTS) { \
+		SQInteger qmask = type(o1)|type(o2); \
+		if(qmask == OT_INTEGER) ci->_ip[-1].op = iiop; \
+		else if(qmask == OT_FLOAT) ci->_ip[-1].op = ffop; \
+	} \
+}
+
+#define _DEOPTIMIZE_(genericop) \
+{ \
+	SQInstruction &q = ci->_ip[-1]; \
+	q.op = genericop; \
+	if((q._arg3 >> QUICKEN_DEOPT_SHIFT) < QUICKEN_MAX_DEOPTS) q._arg3 += (1 << QUICKEN_DEOPT_SHIFT); \
+}
+
+//CMP_OP on the result of ObjCmp, for operands of the same numeric type
+static inline bool QuickCompare(SQInteger op,SQInteger r)
+{
+	switch(op) {
+		case CMP_G: return r > 0;
+		case CMP_GE: return r >= 0;
+		case CMP_L: return r < 0;
+		case CMP_LE: return r <= 0;
+		default: return r != 0;
+	}
+}
+
 bool SQVM::ARITH_OP(SQUnsignedInteger op,SQObjectPtr &trg,const SQObjectPtr &o1,const SQObjectPtr &o2)
 {
 	SQInteger tmask = type(o1)|type(o2);
@@ -520,6 +550,9 @@ bool SQVM::FOREACH_OP(SQObjectPtr &o1,SQObjectPtr &o2,SQObjectPtr
 	case OT_ARRAY:
 		if((nrefidx = _array(o1)->Next(o4, o2, o3)) == -1) _FINISH(exitpos);
 		o4 = (SQInteger) nrefidx; _FINISH(1);
+	case OT_TYPEDARRAY:
+		if((nrefidx = _typedarray(o1)->Next(o4, o2, o3)) == -1) _FINISH(exitpos);
+		o4 = (SQInteger) nrefidx; _FINISH(1);
 	case OT_STRING:
 		if((nrefidx = _string(o1)->Next(o4, o2, o3)) == -1)_FINISH(exitpos);
 		o4 = (SQInteger)nrefidx; _FINISH(1);
@@ -575,6 +608,25 @@ bool SQVM::FOREACH_OP(SQObjectPtr &o1,SQObjectPtr &o2,SQObjectPtr
 
 #define _GUARD(exp) { if(!exp) { SQ_THROW();} }
 
+#define FALLBACK_OK			0
+#define FALLBACK_NO_MATCH	1
+#define FALLBACK_ERROR		2
+
+/*
+	With SQ_USE_COMPUTED_GOTO every opcode handler ends in its own indirect
+	jump through _dispatch_table instead of returning to the shared switch,
+	so the branch predictor sees one dispatch site per opcode.
+	A computed goto does not run destructors, so handlers leaving a scope
+	that holds SQObjectPtr locals must use 'continue' instead of SQ_NEXT().
+*/
+#ifdef SQ_USE_COMPUTED_GOTO
+#define SQ_OPCASE(op) case op: _L##op
+#define SQ_NEXT() { _i_ = *ci->_ip++; goto *_dispatch_table[_i_.op]; }
+#else
+#define SQ_OPCASE(op) case op
+#define SQ_NEXT() continue
+#endif
+
 bool SQVM::CLOSURE_OP(SQObjectPtr &target, SQFunctionProto *func)
 {
 	SQInteger nouters;
@@ -695,24 +747,46 @@ bool SQVM::Execute(SQObjectPtr &closure, SQInteger nargs, SQInteger stackbase,SQ
 exception_restore:
 	//
 	{
+#ifdef SQ_USE_COMPUTED_GOTO
+		/* indexed by SQOpcode, keep in the same order */
+		static const void *_dispatch_table[] = {
+			&&_L_OP_LINE, &&_L_OP_LOAD, &&_L_OP_LOADINT, &&_L_OP_LOADFLOAT, &&_L_OP_DLOAD,
+			&&_L_OP_TAILCALL, &&_L_OP_CALL, &&_L_OP_PREPCALL, &&_L_OP_PREPCALLK, &&_L_OP_GETK,
+			&&_L_OP_MOVE, &&_L_OP_NEWSLOT, &&_L_OP_DELETE, &&_L_OP_SET, &&_L_OP_GET,
+			&&_L_OP_EQ, &&_L_OP_NE, &&_L_OP_ADD, &&_L_OP_SUB, &&_L_OP_MUL,
+			&&_L_OP_DIV, &&_L_OP_MOD, &&_L_OP_BITW, &&_L_OP_RETURN, &&_L_OP_LOADNULLS,
+			&&_L_OP_LOADROOT, &&_L_OP_LOADBOOL, &&_L_OP_DMOVE, &&_L_OP_JMP, &&_L_OP_JCMP,
+			&&_L_OP_JZ, &&_L_OP_SETOUTER, &&_L_OP_GETOUTER, &&_L_OP_NEWOBJ, &&_L_OP_APPENDARRAY,
+			&&_L_OP_COMPARITH, &&_L_OP_INC, &&_L_OP_INCL, &&_L_OP_PINC, &&_L_OP_PINCL,
+			&&_L_OP_CMP, &&_L_OP_EXISTS, &&_L_OP_INSTANCEOF, &&_L_OP_AND, &&_L_OP_OR,
+			&&_L_OP_NEG, &&_L_OP_NOT, &&_L_OP_BWNOT, &&_L_OP_CLOSURE, &&_L_OP_YIELD,
+			&&_L_OP_RESUME, &&_L_OP_FOREACH, &&_L_OP_POSTFOREACH, &&_L_OP_CLONE, &&_L_OP_TYPEOF,
+			&&_L_OP_PUSHTRAP, &&_L_OP_POPTRAP, &&_L_OP_THROW, &&_L_OP_NEWSLOTA, &&_L_OP_GETBASE,
+			&&_L_OP_CLOSE, &&_L_OP_JCMPK, &&_L_OP_CALLK, &&_L_OP_INCLJMP, &&_L_OP_ADD_II,
+			&&_L_OP_ADD_FF, &&_L_OP_SUB_II, &&_L_OP_SUB_FF, &&_L_OP_MUL_II, &&_L_OP_MUL_FF,
+			&&_L_OP_JCMP_II, &&_L_OP_JCMP_FF
+		};
+		static_assert(sizeof(_dispatch_table) / sizeof(_dispatch_table[0]) == _OP_JCMP_FF + 1, "one label per opcode");
+#endif
+		SQInstruction _i_;
 		for(;;)
 		{
-			const SQInstruction &_i_ = *ci->_ip++;
+			_i_ = *ci->_ip++;
 			//dumpstack(_stackbase);
 			//scprintf("\n[%d] %s %d %d %d %d\n",ci->_ip-_closure(ci->_closure)->_function->_instructions,g_InstrDesc[_i_.op].name,arg0,arg1,arg2,arg3);
 			switch(_i_.op)
 			{
-			case _OP_LINE: if (_debughook) CallDebugHook(_SC('l'),arg1); continue;
-			case _OP_LOAD: TARGET = ci->_literals[arg1]; continue;
-			case _OP_LOADINT: 
+			SQ_OPCASE(_OP_LINE): if (_debughook) CallDebugHook(_SC('l'),arg1); SQ_NEXT();
+			SQ_OPCASE(_OP_LOAD): TARGET = ci->_literals[arg1]; SQ_NEXT();
+			SQ_OPCASE(_OP_LOADINT): 
 #ifndef _SQ64
-				TARGET = (SQInteger)arg1; continue;
+				TARGET = (SQInteger)arg1; SQ_NEXT();
 #else
-				TARGET = (SQInteger)((SQUnsignedInteger32)arg1); continue;
+				TARGET = (SQInteger)((SQUnsignedInteger32)arg1); SQ_NEXT();
 #endif
-			case _OP_LOADFLOAT: TARGET = *((SQFloat *)&arg1); continue;
-			case _OP_DLOAD: TARGET = ci->_literals[arg1]; STK(arg2) = ci->_literals[arg3];continue;
-			case _OP_TAILCALL:{
+			SQ_OPCASE(_OP_LOADFLOAT): TARGET = *((SQFloat *)&arg1); SQ_NEXT();
+			SQ_OPCASE(_OP_DLOAD): TARGET = ci->_literals[arg1]; STK(arg2) = ci->_literals[arg3];SQ_NEXT();
+			SQ_OPCASE(_OP_TAILCALL):{
 				SQObjectPtr &t = STK(arg1);
 				if (type(t) == OT_CLOSURE 
 					&& (!_closure(t)->_function->_bgenerator)){
@@ -723,7 +797,8 @@ exception_restore:
 					continue;
 				}
 							  }
-			case _OP_CALL: {
+			SQ_OPCASE(_OP_CALL):
+			call_op: {
 					SQObjectPtr clo = STK(arg1);
 					switch (type(clo)) {
 					case OT_CLOSURE:
@@ -790,9 +865,9 @@ exception_restore:
 						SQ_THROW();
 					}
 				}
-				  continue;
-			case _OP_PREPCALL:
-			case _OP_PREPCALLK:	{
+				  SQ_NEXT();
+			SQ_OPCASE(_OP_PREPCALL):
+			SQ_OPCASE(_OP_PREPCALLK):	{
 					SQObjectPtr &key = _i_.op == _OP_PREPCALLK?(ci->_literals)[arg1]:STK(arg1);
 					SQObjectPtr &o = STK(arg2);
 					if (!Get(o, key, temp_reg,false,arg2)) {
@@ -801,42 +876,48 @@ exception_restore:
 					STK(arg3) = o;
 					_Swap(TARGET,temp_reg);//TARGET = temp_reg;
 				}
-				continue;
-			case _OP_GETK:
-				if (!Get(STK(arg2), ci->_literals[arg1], temp_reg, false,arg2)) { SQ_THROW();}
+				SQ_NEXT();
+			SQ_OPCASE(_OP_GETK): {
+				SQInteger cached = GetCached(STK(arg2), ci->_literals[arg1], temp_reg);
+				if (cached == FALLBACK_ERROR
+					|| (cached == FALLBACK_NO_MATCH && !Get(STK(arg2), ci->_literals[arg1], temp_reg, false,arg2))) { SQ_THROW();}
+				}
 				_Swap(TARGET,temp_reg);//TARGET = temp_reg;
-				continue;
-			case _OP_MOVE: TARGET = STK(arg1); continue;
-			case _OP_NEWSLOT:
+				SQ_NEXT();
+			SQ_OPCASE(_OP_MOVE): TARGET = STK(arg1); SQ_NEXT();
+			SQ_OPCASE(_OP_NEWSLOT):
 				_GUARD(NewSlot(STK(arg1), STK(arg2), STK(arg3),false));
 				if(arg0 != 0xFF) TARGET = STK(arg3);
-				continue;
-			case _OP_DELETE: _GUARD(DeleteSlot(STK(arg1), STK(arg2), TARGET)); continue;
-			case _OP_SET:
+				SQ_NEXT();
+			SQ_OPCASE(_OP_DELETE): _GUARD(DeleteSlot(STK(arg1), STK(arg2), TARGET)); SQ_NEXT();
+			SQ_OPCASE(_OP_SET):
 				if (!Set(STK(arg1), STK(arg2), STK(arg3),arg1)) { SQ_THROW(); }
 				if (arg0 != 0xFF) TARGET = STK(arg3);
-				continue;
-			case _OP_GET:
-				if (!Get(STK(arg1), STK(arg2), temp_reg, false,arg1)) { SQ_THROW(); }
+				SQ_NEXT();
+			SQ_OPCASE(_OP_GET): {
+				SQInteger cached = GetCached(STK(arg1), STK(arg2), temp_reg);
+				if (cached == FALLBACK_ERROR
+					|| (cached == FALLBACK_NO_MATCH && !Get(STK(arg1), STK(arg2), temp_reg, false,arg1))) { SQ_THROW(); }
+				}
 				_Swap(TARGET,temp_reg);//TARGET = temp_reg;
-				continue;
-			case _OP_EQ:{
+				SQ_NEXT();
+			SQ_OPCASE(_OP_EQ):{
 				bool res;
 				if(!IsEqual(STK(arg2),COND_LITERAL,res)) { SQ_THROW(); }
 				TARGET = res?true:false;
-				}continue;
-			case _OP_NE:{ 
+				}SQ_NEXT();
+			SQ_OPCASE(_OP_NE):{ 
 				bool res;
 				if(!IsEqual(STK(arg2),COND_LITERAL,res)) { SQ_THROW(); }
 				TARGET = (!res)?true:false;
-				} continue;
-			case _OP_ADD: _ARITH_(+,TARGET,STK(arg2),STK(arg1)); continue;
-			case _OP_SUB: _ARITH_(-,TARGET,STK(arg2),STK(arg1)); continue;
-			case _OP_MUL: _ARITH_(*,TARGET,STK(arg2),STK(arg1)); continue;
-			case _OP_DIV: _ARITH_NOZERO(/,TARGET,STK(arg2),STK(arg1),_SC("division by zero")); continue;
-			case _OP_MOD: ARITH_OP('%',TARGET,STK(arg2),STK(arg1)); continue;
-			case _OP_BITW:	_GUARD(BW_OP( arg3,TARGET,STK(arg2),STK(arg1))); continue;
-			case _OP_RETURN:
+				} SQ_NEXT();
+			SQ_OPCASE(_OP_ADD): _QUICKEN_(_OP_ADD_II,_OP_ADD_FF,STK(arg2),STK(arg1)); _ARITH_(+,TARGET,STK(arg2),STK(arg1)); SQ_NEXT();
+			SQ_OPCASE(_OP_SUB): _QUICKEN_(_OP_SUB_II,_OP_SUB_FF,STK(arg2),STK(arg1)); _ARITH_(-,TARGET,STK(arg2),STK(arg1)); SQ_NEXT();
+			SQ_OPCASE(_OP_MUL): _QUICKEN_(_OP_MUL_II,_OP_MUL_FF,STK(arg2),STK(arg1)); _ARITH_(*,TARGET,STK(arg2),STK(arg1)); SQ_NEXT();
+			SQ_OPCASE(_OP_DIV): _ARITH_NOZERO(/,TARGET,STK(arg2),STK(arg1),_SC("division by zero")); SQ_NEXT();
+			SQ_OPCASE(_OP_MOD): ARITH_OP('%',TARGET,STK(arg2),STK(arg1)); SQ_NEXT();
+			SQ_OPCASE(_OP_BITW):	_GUARD(BW_OP( arg3,TARGET,STK(arg2),STK(arg1))); SQ_NEXT();
+			SQ_OPCASE(_OP_RETURN):
 				if((ci)->_generator) {
 					(ci)->_generator->Kill();
 				}
@@ -846,9 +927,9 @@ exception_restore:
 					_Swap(outres,temp_reg);
 					return true;
 				}
-				continue;
-			case _OP_LOADNULLS:{ for(SQInt32 n=0; n < arg1; n++) STK(arg0+n).Null(); }continue;
-			case _OP_LOADROOT:	{
+				SQ_NEXT();
+			SQ_OPCASE(_OP_LOADNULLS):{ for(SQInt32 n=0; n < arg1; n++) STK(arg0+n).Null(); }SQ_NEXT();
+			SQ_OPCASE(_OP_LOADROOT):	{
 				SQWeakRef *w = _closure(ci->_closure)->_root;
 				if(type(w->_obj) != OT_NULL) {
 					TARGET = w->_obj;
@@ -856,39 +937,41 @@ exception_restore:
 					TARGET = _roottable; //shoud this be like this? or null
 				}
 								}
-				continue;
-			case _OP_LOADBOOL: TARGET = arg1?true:false; continue;
-			case _OP_DMOVE: STK(arg0) = STK(arg1); STK(arg2) = STK(arg3); continue;
-			case _OP_JMP: ci->_ip += (sarg1); continue;
+				SQ_NEXT();
+			SQ_OPCASE(_OP_LOADBOOL): TARGET = arg1?true:false; SQ_NEXT();
+			SQ_OPCASE(_OP_DMOVE): STK(arg0) = STK(arg1); STK(arg2) = STK(arg3); SQ_NEXT();
+			SQ_OPCASE(_OP_JMP): ci->_ip += (sarg1); SQ_NEXT();
 			//case _OP_JNZ: if(!IsFalse(STK(arg0))) ci->_ip+=(sarg1); continue;
-			case _OP_JCMP: 
-				_GUARD(CMP_OP((CmpOP)arg3,STK(arg2),STK(arg0),temp_reg));
+			SQ_OPCASE(_OP_JCMP): 
+				_QUICKEN_(_OP_JCMP_II,_OP_JCMP_FF,STK(arg2),STK(arg0));
+				_GUARD(CMP_OP((CmpOP)(arg3 & QUICKEN_ARG3_MASK),STK(arg2),STK(arg0),temp_reg));
 				if(IsFalse(temp_reg)) ci->_ip+=(sarg1);
-				continue;
-			case _OP_JZ: if(IsFalse(STK(arg0))) ci->_ip+=(sarg1); continue;
-			case _OP_GETOUTER: {
+				SQ_NEXT();
+			SQ_OPCASE(_OP_JZ): if(IsFalse(STK(arg0))) ci->_ip+=(sarg1); SQ_NEXT();
+			SQ_OPCASE(_OP_GETOUTER): {
 				SQClosure *cur_cls = _closure(ci->_closure);
 				SQOuter *otr = _outer(cur_cls->_outervalues[arg1]);
 				TARGET = *(otr->_valptr);
 				}
-			continue;
-			case _OP_SETOUTER: {
+			SQ_NEXT();
+			SQ_OPCASE(_OP_SETOUTER): {
 				SQClosure *cur_cls = _closure(ci->_closure);
 				SQOuter   *otr = _outer(cur_cls->_outervalues[arg1]);
+				SQ_GC_BARRIER(_ss(this),STK(arg2));
 				*(otr->_valptr) = STK(arg2);
 				if(arg0 != 0xFF) {
 					TARGET = STK(arg2);
 				}
 				}
-			continue;
-			case _OP_NEWOBJ: 
+			SQ_NEXT();
+			SQ_OPCASE(_OP_NEWOBJ): 
 				switch(arg3) {
-					case NOT_TABLE: TARGET = SQTable::Create(_ss(this), arg1); continue;
-					case NOT_ARRAY: TARGET = SQArray::Create(_ss(this), 0); _array(TARGET)->Reserve(arg1); continue;
-					case NOT_CLASS: _GUARD(CLASS_OP(TARGET,arg1,arg2)); continue;
-					default: assert(0); continue;
+					case NOT_TABLE: TARGET = SQTable::Create(_ss(this), arg1); SQ_NEXT();
+					case NOT_ARRAY: TARGET = SQArray::Create(_ss(this), 0); _array(TARGET)->Reserve(arg1); SQ_NEXT();
+					case NOT_CLASS: _GUARD(CLASS_OP(TARGET,arg1,arg2)); SQ_NEXT();
+					default: assert(0); SQ_NEXT();
 				}
-			case _OP_APPENDARRAY: 
+			SQ_OPCASE(_OP_APPENDARRAY): 
 				{
 					SQObject val;
 					val._unVal.raw = 0;
@@ -916,15 +999,15 @@ exception_restore:
 				default: assert(0); break;
 
 				}
-				_array(STK(arg0))->Append(val);	continue;
+				_array(STK(arg0))->Append(val);	SQ_NEXT();
 				}
-			case _OP_COMPARITH: {
+			SQ_OPCASE(_OP_COMPARITH): {
 				SQInteger selfidx = (((SQUnsignedInteger)arg1&0xFFFF0000)>>16);
 				_GUARD(DerefInc(arg3, TARGET, STK(selfidx), STK(arg2), STK(arg1&0x0000FFFF), false, selfidx)); 
 								}
-				continue;
-			case _OP_INC: {SQObjectPtr o(sarg3); _GUARD(DerefInc('+',TARGET, STK(arg1), STK(arg2), o, false, arg1));} continue;
-			case _OP_INCL: {
+				SQ_NEXT();
+			SQ_OPCASE(_OP_INC): {SQObjectPtr o(sarg3); _GUARD(DerefInc('+',TARGET, STK(arg1), STK(arg2), o, false, arg1));} SQ_NEXT();
+			SQ_OPCASE(_OP_INCL): {
 				SQObjectPtr &a = STK(arg1);
 				if(type(a) == OT_INTEGER) {
 					a._unVal.nInteger = _integer(a) + sarg3;
@@ -933,9 +1016,9 @@ exception_restore:
 					SQObjectPtr o(sarg3); //_GUARD(LOCAL_INC('+',TARGET, STK(arg1), o));
 					_ARITH_(+,a,a,o);
 				}
-						   } continue;
-			case _OP_PINC: {SQObjectPtr o(sarg3); _GUARD(DerefInc('+',TARGET, STK(arg1), STK(arg2), o, true, arg1));} continue;
-			case _OP_PINCL:	{
+						   } SQ_NEXT();
+			SQ_OPCASE(_OP_PINC): {SQObjectPtr o(sarg3); _GUARD(DerefInc('+',TARGET, STK(arg1), STK(arg2), o, true, arg1));} SQ_NEXT();
+			SQ_OPCASE(_OP_PINCL):	{
 				SQObjectPtr &a = STK(arg1);
 				if(type(a) == OT_INTEGER) {
 					TARGET = a;
@@ -945,43 +1028,43 @@ exception_restore:
 					SQObjectPtr o(sarg3); _GUARD(PLOCAL_INC('+',TARGET, STK(arg1), o));
 				}
 				
-						} continue;
-			case _OP_CMP:	_GUARD(CMP_OP((CmpOP)arg3,STK(arg2),STK(arg1),TARGET))	continue;
-			case _OP_EXISTS: TARGET = Get(STK(arg1), STK(arg2), temp_reg, true,DONT_FALL_BACK)?true:false;continue;
-			case _OP_INSTANCEOF: 
+						} SQ_NEXT();
+			SQ_OPCASE(_OP_CMP):	_GUARD(CMP_OP((CmpOP)arg3,STK(arg2),STK(arg1),TARGET))	SQ_NEXT();
+			SQ_OPCASE(_OP_EXISTS): TARGET = Get(STK(arg1), STK(arg2), temp_reg, true,DONT_FALL_BACK)?true:false;SQ_NEXT();
+			SQ_OPCASE(_OP_INSTANCEOF): 
 				if(type(STK(arg1)) != OT_CLASS)
 				{Raise_Error(_SC("cannot apply instanceof between a %s and a %s"),GetTypeName(STK(arg1)),GetTypeName(STK(arg2))); SQ_THROW();}
 				TARGET = (type(STK(arg2)) == OT_INSTANCE) ? (_instance(STK(arg2))->InstanceOf(_class(STK(arg1)))?true:false) : false;
-				continue;
-			case _OP_AND: 
+				SQ_NEXT();
+			SQ_OPCASE(_OP_AND): 
 				if(IsFalse(STK(arg2))) {
 					TARGET = STK(arg2);
 					ci->_ip += (sarg1);
 				}
-				continue;
-			case _OP_OR:
+				SQ_NEXT();
+			SQ_OPCASE(_OP_OR):
 				if(!IsFalse(STK(arg2))) {
 					TARGET = STK(arg2);
 					ci->_ip += (sarg1);
 				}
-				continue;
-			case _OP_NEG: _GUARD(NEG_OP(TARGET,STK(arg1))); continue;
-			case _OP_NOT: TARGET = IsFalse(STK(arg1)); continue;
-			case _OP_BWNOT:
+				SQ_NEXT();
+			SQ_OPCASE(_OP_NEG): _GUARD(NEG_OP(TARGET,STK(arg1))); SQ_NEXT();
+			SQ_OPCASE(_OP_NOT): TARGET = IsFalse(STK(arg1)); SQ_NEXT();
+			SQ_OPCASE(_OP_BWNOT):
 				if(type(STK(arg1)) == OT_INTEGER) {
 					SQInteger t = _integer(STK(arg1));
 					TARGET = SQInteger(~t);
-					continue;
+					SQ_NEXT();
 				}
 				Raise_Error(_SC("attempt to perform a bitwise op on a %s"), GetTypeName(STK(arg1)));
 				SQ_THROW();
-			case _OP_CLOSURE: {
+			SQ_OPCASE(_OP_CLOSURE): {
 				SQClosure *c = ci->_closure._unVal.pClosure;
 				SQFunctionProto *fp = c->_function;
 				if(!CLOSURE_OP(TARGET,fp->_functions[arg1]._unVal.pFunctionProto)) { SQ_THROW(); }
-				continue;
+				SQ_NEXT();
 			}
-			case _OP_YIELD:{
+			SQ_OPCASE(_OP_YIELD):{
 				if(ci->_generator) {
 					if(sarg1 != MAX_FUNC_STACKSIZE) temp_reg = STK(arg1);
 					_GUARD(ci->_generator->Yield(this,arg2));
@@ -996,41 +1079,41 @@ exception_restore:
 				}
 					
 				}
-				continue;
-			case _OP_RESUME:
+				SQ_NEXT();
+			SQ_OPCASE(_OP_RESUME):
 				if(type(STK(arg1)) != OT_GENERATOR){ Raise_Error(_SC("trying to resume a '%s',only genenerator can be resumed"), GetTypeName(STK(arg1))); SQ_THROW();}
 				_GUARD(_generator(STK(arg1))->Resume(this, TARGET));
 				traps += ci->_etraps;
-                continue;
-			case _OP_FOREACH:{ int tojump;
+                SQ_NEXT();
+			SQ_OPCASE(_OP_FOREACH):{ int tojump;
 				_GUARD(FOREACH_OP(STK(arg0),STK(arg2),STK(arg2+1),STK(arg2+2),arg2,sarg1,tojump));
 				ci->_ip += tojump; }
-				continue;
-			case _OP_POSTFOREACH:
+				SQ_NEXT();
+			SQ_OPCASE(_OP_POSTFOREACH):
 				assert(type(STK(arg0)) == OT_GENERATOR);
 				if(_generator(STK(arg0))->_state == SQGenerator::eDead) 
 					ci->_ip += (sarg1 - 1);
-				continue;
-			case _OP_CLONE: _GUARD(Clone(STK(arg1), TARGET)); continue;
-			case _OP_TYPEOF: _GUARD(TypeOf(STK(arg1), TARGET)) continue;
-			case _OP_PUSHTRAP:{
+				SQ_NEXT();
+			SQ_OPCASE(_OP_CLONE): _GUARD(Clone(STK(arg1), TARGET)); SQ_NEXT();
+			SQ_OPCASE(_OP_TYPEOF): _GUARD(TypeOf(STK(arg1), TARGET)) SQ_NEXT();
+			SQ_OPCASE(_OP_PUSHTRAP):{
 				SQInstruction *_iv = _closure(ci->_closure)->_function->_instructions;
 				_etraps.push_back(SQExceptionTrap(_top,_stackbase, &_iv[(ci->_ip-_iv)+arg1], arg0)); traps++;
 				ci->_etraps++;
 							  }
-				continue;
-			case _OP_POPTRAP: {
+				SQ_NEXT();
+			SQ_OPCASE(_OP_POPTRAP): {
 				for(SQInteger i = 0; i < arg0; i++) {
 					_etraps.pop_back(); traps--;
 					ci->_etraps--;
 				}
 							  }
-				continue;
-			case _OP_THROW:	Raise_Error(TARGET); SQ_THROW(); continue;
-			case _OP_NEWSLOTA:
+				SQ_NEXT();
+			SQ_OPCASE(_OP_THROW):	Raise_Error(TARGET); SQ_THROW(); SQ_NEXT();
+			SQ_OPCASE(_OP_NEWSLOTA):
 				_GUARD(NewSlotA(STK(arg1),STK(arg2),STK(arg3),(arg0&NEW_SLOT_ATTRIBUTES_FLAG) ? STK(arg2-1) : SQObjectPtr(),(arg0&NEW_SLOT_STATIC_FLAG)?true:false,false));
-				continue;
-			case _OP_GETBASE:{
+				SQ_NEXT();
+			SQ_OPCASE(_OP_GETBASE):{
 				SQClosure *clo = _closure(ci->_closure);
 				if(clo->_base) {
 					TARGET = clo->_base;
@@ -1038,11 +1121,117 @@ exception_restore:
 				else {
 					TARGET.Null();
 				}
-				continue;
+				SQ_NEXT();
 			}
-			case _OP_CLOSE:
+			SQ_OPCASE(_OP_CLOSE):
 				if(_openouters) CloseOuters(&(STK(arg1)));
-				continue;
+				SQ_NEXT();
+			SQ_OPCASE(_OP_JCMPK): {
+				const SQObjectPtr &a = STK(arg2), &k = ci->_literals[arg0];
+				if((type(a) | type(k)) == OT_INTEGER) {
+					bool res;
+					switch(arg3) {
+						case CMP_G: res = _integer(a) > _integer(k); break;
+						case CMP_GE: res = _integer(a) >= _integer(k); break;
+						case CMP_L: res = _integer(a) < _integer(k); break;
+						default: res = _integer(a) <= _integer(k); break;
+					}
+					if(!res) ci->_ip += (sarg1);
+					SQ_NEXT();
+				}
+				_GUARD(CMP_OP((CmpOP)arg3,a,k,temp_reg));
+				if(IsFalse(temp_reg)) ci->_ip += (sarg1);
+				}
+				SQ_NEXT();
+			SQ_OPCASE(_OP_CALLK): {
+				SQObjectPtr &o = STK(arg2);
+				if (!Get(o, ci->_literals[arg1], temp_reg, false, arg2)) {
+					SQ_THROW();
+				}
+				STK(arg0 + 1) = o;
+				_Swap(TARGET,temp_reg);//TARGET = temp_reg;
+				}
+				_i_ = SQInstruction(_OP_CALL, (arg3 & CALLK_DISCARD_RESULT) ? 0xFF : arg0, arg0, arg0 + 1, arg3 & ~CALLK_DISCARD_RESULT);
+				goto call_op;
+			SQ_OPCASE(_OP_INCLJMP): {
+				SQObjectPtr &a = STK(arg0);
+				if(type(a) == OT_INTEGER) {
+					a._unVal.nInteger = _integer(a) + sarg3;
+				}
+				else {
+					SQObjectPtr o(sarg3);
+					_ARITH_(+,a,a,o);
+				}
+				}
+				ci->_ip += (sarg1);
+				SQ_NEXT();
+			SQ_OPCASE(_OP_ADD_II): {
+				const SQObjectPtr &o1 = STK(arg2), &o2 = STK(arg1);
+				if((type(o1)|type(o2)) == OT_INTEGER) { TARGET = _integer(o1) + _integer(o2); SQ_NEXT(); }
+				_DEOPTIMIZE_(_OP_ADD);
+				_ARITH_(+,TARGET,o1,o2);
+				}
+				SQ_NEXT();
+			SQ_OPCASE(_OP_ADD_FF): {
+				const SQObjectPtr &o1 = STK(arg2), &o2 = STK(arg1);
+				if((type(o1)|type(o2)) == OT_FLOAT) { TARGET = _float(o1) + _float(o2); SQ_NEXT(); }
+				_DEOPTIMIZE_(_OP_ADD);
+				_ARITH_(+,TARGET,o1,o2);
+				}
+				SQ_NEXT();
+			SQ_OPCASE(_OP_SUB_II): {
+				const SQObjectPtr &o1 = STK(arg2), &o2 = STK(arg1);
+				if((type(o1)|type(o2)) == OT_INTEGER) { TARGET = _integer(o1) - _integer(o2); SQ_NEXT(); }
+				_DEOPTIMIZE_(_OP_SUB);
+				_ARITH_(-,TARGET,o1,o2);
+				}
+				SQ_NEXT();
+			SQ_OPCASE(_OP_SUB_FF): {
+				const SQObjectPtr &o1 = STK(arg2), &o2 = STK(arg1);
+				if((type(o1)|type(o2)) == OT_FLOAT) { TARGET = _float(o1) - _float(o2); SQ_NEXT(); }
+				_DEOPTIMIZE_(_OP_SUB);
+				_ARITH_(-,TARGET,o1,o2);
+				}
+				SQ_NEXT();
+			SQ_OPCASE(_OP_MUL_II): {
+				const SQObjectPtr &o1 = STK(arg2), &o2 = STK(arg1);
+				if((type(o1)|type(o2)) == OT_INTEGER) { TARGET = _integer(o1) * _integer(o2); SQ_NEXT(); }
+				_DEOPTIMIZE_(_OP_MUL);
+				_ARITH_(*,TARGET,o1,o2);
+				}
+				SQ_NEXT();
+			SQ_OPCASE(_OP_MUL_FF): {
+				const SQObjectPtr &o1 = STK(arg2), &o2 = STK(arg1);
+				if((type(o1)|type(o2)) == OT_FLOAT) { TARGET = _float(o1) * _float(o2); SQ_NEXT(); }
+				_DEOPTIMIZE_(_OP_MUL);
+				_ARITH_(*,TARGET,o1,o2);
+				}
+				SQ_NEXT();
+			SQ_OPCASE(_OP_JCMP_II): {
+				const SQObjectPtr &o1 = STK(arg2), &o2 = STK(arg0);
+				if((type(o1)|type(o2)) == OT_INTEGER) {
+					SQInteger i1 = _integer(o1), i2 = _integer(o2);
+					if(!QuickCompare(arg3 & QUICKEN_ARG3_MASK,i1 == i2 ? 0 : (i1 < i2 ? -1 : 1))) ci->_ip += (sarg1);
+					SQ_NEXT();
+				}
+				_DEOPTIMIZE_(_OP_JCMP);
+				_GUARD(CMP_OP((CmpOP)(arg3 & QUICKEN_ARG3_MASK),o1,o2,temp_reg));
+				if(IsFalse(temp_reg)) ci->_ip += (sarg1);
+				}
+				SQ_NEXT();
+			SQ_OPCASE(_OP_JCMP_FF): {
+				const SQObjectPtr &o1 = STK(arg2), &o2 = STK(arg0);
+				if((type(o1)|type(o2)) == OT_FLOAT) {
+					//same ordering as ObjCmp, which tells equal floats by their bits
+					SQInteger r = _rawval(o1) == _rawval(o2) ? 0 : (_float(o1) < _float(o2) ? -1 : 1);
+					if(!QuickCompare(arg3 & QUICKEN_ARG3_MASK,r)) ci->_ip += (sarg1);
+					SQ_NEXT();
+				}
+				_DEOPTIMIZE_(_OP_JCMP);
+				_GUARD(CMP_OP((CmpOP)(arg3 & QUICKEN_ARG3_MASK),o1,o2,temp_reg));
+				if(IsFalse(temp_reg)) ci->_ip += (sarg1);
+				}
+				SQ_NEXT();
 			}
 			
 		}
@@ -1088,7 +1277,7 @@ exception_trap:
 
 bool SQVM::CreateClassInstance(SQClass *theclass, SQObjectPtr &inst, SQObjectPtr &constructor)
 {
-	inst = theclass->CreateInstance();
+	inst = theclass->CreateInstance(_ss(this));
 	if(!theclass->GetConstructor(constructor)) {
 		constructor.Null();
 	}
@@ -1189,9 +1378,57 @@ bool SQVM::CallNative(SQNativeClosure *nclosure, SQInteger nargs, SQInteger newb
 	return true;
 }
 
-#define FALLBACK_OK			0
-#define FALLBACK_NO_MATCH	1
-#define FALLBACK_ERROR		2
+/*
+	Resolves an instance member through the inline cache of the executing
+	instruction. Returns FALLBACK_NO_MATCH (without raising) when the key
+	isn't a class member, so the caller falls back to the generic Get.
+*/
+SQInteger SQVM::GetCached(const SQObjectPtr &self,const SQObjectPtr &key,SQObjectPtr &dest)
+{
+	if(type(self) != OT_INSTANCE || type(key) != OT_STRING) return FALLBACK_NO_MATCH;
+	SQInstance *inst = _instance(self);
+	SQClass *theclass = inst->_class;
+	SQFunctionProto *func = _closure(ci->_closure)->_function;
+	SQInlineCache &ic = func->GetInlineCache((ci->_ip - func->_instructions) - 1);
+	if(ic._class == theclass && ic._version == theclass->_version && _rawval(ic._key) == _rawval(key)) {
+		_ss(this)->_inlinecachehits++;
+	}
+	else {
+		SQObjectPtr member;
+		_ss(this)->_inlinecachemisses++;
+		if(!theclass->_members->Get(key,member)) return FALLBACK_NO_MATCH;
+		ic._class = theclass;
+		ic._version = theclass->_version;
+		if(_rawval(ic._key) != _rawval(key)) ic._key = key;
+		ic._member = _integer(member);
+	}
+	if(ic._member & MEMBER_TYPE_PROPERTY) {
+		return GetProperty(self,ic._member,dest) ? FALLBACK_OK : FALLBACK_ERROR;
+	}
+	inst->GetMember(ic._member,dest);
+	return FALLBACK_OK;
+}
+
+bool SQVM::GetProperty(const SQObjectPtr &self,SQInteger member,SQObjectPtr &dest)
+{
+	SQObjectPtr getter = _instance(self)->_class->_properties[member & 0x00FFFFFF].getter;
+	if(type(getter) == OT_NULL) { Raise_Error(_SC("the property is write-only")); return false; }
+	Push(self);
+	bool ret = Call(getter, 1, _top - 1, dest, SQFalse);
+	Pop(1);
+	return ret;
+}
+
+bool SQVM::SetProperty(const SQObjectPtr &self,SQInteger member,const SQObjectPtr &val)
+{
+	SQObjectPtr setter = _instance(self)->_class->_properties[member & 0x00FFFFFF].setter;
+	if(type(setter) == OT_NULL) { Raise_Error(_SC("the property is read-only")); return false; }
+	SQObjectPtr ret;
+	Push(self); Push(val);
+	bool succeeded = Call(setter, 2, _top - 2, ret, SQFalse);
+	Pop(2);
+	return succeeded;
+}
 
 bool SQVM::Get(const SQObjectPtr &self,const SQObjectPtr &key,SQObjectPtr &dest,bool raw, SQInteger selfidx)
 {
@@ -1202,8 +1439,16 @@ bool SQVM::Get(const SQObjectPtr &self,const SQObjectPtr &key,SQObjectPtr &dest,
 	case OT_ARRAY:
 		if(sq_isnumeric(key)) { if(_array(self)->Get(tointeger(key),dest)) { return true; } Raise_IdxError(key); return false; }
 		break;
+	case OT_TYPEDARRAY:
+		if(sq_isnumeric(key)) { if(_typedarray(self)->Get(tointeger(key),dest)) { return true; } Raise_IdxError(key); return false; }
+		break;
 	case OT_INSTANCE:
-		if(_instance(self)->Get(key,dest)) return true;
+		if(_instance(self)->_class->_members->Get(key,dest)) {
+			SQInteger member = _integer(dest);
+			if(member & MEMBER_TYPE_PROPERTY) return GetProperty(self,member,dest);
+			_instance(self)->GetMember(member,dest);
+			return true;
+		}
 		break;
 	case OT_CLASS: 
 		if(_class(self)->Get(key,dest)) return true;
@@ -1253,6 +1498,7 @@ bool SQVM::InvokeDefaultDelegate(const SQObjectPtr &self,const SQObjectPtr &key,
 		case OT_CLASS: ddel = _class_ddel; break;
 		case OT_TABLE: ddel = _table_ddel; break;
 		case OT_ARRAY: ddel = _array_ddel; break;
+		case OT_TYPEDARRAY: ddel = _typedarray_ddel; break;
 		case OT_STRING: ddel = _string_ddel; break;
 		case OT_INSTANCE: ddel = _instance_ddel; break;
 		case OT_INTEGER:case OT_FLOAT:case OT_BOOL: ddel = _number_ddel; break;
@@ -1310,8 +1556,17 @@ bool SQVM::Set(const SQObjectPtr &self,const SQObjectPtr &key,const SQObjectPtr
 	case OT_TABLE:
 		if(_table(self)->Set(key,val)) return true;
 		break;
-	case OT_INSTANCE:
-		if(_instance(self)->Set(key,val)) return true;
+	case OT_INSTANCE: {
+		SQObjectPtr member;
+		if(_instance(self)->_class->_members->Get(key,member)) {
+			if(_isfield(member)) {
+				SQ_GC_BARRIER(_ss(this),val);
+				_instance(self)->_values[_member_idx(member)] = val;
+				return true;
+			}
+			if(_isproperty(member)) return SetProperty(self,_integer(member),val);
+		}
+					  }
 		break;
 	case OT_ARRAY:
 		if(!sq_isnumeric(key)) { Raise_Error(_SC("indexing %s with %s"),GetTypeName(self),GetTypeName(key)); return false; }
@@ -1320,6 +1575,14 @@ bool SQVM::Set(const SQObjectPtr &self,const SQObjectPtr &key,const SQObjectPtr
 			return false;
 		}
 		return true;
+	case OT_TYPEDARRAY:
+		if(!sq_isnumeric(key)) { Raise_Error(_SC("indexing %s with %s"),GetTypeName(self),GetTypeName(key)); return false; }
+		if(!sq_isnumeric(val)) { Raise_Error(_SC("cannot store a %s in a typedarray"),GetTypeName(val)); return false; }
+		if(!_typedarray(self)->Set(tointeger(key),val)) {
+			Raise_IdxError(key);
+			return false;
+		}
+		return true;
 	default:
 		Raise_Error(_SC("trying to set '%s'"),GetTypeName(self));
 		return false;
@@ -1398,6 +1661,15 @@ cloned_mt:
 	case OT_ARRAY: 
 		target = _array(self)->Clone();
 		return true;
+	case OT_TYPEDARRAY: {
+		SQTypedArray *anew = _typedarray(self)->Clone();
+		if(!anew) {
+			Raise_Error(_SC("out of memory"));
+			return false;
+		}
+		target = anew;
+		return true;
+		}
 	default: 
 		Raise_Error(_SC("cloning a %s"), GetTypeName(self));
 		return false;
@@ -1661,6 +1933,7 @@ void SQVM::RelocateOuters()
 void SQVM::CloseOuters(SQObjectPtr *stackindex) {
   SQOuter *p;
   while ((p = _openouters) != NULL && p->_valptr >= stackindex) {
+    SQ_GC_BARRIER(_ss(this),*(p->_valptr));
     p->_value = *(p->_valptr);
     p->_valptr = &p->_value;
     _openouters = p->_next;
@@ -1716,6 +1989,7 @@ void SQVM::dumpstack(SQInteger stackbase,bool dumpall)
 		case OT_NULL:			scprintf(_SC("NULL"));	break;
 		case OT_TABLE:			scprintf(_SC("TABLE %p[%p]"),_table(obj),_table(obj)->_delegate);break;
 		case OT_ARRAY:			scprintf(_SC("ARRAY %p"),_array(obj));break;
+		case OT_TYPEDARRAY:		scprintf(_SC("TYPEDARRAY %p"),_typedarray(obj));break;
 		case OT_CLOSURE:		scprintf(_SC("CLOSURE [%p]"),_closure(obj));break;
 		case OT_NATIVECLOSURE:	scprintf(_SC("NATIVECLOSURE"));break;
 		case OT_USERDATA:		scprintf(_SC("USERDATA %p[%p]"),_userdataval(obj),_userdata(obj)->_delegate);break;
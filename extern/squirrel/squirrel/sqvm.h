@@ -66,6 +66,9 @@ public:
 	void CallDebugHook(SQInteger type,SQInteger forcedline=0);
 	void CallErrorHandler(SQObjectPtr &e);
 	bool Get(const SQObjectPtr &self, const SQObjectPtr &key, SQObjectPtr &dest, bool raw, SQInteger selfidx);
+	SQInteger GetCached(const SQObjectPtr &self, const SQObjectPtr &key, SQObjectPtr &dest);
+	bool GetProperty(const SQObjectPtr &self, SQInteger member, SQObjectPtr &dest);
+	bool SetProperty(const SQObjectPtr &self, SQInteger member, const SQObjectPtr &val);
 	SQInteger FallBackGet(const SQObjectPtr &self,const SQObjectPtr &key,SQObjectPtr &dest);
 	bool InvokeDefaultDelegate(const SQObjectPtr &self,const SQObjectPtr &key,SQObjectPtr &dest);
 	bool Set(const SQObjectPtr &self, const SQObjectPtr &key, const SQObjectPtr &val, SQInteger selfidx);
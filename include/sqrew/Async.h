@@ -0,0 +1,160 @@
+#pragma once
+#ifndef SQREW_ASYNC_H
+#define SQREW_ASYNC_H
+
+#include "sqrew/Forward.h"
+#include "sqrew/Marshal.h"
+
+#include <condition_variable>
+#include <mutex>
+
+namespace sqrew {
+
+template<class ValueT>
+class Future;
+
+namespace detail {
+
+// Result slot shared by a Promise and its Futures. Completing it wakes up
+// whoever waits on it: the Scheduler owning a suspended script thread, or
+// a thread blocked in await().
+class FutureState
+{
+public:
+    FutureState();
+    virtual ~FutureState();
+
+    bool isReady() const;
+
+    void reject(const String& error);
+
+protected:
+    mutable std::mutex mutex_;
+
+    // Marks the state done; 'lock' must hold mutex_ and is released.
+    void complete(std::unique_lock<std::mutex>& lock);
+
+    virtual void pushValue(HSQUIRRELVM v) = 0;
+
+private:
+    friend class sqrew::Scheduler;
+    friend Integer awaitFuture(HSQUIRRELVM v, const std::shared_ptr<FutureState>& state, bool hasValue);
+
+    std::condition_variable ready_;
+    bool done_;
+    bool failed_;
+    String error_;
+
+    // Set while a script thread is suspended on the state.
+    Scheduler* scheduler_;
+    HSQUIRRELVM thread_;
+
+    FutureState(const FutureState&) = delete;
+    FutureState& operator=(const FutureState&) = delete;
+};
+
+template<class ValueT>
+class FutureValue: public FutureState
+{
+public:
+    void resolve(ValueT value)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        value_ = std::move(value);
+        complete(lock);
+    }
+
+private:
+    ValueT value_;
+
+    void pushValue(HSQUIRRELVM v) override
+    {
+        Put<ValueT>::put(v, value_);
+    }
+};
+
+template<>
+class FutureValue<void>: public FutureState
+{
+public:
+    void resolve()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        complete(lock);
+    }
+
+private:
+    void pushValue(HSQUIRRELVM) override {}
+};
+
+// Hands a future returned by a bound call to the VM. On a script thread
+// run by a Scheduler a pending future suspends the thread; anywhere else
+// the call blocks until the future completes.
+Integer awaitFuture(HSQUIRRELVM v, const std::shared_ptr<FutureState>& state, bool hasValue);
+
+} // namespace detail
+
+// Producer side of a Future. Copies share the same result, and it may be
+// completed from any thread, exactly once.
+template<class ValueT>
+class Promise
+{
+public:
+    Promise()
+        : state_(std::make_shared<detail::FutureValue<ValueT>>())
+    {}
+
+    Future<ValueT> getFuture() const { return Future<ValueT>(state_); }
+
+    template<class ...ArgsT>
+    void resolve(ArgsT&&... value) const
+    {
+        state_->resolve(std::forward<ArgsT>(value)...);
+    }
+
+    // The script sees 'error' thrown from the call that returned the future.
+    void reject(const String& error) const
+    {
+        state_->reject(error);
+    }
+
+private:
+    std::shared_ptr<detail::FutureValue<ValueT>> state_;
+};
+
+// Result of an asynchronous operation. A bound method returning a Future
+// looks synchronous to script: the call yields the value once the promise
+// is resolved.
+template<class ValueT>
+class Future
+{
+public:
+    bool isReady() const { return state_->isReady(); }
+
+private:
+    friend class Promise<ValueT>;
+    friend struct detail::ReturnMarshal<Future>;
+
+    std::shared_ptr<detail::FutureValue<ValueT>> state_;
+
+    explicit Future(std::shared_ptr<detail::FutureValue<ValueT>> state)
+        : state_(std::move(state))
+    {}
+};
+
+namespace detail {
+
+template<class ValueT>
+struct ReturnMarshal<Future<ValueT>>
+{
+    static Integer put(HSQUIRRELVM v, const Future<ValueT>& value)
+    {
+        return awaitFuture(v, value.state_, !std::is_void<ValueT>::value);
+    }
+};
+
+} // namespace detail
+
+} // namespace sqrew
+
+#endif // SQREW_ASYNC_H
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef SQREW_BYTECODECACHE_H
+#define SQREW_BYTECODECACHE_H
+
+#include "sqrew/Forward.h"
+
+namespace sqrew {
+
+// Caches compiled scripts keyed by a hash of their source name, contents
+// and the context's optimization level. Entries are serialized closures (SQClosure::Save), kept in
+// memory and, when a directory is given, in one file per script on disk.
+// A cache may be shared by several contexts.
+class BytecodeCache final
+{
+public:
+    struct Stats
+    {
+        size_t memoryHits = 0;
+        size_t diskHits = 0;
+        size_t misses = 0;
+        size_t rejected = 0; // disk entries that were stale or corrupted
+    };
+
+    BytecodeCache();
+    explicit BytecodeCache(const String& directory);
+    ~BytecodeCache();
+
+    // Pushes the closure compiled from 'buffer' onto the stack. Falls back
+    // to compiling the source whenever a cached entry can't be used.
+    bool load(const Context& context, const String& buffer, const String& source);
+
+    Stats getStats() const;
+
+    void clear();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+
+    BytecodeCache(const BytecodeCache&) = delete;
+    BytecodeCache& operator=(const BytecodeCache&) = delete;
+};
+
+} // namespace sqrew
+
+#endif // SQREW_BYTECODECACHE_H
@@ -4,7 +4,9 @@
 
 #include <typeindex>
 
+#include "sqrew/Async.h"
 #include "sqrew/Forward.h"
+#include "sqrew/Marshal.h"
 #include "sqrew/Utils.h"
 
 namespace sqrew {
@@ -26,6 +28,7 @@ protected:
 
     void registerConstructor(Func func);
     void registerClosure(ClosureType type, const String& name, Func func);
+    void registerFunction(ClosureType type, const String& name, Func func);
 
     static void* createUserData(HSQUIRRELVM v, size_t size, ReleaseHook releaseHook);
     void* createUserData(size_t size, ReleaseHook releaseHook);
@@ -34,14 +37,22 @@ protected:
     static void setInstance(HSQUIRRELVM v, Integer index, void* instance, ReleaseHook releaseHook);
     static void* getInstance(HSQUIRRELVM v, Integer index, size_t typeTag);
 
+    static Integer throwError(HSQUIRRELVM v, const std::exception& error);
+
     template<class ValueT>
-    static ValueT getValue(HSQUIRRELVM v, Integer index);
+    static auto getValue(HSQUIRRELVM v, Integer index) -> decltype(Marshal<Bare<ValueT>>::get(v, index))
+    {
+        return Marshal<Bare<ValueT>>::get(v, index);
+    }
 
     template<class ValueT>
-    static void putValue(HSQUIRRELVM v, ValueT value);
+    static void putValue(HSQUIRRELVM v, const Bare<ValueT>& value)
+    {
+        Put<ValueT>::put(v, value);
+    }
 
     template<class ValueT>
-    static void putReturn(HSQUIRRELVM v, const Return<ValueT>& ret);
+    static Integer putReturn(HSQUIRRELVM v, const Return<ValueT>& ret);
 
     ClassImpl(ClassImpl&& rhs);
 
@@ -57,13 +68,13 @@ private:
 };
 
 template<class ValueT>
-inline void ClassImpl::putReturn(HSQUIRRELVM v, const Return<ValueT>& ret)
+inline Integer ClassImpl::putReturn(HSQUIRRELVM v, const Return<ValueT>& ret)
 {
-    putValue<ValueT>(v, ret.getValue());
+    return ReturnMarshal<ValueT>::put(v, ret.getValue());
 }
 
 template<>
-inline void ClassImpl::putReturn(HSQUIRRELVM, const Return<void>&) {}
+inline Integer ClassImpl::putReturn(HSQUIRRELVM, const Return<void>&) { return 0; }
 
 }
 
@@ -114,7 +125,7 @@ struct DefaultAllocator
 template<class ClassT, template<class> class AllocatorT = DefaultAllocator>
 class Class: protected detail::ClassImpl
 {
-    static size_t getTypeTag() { return typeid(ClassT).hash_code(); }
+    static size_t getTypeTag() { return detail::getTypeTag<ClassT>(); }
 
     using Allocator = AllocatorT<ClassT>;
 
@@ -133,50 +144,109 @@ class Class: protected detail::ClassImpl
     template<class ReturnT, class ...ArgsT>
     class MethodDelegate;
 
+    template<class ReturnT, class ...ArgsT>
+    struct FunctionThunk;
+
+    template<class MethodT>
+    struct MethodThunk;
+
     static Integer releaseInstance(void* ptr, Integer)
     {
         Allocator::destroyInstance(static_cast<typename Allocator::Pointer>(ptr));
         return 0;
     }
 
+    static ClassT* castInstance(void* ptr)
+    {
+        return Allocator::castInstance(static_cast<typename Allocator::Pointer>(ptr));
+    }
+
+    static void* copyInstance(const ClassT& value)
+    {
+        return Allocator::createInstance(value);
+    }
+
+    static ClassT* getThis(HSQUIRRELVM v)
+    {
+        auto instance = getInstance(v, 1, getTypeTag());
+        if (instance == nullptr)
+            throw std::runtime_error("'this' is not an instance of the exposed class");
+
+        return castInstance(instance);
+    }
+
+    template<class ...ArgsT, size_t ...Indices>
+    static Integer createInstance(HSQUIRRELVM v, IndexSequence<Indices...>)
+    {
+        try
+        {
+            setInstance(v, 1, Allocator::createInstance(getValue<ArgsT>(v, Indices + 2)...), releaseInstance);
+            return 0;
+        }
+        catch (const std::exception& error)
+        {
+            return throwError(v, error);
+        }
+    }
+
     template<class ...ArgsT>
     static Integer createInstance(HSQUIRRELVM v)
     {
-        Integer index = 2;
-        setInstance(v, 1, Allocator::createInstance(getValue<ArgsT>(v, index++)...), releaseInstance);
-        return 0;
+        return createInstance<ArgsT...>(v, typename MakeIndexSequence<sizeof...(ArgsT)>::Type());
+    }
+
+    template<class ReturnT, class ...ArgsT, size_t ...Indices>
+    static Integer callMethod(HSQUIRRELVM v, IndexSequence<Indices...>)
+    {
+        try
+        {
+            auto method = static_cast<MethodDelegate<ReturnT, ArgsT...>*>(getUserData(v, -1));
+
+            auto result = method->invoke(getThis(v), getValue<ArgsT>(v, Indices + 2)...);
+            return putReturn<ReturnT>(v, result);
+        }
+        catch (const std::exception& error)
+        {
+            return throwError(v, error);
+        }
     }
 
     template<class ReturnT, class ...ArgsT>
     static Integer callMethod(HSQUIRRELVM v)
     {
-        auto instance = static_cast<typename Allocator::Pointer>(getInstance(v, 1, getTypeTag()));
-        auto method = static_cast<MethodDelegate<ReturnT, ArgsT...>*>(getUserData(v, -1));
-
-        Integer index = 2;
-        auto result = method->invoke(Allocator::castInstance(instance), getValue<ArgsT>(v, index++)...);
-        putReturn<ReturnT>(v, result);
-        return Return<ReturnT>::size;
+        return callMethod<ReturnT, ArgsT...>(v, typename MakeIndexSequence<sizeof...(ArgsT)>::Type());
     }
 
     template<class FieldT>
     static Integer callSetter(HSQUIRRELVM v)
     {
-        auto instance = static_cast<typename Allocator::Pointer>(getInstance(v, 1, getTypeTag()));
-        auto field = static_cast<Field<FieldT>*>(getUserData(v, -1));
-
-        Allocator::castInstance(instance)->*(*field) = getValue<FieldT>(v, 2);
-        return 0;
+        try
+        {
+            auto field = static_cast<Field<FieldT>*>(getUserData(v, -1));
+
+            getThis(v)->*(*field) = getValue<FieldT>(v, 2);
+            return 0;
+        }
+        catch (const std::exception& error)
+        {
+            return throwError(v, error);
+        }
     }
 
     template<class FieldT>
     static Integer callGetter(HSQUIRRELVM v)
     {
-        auto instance = static_cast<typename Allocator::Pointer>(getInstance(v, 1, getTypeTag()));
-        auto field = static_cast<Field<FieldT>*>(getUserData(v, -1));
-
-        putValue(v, Allocator::castInstance(instance)->*(*field));
-        return 1;
+        try
+        {
+            auto field = static_cast<Field<FieldT>*>(getUserData(v, -1));
+
+            putValue<FieldT>(v, getThis(v)->*(*field));
+            return 1;
+        }
+        catch (const std::exception& error)
+        {
+            return throwError(v, error);
+        }
     }
 
     template<class ReturnT, class ...ArgsT>
@@ -214,6 +284,12 @@ class Class: protected detail::ClassImpl
     void initialize(const String& name)
     {
         ClassImpl::initialize(name, getTypeTag());
+
+        using Exposed = detail::ExposedClass<ClassT>;
+        Exposed::cast = castInstance;
+        Exposed::copy = copyInstance;
+        Exposed::release = releaseInstance;
+        Exposed::isBorrowable = std::is_same<typename Allocator::Pointer, ClassT*>::value;
     }
 
 public:
@@ -252,6 +328,23 @@ public:
         return *this;
     }
 
+    // Binds the method at compile time: the generated closure calls it
+    // directly, without a MethodDelegate outer value.
+    template<class MethodT, MethodT method>
+    Class& setMethod(const String& name)
+    {
+        registerFunction(ClosureType::Method, name, MethodThunk<MethodT>::template call<method>);
+        return *this;
+    }
+
+#if __cplusplus >= 201703L
+    template<auto method>
+    Class& setMethod(const String& name)
+    {
+        return setMethod<decltype(method), method>(name);
+    }
+#endif
+
     template<class FieldT>
     Class& setField(const String& name, Field<FieldT> field)
     {
@@ -341,6 +434,86 @@ private:
     }
 };
 
+template<class ClassT, template<class> class AllocatorT>
+template<class ReturnT, class ...ArgsT>
+struct Class<ClassT, AllocatorT>::FunctionThunk
+{
+    using Invoke = ReturnT (*)(ClassT* instance, ArgsT&&... args);
+
+    template<Invoke invoke, size_t ...Indices>
+    static Integer dispatch(HSQUIRRELVM v, IndexSequence<Indices...>)
+    {
+        try
+        {
+            return putReturn<ReturnT>(v, Return<ReturnT>(invoke, getThis(v), getValue<ArgsT>(v, Indices + 2)...));
+        }
+        catch (const std::exception& error)
+        {
+            return throwError(v, error);
+        }
+    }
+
+    template<Invoke invoke>
+    static Integer call(HSQUIRRELVM v)
+    {
+        return dispatch<invoke>(v, typename MakeIndexSequence<sizeof...(ArgsT)>::Type());
+    }
+};
+
+template<class ClassT, template<class> class AllocatorT>
+template<class ReturnT, class ...ArgsT>
+struct Class<ClassT, AllocatorT>::MethodThunk<ReturnT (ClassT::*)(ArgsT...)>
+    : FunctionThunk<ReturnT, ArgsT...>
+{
+    template<ReturnT (ClassT::*method)(ArgsT...)>
+    static ReturnT invoke(ClassT* instance, ArgsT&&... args)
+    {
+        return (instance->*method)(std::forward<ArgsT>(args)...);
+    }
+
+    template<ReturnT (ClassT::*method)(ArgsT...)>
+    static Integer call(HSQUIRRELVM v)
+    {
+        return FunctionThunk<ReturnT, ArgsT...>::template call<invoke<method>>(v);
+    }
+};
+
+template<class ClassT, template<class> class AllocatorT>
+template<class ReturnT, class ...ArgsT>
+struct Class<ClassT, AllocatorT>::MethodThunk<ReturnT (ClassT::*)(ArgsT...) const>
+    : FunctionThunk<ReturnT, ArgsT...>
+{
+    template<ReturnT (ClassT::*method)(ArgsT...) const>
+    static ReturnT invoke(ClassT* instance, ArgsT&&... args)
+    {
+        return (instance->*method)(std::forward<ArgsT>(args)...);
+    }
+
+    template<ReturnT (ClassT::*method)(ArgsT...) const>
+    static Integer call(HSQUIRRELVM v)
+    {
+        return FunctionThunk<ReturnT, ArgsT...>::template call<invoke<method>>(v);
+    }
+};
+
+template<class ClassT, template<class> class AllocatorT>
+template<class ReturnT, class ...ArgsT>
+struct Class<ClassT, AllocatorT>::MethodThunk<ReturnT (*)(typename AllocatorT<ClassT>::Pointer, ArgsT...)>
+    : FunctionThunk<ReturnT, ArgsT...>
+{
+    template<ReturnT (*method)(typename AllocatorT<ClassT>::Pointer, ArgsT...)>
+    static ReturnT invoke(ClassT* instance, ArgsT&&... args)
+    {
+        return method(instance, std::forward<ArgsT>(args)...);
+    }
+
+    template<ReturnT (*method)(typename AllocatorT<ClassT>::Pointer, ArgsT...)>
+    static Integer call(HSQUIRRELVM v)
+    {
+        return FunctionThunk<ReturnT, ArgsT...>::template call<invoke<method>>(v);
+    }
+};
+
 } // namespace sqrew
 
 #endif // SQREW_CLASS_H
@@ -4,16 +4,83 @@
 
 #include "sqrew/Forward.h"
 
+#include <vector>
+
 namespace sqrew {
 
+// Where a Context allocates its script objects from. A Pool context owns a
+// size-class allocator of its own, so VMs running on different threads
+// don't contend on the global heap.
+enum class Allocation
+{
+    Heap,
+    Pool
+};
+
+// How hard the compiler works on scripts run through the context. Basic
+// folds constants and drops dead code, Full also fuses common instruction
+// pairs and removes line ops, so debug hooks see no line events.
+enum class OptimizationLevel
+{
+    None,
+    Basic,
+    Full
+};
+
+struct AllocationStats
+{
+    struct SizeClass
+    {
+        size_t blockSize;
+        size_t live;
+        size_t allocations;
+    };
+
+    size_t bytesLive = 0;
+    size_t bytesPeak = 0;
+    size_t largeBytesLive = 0;
+    size_t bytesReserved = 0;
+
+    // Only classes that were ever used are listed.
+    std::vector<SizeClass> sizeClasses;
+};
+
+struct CollectorStats
+{
+    static const size_t PauseBuckets = 16;
+
+    size_t cycles = 0;
+    size_t objectsFreed = 0;
+    bool collecting = false;
+
+    // Pauses of collectStep calls. Bucket i counts the pauses shorter than
+    // 2^i microseconds that didn't fit a lower bucket; the last one also
+    // takes everything longer.
+    size_t steps = 0;
+    double longestPauseMicros = 0;
+    double totalPauseMicros = 0;
+    size_t pauseHistogram[PauseBuckets] = {};
+};
+
 class Context final
 {
 public:
     Context();
     explicit Context(int stackSize);
+    Context(int stackSize, Allocation allocation);
     ~Context();
 
     inline HSQUIRRELVM getHandle() const { return vm_; }
+    inline HSQALLOCATOR getAllocator() const { return allocator_; }
+
+    // Statistics of the context's pool; all zero for Allocation::Heap.
+    AllocationStats getAllocationStats() const;
+
+    // Advances the incremental garbage collector for about budgetMicros,
+    // starting a new cycle if none is running. Returns true when a cycle
+    // finished during the call.
+    bool collectStep(int budgetMicros);
+    CollectorStats getCollectorStats() const;
 
     void initialize();
 
@@ -23,14 +90,65 @@ public:
         interface_.reset(new InterfaceT(std::forward<ArgsT>(args)...));
     }
 
+    // Scripts run through executeBuffer are looked up in 'cache' before
+    // being compiled. Pass nullptr to always compile.
+    void setBytecodeCache(std::shared_ptr<BytecodeCache> cache);
+    inline const std::shared_ptr<BytecodeCache>& getBytecodeCache() const { return bytecodeCache_; }
+
+    // Applies to scripts compiled from now on, including the ones compiled
+    // on a bytecode cache miss.
+    void setOptimizationLevel(OptimizationLevel level);
+    OptimizationLevel getOptimizationLevel() const;
+
+    // Directories require searches, in order. Module "a.b" is the file
+    // a/b.nut in the first directory that has one.
+    void setModulePaths(std::vector<String> paths);
+    inline const std::vector<String>& getModulePaths() const { return modulePaths_; }
+
+    // Returns the table of a module, loading it on first use: the module's
+    // script runs once with a fresh table as 'this', so its slots become
+    // the module's members, and the table is kept for later calls. Scripts
+    // reach the same modules through the global require(name). On failure
+    // the table is invalid and the reason goes to Interface::printError.
+    // Goes through the bytecode cache when one is set.
+    Table require(const String& name) const;
+
     bool executeBuffer(const String& buffer) const;
     bool executeBuffer(const String& buffer, const String& source) const;
 
+    // Runs a script file. The file is memory mapped and the lexer reads
+    // it in place; with a bytecode cache set it goes through executeBuffer.
+    bool executeFile(const String& path) const;
+
+    // Runs a precompiled script (as written by sq_writeclosure). The file
+    // is memory mapped and loaded in place.
+    bool executeBytecodeFile(const String& path) const;
+
 private:
     struct Detail;
 
+    HSQALLOCATOR allocator_;
     HSQUIRRELVM vm_;
     std::unique_ptr<Interface> interface_;
+    std::shared_ptr<BytecodeCache> bytecodeCache_;
+    std::vector<String> modulePaths_;
+    CollectorStats collectorStats_;
+};
+
+// Routes allocations made on this thread to the context's pool for the
+// lifetime of the scope. Memory is always freed back to the pool it came
+// from, so the scope only matters for where new objects are placed.
+class AllocatorScope final
+{
+public:
+    explicit AllocatorScope(const Context& ctx);
+    ~AllocatorScope();
+
+private:
+    HSQALLOCATOR previous_;
+
+    AllocatorScope(const AllocatorScope&) = delete;
+    AllocatorScope& operator=(const AllocatorScope&) = delete;
 };
 
 class StackLock final
@@ -40,6 +158,7 @@ public:
     ~StackLock();
 
 private:
+    AllocatorScope scope_;
     const Context& context_;
     Integer top_;
 
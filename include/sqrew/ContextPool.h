@@ -0,0 +1,86 @@
+#pragma once
+#ifndef SQREW_CONTEXTPOOL_H
+#define SQREW_CONTEXTPOOL_H
+
+#include "sqrew/Context.h"
+
+#include <functional>
+#include <vector>
+
+namespace sqrew {
+
+// A script compiled once by ContextPool::compile. It holds the serialized
+// closure (SQClosure::Save) and is never modified afterwards, so it can be
+// shared by any number of threads. Each worker loads it into its own VM on
+// first use and keeps the closure for later runs.
+class Program final
+{
+public:
+    inline const String& getSource() const { return source_; }
+    inline size_t getSize() const { return bytes_.size(); }
+
+    // Pushes a closure of the program onto the context's stack.
+    bool load(const Context& context) const;
+
+private:
+    friend class ContextPool;
+    friend class ScriptLoader;
+
+    String source_;
+    std::vector<char> bytes_;
+};
+
+// A fixed set of worker threads, each owning an initialized Context with
+// a pool allocator of its own. Work is handed over through a lock-free
+// queue and runs on whichever worker picks it up first, so tasks must not
+// rely on state left in a particular context.
+class ContextPool final
+{
+public:
+    using Task = std::function<void(Context&)>;
+
+    struct Stats
+    {
+        size_t completed = 0;
+        size_t failed = 0; // tasks that threw, programs that raised an error
+    };
+
+    // Starts 'workerCount' workers, one per hardware thread when 0. 'setup'
+    // runs on every worker context right after Context::initialize, which
+    // is where classes and functions are bound.
+    explicit ContextPool(size_t workerCount = 0, Task setup = Task(), size_t queueCapacity = 1024);
+
+    // Finishes the queued work before stopping the workers.
+    ~ContextPool();
+
+    size_t getWorkerCount() const;
+
+    // Compiles 'buffer' on the calling thread. Returns nullptr on a syntax
+    // error.
+    std::shared_ptr<const Program> compile(const String& buffer, const String& source,
+        OptimizationLevel level = OptimizationLevel::None);
+
+    // Queue 'task' or a run of 'program' with the worker's root table as
+    // 'this'. Both block while the queue is full.
+    void submit(Task task);
+    void submit(std::shared_ptr<const Program> program);
+
+    // Returns false instead of blocking when the queue is full.
+    bool trySubmit(Task& task);
+
+    // Blocks until everything submitted so far has run.
+    void wait();
+
+    Stats getStats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+
+    ContextPool(const ContextPool&) = delete;
+    ContextPool& operator=(const ContextPool&) = delete;
+};
+
+} // namespace sqrew
+
+#endif // SQREW_CONTEXTPOOL_H
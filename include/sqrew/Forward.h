@@ -6,16 +6,24 @@
 #include <memory>
 
 typedef struct SQVM* HSQUIRRELVM;
+typedef struct SQAllocator* HSQALLOCATOR;
 //#define SQREW_STR(a) a
 
 namespace sqrew {
 
+class BytecodeCache;
 class Context;
+class ContextPool;
 class Interface;
+class Scheduler;
 class Table;
 
 using String = std::string;
+#if defined(_WIN64) || defined(_LP64)
+using Integer = long long;
+#else
 using Integer = int;
+#endif
 using Float = float;
 
 } // namespace sqrew
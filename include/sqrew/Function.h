@@ -2,43 +2,151 @@
 #ifndef SQREW_FUNCTION_H
 #define SQREW_FUNCTION_H
 
+#include "sqrew/Context.h"
+#include "sqrew/Forward.h"
+#include "sqrew/Marshal.h"
 #include "sqrew/Utils.h"
 
+#include <tuple>
+
 namespace sqrew {
-/*
-template<class ReturnT, class... ArgsT>
-ReturnT dummyCall(ArgsT&&...)
+
+namespace detail {
+
+class FunctionImpl
 {
-    return ReturnT();
-}
+public:
+    FunctionImpl();
+    FunctionImpl(const Context& context, const HSQOBJECT& closure, const HSQOBJECT& environment);
+    FunctionImpl(const FunctionImpl& rhs);
+    FunctionImpl(FunctionImpl&& rhs);
+    ~FunctionImpl();
+
+    FunctionImpl& operator=(const FunctionImpl& rhs);
+    FunctionImpl& operator=(FunctionImpl&& rhs);
+
+    bool isValid() const;
+
+    void reserveStack(Integer size) const;
+
+protected:
+    friend class sqrew::Scheduler;
+
+    inline const Context& getContext() const { return *context_; }
+    HSQUIRRELVM getHandle() const;
+
+    void push(HSQUIRRELVM v) const;
+    void call(HSQUIRRELVM v, Integer argumentCount, bool hasResult) const;
+
+private:
+    const Context* context_;
+    HSQOBJECT closure_;
+    HSQOBJECT environment_;
 
-template<class... ArgsT>
-void dummyCall<void, ArgsT...>(ArgsT&&...)
+    void addRef();
+    void release();
+};
+
+template<class ReturnT>
+struct FunctionResult
 {
-}*/
+    static_assert(!std::is_same<Bare<ReturnT>, const SQChar*>::value && !std::is_same<Bare<ReturnT>, StringView>::value,
+                  "a string view into a script return value would dangle; return sqrew::String instead");
 
-static void intCall(int)
+    enum { hasResult = 1 };
+
+    static Bare<ReturnT> get(HSQUIRRELVM v)
+    {
+        return Marshal<Bare<ReturnT>>::get(v, -1);
+    }
+};
+
+template<>
+struct FunctionResult<void>
 {
+    enum { hasResult = 0 };
 
-}
+    static void get(HSQUIRRELVM) {}
+};
 
-template<class ReturnT>
-class Function
+} // namespace detail
+
+// Handle to a script closure and the environment ('this') it is called
+// with. The closure is resolved once and held by a strong reference, so a
+// call only pushes the arguments and enters the VM.
+template<class ReturnT = void>
+class Function: public detail::FunctionImpl
 {
+    using Result = detail::FunctionResult<ReturnT>;
+
 public:
     Function() {}
 
-    template<class... ArgsT>
-    Return<ReturnT> operator()(ArgsT&&... args)
+    explicit Function(detail::FunctionImpl&& impl)
+        : detail::FunctionImpl(std::move(impl))
+    {}
+
+    template<class ...ArgsT>
+    ReturnT operator()(ArgsT&&... args) const
     {
-        //return Return<ReturnT>(dummyCall<ReturnT, ArgsT...>, std::forward<ArgsT>(args)...);
-        return Return<ReturnT>(intCall, 12);
+        StackLock lock(getContext());
+
+        auto v = getHandle();
+        pushCall(v, std::forward<ArgsT>(args)...);
+        return Result::get(v);
     }
 
-    bool isValid() const
+    // Calls the closure once per argument tuple, discarding the results.
+    template<class TupleT>
+    void callBatch(Span<TupleT> arguments) const
     {
-        return true;
+        callBatch(arguments, Discard());
     }
+
+    // Calls the closure once per argument tuple and writes each result to 'output'.
+    template<class TupleT, class OutputT>
+    void callBatch(Span<TupleT> arguments, OutputT output) const
+    {
+        StackLock lock(getContext());
+
+        auto v = getHandle();
+        const auto top = sq_gettop(v);
+
+        for (auto& tuple: arguments)
+        {
+            pushTuple(v, tuple, typename MakeIndexSequence<std::tuple_size<typename std::remove_cv<TupleT>::type>::value>::Type());
+            store(v, output);
+            sq_settop(v, top);
+        }
+    }
+
+private:
+    struct Discard {};
+
+    template<class ...ArgsT>
+    void pushCall(HSQUIRRELVM v, ArgsT&&... args) const
+    {
+        push(v);
+
+        using Expand = int[];
+        (void)Expand{ 0, (detail::Put<ArgsT>::put(v, args), 0)... };
+
+        call(v, sizeof...(ArgsT) + 1, Result::hasResult);
+    }
+
+    template<class TupleT, size_t ...Indices>
+    void pushTuple(HSQUIRRELVM v, TupleT& tuple, IndexSequence<Indices...>) const
+    {
+        pushCall(v, std::get<Indices>(tuple)...);
+    }
+
+    template<class OutputT>
+    static void store(HSQUIRRELVM v, OutputT& output)
+    {
+        *output++ = Result::get(v);
+    }
+
+    static void store(HSQUIRRELVM, Discard&) {}
 };
 
 } // namespace sqrew
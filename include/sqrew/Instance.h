@@ -2,6 +2,7 @@
 #ifndef SQREW_INSTANCE_H
 #define SQREW_INSTANCE_H
 
+#include "sqrew/Context.h"
 #include "sqrew/Forward.h"
 #include "sqrew/Function.h"
 
@@ -10,20 +11,53 @@ namespace sqrew {
 class Instance
 {
 public:
-    Instance(const Context& context, const String& className);
+    // Creates an instance of the script or exposed class at 'className'
+    // (a dotted path from the root table) by calling its constructor.
+    // Throws std::runtime_error if there is no such class or the
+    // constructor fails.
+    template<class ...ArgsT>
+    Instance(const Context& context, const String& className, ArgsT&&... args)
+        : Instance(context)
+    {
+        StackLock lock(context);
+
+        auto v = context.getHandle();
+        pushClass(className);
+
+        using Expand = int[];
+        (void)Expand{ 0, (detail::Put<ArgsT>::put(v, args), 0)... };
+
+        construct(sizeof...(ArgsT) + 1);
+    }
+
+    Instance(Instance&& rhs);
     ~Instance();
 
+    bool isValid() const;
 
+    // The closure is resolved on the first request for 'name' and cached;
+    // keep the returned Function to call the method without any lookup.
     template<class ReturnT = void>
     Function<ReturnT> getMethod(const String& name)
     {
-        return Function<ReturnT>();
+        return Function<ReturnT>(findMethod(name));
     }
 
 private:
     struct Impl;
 
     std::unique_ptr<Impl> impl_;
+
+    explicit Instance(const Context& context);
+
+    void pushClass(const String& className);
+    void construct(Integer argumentCount);
+
+    detail::FunctionImpl findMethod(const String& name);
+
+    Instance(const Instance&) = delete;
+    Instance& operator=(const Instance&) = delete;
+    Instance& operator=(Instance&&) = delete;
 };
 
 } // namespace sqrew
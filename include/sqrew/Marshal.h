@@ -0,0 +1,495 @@
+#pragma once
+#ifndef SQREW_MARSHAL_H
+#define SQREW_MARSHAL_H
+
+#include "sqrew/Forward.h"
+#include "sqrew/Utils.h"
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include <squirrel.h>
+
+namespace sqrew {
+
+namespace detail {
+
+// Strips references and cv-qualifiers; arrays (e.g. string literals) decay to pointers.
+template<class ValueT>
+using Bare = typename std::conditional<std::is_array<typename std::remove_reference<ValueT>::type>::value,
+                                       typename std::decay<ValueT>::type,
+                                       typename std::remove_cv<typename std::remove_reference<ValueT>::type>::type>::type;
+
+template<class ClassT>
+inline size_t getTypeTag() { return typeid(ClassT).hash_code(); }
+
+[[noreturn]] void throwArgumentError(HSQUIRRELVM v, Integer index, const char* expected);
+
+Integer toAbsoluteIndex(HSQUIRRELVM v, Integer index);
+
+void* getInstancePointer(HSQUIRRELVM v, Integer index, size_t typeTag);
+void pushInstancePointer(HSQUIRRELVM v, size_t typeTag, void* instance, SQRELEASEHOOK releaseHook);
+
+// Returns the bytes of the blob at 'index'. A read-only blob is rejected
+// when 'writable' is set.
+Span<unsigned char> getBlob(HSQUIRRELVM v, Integer index, bool writable);
+
+// Pushes a blob that reads and writes 'data' in place; 'release' runs when
+// the blob is collected, or right away if it can't be created.
+void pushBlobView(HSQUIRRELVM v, unsigned char* data, size_t size, bool readOnly, const std::function<void()>& release);
+
+// Element types stored packed by typed arrays (int32array() and friends).
+template<class ValueT>
+struct TypedArrayElement { enum { isElement = false }; };
+
+template<>
+struct TypedArrayElement<std::int32_t> { enum { isElement = true }; static SQTypedArrayType type() { return SQTA_INT32; } };
+
+template<>
+struct TypedArrayElement<float> { enum { isElement = true }; static SQTypedArrayType type() { return SQTA_FLOAT32; } };
+
+template<>
+struct TypedArrayElement<double> { enum { isElement = true }; static SQTypedArrayType type() { return SQTA_FLOAT64; } };
+
+// Returns the storage of the typed array at 'index', which must hold 'type' elements.
+void* getTypedArray(HSQUIRRELVM v, Integer index, SQTypedArrayType type, size_t& size);
+
+// Filled in by Class<ClassT>::expose, so values of an exposed class can be
+// marshalled without knowing which allocator it was exposed with.
+template<class ClassT>
+struct ExposedClass
+{
+    using Cast = ClassT* (*)(void*);
+    using Copy = void* (*)(const ClassT&);
+
+    static Cast cast;
+    static Copy copy;
+    static SQRELEASEHOOK release;
+    static bool isBorrowable;
+};
+
+template<class ClassT> typename ExposedClass<ClassT>::Cast ExposedClass<ClassT>::cast = nullptr;
+template<class ClassT> typename ExposedClass<ClassT>::Copy ExposedClass<ClassT>::copy = nullptr;
+template<class ClassT> SQRELEASEHOOK ExposedClass<ClassT>::release = nullptr;
+template<class ClassT> bool ExposedClass<ClassT>::isBorrowable = false;
+
+template<class ClassT>
+struct InstanceMarshal
+{
+    static_assert(std::is_class<ClassT>::value, "sqrew::Marshal has no specialization for this type");
+
+    static ClassT* getPointer(HSQUIRRELVM v, Integer index)
+    {
+        using Exposed = ExposedClass<ClassT>;
+
+        auto ptr = getInstancePointer(v, index, getTypeTag<ClassT>());
+        if (ptr == nullptr || Exposed::cast == nullptr)
+            throwArgumentError(v, index, "instance of an exposed class");
+
+        return Exposed::cast(ptr);
+    }
+
+    static void putPointer(HSQUIRRELVM v, const ClassT* value)
+    {
+        if (!ExposedClass<ClassT>::isBorrowable)
+            throw std::runtime_error("Class uses a custom allocator and can't be passed by pointer");
+
+        pushInstancePointer(v, getTypeTag<ClassT>(), const_cast<ClassT*>(value), nullptr);
+    }
+
+    static ClassT& get(HSQUIRRELVM v, Integer index)
+    {
+        return *getPointer(v, index);
+    }
+
+    static void put(HSQUIRRELVM v, const ClassT& value)
+    {
+        using Exposed = ExposedClass<ClassT>;
+
+        if (Exposed::copy == nullptr)
+            throw std::runtime_error("Class is not exposed and can't be passed by value");
+
+        pushInstancePointer(v, getTypeTag<ClassT>(), Exposed::copy(value), Exposed::release);
+    }
+};
+
+} // namespace detail
+
+// Converts values between the Squirrel stack and C++.
+//
+// A specialization provides 'get(v, index)' and 'put(v, value)'. get() may
+// throw std::exception on a type mismatch; bound thunks turn it into a
+// script error. Types without a specialization are treated as exposed
+// classes.
+template<class ValueT, class EnableT = void>
+struct Marshal: detail::InstanceMarshal<ValueT> {};
+
+template<class ValueT>
+struct Marshal<ValueT, typename std::enable_if<std::is_integral<ValueT>::value && !std::is_same<ValueT, bool>::value>::type>
+{
+    static ValueT get(HSQUIRRELVM v, Integer index)
+    {
+        SQInteger value;
+        if (SQ_FAILED( sq_getinteger(v, index, &value) ))
+            detail::throwArgumentError(v, index, "integer");
+
+        return static_cast<ValueT>(value);
+    }
+
+    static void put(HSQUIRRELVM v, ValueT value)
+    {
+        sq_pushinteger(v, static_cast<SQInteger>(value));
+    }
+};
+
+template<class ValueT>
+struct Marshal<ValueT, typename std::enable_if<std::is_floating_point<ValueT>::value>::type>
+{
+    static ValueT get(HSQUIRRELVM v, Integer index)
+    {
+        SQFloat value;
+        if (SQ_FAILED( sq_getfloat(v, index, &value) ))
+            detail::throwArgumentError(v, index, "float");
+
+        return static_cast<ValueT>(value);
+    }
+
+    static void put(HSQUIRRELVM v, ValueT value)
+    {
+        sq_pushfloat(v, static_cast<SQFloat>(value));
+    }
+};
+
+template<class ValueT>
+struct Marshal<ValueT, typename std::enable_if<std::is_enum<ValueT>::value>::type>
+{
+    using Underlying = typename std::underlying_type<ValueT>::type;
+
+    static ValueT get(HSQUIRRELVM v, Integer index)
+    {
+        return static_cast<ValueT>(Marshal<Underlying>::get(v, index));
+    }
+
+    static void put(HSQUIRRELVM v, ValueT value)
+    {
+        Marshal<Underlying>::put(v, static_cast<Underlying>(value));
+    }
+};
+
+template<>
+struct Marshal<bool>
+{
+    static bool get(HSQUIRRELVM v, Integer index)
+    {
+        SQBool value;
+        if (SQ_FAILED( sq_getbool(v, index, &value) ))
+            detail::throwArgumentError(v, index, "bool");
+
+        return value != SQFalse;
+    }
+
+    static void put(HSQUIRRELVM v, bool value)
+    {
+        sq_pushbool(v, value ? SQTrue : SQFalse);
+    }
+};
+
+// The returned pointer refers to the interned SQString and stays valid as
+// long as the script value does, i.e. for the duration of a bound call.
+template<>
+struct Marshal<const SQChar*>
+{
+    static const SQChar* get(HSQUIRRELVM v, Integer index)
+    {
+        const SQChar* value;
+        if (SQ_FAILED( sq_getstring(v, index, &value) ))
+            detail::throwArgumentError(v, index, "string");
+
+        return value;
+    }
+
+    static void put(HSQUIRRELVM v, const SQChar* value)
+    {
+        if (value != nullptr)
+            sq_pushstring(v, value, -1);
+        else
+            sq_pushnull(v);
+    }
+};
+
+template<>
+struct Marshal<StringView>
+{
+    static StringView get(HSQUIRRELVM v, Integer index)
+    {
+        const SQChar* value;
+        if (SQ_FAILED( sq_getstring(v, index, &value) ))
+            detail::throwArgumentError(v, index, "string");
+
+        return StringView(value, static_cast<size_t>(sq_getsize(v, index)));
+    }
+
+    static void put(HSQUIRRELVM v, StringView value)
+    {
+        sq_pushstring(v, value.data(), static_cast<SQInteger>(value.size()));
+    }
+};
+
+template<>
+struct Marshal<String>
+{
+    static String get(HSQUIRRELVM v, Integer index)
+    {
+        auto view = Marshal<StringView>::get(v, index);
+        return String(view.data(), view.size());
+    }
+
+    static void put(HSQUIRRELVM v, const String& value)
+    {
+        sq_pushstring(v, value.c_str(), static_cast<SQInteger>(value.size()));
+    }
+};
+
+#if __cplusplus >= 201703L
+template<>
+struct Marshal<std::string_view>
+{
+    static std::string_view get(HSQUIRRELVM v, Integer index)
+    {
+        auto view = Marshal<StringView>::get(v, index);
+        return std::string_view(view.data(), view.size());
+    }
+
+    static void put(HSQUIRRELVM v, std::string_view value)
+    {
+        sq_pushstring(v, value.data(), static_cast<SQInteger>(value.size()));
+    }
+};
+#endif
+
+// Byte spans travel as blobs (sqstdblob) without copying. A Span argument
+// refers to the blob's own buffer for the duration of the call; a Span
+// pushed to script becomes a blob over the caller's memory, which must
+// outlive every script reference to it (use BlobView to hand it over).
+template<>
+struct Marshal<Span<unsigned char>>
+{
+    static Span<unsigned char> get(HSQUIRRELVM v, Integer index)
+    {
+        return detail::getBlob(v, index, true);
+    }
+
+    static void put(HSQUIRRELVM v, Span<unsigned char> value)
+    {
+        detail::pushBlobView(v, value.data(), value.size(), false, nullptr);
+    }
+};
+
+template<>
+struct Marshal<Span<const unsigned char>>
+{
+    static Span<const unsigned char> get(HSQUIRRELVM v, Integer index)
+    {
+        auto bytes = detail::getBlob(v, index, false);
+        return Span<const unsigned char>(bytes.data(), bytes.size());
+    }
+
+    static void put(HSQUIRRELVM v, Span<const unsigned char> value)
+    {
+        detail::pushBlobView(v, const_cast<unsigned char*>(value.data()), value.size(), true, nullptr);
+    }
+};
+
+// Spans of int32_t, float or double refer to the packed storage of a
+// typed array of that element type, without copying, for as long as the
+// array lives. Pushing one creates a new typed array holding a copy.
+template<class ValueT>
+struct Marshal<Span<ValueT>, typename std::enable_if<detail::TypedArrayElement<typename std::remove_const<ValueT>::type>::isElement>::type>
+{
+    using Element = detail::TypedArrayElement<typename std::remove_const<ValueT>::type>;
+
+    static Span<ValueT> get(HSQUIRRELVM v, Integer index)
+    {
+        size_t size = 0;
+        auto data = detail::getTypedArray(v, index, Element::type(), size);
+        return Span<ValueT>(static_cast<ValueT*>(data), size);
+    }
+
+    static void put(HSQUIRRELVM v, Span<ValueT> value)
+    {
+        auto data = sq_newtypedarray(v, Element::type(), static_cast<SQInteger>(value.size()));
+        if (data == nullptr)
+            throw std::runtime_error("Can't allocate a typed array");
+        if (!value.empty())
+            std::memcpy(data, value.data(), value.size() * sizeof(ValueT));
+    }
+};
+
+template<>
+struct Marshal<BlobView>
+{
+    static void put(HSQUIRRELVM v, const BlobView& value)
+    {
+        detail::pushBlobView(v, value.data(), value.size(), value.isReadOnly(), value.getRelease());
+    }
+};
+
+template<class ClassT>
+struct Marshal<ClassT*, typename std::enable_if<std::is_class<ClassT>::value>::type>
+{
+    static ClassT* get(HSQUIRRELVM v, Integer index)
+    {
+        if (sq_gettype(v, index) == OT_NULL)
+            return nullptr;
+
+        return Marshal<typename std::remove_cv<ClassT>::type>::getPointer(v, index);
+    }
+
+    static void put(HSQUIRRELVM v, const ClassT* value)
+    {
+        if (value != nullptr)
+            Marshal<typename std::remove_cv<ClassT>::type>::putPointer(v, value);
+        else
+            sq_pushnull(v);
+    }
+};
+
+template<class ValueT, class AllocT>
+struct Marshal<std::vector<ValueT, AllocT>>
+{
+    using Vector = std::vector<ValueT, AllocT>;
+
+    static Vector get(HSQUIRRELVM v, Integer index)
+    {
+        if (sq_gettype(v, index) != OT_ARRAY)
+            detail::throwArgumentError(v, index, "array");
+
+        index = detail::toAbsoluteIndex(v, index);
+
+        const auto size = sq_getsize(v, index);
+
+        Vector result;
+        result.reserve(static_cast<size_t>(size));
+
+        for (SQInteger i = 0; i < size; ++i)
+        {
+            sq_pushinteger(v, i);
+            sq_get(v, index);
+            result.push_back(Marshal<ValueT>::get(v, -1));
+            sq_pop(v, 1);
+        }
+
+        return result;
+    }
+
+    static void put(HSQUIRRELVM v, const Vector& value)
+    {
+        sq_newarray(v, 0);
+
+        for (const auto& item: value)
+        {
+            Marshal<ValueT>::put(v, item);
+            sq_arrayappend(v, -2);
+        }
+    }
+};
+
+namespace detail {
+
+template<class MapT>
+struct MapMarshal
+{
+    using Key = typename MapT::key_type;
+    using Value = typename MapT::mapped_type;
+
+    static MapT get(HSQUIRRELVM v, Integer index)
+    {
+        if (sq_gettype(v, index) != OT_TABLE)
+            throwArgumentError(v, index, "table");
+
+        index = toAbsoluteIndex(v, index);
+
+        MapT result;
+
+        sq_pushnull(v);
+        while (SQ_SUCCEEDED( sq_next(v, index) ))
+        {
+            result.emplace(Marshal<Key>::get(v, -2), Marshal<Value>::get(v, -1));
+            sq_pop(v, 2);
+        }
+        sq_pop(v, 1);
+
+        return result;
+    }
+
+    static void put(HSQUIRRELVM v, const MapT& value)
+    {
+        sq_newtable(v);
+
+        for (const auto& item: value)
+        {
+            Marshal<Key>::put(v, item.first);
+            Marshal<Value>::put(v, item.second);
+            sq_newslot(v, -3, SQFalse);
+        }
+    }
+};
+
+} // namespace detail
+
+template<class KeyT, class ValueT, class CompareT, class AllocT>
+struct Marshal<std::map<KeyT, ValueT, CompareT, AllocT>>
+    : detail::MapMarshal<std::map<KeyT, ValueT, CompareT, AllocT>> {};
+
+template<class KeyT, class ValueT, class HashT, class EqualT, class AllocT>
+struct Marshal<std::unordered_map<KeyT, ValueT, HashT, EqualT, AllocT>>
+    : detail::MapMarshal<std::unordered_map<KeyT, ValueT, HashT, EqualT, AllocT>> {};
+
+namespace detail {
+
+template<class ValueT, class EnableT = void>
+struct Put
+{
+    static void put(HSQUIRRELVM v, const Bare<ValueT>& value)
+    {
+        Marshal<Bare<ValueT>>::put(v, value);
+    }
+};
+
+// References to exposed classes are pushed as borrowed instances rather than copies.
+template<class ValueT>
+struct Put<ValueT&, typename std::enable_if<std::is_base_of<InstanceMarshal<Bare<ValueT>>, Marshal<Bare<ValueT>>>::value>::type>
+{
+    static void put(HSQUIRRELVM v, const Bare<ValueT>& value)
+    {
+        Marshal<Bare<ValueT>*>::put(v, &value);
+    }
+};
+
+// Pushes the result of a bound call and returns what its native closure
+// hands back to the VM.
+template<class ValueT>
+struct ReturnMarshal
+{
+    static Integer put(HSQUIRRELVM v, const Bare<ValueT>& value)
+    {
+        Put<ValueT>::put(v, value);
+        return 1;
+    }
+};
+
+} // namespace detail
+
+} // namespace sqrew
+
+#endif // SQREW_MARSHAL_H
@@ -0,0 +1,98 @@
+#pragma once
+#ifndef SQREW_SCHEDULER_H
+#define SQREW_SCHEDULER_H
+
+#include "sqrew/Async.h"
+#include "sqrew/Context.h"
+#include "sqrew/Forward.h"
+#include "sqrew/Function.h"
+
+namespace sqrew {
+
+// Runs script functions on script threads of one context and multiplexes
+// them on the thread that owns the scheduler. When a thread calls a bound
+// method returning a pending Future it is suspended (sq_suspendvm) and
+// resumed by poll() once the promise is completed, possibly from another
+// thread.
+class Scheduler final
+{
+public:
+    struct Stats
+    {
+        size_t spawned = 0;
+        size_t finished = 0;
+        size_t failed = 0;
+        size_t suspensions = 0;
+    };
+
+    // Script threads are recycled through a ScriptThreadPool that starts
+    // with 'preparedThreads' threads.
+    explicit Scheduler(const Context& context, size_t preparedThreads = 0);
+
+    // Threads still waiting are dropped; completing their futures later
+    // does nothing.
+    ~Scheduler();
+
+    // Calls 'function' with 'args' on a new script thread. Returns false
+    // if it raised an error before its first suspension or completion.
+    template<class ReturnT, class ...ArgsT>
+    bool spawn(const Function<ReturnT>& function, ArgsT&&... args)
+    {
+        AllocatorScope scope(context_);
+
+        HSQOBJECT handle;
+        auto thread = createThread(handle);
+
+        try
+        {
+            static_cast<const detail::FunctionImpl&>(function).push(thread);
+
+            using Expand = int[];
+            (void)Expand{ 0, (detail::Put<ArgsT>::put(thread, args), 0)... };
+        }
+        catch (...)
+        {
+            releaseThread(handle);
+            throw;
+        }
+
+        return start(handle, thread, sizeof...(ArgsT) + 1);
+    }
+
+    // Resumes the threads whose futures completed since the last call and
+    // returns how many there were. Never blocks.
+    size_t poll();
+
+    // Blocks until a future some thread waits on completes, then polls.
+    size_t wait();
+
+    // Keeps resuming threads until none is left waiting.
+    void run();
+
+    size_t getWaitingCount() const;
+    Stats getStats() const;
+
+private:
+    struct Impl;
+    friend Integer detail::awaitFuture(HSQUIRRELVM v, const std::shared_ptr<detail::FutureState>& state, bool hasValue);
+    friend class detail::FutureState;
+
+    const Context& context_;
+    std::unique_ptr<Impl> impl_;
+
+    HSQUIRRELVM createThread(HSQOBJECT& handle);
+    void releaseThread(HSQOBJECT& handle);
+    bool start(HSQOBJECT handle, HSQUIRRELVM thread, Integer argumentCount);
+    bool resume(HSQOBJECT handle, HSQUIRRELVM thread, bool hasValue, bool throwError);
+    bool settle(HSQOBJECT handle, HSQUIRRELVM thread, bool succeeded);
+
+    // Called by a completed future, on any thread.
+    void post(HSQUIRRELVM thread);
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+};
+
+} // namespace sqrew
+
+#endif // SQREW_SCHEDULER_H
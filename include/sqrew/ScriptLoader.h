@@ -0,0 +1,51 @@
+#pragma once
+#ifndef SQREW_SCRIPTLOADER_H
+#define SQREW_SCRIPTLOADER_H
+
+#include "sqrew/ContextPool.h"
+
+#include <vector>
+
+namespace sqrew {
+
+// Loads many independent script files at once. The files are compiled
+// concurrently on a ContextPool, each worker in a VM of its own, into
+// Programs; only the final step of loading the closures into the target
+// context and running them is serial.
+class ScriptLoader final
+{
+public:
+    struct Result
+    {
+        String path;
+        std::shared_ptr<const Program> program; // nullptr if the file didn't compile
+        String error;
+    };
+
+    // Compiles on 'threadCount' threads, one per hardware thread when 0.
+    explicit ScriptLoader(size_t threadCount = 0, OptimizationLevel level = OptimizationLevel::None);
+    ~ScriptLoader();
+
+    size_t getThreadCount() const;
+
+    // Results come back in the order of 'paths'. A file that can't be read
+    // or has a syntax error gets no program and the reason in 'error'.
+    std::vector<Result> compile(const std::vector<String>& paths);
+
+    // Runs the compiled files in 'context' in order, with the root table
+    // as 'this'. Stops at the first one that is missing or raises an error.
+    bool execute(const Context& context, const std::vector<Result>& results) const;
+
+    // compile followed by execute.
+    bool load(const Context& context, const std::vector<String>& paths);
+
+private:
+    ContextPool pool_;
+
+    ScriptLoader(const ScriptLoader&) = delete;
+    ScriptLoader& operator=(const ScriptLoader&) = delete;
+};
+
+} // namespace sqrew
+
+#endif // SQREW_SCRIPTLOADER_H
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef SQREW_SCRIPTTHREADPOOL_H
+#define SQREW_SCRIPTTHREADPOOL_H
+
+#include "sqrew/Forward.h"
+
+#include <vector>
+
+#include <squirrel.h>
+
+namespace sqrew {
+
+// Script threads (friend VMs sharing a context's root table) kept for
+// reuse, so running a call on a thread of its own doesn't allocate a VM
+// and its stacks every time. Threads take the context's error handler
+// and foreign pointer when they are created.
+class ScriptThreadPool final
+{
+public:
+    struct Stats
+    {
+        size_t created = 0;
+        size_t reused = 0;
+        size_t discarded = 0; // returned while still suspended or running
+    };
+
+    // Creates 'prepared' threads up front, each with a stack of 'stackSize'
+    // slots. At most 'capacity' idle threads are kept.
+    explicit ScriptThreadPool(const Context& context, size_t prepared = 0, Integer stackSize = 64, size_t capacity = 1024);
+    ~ScriptThreadPool();
+
+    // Returns a thread with an empty stack; 'handle' holds the reference
+    // that keeps it alive until it is given back.
+    HSQUIRRELVM acquire(HSQOBJECT& handle);
+
+    // Clears the thread's stack and last error and keeps it for the next
+    // acquire. A thread that is still suspended is released instead.
+    void release(HSQOBJECT& handle);
+
+    size_t getIdleCount() const;
+    Stats getStats() const;
+
+private:
+    const Context& context_;
+    Integer stackSize_;
+    size_t capacity_;
+    std::vector<HSQOBJECT> idle_;
+    Stats stats_;
+
+    HSQOBJECT create();
+
+    ScriptThreadPool(const ScriptThreadPool&) = delete;
+    ScriptThreadPool& operator=(const ScriptThreadPool&) = delete;
+};
+
+} // namespace sqrew
+
+#endif // SQREW_SCRIPTTHREADPOOL_H
@@ -3,6 +3,7 @@
 #define SQREW_TABLE_H
 
 #include "sqrew/Forward.h"
+#include "sqrew/Function.h"
 
 namespace sqrew {
 
@@ -29,11 +30,26 @@ public:
 
     bool contains(const String& name) const;
 
+    // Resolves the closure stored under 'name' once; the table is used as
+    // 'this' for the calls.
+    template<class ReturnT = void>
+    Function<ReturnT> getFunction(const String& name) const
+    {
+        return Function<ReturnT>(findFunction(name));
+    }
+
 private:
+    friend class Context;
+
     struct Impl;
     std::unique_ptr<Impl> impl_;
 
+    detail::FunctionImpl findFunction(const String& name) const;
+
     explicit Table(const Context& context);
+
+    // Takes the table on top of the stack when 'valid', else an empty one.
+    static Table fromTop(const Context& context, bool valid);
 };
 
 } // namespace sqrew
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <functional>
 #include <algorithm>
+#include <type_traits>
 
 namespace sqrew {
 
@@ -42,6 +43,126 @@ public:
     }
 };
 
+// Non-owning view of a character range, e.g. the buffer of an interned
+// script string.
+class StringView
+{
+public:
+    StringView()
+        : data_(nullptr)
+        , size_(0)
+    {}
+
+    StringView(const String::value_type* data, size_t size)
+        : data_(data)
+        , size_(size)
+    {}
+
+    StringView(const String& string)
+        : data_(string.data())
+        , size_(string.size())
+    {}
+
+    inline const String::value_type* data() const { return data_; }
+    inline size_t size() const { return size_; }
+    inline bool empty() const { return size_ == 0; }
+
+    inline const String::value_type* begin() const { return data_; }
+    inline const String::value_type* end() const { return data_ + size_; }
+
+    inline String str() const { return String(data_, size_); }
+
+private:
+    const String::value_type* data_;
+    size_t size_;
+};
+
+// Non-owning view of a contiguous range of values.
+template<class ValueT>
+class Span
+{
+public:
+    Span()
+        : data_(nullptr)
+        , size_(0)
+    {}
+
+    Span(ValueT* data, size_t size)
+        : data_(data)
+        , size_(size)
+    {}
+
+    template<class ContainerT>
+    Span(ContainerT& container)
+        : data_(container.data())
+        , size_(container.size())
+    {}
+
+    inline ValueT* data() const { return data_; }
+    inline size_t size() const { return size_; }
+    inline bool empty() const { return size_ == 0; }
+
+    inline ValueT* begin() const { return data_; }
+    inline ValueT* end() const { return data_ + size_; }
+
+    inline ValueT& operator[](size_t index) const { return data_[index]; }
+
+private:
+    ValueT* data_;
+    size_t size_;
+};
+
+template<class ContainerT>
+inline auto makeSpan(ContainerT& container) -> Span<typename std::remove_pointer<decltype(container.data())>::type>
+{
+    return Span<typename std::remove_pointer<decltype(container.data())>::type>(container.data(), container.size());
+}
+
+// Bytes handed to script as a blob without copying. A Span pushed to
+// script only lends its memory for the duration of the call; a BlobView
+// calls 'release' once the script drops the blob, so the buffer may be
+// given away for good.
+class BlobView
+{
+public:
+    BlobView(unsigned char* data, size_t size, std::function<void()> release = nullptr)
+        : data_(data)
+        , size_(size)
+        , readOnly_(false)
+        , release_(std::move(release))
+    {}
+
+    BlobView(const unsigned char* data, size_t size, std::function<void()> release = nullptr)
+        : data_(const_cast<unsigned char*>(data))
+        , size_(size)
+        , readOnly_(true)
+        , release_(std::move(release))
+    {}
+
+    inline unsigned char* data() const { return data_; }
+    inline size_t size() const { return size_; }
+    inline bool isReadOnly() const { return readOnly_; }
+    inline const std::function<void()>& getRelease() const { return release_; }
+
+private:
+    unsigned char* data_;
+    size_t size_;
+    bool readOnly_;
+    std::function<void()> release_;
+};
+
+template<size_t ...Indices>
+struct IndexSequence {};
+
+template<size_t Count, size_t ...Indices>
+struct MakeIndexSequence: MakeIndexSequence<Count - 1, Count - 1, Indices...> {};
+
+template<size_t ...Indices>
+struct MakeIndexSequence<0, Indices...>
+{
+    using Type = IndexSequence<Indices...>;
+};
+
 template<class FuncT>
 inline bool iteratePath(const String& path, FuncT func)
 {
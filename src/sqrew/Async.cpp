@@ -0,0 +1,45 @@
+#include "sqrew/Async.h"
+
+#include "sqrew/Scheduler.h"
+
+namespace sqrew {
+namespace detail {
+
+FutureState::FutureState()
+    : done_(false)
+    , failed_(false)
+    , scheduler_(nullptr)
+    , thread_(nullptr)
+{}
+
+FutureState::~FutureState() {}
+
+bool FutureState::isReady() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return done_;
+}
+
+void FutureState::reject(const String& error)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    failed_ = true;
+    error_ = error;
+    complete(lock);
+}
+
+void FutureState::complete(std::unique_lock<std::mutex>& lock)
+{
+    done_ = true;
+
+    // The scheduler is posted to under the lock so that it can't go away
+    // in between; its destructor clears scheduler_ under the same lock.
+    if (scheduler_ != nullptr)
+        scheduler_->post(thread_);
+
+    lock.unlock();
+    ready_.notify_all();
+}
+
+} // namespace detail
+} // namespace sqrew
@@ -0,0 +1,262 @@
+#include "sqrew/BytecodeCache.h"
+
+#include "sqrew/Context.h"
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <squirrel.h>
+
+namespace sqrew {
+
+namespace {
+
+using Bytes = std::vector<char>;
+
+// Serialized closure, backed either by a mapped cache file or by bytes
+// produced by the compiler.
+struct Entry
+{
+    std::shared_ptr<const void> owner;
+    const char* data;
+    size_t size;
+};
+
+const uint32_t cacheMagic = 0x43525153; // "SQRC"
+const uint32_t cacheFormatVersion = 1;
+
+struct Header
+{
+    uint32_t magic;
+    uint32_t formatVersion;
+    uint32_t squirrelVersion;
+    uint8_t charSize;
+    uint8_t integerSize;
+    uint8_t floatSize;
+    uint8_t pointerSize;
+    uint64_t key;
+    uint64_t payloadSize;
+    uint64_t payloadHash;
+};
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ULL)
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+Header makeHeader(uint64_t key, const Bytes& payload)
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = cacheMagic;
+    header.formatVersion = cacheFormatVersion;
+    header.squirrelVersion = SQUIRREL_VERSION_NUMBER;
+    header.charSize = sizeof(SQChar);
+    header.integerSize = sizeof(SQInteger);
+    header.floatSize = sizeof(SQFloat);
+    header.pointerSize = sizeof(void*);
+    header.key = key;
+    header.payloadSize = payload.size();
+    header.payloadHash = hashBytes(payload.data(), payload.size());
+    return header;
+}
+
+bool isValid(const Header& header, uint64_t key)
+{
+    return header.magic == cacheMagic
+        && header.formatVersion == cacheFormatVersion
+        && header.squirrelVersion == SQUIRREL_VERSION_NUMBER
+        && header.charSize == sizeof(SQChar)
+        && header.integerSize == sizeof(SQInteger)
+        && header.floatSize == sizeof(SQFloat)
+        && header.pointerSize == sizeof(void*)
+        && header.key == key;
+}
+
+SQInteger writeBytes(SQUserPointer up, SQUserPointer data, SQInteger size)
+{
+    auto bytes = static_cast<Bytes*>(up);
+    auto chars = static_cast<const char*>(data);
+    bytes->insert(bytes->end(), chars, chars + size);
+    return size;
+}
+
+bool readClosure(HSQUIRRELVM v, const Entry& entry)
+{
+    return SQ_SUCCEEDED( sq_readclosurebuffer(v, entry.data, static_cast<SQInteger>(entry.size)) );
+}
+
+} // namespace
+
+struct BytecodeCache::Impl
+{
+    String directory;
+    Stats stats;
+    std::unordered_map<uint64_t, Entry> entries;
+    mutable std::mutex mutex;
+
+    String getPath(uint64_t key) const
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.cnut", static_cast<unsigned long long>(key));
+        return directory + "/" + name;
+    }
+
+    bool readFile(uint64_t key, Entry& entry, bool& exists) const
+    {
+        auto file = std::make_shared<detail::MappedFile>(getPath(key));
+        exists = file->isValid();
+        if (!exists || file->size() < sizeof(Header))
+            return false;
+
+        Header header;
+        std::memcpy(&header, file->data(), sizeof(header));
+
+        if (!isValid(header, key) || header.payloadSize != file->size() - sizeof(Header))
+            return false;
+
+        entry.owner = file;
+        entry.data = file->data() + sizeof(Header);
+        entry.size = static_cast<size_t>(header.payloadSize);
+
+        return hashBytes(entry.data, entry.size) == header.payloadHash;
+    }
+
+    void writeFile(uint64_t key, const Bytes& payload) const
+    {
+        const auto path = getPath(key);
+        const auto temporaryPath = path + ".tmp";
+
+        auto file = std::fopen(temporaryPath.c_str(), "wb");
+        if (file == nullptr)
+            return;
+
+        const auto header = makeHeader(key, payload);
+        const bool written = std::fwrite(&header, sizeof(header), 1, file) == 1
+            && std::fwrite(payload.data(), 1, payload.size(), file) == payload.size();
+
+        std::fclose(file);
+
+        if (!written || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+            std::remove(temporaryPath.c_str());
+    }
+
+    bool findInMemory(uint64_t key, Entry& entry) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto found = entries.find(key);
+        if (found == entries.end())
+            return false;
+
+        entry = found->second;
+        return true;
+    }
+
+    void store(uint64_t key, const Entry& entry)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[key] = entry;
+    }
+
+    void store(uint64_t key, Bytes&& payload)
+    {
+        auto bytes = std::make_shared<const Bytes>(std::move(payload));
+
+        Entry entry = { bytes, bytes->data(), bytes->size() };
+        store(key, entry);
+    }
+
+    void count(size_t Stats::* counter)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++(stats.*counter);
+    }
+};
+
+BytecodeCache::BytecodeCache()
+    : impl_(new Impl())
+{}
+
+BytecodeCache::BytecodeCache(const String& directory)
+    : impl_(new Impl())
+{
+    impl_->directory = directory;
+}
+
+BytecodeCache::~BytecodeCache() {}
+
+bool BytecodeCache::load(const Context& context, const String& buffer, const String& source)
+{
+    auto v = context.getHandle();
+
+    auto key = hashBytes(buffer.data(), buffer.size(), hashBytes(source.c_str(), source.size() + 1));
+
+    // Optimized code gets entries of its own; unoptimized keys stay as they were.
+    const auto level = sq_getoptimizationlevel(v);
+    if (level != SQ_OPT_NONE)
+        key = hashBytes(&level, sizeof(level), key);
+
+    Entry entry;
+
+    if (impl_->findInMemory(key, entry) && readClosure(v, entry))
+    {
+        impl_->count(&Stats::memoryHits);
+        return true;
+    }
+
+    if (!impl_->directory.empty())
+    {
+        bool exists = false;
+        if (impl_->readFile(key, entry, exists) && readClosure(v, entry))
+        {
+            impl_->store(key, entry);
+            impl_->count(&Stats::diskHits);
+            return true;
+        }
+
+        if (exists)
+            impl_->count(&Stats::rejected);
+    }
+
+    impl_->count(&Stats::misses);
+
+    if (SQ_FAILED( sq_compilebuffer(v, buffer.c_str(), buffer.size(), source.c_str(), SQTrue) ))
+        return false;
+
+    Bytes payload;
+    if (SQ_FAILED( sq_writeclosure(v, writeBytes, &payload) ))
+        return true;
+
+    if (!impl_->directory.empty())
+        impl_->writeFile(key, payload);
+
+    impl_->store(key, std::move(payload));
+    return true;
+}
+
+BytecodeCache::Stats BytecodeCache::getStats() const
+{
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->stats;
+}
+
+void BytecodeCache::clear()
+{
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->entries.clear();
+}
+
+} // namespace sqrew
@@ -11,62 +11,43 @@ namespace detail {
 struct ClassImpl::Detail
 {
     HSQOBJECT classObject;
-    HSQOBJECT setTable;
-    HSQOBJECT getTable;
 
     bool isConstructorSet = false;
 
     Detail()
     {
         sq_resetobject(&classObject);
-        sq_resetobject(&setTable);
-        sq_resetobject(&getTable);
     }
 
     ~Detail() {}
 
-    void registerClosure(HSQUIRRELVM v, ClosureType type, const String& name, Func func)
+    // Setters and getters become the two halves of a native property slot,
+    // which the VM calls directly on member access.
+    void registerClosure(HSQUIRRELVM v, ClosureType type, const String& name, Func func, bool bindUserData)
     {
-        const HSQOBJECT* registerAs[] = { &classObject, &setTable, &getTable };
+        const auto userData = sq_gettop(v);
 
-        sq_pushobject(v, *registerAs[static_cast<int>(type)]);
+        sq_pushobject(v, classObject);
         sq_pushstring(v, name.c_str(), name.size());
-        sq_push(v, -3);
-        sq_newclosure(v, func, 1);
-        sq_setnativeclosurename(v, -1, name.c_str());
-        sq_newslot(v, -3, SQFalse);
-        sq_pop(v, 2);
-    }
 
-    static int set(HSQUIRRELVM v)
-    {
-        sq_push(v, 2);
-        if (SQ_FAILED( sq_get(v, -2) ))
-        {
-            //String errorMessage
-            return sq_throwerror(v, _SC("the index '' does not exist"));
-        }
-
-        sq_push(v, 1);
-        sq_push(v, 3);
-
-        sq_call(v, 2, SQFalse, SQTrue);
-        return 0;
-    }
+        if (type == ClosureType::Setter)
+            sq_pushnull(v);
 
-    static int get(HSQUIRRELVM v)
-    {
-        sq_push(v, 2);
-        if (SQ_FAILED( sq_get(v, -2) ))
-        {
-            //String errorMessage
-            return sq_throwerror(v, _SC("the index '' does not exist"));
-        }
+        if (bindUserData)
+            sq_push(v, userData);
+
+        sq_newclosure(v, func, bindUserData ? 1 : 0);
+        sq_setnativeclosurename(v, -1, name.c_str());
 
-        sq_push(v, 1);
+        if (type == ClosureType::Getter)
+            sq_pushnull(v);
 
-        sq_call(v, 1, SQTrue, SQTrue);
-        return 1;
+        if (type == ClosureType::Method)
+            sq_newslot(v, -3, SQFalse);
+        else
+            sq_newproperty(v, -4);
+
+        sq_pop(v, bindUserData ? 2 : 1);
     }
 };
 
@@ -79,6 +60,8 @@ ClassImpl::~ClassImpl() {}
 
 void ClassImpl::initialize(const String& name, size_t typeTag)
 {
+    AllocatorScope scope(context_);
+
     auto v = context_.getHandle();
 
 
@@ -96,60 +79,27 @@ void ClassImpl::initialize(const String& name, size_t typeTag)
 
     sq_pop(v, 1);
 
-    //auto classRegistry = Table::
-
-    /*
-    auto classesTable = Table::create(context_, _SC("__sqrew_classes"), TableDomain::Registry);
-    auto classRegistry = classesTable.createTable(name);
-    auto setTable = classRegistry.create("set");
-    auto getTable = classRegistry.create("get");
-    */
-
     sq_pushregistrytable(v);
 
     sq_pushstring(v, _SC("__sqrew_classes"), -1);
     sq_get(v, -2);
-
-    HSQOBJECT registryTable;
-    sq_resetobject(&registryTable);
     sq_pushstring(v, name.c_str(), name.size());
-    sq_newtable(v);
-    sq_getstackobj(v, -1, &registryTable);
-    sq_newslot(v, -3, SQTrue);
-
-    sq_pop(v, 2);
-
-    sq_pushobject(v, registryTable);
-
-    sq_pushstring(v, _SC("set"), -1);
-    sq_newtable(v);
-    sq_getstackobj(v, -1, &detail_->setTable);
-    sq_newslot(v, -3, SQTrue);
-
-    sq_pushstring(v, _SC("get"), -1);
-    sq_newtable(v);
-    sq_getstackobj(v, -1, &detail_->getTable);
+    sq_pushobject(v, detail_->classObject);
     sq_newslot(v, -3, SQTrue);
 
-    sq_pop(v, 1);
-
+    sq_pushstring(v, _SC("__sqrew_types"), -1);
+    sq_get(v, -3);
+    sq_pushuserpointer(v, reinterpret_cast<SQUserPointer>(typeTag));
     sq_pushobject(v, detail_->classObject);
-
-    sq_pushstring(v, _SC("_set"), -1);
-    sq_pushobject(v, detail_->setTable);
-    sq_newclosure(v, Detail::set, 1);
-    sq_newslot(v, -3, SQFalse);
-
-    sq_pushstring(v, _SC("_get"), -1);
-    sq_pushobject(v, detail_->getTable);
-    sq_newclosure(v, Detail::get, 1);
     sq_newslot(v, -3, SQFalse);
 
-    sq_pop(v, 1);
+    sq_pop(v, 3);
 }
 
 void ClassImpl::registerConstructor(Func func)
 {
+    AllocatorScope scope(context_);
+
     auto v = context_.getHandle();
 
     if (detail_->isConstructorSet)
@@ -166,8 +116,18 @@ void ClassImpl::registerConstructor(Func func)
 
 void ClassImpl::registerClosure(ClassImpl::ClosureType type, const String& name, ClassImpl::Func func)
 {
+    AllocatorScope scope(context_);
+
     auto v = context_.getHandle();
-    detail_->registerClosure(v, type, name, func);
+    detail_->registerClosure(v, type, name, func, true);
+}
+
+void ClassImpl::registerFunction(ClassImpl::ClosureType type, const String& name, ClassImpl::Func func)
+{
+    AllocatorScope scope(context_);
+
+    auto v = context_.getHandle();
+    detail_->registerClosure(v, type, name, func, false);
 }
 
 void* ClassImpl::createUserData(HSQUIRRELVM v, size_t size, ReleaseHook releaseHook)
@@ -180,6 +140,8 @@ void* ClassImpl::createUserData(HSQUIRRELVM v, size_t size, ReleaseHook releaseH
 
 void *ClassImpl::createUserData(size_t size, ClassImpl::ReleaseHook releaseHook)
 {
+    AllocatorScope scope(context_);
+
     return createUserData(context_.getHandle(), size, releaseHook);
 }
 
@@ -198,9 +160,12 @@ void ClassImpl::setInstance(HSQUIRRELVM v, Integer index, void* instance, Releas
 
 void* ClassImpl::getInstance(HSQUIRRELVM v, Integer index, size_t typeTag)
 {
-    SQUserPointer ptr;
-    sq_getinstanceup(v, index, &ptr, reinterpret_cast<SQUserPointer>(typeTag));
-    return ptr;
+    return getInstancePointer(v, index, typeTag);
+}
+
+Integer ClassImpl::throwError(HSQUIRRELVM v, const std::exception& error)
+{
+    return sq_throwerror(v, error.what());
 }
 
 ClassImpl::ClassImpl(ClassImpl&& rhs)
@@ -208,37 +173,5 @@ ClassImpl::ClassImpl(ClassImpl&& rhs)
     , context_(std::move(rhs.context_))
 {}
 
-template<>
-Integer ClassImpl::getValue<Integer>(HSQUIRRELVM v, Integer index)
-{
-    SQInteger value;
-    if (SQ_FAILED( sq_getinteger(v, index, &value) ))
-        sq_throwerror(v, _SC("Invalid argument type"));
-
-    return value;
-}
-
-template<>
-Float ClassImpl::getValue<Float>(HSQUIRRELVM v, Integer index)
-{
-    SQFloat value;
-    if (SQ_FAILED( sq_getfloat(v, index, &value) ))
-        sq_throwerror(v, _SC("Invalid argument type"));
-
-    return value;
-}
-
-template<>
-void ClassImpl::putValue<Integer>(HSQUIRRELVM v, Integer value)
-{
-    sq_pushinteger(v, value);
-}
-
-template<>
-void ClassImpl::putValue<Float>(HSQUIRRELVM v, Float value)
-{
-    sq_pushfloat(v, value);
-}
-
 } // namespace detail
 } // namespace sqrew
@@ -1,8 +1,13 @@
 #include "sqrew/Context.h"
 
+#include "sqrew/BytecodeCache.h"
 #include "sqrew/Interface.h"
 #include "sqrew/Table.h"
 
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
 #include <cstdarg>
 #include <cstdio>
 
@@ -31,7 +36,16 @@ struct Context::Detail
                                     SQInteger line,
                                     SQInteger column);
 
+    static SQInteger require(HSQUIRRELVM vm);
+
+    // Pushes the table of module 'name', running the module first if it
+    // isn't cached yet. Leaves the stack as it was on failure.
+    static bool loadModule(const Context& context, const String& name, String& error);
+
     static Context* getContext(HSQUIRRELVM vm);
+
+    // Objects scanned or swept between two looks at the clock.
+    static const SQInteger collectSlice = 64;
 };
 
 Context::Context()
@@ -40,18 +54,105 @@ Context::Context()
 }
 
 Context::Context(int stackSize)
-    : vm_(sq_open(stackSize))
+    : Context(stackSize, Allocation::Heap)
 {
+}
 
+Context::Context(int stackSize, Allocation allocation)
+    : allocator_(allocation == Allocation::Pool ? sq_newallocator() : nullptr)
+    , vm_(nullptr)
+{
+    AllocatorScope scope(*this);
+    vm_ = sq_open(stackSize);
 }
 
 Context::~Context()
 {
-    sq_close(vm_);
+    {
+        AllocatorScope scope(*this);
+        sq_close(vm_);
+    }
+
+    if (allocator_ != nullptr)
+        sq_releaseallocator(allocator_);
+}
+
+AllocationStats Context::getAllocationStats() const
+{
+    AllocationStats result;
+    if (allocator_ == nullptr)
+        return result;
+
+    SQAllocatorStats stats;
+    sq_getallocatorstats(allocator_, &stats);
+
+    result.bytesLive = stats.bytes_live;
+    result.bytesPeak = stats.bytes_peak;
+    result.largeBytesLive = stats.large_bytes_live;
+    result.bytesReserved = stats.bytes_reserved;
+
+    for (size_t i = 0; i < SQ_ALLOCATOR_CLASSES; ++i)
+    {
+        if (stats.class_allocs[i] == 0)
+            continue;
+
+        result.sizeClasses.push_back({ (i + 1) * SQ_ALLOCATOR_GRANULARITY, stats.class_live[i], stats.class_allocs[i] });
+    }
+
+    return result;
+}
+
+bool Context::collectStep(int budgetMicros)
+{
+    AllocatorScope scope(*this);
+
+    using Clock = std::chrono::steady_clock;
+
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::microseconds(budgetMicros);
+
+    bool finished = false;
+    auto now = start;
+    do
+    {
+        finished = sq_collectstep(vm_, Detail::collectSlice) != SQFalse;
+        now = Clock::now();
+    }
+    while (!finished && now < deadline);
+
+    const double pause = std::chrono::duration<double, std::micro>(now - start).count();
+
+    size_t bucket = 0;
+    while (bucket + 1 < CollectorStats::PauseBuckets && pause >= static_cast<double>(1u << bucket))
+        ++bucket;
+
+    ++collectorStats_.pauseHistogram[bucket];
+    ++collectorStats_.steps;
+    collectorStats_.totalPauseMicros += pause;
+    if (pause > collectorStats_.longestPauseMicros)
+        collectorStats_.longestPauseMicros = pause;
+
+    return finished;
+}
+
+CollectorStats Context::getCollectorStats() const
+{
+    CollectorStats result = collectorStats_;
+
+    SQCollectorStats stats;
+    sq_getcollectorstats(vm_, &stats);
+
+    result.cycles = stats.cycles;
+    result.objectsFreed = stats.freed;
+    result.collecting = stats.collecting != SQFalse;
+
+    return result;
 }
 
 void Context::initialize()
 {
+    AllocatorScope scope(*this);
+
     sq_setforeignptr(vm_, this);
 
     sq_setprintfunc(vm_, Detail::print, Detail::printError);
@@ -62,6 +163,15 @@ void Context::initialize()
     sqstd_register_stringlib(vm_);
     sqstd_register_bloblib(vm_);
 
+    // The context is bound to the closure: threads made by the script's
+    // newthread have no foreign pointer to find it through.
+    sq_pushstring(vm_, _SC("require"), -1);
+    sq_pushuserpointer(vm_, this);
+    sq_newclosure(vm_, Detail::require, 1);
+    sq_setparamscheck(vm_, 2, _SC(".s"));
+    sq_setnativeclosurename(vm_, -1, _SC("require"));
+    sq_newslot(vm_, -3, SQFalse);
+
     sq_setcompilererrorhandler(vm_, Detail::handleCompilerError);
     sq_newclosure(vm_, Detail::handleError, 0);
     sq_seterrorhandler(vm_);
@@ -69,6 +179,44 @@ void Context::initialize()
     sq_pop(vm_, 1);
 
     Table::create(*this, _SC("__sqrew_classes"), TableDomain::Registry);
+    Table::create(*this, _SC("__sqrew_types"), TableDomain::Registry);
+    Table::create(*this, _SC("__sqrew_modules"), TableDomain::Registry);
+}
+
+void Context::setModulePaths(std::vector<String> paths)
+{
+    modulePaths_ = std::move(paths);
+}
+
+Table Context::require(const String& name) const
+{
+    StackLock lock(*this);
+
+    String error;
+    if (!Detail::loadModule(*this, name, error))
+    {
+        if (interface_)
+            interface_->printError(error);
+
+        return Table::fromTop(*this, false);
+    }
+
+    return Table::fromTop(*this, true);
+}
+
+void Context::setBytecodeCache(std::shared_ptr<BytecodeCache> cache)
+{
+    bytecodeCache_ = std::move(cache);
+}
+
+void Context::setOptimizationLevel(OptimizationLevel level)
+{
+    sq_setoptimizationlevel(vm_, static_cast<SQInteger>(level));
+}
+
+OptimizationLevel Context::getOptimizationLevel() const
+{
+    return static_cast<OptimizationLevel>(sq_getoptimizationlevel(vm_));
 }
 
 bool Context::executeBuffer(const String& buffer) const
@@ -82,7 +230,55 @@ bool Context::executeBuffer(const String& buffer, const String& source) const
 
     sq_pushroottable(vm_);
 
-    if (SQ_FAILED( sq_compilebuffer(vm_, buffer.c_str(), buffer.size(), source.c_str(), SQTrue) ))
+    if (bytecodeCache_)
+    {
+        if (!bytecodeCache_->load(*this, buffer, source))
+            return false;
+    }
+    else if (SQ_FAILED( sq_compilebuffer(vm_, buffer.c_str(), buffer.size(), source.c_str(), SQTrue) ))
+    {
+        return false;
+    }
+
+    sq_push(vm_, -2);
+    return SQ_SUCCEEDED( sq_call(vm_, 1, SQFalse, SQTrue) );
+}
+
+bool Context::executeFile(const String& path) const
+{
+    detail::MappedFile file(path);
+    if (!file.isValid())
+        return false;
+
+    const char* data = file.data();
+    size_t size = file.size();
+    detail::skipByteOrderMark(data, size);
+
+    if (bytecodeCache_)
+        return executeBuffer(String(data, size), path);
+
+    StackLock lock(*this);
+
+    sq_pushroottable(vm_);
+
+    if (SQ_FAILED( sq_compilebuffer(vm_, data, static_cast<SQInteger>(size), path.c_str(), SQTrue) ))
+        return false;
+
+    sq_push(vm_, -2);
+    return SQ_SUCCEEDED( sq_call(vm_, 1, SQFalse, SQTrue) );
+}
+
+bool Context::executeBytecodeFile(const String& path) const
+{
+    StackLock lock(*this);
+
+    detail::MappedFile file(path);
+    if (!file.isValid())
+        return false;
+
+    sq_pushroottable(vm_);
+
+    if (SQ_FAILED( sq_readclosurebuffer(vm_, file.data(), static_cast<SQInteger>(file.size())) ))
         return false;
 
     sq_push(vm_, -2);
@@ -152,13 +348,133 @@ void Context::Detail::handleCompilerError(HSQUIRRELVM vm,
 
 }
 
+SQInteger Context::Detail::require(HSQUIRRELVM vm)
+{
+    SQUserPointer bound = nullptr;
+    sq_getuserpointer(vm, -1, &bound);
+    Context* context = static_cast<Context*>(bound);
+
+    const SQChar* name;
+    sq_getstring(vm, 2, &name);
+
+    String error;
+    if (!loadModule(*context, name, error))
+        return sq_throwerror(vm, error.c_str());
+
+    // Called from a script thread: the module ran on the context's VM.
+    if (vm != context->vm_)
+    {
+        sq_move(vm, context->vm_, -1);
+        sq_pop(context->vm_, 1);
+    }
+
+    return 1;
+}
+
+bool Context::Detail::loadModule(const Context& context, const String& name, String& error)
+{
+    auto v = context.vm_;
+    const SQInteger top = sq_gettop(v);
+
+    HSQOBJECT modules, module;
+    sq_pushregistrytable(v);
+    sq_pushstring(v, _SC("__sqrew_modules"), -1);
+    sq_get(v, -2);
+    sq_getstackobj(v, -1, &modules);
+
+    sq_pushstring(v, name.c_str(), name.size());
+    if (SQ_SUCCEEDED( sq_get(v, -2) ))
+    {
+        sq_getstackobj(v, -1, &module);
+        sq_settop(v, top);
+        sq_pushobject(v, module);
+        return true;
+    }
+
+    String relative = name;
+    std::replace(relative.begin(), relative.end(), '.', '/');
+    relative += ".nut";
+
+    std::unique_ptr<detail::MappedFile> file;
+    String path;
+    for (const auto& directory: context.modulePaths_)
+    {
+        path = directory.empty() ? relative : directory + "/" + relative;
+        file.reset(new detail::MappedFile(path));
+        if (file->isValid())
+            break;
+        file.reset();
+    }
+
+    if (!file)
+    {
+        sq_settop(v, top);
+        error = "module '" + name + "' not found";
+        return false;
+    }
+
+    // The table is cached before the module runs, so modules requiring
+    // each other get the partly filled table instead of recursing.
+    sq_pushstring(v, name.c_str(), name.size());
+    sq_newtable(v);
+    sq_getstackobj(v, -1, &module);
+    sq_newslot(v, -3, SQFalse);
+    sq_settop(v, top);
+
+    const char* data = file->data();
+    size_t size = file->size();
+    detail::skipByteOrderMark(data, size);
+
+    bool loaded;
+    if (context.bytecodeCache_)
+        loaded = context.bytecodeCache_->load(context, String(data, size), path);
+    else
+        loaded = SQ_SUCCEEDED( sq_compilebuffer(v, data, static_cast<SQInteger>(size), path.c_str(), SQTrue) );
+
+    // The error isn't raised here: it goes back to whoever asked for the
+    // module, which reports it once.
+    if (loaded)
+    {
+        sq_pushobject(v, module);
+        loaded = SQ_SUCCEEDED( sq_call(v, 1, SQFalse, SQFalse) );
+    }
+
+    if (!loaded)
+    {
+        const SQChar* reason = _SC("failed to load");
+        sq_getlasterror(v);
+        sq_getstring(v, -1, &reason);
+        error = "module '" + name + "': " + reason;
+
+        sq_pushobject(v, modules);
+        sq_pushstring(v, name.c_str(), name.size());
+        sq_deleteslot(v, -2, SQFalse);
+        sq_settop(v, top);
+        return false;
+    }
+
+    sq_settop(v, top);
+    sq_pushobject(v, module);
+    return true;
+}
+
 Context* Context::Detail::getContext(HSQUIRRELVM vm)
 {
     return static_cast<Context*>(sq_getforeignptr(vm));
 }
 
+AllocatorScope::AllocatorScope(const Context& ctx)
+    : previous_(sq_setallocator(ctx.getAllocator()))
+{}
+
+AllocatorScope::~AllocatorScope()
+{
+    sq_setallocator(previous_);
+}
+
 StackLock::StackLock(const Context& ctx)
-    : context_(ctx)
+    : scope_(ctx)
+    , context_(ctx)
     , top_(sq_gettop(ctx.getHandle()))
 {}
 
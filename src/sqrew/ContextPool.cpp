@@ -0,0 +1,293 @@
+#include "sqrew/ContextPool.h"
+
+#include "sqrew/Context.h"
+
+#include "TaskQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <squirrel.h>
+
+namespace sqrew {
+
+namespace {
+
+// Times a worker polls the empty queue before going to sleep.
+const int spinCount = 64;
+
+SQInteger writeBytes(SQUserPointer up, SQUserPointer data, SQInteger size)
+{
+    auto bytes = static_cast<std::vector<char>*>(up);
+    auto chars = static_cast<const char*>(data);
+    bytes->insert(bytes->end(), chars, chars + size);
+    return size;
+}
+
+} // namespace
+
+bool Program::load(const Context& context) const
+{
+    AllocatorScope scope(context);
+    return SQ_SUCCEEDED( sq_readclosurebuffer(context.getHandle(), bytes_.data(), static_cast<SQInteger>(bytes_.size())) );
+}
+
+struct ContextPool::Impl
+{
+    struct Job
+    {
+        Task task;
+        std::shared_ptr<const Program> program;
+    };
+
+    // Closures of the programs a worker has run. The entry keeps the
+    // program alive, so the key can't be reused while it's cached.
+    struct CachedProgram
+    {
+        std::shared_ptr<const Program> program;
+        HSQOBJECT closure;
+    };
+
+    Task setup;
+    detail::TaskQueue<Job> queue;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable idle;
+    std::atomic<size_t> sleeping;
+    std::atomic<size_t> pending;
+    bool stopping;
+
+    std::atomic<size_t> completed;
+    std::atomic<size_t> failed;
+
+    std::mutex compilerMutex;
+    Context compiler;
+
+    explicit Impl(size_t queueCapacity)
+        : queue(queueCapacity)
+        , sleeping(0)
+        , pending(0)
+        , stopping(false)
+        , completed(0)
+        , failed(0)
+    {
+        compiler.initialize();
+    }
+
+    bool push(Job& job)
+    {
+        pending.fetch_add(1);
+
+        if (!queue.tryPush(job))
+        {
+            finish();
+            return false;
+        }
+
+        // Pairs with the fence in pop: either the worker sees the job when
+        // it looks again, or we see it asleep and wake it up.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            wakeup.notify_one();
+        }
+
+        return true;
+    }
+
+    // Blocks until a job arrives; false once the pool is stopping and the
+    // queue has run dry.
+    bool pop(Job& job)
+    {
+        for (int i = 0; i < spinCount; ++i)
+        {
+            if (queue.tryPop(job))
+                return true;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        sleeping.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool popped;
+        while (!(popped = queue.tryPop(job)) && !stopping)
+            wakeup.wait(lock);
+
+        sleeping.fetch_sub(1);
+        return popped;
+    }
+
+    void finish()
+    {
+        if (pending.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            idle.notify_all();
+        }
+    }
+
+    static bool run(Context& context, std::unordered_map<const Program*, CachedProgram>& closures, const std::shared_ptr<const Program>& program)
+    {
+        StackLock lock(context);
+        auto v = context.getHandle();
+
+        auto found = closures.find(program.get());
+        if (found == closures.end())
+        {
+            if (!program->load(context))
+                return false;
+
+            CachedProgram cached = { program, HSQOBJECT() };
+            sq_getstackobj(v, -1, &cached.closure);
+            sq_addref(v, &cached.closure);
+            closures.emplace(program.get(), cached);
+        }
+        else
+        {
+            sq_pushobject(v, found->second.closure);
+        }
+
+        sq_pushroottable(v);
+        return SQ_SUCCEEDED( sq_call(v, 1, SQFalse, SQTrue) );
+    }
+
+    void work()
+    {
+        Context context(1024, Allocation::Pool);
+        context.initialize();
+        if (setup)
+            setup(context);
+
+        std::unordered_map<const Program*, CachedProgram> closures;
+
+        Job job;
+        while (pop(job))
+        {
+            bool succeeded = true;
+
+            if (job.program)
+            {
+                succeeded = run(context, closures, job.program);
+            }
+            else
+            {
+                try
+                {
+                    job.task(context);
+                }
+                catch (...)
+                {
+                    succeeded = false;
+                }
+            }
+
+            job = Job();
+
+            ++(succeeded ? completed : failed);
+            finish();
+        }
+
+        AllocatorScope scope(context);
+        for (auto& entry: closures)
+            sq_release(context.getHandle(), &entry.second.closure);
+    }
+};
+
+ContextPool::ContextPool(size_t workerCount, Task setup, size_t queueCapacity)
+    : impl_(new Impl(queueCapacity))
+{
+    if (workerCount == 0)
+        workerCount = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+    impl_->setup = std::move(setup);
+
+    for (size_t i = 0; i < workerCount; ++i)
+        impl_->workers.emplace_back(&Impl::work, impl_.get());
+}
+
+ContextPool::~ContextPool()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->stopping = true;
+    }
+    impl_->wakeup.notify_all();
+
+    for (auto& worker: impl_->workers)
+        worker.join();
+}
+
+size_t ContextPool::getWorkerCount() const
+{
+    return impl_->workers.size();
+}
+
+std::shared_ptr<const Program> ContextPool::compile(const String& buffer, const String& source,
+    OptimizationLevel level)
+{
+    std::lock_guard<std::mutex> lock(impl_->compilerMutex);
+
+    StackLock stack(impl_->compiler);
+    auto v = impl_->compiler.getHandle();
+
+    impl_->compiler.setOptimizationLevel(level);
+    if (SQ_FAILED( sq_compilebuffer(v, buffer.c_str(), buffer.size(), source.c_str(), SQTrue) ))
+        return nullptr;
+
+    auto program = std::make_shared<Program>();
+    program->source_ = source;
+
+    if (SQ_FAILED( sq_writeclosure(v, writeBytes, &program->bytes_) ))
+        return nullptr;
+
+    return program;
+}
+
+void ContextPool::submit(Task task)
+{
+    Impl::Job job = { std::move(task), nullptr };
+    while (!impl_->push(job))
+        std::this_thread::yield();
+}
+
+void ContextPool::submit(std::shared_ptr<const Program> program)
+{
+    Impl::Job job = { Task(), std::move(program) };
+    while (!impl_->push(job))
+        std::this_thread::yield();
+}
+
+bool ContextPool::trySubmit(Task& task)
+{
+    Impl::Job job = { std::move(task), nullptr };
+    if (impl_->push(job))
+        return true;
+
+    task = std::move(job.task);
+    return false;
+}
+
+void ContextPool::wait()
+{
+    std::unique_lock<std::mutex> lock(impl_->mutex);
+    impl_->idle.wait(lock, [this]() { return impl_->pending.load() == 0; });
+}
+
+ContextPool::Stats ContextPool::getStats() const
+{
+    Stats result;
+    result.completed = impl_->completed.load();
+    result.failed = impl_->failed.load();
+    return result;
+}
+
+} // namespace sqrew
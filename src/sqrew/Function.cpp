@@ -1,10 +1,140 @@
 #include "sqrew/Function.h"
 
+#include "sqrew/Context.h"
+
+#include <squirrel.h>
+
 namespace sqrew {
+namespace detail {
+
+FunctionImpl::FunctionImpl()
+    : context_(nullptr)
+{
+    sq_resetobject(&closure_);
+    sq_resetobject(&environment_);
+}
+
+FunctionImpl::FunctionImpl(const Context& context, const HSQOBJECT& closure, const HSQOBJECT& environment)
+    : context_(&context)
+    , closure_(closure)
+    , environment_(environment)
+{
+    addRef();
+}
+
+FunctionImpl::FunctionImpl(const FunctionImpl& rhs)
+    : context_(rhs.context_)
+    , closure_(rhs.closure_)
+    , environment_(rhs.environment_)
+{
+    addRef();
+}
+
+FunctionImpl::FunctionImpl(FunctionImpl&& rhs)
+    : context_(rhs.context_)
+    , closure_(rhs.closure_)
+    , environment_(rhs.environment_)
+{
+    rhs.context_ = nullptr;
+    sq_resetobject(&rhs.closure_);
+    sq_resetobject(&rhs.environment_);
+}
+
+FunctionImpl::~FunctionImpl()
+{
+    release();
+}
+
+FunctionImpl& FunctionImpl::operator=(const FunctionImpl& rhs)
+{
+    if (this != &rhs)
+    {
+        release();
+        context_ = rhs.context_;
+        closure_ = rhs.closure_;
+        environment_ = rhs.environment_;
+        addRef();
+    }
+
+    return *this;
+}
+
+FunctionImpl& FunctionImpl::operator=(FunctionImpl&& rhs)
+{
+    if (this != &rhs)
+    {
+        release();
+        context_ = rhs.context_;
+        closure_ = rhs.closure_;
+        environment_ = rhs.environment_;
+
+        rhs.context_ = nullptr;
+        sq_resetobject(&rhs.closure_);
+        sq_resetobject(&rhs.environment_);
+    }
+
+    return *this;
+}
+
+bool FunctionImpl::isValid() const
+{
+    return context_ != nullptr && (sq_isclosure(closure_) || sq_isnativeclosure(closure_));
+}
+
+void FunctionImpl::reserveStack(Integer size) const
+{
+    if (context_ != nullptr)
+        sq_reservestack(getHandle(), size);
+}
 
-/*Function::Function()
+HSQUIRRELVM FunctionImpl::getHandle() const
 {
+    return context_->getHandle();
+}
+
+void FunctionImpl::push(HSQUIRRELVM v) const
+{
+    if (!isValid())
+        throw std::runtime_error("Function is not bound to a closure");
+
+    sq_pushobject(v, closure_);
+    sq_pushobject(v, environment_);
+}
+
+void FunctionImpl::call(HSQUIRRELVM v, Integer argumentCount, bool hasResult) const
+{
+    if (SQ_SUCCEEDED( sq_call(v, argumentCount, hasResult ? SQTrue : SQFalse, SQTrue) ))
+        return;
+
+    String message("script function call failed");
+
+    sq_getlasterror(v);
+    const SQChar* error = nullptr;
+    if (SQ_SUCCEEDED( sq_getstring(v, -1, &error) ))
+        message = error;
+
+    throw std::runtime_error(message);
+}
+
+void FunctionImpl::addRef()
+{
+    if (context_ == nullptr)
+        return;
+
+    auto v = getHandle();
+    sq_addref(v, &closure_);
+    sq_addref(v, &environment_);
+}
+
+void FunctionImpl::release()
+{
+    if (context_ == nullptr)
+        return;
+
+    auto v = getHandle();
+    sq_release(v, &closure_);
+    sq_release(v, &environment_);
 }
-*/
 
+} // namespace detail
 } // namespace sqrew
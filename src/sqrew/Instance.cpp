@@ -1,21 +1,120 @@
 #include "sqrew/Instance.h"
 
+#include "sqrew/Utils.h"
+
+#include <stdexcept>
+#include <unordered_map>
+
+#include <squirrel.h>
+
 namespace sqrew {
 
 struct Instance::Impl
 {
+    const Context& context;
+    HSQOBJECT object;
+    std::unordered_map<String, detail::FunctionImpl> methods;
+
+    explicit Impl(const Context& ctx)
+        : context(ctx)
+    {
+        sq_resetobject(&object);
+    }
 
+    ~Impl()
+    {
+        methods.clear();
+
+        if (isValid())
+            sq_release(context.getHandle(), &object);
+    }
+
+    inline bool isValid() const
+    {
+        return sq_isinstance(object);
+    }
 };
 
-Instance::Instance(const Context& context, const String& className)
-    : impl_(new Impl())
+Instance::Instance(const Context& context)
+    : impl_(new Impl(context))
+{}
+
+Instance::Instance(Instance&& rhs)
+    : impl_(std::move(rhs.impl_))
+{}
+
+Instance::~Instance() {}
+
+bool Instance::isValid() const
+{
+    return impl_ && impl_->isValid();
+}
+
+void Instance::pushClass(const String& className)
+{
+    auto v = impl_->context.getHandle();
+
+    sq_pushroottable(v);
+
+    const bool found = iteratePath(className, [=](const String& name) -> bool
+    {
+        sq_pushstring(v, name.c_str(), name.size());
+        return SQ_SUCCEEDED( sq_get(v, -2) );
+    });
+
+    if (!found || sq_gettype(v, -1) != OT_CLASS)
+        throw std::runtime_error("Class not found: " + className);
+
+    sq_pushroottable(v);
+}
+
+void Instance::construct(Integer argumentCount)
 {
+    auto v = impl_->context.getHandle();
+
+    if (SQ_FAILED( sq_call(v, argumentCount, SQTrue, SQTrue) ))
+    {
+        String message("script class constructor failed");
+
+        sq_getlasterror(v);
+        const SQChar* error = nullptr;
+        if (SQ_SUCCEEDED( sq_getstring(v, -1, &error) ))
+            message = error;
 
+        throw std::runtime_error(message);
+    }
+
+    sq_getstackobj(v, -1, &impl_->object);
+    sq_addref(v, &impl_->object);
 }
 
-Instance::~Instance()
+detail::FunctionImpl Instance::findMethod(const String& name)
 {
+    if (!isValid())
+        return detail::FunctionImpl();
+
+    auto cached = impl_->methods.find(name);
+    if (cached != impl_->methods.end())
+        return cached->second;
+
+    StackLock lock(impl_->context);
+
+    auto v = impl_->context.getHandle();
+
+    sq_pushobject(v, impl_->object);
+    sq_pushstring(v, name.c_str(), name.size());
+    if (SQ_FAILED( sq_get(v, -2) ))
+        return detail::FunctionImpl();
+
+    HSQOBJECT closure;
+    sq_getstackobj(v, -1, &closure);
+
+    if (!sq_isclosure(closure) && !sq_isnativeclosure(closure))
+        return detail::FunctionImpl();
 
+    detail::FunctionImpl method(impl_->context, closure, impl_->object);
+    impl_->methods.emplace(name, method);
+    return method;
 }
 
 } // namespace sqrew
@@ -0,0 +1,81 @@
+#include "MappedFile.h"
+
+#include <cstdio>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sqrew {
+namespace detail {
+
+MappedFile::MappedFile(const String& path)
+    : data_(nullptr)
+    , size_(0)
+    , mapped_(false)
+{
+#if !defined(_WIN32)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat info;
+    if (::fstat(fd, &info) == 0)
+    {
+        if (info.st_size == 0)
+        {
+            data_ = "";
+        }
+        else
+        {
+            void* address = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED)
+            {
+                data_ = static_cast<const char*>(address);
+                size_ = static_cast<size_t>(info.st_size);
+                mapped_ = true;
+            }
+        }
+    }
+
+    ::close(fd);
+#else
+    auto file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return;
+
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+
+    if (size == 0)
+    {
+        data_ = "";
+    }
+    else if (size > 0)
+    {
+        buffer_.resize(static_cast<size_t>(size));
+        if (std::fread(buffer_.data(), 1, buffer_.size(), file) == buffer_.size())
+        {
+            data_ = buffer_.data();
+            size_ = buffer_.size();
+        }
+    }
+
+    std::fclose(file);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#if !defined(_WIN32)
+    if (mapped_)
+        ::munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+} // namespace detail
+} // namespace sqrew
@@ -0,0 +1,50 @@
+#pragma once
+#ifndef SQREW_MAPPEDFILE_H
+#define SQREW_MAPPEDFILE_H
+
+#include "sqrew/Forward.h"
+
+#include <cstring>
+#include <vector>
+
+namespace sqrew {
+namespace detail {
+
+// Read-only view of a whole file. Uses mmap where available, so loading
+// costs page faults rather than a copy; elsewhere the file is read. An
+// empty file is valid, with a size of 0.
+class MappedFile final
+{
+public:
+    explicit MappedFile(const String& path);
+    ~MappedFile();
+
+    inline bool isValid() const { return data_ != nullptr; }
+    inline const char* data() const { return data_; }
+    inline size_t size() const { return size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    bool mapped_;
+    std::vector<char> buffer_;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
+// Moves 'data' past a UTF-8 byte order mark, the only one sqstd_loadfile
+// accepts besides UTF-16 ones.
+inline void skipByteOrderMark(const char*& data, size_t& size)
+{
+    if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+    {
+        data += 3;
+        size -= 3;
+    }
+}
+
+} // namespace detail
+} // namespace sqrew
+
+#endif // SQREW_MAPPEDFILE_H
@@ -0,0 +1,142 @@
+#include "sqrew/Marshal.h"
+
+#include <sstream>
+
+#include <sqstdblob.h>
+
+namespace sqrew {
+namespace detail {
+
+static const SQChar* getTypeName(SQObjectType type)
+{
+    switch (type)
+    {
+    case OT_NULL: return _SC("null");
+    case OT_INTEGER: return _SC("integer");
+    case OT_FLOAT: return _SC("float");
+    case OT_BOOL: return _SC("bool");
+    case OT_STRING: return _SC("string");
+    case OT_TABLE: return _SC("table");
+    case OT_ARRAY: return _SC("array");
+    case OT_USERDATA: return _SC("userdata");
+    case OT_CLOSURE: return _SC("function");
+    case OT_NATIVECLOSURE: return _SC("native function");
+    case OT_GENERATOR: return _SC("generator");
+    case OT_USERPOINTER: return _SC("userpointer");
+    case OT_THREAD: return _SC("thread");
+    case OT_CLASS: return _SC("class");
+    case OT_INSTANCE: return _SC("instance");
+    case OT_WEAKREF: return _SC("weakref");
+    case OT_TYPEDARRAY: return _SC("typedarray");
+    default: return _SC("unknown");
+    }
+}
+
+void throwArgumentError(HSQUIRRELVM v, Integer index, const char* expected)
+{
+    std::ostringstream oss;
+    oss << "parameter " << index - 1 << " has an invalid type '" << getTypeName(sq_gettype(v, index))
+        << "'; expected '" << expected << "'";
+    throw std::runtime_error(oss.str());
+}
+
+Integer toAbsoluteIndex(HSQUIRRELVM v, Integer index)
+{
+    return index < 0 ? sq_gettop(v) + index + 1 : index;
+}
+
+void* getInstancePointer(HSQUIRRELVM v, Integer index, size_t typeTag)
+{
+    SQUserPointer ptr = nullptr;
+    if (SQ_FAILED( sq_getinstanceup(v, index, &ptr, reinterpret_cast<SQUserPointer>(typeTag)) ))
+        return nullptr;
+
+    return ptr;
+}
+
+void pushInstancePointer(HSQUIRRELVM v, size_t typeTag, void* instance, SQRELEASEHOOK releaseHook)
+{
+    sq_pushregistrytable(v);
+    sq_pushstring(v, _SC("__sqrew_types"), -1);
+    sq_get(v, -2);
+    sq_pushuserpointer(v, reinterpret_cast<SQUserPointer>(typeTag));
+
+    if (SQ_FAILED( sq_get(v, -2) ))
+    {
+        sq_pop(v, 2);
+
+        if (releaseHook != nullptr)
+            releaseHook(instance, 0);
+
+        throw std::runtime_error("Class is not exposed in this context");
+    }
+
+    sq_createinstance(v, -1);
+    sq_setinstanceup(v, -1, instance);
+
+    if (releaseHook != nullptr)
+        sq_setreleasehook(v, -1, releaseHook);
+
+    sq_remove(v, -2);
+    sq_remove(v, -2);
+    sq_remove(v, -2);
+}
+
+Span<unsigned char> getBlob(HSQUIRRELVM v, Integer index, bool writable)
+{
+    SQUserPointer data = nullptr;
+    if (SQ_FAILED( sqstd_getblob(v, index, &data) ))
+        throwArgumentError(v, index, "blob");
+
+    if (writable && sqstd_isblobreadonly(v, index))
+        throwArgumentError(v, index, "writable blob");
+
+    return Span<unsigned char>(static_cast<unsigned char*>(data), static_cast<size_t>(sqstd_getblobsize(v, index)));
+}
+
+static void releaseBlobView(SQUserPointer /*data*/, SQInteger /*size*/, SQUserPointer userData)
+{
+    auto release = static_cast<std::function<void()>*>(userData);
+    (*release)();
+    delete release;
+}
+
+void pushBlobView(HSQUIRRELVM v, unsigned char* data, size_t size, bool readOnly, const std::function<void()>& release)
+{
+    // A view needs a buffer even when it is empty.
+    static unsigned char empty = 0;
+
+    auto hook = release ? new std::function<void()>(release) : nullptr;
+
+    if (SQ_FAILED( sqstd_createblobview(v, data != nullptr ? data : &empty, static_cast<SQInteger>(size),
+                                        readOnly ? SQTrue : SQFalse, hook ? releaseBlobView : nullptr, hook) ))
+    {
+        if (hook != nullptr)
+            releaseBlobView(data, 0, hook);
+
+        throw std::runtime_error("Can't create a blob; is the blob library registered?");
+    }
+}
+
+void* getTypedArray(HSQUIRRELVM v, Integer index, SQTypedArrayType type, size_t& size)
+{
+    SQUserPointer data = nullptr;
+    SQInteger length = 0;
+    SQTypedArrayType actual = type;
+
+    if (sq_gettype(v, index) != OT_TYPEDARRAY || SQ_FAILED( sq_gettypedarray(v, index, &data, &length, &actual) ) || actual != type)
+    {
+        switch (type)
+        {
+        case SQTA_INT32: throwArgumentError(v, index, "int32array");
+        case SQTA_FLOAT32: throwArgumentError(v, index, "float32array");
+        default: throwArgumentError(v, index, "float64array");
+        }
+    }
+
+    size = static_cast<size_t>(length);
+    return data;
+}
+
+} // namespace detail
+} // namespace sqrew
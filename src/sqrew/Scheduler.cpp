@@ -0,0 +1,276 @@
+#include "sqrew/Scheduler.h"
+
+#include "sqrew/ScriptThreadPool.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <squirrel.h>
+
+namespace sqrew {
+
+struct Scheduler::Impl
+{
+    // Finished threads go back here, so a spawn rarely creates a VM.
+    ScriptThreadPool threads;
+
+    struct Waiting
+    {
+        HSQOBJECT handle;
+        std::shared_ptr<detail::FutureState> future;
+        bool hasValue;
+    };
+
+    // Threads suspended on a future; only touched by the owning thread.
+    std::unordered_map<HSQUIRRELVM, Waiting> waiting;
+
+    // Threads whose futures completed, filled by any thread.
+    std::mutex mutex;
+    std::condition_variable completed;
+    std::vector<HSQUIRRELVM> ready;
+    std::vector<HSQUIRRELVM> resuming;
+
+    Stats stats;
+
+    Impl(const Context& context, size_t preparedThreads)
+        : threads(context, preparedThreads)
+    {}
+
+    // The scheduler and script thread running on this OS thread, so that
+    // a bound call can tell whether it may suspend.
+    static thread_local Scheduler* current;
+    static thread_local HSQUIRRELVM running;
+
+    class RunningScope final
+    {
+    public:
+        RunningScope(Scheduler* scheduler, HSQUIRRELVM thread)
+            : scheduler_(current)
+            , thread_(running)
+        {
+            current = scheduler;
+            running = thread;
+        }
+
+        ~RunningScope()
+        {
+            current = scheduler_;
+            running = thread_;
+        }
+
+    private:
+        Scheduler* scheduler_;
+        HSQUIRRELVM thread_;
+    };
+};
+
+thread_local Scheduler* Scheduler::Impl::current = nullptr;
+thread_local HSQUIRRELVM Scheduler::Impl::running = nullptr;
+
+Scheduler::Scheduler(const Context& context, size_t preparedThreads)
+    : context_(context)
+    , impl_(new Impl(context, preparedThreads))
+{}
+
+Scheduler::~Scheduler()
+{
+    AllocatorScope scope(context_);
+
+    for (auto& entry: impl_->waiting)
+    {
+        {
+            std::lock_guard<std::mutex> lock(entry.second.future->mutex_);
+            entry.second.future->scheduler_ = nullptr;
+        }
+
+        releaseThread(entry.second.handle);
+    }
+}
+
+HSQUIRRELVM Scheduler::createThread(HSQOBJECT& handle)
+{
+    ++impl_->stats.spawned;
+    return impl_->threads.acquire(handle);
+}
+
+void Scheduler::releaseThread(HSQOBJECT& handle)
+{
+    impl_->threads.release(handle);
+}
+
+bool Scheduler::start(HSQOBJECT handle, HSQUIRRELVM thread, Integer argumentCount)
+{
+    bool succeeded;
+    {
+        Impl::RunningScope running(this, thread);
+        succeeded = SQ_SUCCEEDED( sq_call(thread, argumentCount, SQFalse, SQTrue) );
+    }
+
+    return settle(handle, thread, succeeded);
+}
+
+bool Scheduler::resume(HSQOBJECT handle, HSQUIRRELVM thread, bool hasValue, bool throwError)
+{
+    bool succeeded;
+    {
+        Impl::RunningScope running(this, thread);
+        succeeded = SQ_SUCCEEDED( sq_wakeupvm(thread, hasValue, SQFalse, SQTrue, throwError) );
+    }
+
+    return settle(handle, thread, succeeded);
+}
+
+bool Scheduler::settle(HSQOBJECT handle, HSQUIRRELVM thread, bool succeeded)
+{
+    if (succeeded && sq_getvmstate(thread) == SQ_VMSTATE_SUSPENDED)
+    {
+        auto found = impl_->waiting.find(thread);
+        if (found != impl_->waiting.end())
+        {
+            found->second.handle = handle;
+            return true;
+        }
+
+        // Suspended by the script itself; nothing would ever resume it.
+        succeeded = false;
+    }
+
+    ++(succeeded ? impl_->stats.finished : impl_->stats.failed);
+    releaseThread(handle);
+    return succeeded;
+}
+
+void Scheduler::post(HSQUIRRELVM thread)
+{
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->ready.push_back(thread);
+    }
+
+    impl_->completed.notify_one();
+}
+
+size_t Scheduler::poll()
+{
+    AllocatorScope scope(context_);
+
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->resuming.swap(impl_->ready);
+    }
+
+    size_t resumed = 0;
+
+    for (auto thread: impl_->resuming)
+    {
+        auto found = impl_->waiting.find(thread);
+        if (found == impl_->waiting.end())
+            continue;
+
+        auto waiting = found->second;
+        bool failed;
+        {
+            auto& future = *waiting.future;
+            std::lock_guard<std::mutex> lock(future.mutex_);
+
+            // A late post from a suspension that didn't happen; the thread
+            // waits on another future now.
+            if (!future.done_)
+                continue;
+
+            future.scheduler_ = nullptr;
+            failed = future.failed_;
+
+            if (failed)
+            {
+                sq_pushstring(thread, future.error_.c_str(), static_cast<SQInteger>(future.error_.size()));
+                sq_throwobject(thread);
+            }
+            else if (waiting.hasValue)
+            {
+                future.pushValue(thread);
+            }
+        }
+
+        impl_->waiting.erase(found);
+        resume(waiting.handle, thread, !failed && waiting.hasValue, failed);
+        ++resumed;
+    }
+
+    impl_->resuming.clear();
+    return resumed;
+}
+
+size_t Scheduler::wait()
+{
+    {
+        std::unique_lock<std::mutex> lock(impl_->mutex);
+        impl_->completed.wait(lock, [this]() { return !impl_->ready.empty() || impl_->waiting.empty(); });
+    }
+
+    return poll();
+}
+
+void Scheduler::run()
+{
+    while (!impl_->waiting.empty())
+        wait();
+}
+
+size_t Scheduler::getWaitingCount() const
+{
+    return impl_->waiting.size();
+}
+
+Scheduler::Stats Scheduler::getStats() const
+{
+    return impl_->stats;
+}
+
+namespace detail {
+
+Integer awaitFuture(HSQUIRRELVM v, const std::shared_ptr<FutureState>& state, bool hasValue)
+{
+    std::unique_lock<std::mutex> lock(state->mutex_);
+
+    if (!state->done_)
+    {
+        auto scheduler = Scheduler::Impl::current;
+
+        if (scheduler == nullptr || Scheduler::Impl::running != v)
+        {
+            state->ready_.wait(lock, [&state]() { return state->done_; });
+        }
+        else
+        {
+            state->scheduler_ = scheduler;
+            state->thread_ = v;
+            lock.unlock();
+
+            const auto result = sq_suspendvm(v);
+            if (result == SQ_ERROR)
+            {
+                lock.lock();
+                state->scheduler_ = nullptr;
+                return result;
+            }
+
+            Scheduler::Impl::Waiting waiting = { HSQOBJECT(), state, hasValue };
+            scheduler->impl_->waiting.emplace(v, waiting);
+            ++scheduler->impl_->stats.suspensions;
+            return result;
+        }
+    }
+
+    if (state->failed_)
+        return sq_throwerror(v, state->error_.c_str());
+
+    state->pushValue(v);
+    return hasValue ? 1 : 0;
+}
+
+} // namespace detail
+
+} // namespace sqrew
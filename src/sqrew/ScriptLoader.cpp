@@ -0,0 +1,127 @@
+#include "sqrew/ScriptLoader.h"
+
+#include "MappedFile.h"
+
+#include <sstream>
+
+#include <squirrel.h>
+
+namespace sqrew {
+
+namespace {
+
+// The last compile error on this thread. Workers compile one file at a
+// time, so it's always the error of the current file.
+thread_local String compileError;
+
+void recordCompileError(HSQUIRRELVM /*vm*/, const SQChar* error, const SQChar* source, SQInteger line, SQInteger column)
+{
+    std::ostringstream oss;
+    oss << source << ":" << line << ":" << column << ": " << error;
+    compileError = oss.str();
+}
+
+SQInteger writeBytes(SQUserPointer up, SQUserPointer data, SQInteger size)
+{
+    auto bytes = static_cast<std::vector<char>*>(up);
+    auto chars = static_cast<const char*>(data);
+    bytes->insert(bytes->end(), chars, chars + size);
+    return size;
+}
+
+} // namespace
+
+ScriptLoader::ScriptLoader(size_t threadCount, OptimizationLevel level)
+    : pool_(threadCount, [level](Context& context)
+        {
+            sq_setcompilererrorhandler(context.getHandle(), recordCompileError);
+            context.setOptimizationLevel(level);
+        })
+{
+}
+
+ScriptLoader::~ScriptLoader()
+{
+}
+
+size_t ScriptLoader::getThreadCount() const
+{
+    return pool_.getWorkerCount();
+}
+
+std::vector<ScriptLoader::Result> ScriptLoader::compile(const std::vector<String>& paths)
+{
+    std::vector<Result> results(paths.size());
+
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        Result& result = results[i];
+        result.path = paths[i];
+
+        pool_.submit([&result](Context& context)
+        {
+            detail::MappedFile file(result.path);
+            if (!file.isValid())
+            {
+                result.error = "cannot open " + result.path;
+                return;
+            }
+
+            const char* data = file.data();
+            size_t size = file.size();
+            detail::skipByteOrderMark(data, size);
+
+            StackLock lock(context);
+            auto v = context.getHandle();
+
+            compileError.clear();
+            if (SQ_FAILED( sq_compilebuffer(v, data, static_cast<SQInteger>(size), result.path.c_str(), SQTrue) ))
+            {
+                result.error = compileError;
+                return;
+            }
+
+            auto program = std::make_shared<Program>();
+            program->source_ = result.path;
+
+            if (SQ_FAILED( sq_writeclosure(v, writeBytes, &program->bytes_) ))
+            {
+                result.error = "cannot serialize " + result.path;
+                return;
+            }
+
+            result.program = std::move(program);
+        });
+    }
+
+    pool_.wait();
+    return results;
+}
+
+bool ScriptLoader::execute(const Context& context, const std::vector<Result>& results) const
+{
+    StackLock lock(context);
+    auto v = context.getHandle();
+
+    for (const auto& result: results)
+    {
+        if (!result.program || !result.program->load(context))
+            return false;
+
+        sq_pushroottable(v);
+        const bool succeeded = SQ_SUCCEEDED( sq_call(v, 1, SQFalse, SQTrue) );
+        sq_pop(v, 1);
+
+        if (!succeeded)
+            return false;
+    }
+
+    return true;
+}
+
+bool ScriptLoader::load(const Context& context, const std::vector<String>& paths)
+{
+    return execute(context, compile(paths));
+}
+
+} // namespace sqrew
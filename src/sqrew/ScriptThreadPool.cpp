@@ -0,0 +1,93 @@
+#include "sqrew/ScriptThreadPool.h"
+
+#include "sqrew/Context.h"
+
+namespace sqrew {
+
+ScriptThreadPool::ScriptThreadPool(const Context& context, size_t prepared, Integer stackSize, size_t capacity)
+    : context_(context)
+    , stackSize_(stackSize)
+    , capacity_(capacity)
+{
+    AllocatorScope scope(context_);
+
+    idle_.reserve(prepared);
+    for (size_t i = 0; i < prepared; ++i)
+        idle_.push_back(create());
+}
+
+ScriptThreadPool::~ScriptThreadPool()
+{
+    AllocatorScope scope(context_);
+
+    for (auto& handle: idle_)
+        sq_release(context_.getHandle(), &handle);
+}
+
+HSQOBJECT ScriptThreadPool::create()
+{
+    auto v = context_.getHandle();
+
+    auto thread = sq_newthread(v, stackSize_);
+    sq_setforeignptr(thread, sq_getforeignptr(v));
+
+    HSQOBJECT handle;
+    sq_getstackobj(v, -1, &handle);
+    sq_addref(v, &handle);
+    sq_pop(v, 1);
+
+    ++stats_.created;
+    return handle;
+}
+
+HSQUIRRELVM ScriptThreadPool::acquire(HSQOBJECT& handle)
+{
+    if (idle_.empty())
+    {
+        AllocatorScope scope(context_);
+        handle = create();
+    }
+    else
+    {
+        handle = idle_.back();
+        idle_.pop_back();
+        ++stats_.reused;
+    }
+
+    return handle._unVal.pThread;
+}
+
+void ScriptThreadPool::release(HSQOBJECT& handle)
+{
+    AllocatorScope scope(context_);
+
+    auto thread = handle._unVal.pThread;
+
+    if (sq_getvmstate(thread) != SQ_VMSTATE_IDLE || idle_.size() >= capacity_)
+    {
+        if (sq_getvmstate(thread) != SQ_VMSTATE_IDLE)
+            ++stats_.discarded;
+
+        sq_release(context_.getHandle(), &handle);
+    }
+    else
+    {
+        sq_settop(thread, 0);
+        sq_reseterror(thread);
+        idle_.push_back(handle);
+    }
+
+    sq_resetobject(&handle);
+}
+
+size_t ScriptThreadPool::getIdleCount() const
+{
+    return idle_.size();
+}
+
+ScriptThreadPool::Stats ScriptThreadPool::getStats() const
+{
+    return stats_;
+}
+
+} // namespace sqrew
@@ -145,6 +145,16 @@ Table Table::getRoot(const Context& context, TableDomain domain)
     return std::move(table);
 }
 
+Table Table::fromTop(const Context& context, bool valid)
+{
+    Table table(context);
+
+    if (valid)
+        table.impl_->setFromTop();
+
+    return std::move(table);
+}
+
 bool Table::isValid() const
 {
     return impl_->isValid();
@@ -178,6 +188,29 @@ bool Table::contains(const String& name) const
     return SQ_SUCCEEDED( sq_get(v, -2) );
 }
 
+detail::FunctionImpl Table::findFunction(const String& name) const
+{
+    if (!isValid())
+        return detail::FunctionImpl();
+
+    StackLock lock(impl_->context);
+
+    auto v = impl_->context.getHandle();
+
+    sq_pushobject(v, impl_->object);
+    sq_pushstring(v, name.c_str(), name.length());
+    if (SQ_FAILED( sq_get(v, -2) ))
+        return detail::FunctionImpl();
+
+    HSQOBJECT closure;
+    sq_getstackobj(v, -1, &closure);
+
+    if (!sq_isclosure(closure) && !sq_isnativeclosure(closure))
+        return detail::FunctionImpl();
+
+    return detail::FunctionImpl(impl_->context, closure, impl_->object);
+}
+
 Table::Table(const Context& context)
     : impl_(new Impl(context))
 {}
@@ -0,0 +1,129 @@
+#pragma once
+#ifndef SQREW_TASKQUEUE_H
+#define SQREW_TASKQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace sqrew {
+namespace detail {
+
+// Bounded multi-producer, multi-consumer queue (D. Vyukov's array queue).
+// Every cell carries a sequence number telling whether it is free for the
+// producer of a given position or holds the value for its consumer, so
+// producers and consumers only contend on their own position counter and
+// never take a lock.
+template<class T>
+class TaskQueue final
+{
+public:
+    // The capacity is rounded up to a power of two.
+    explicit TaskQueue(size_t capacity)
+        : mask_(roundUp(capacity) - 1)
+        , cells_(new Cell[mask_ + 1])
+        , enqueuePos_(0)
+        , dequeuePos_(0)
+    {
+        for (size_t i = 0; i <= mask_; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    inline size_t capacity() const { return mask_ + 1; }
+
+    // Fails when the queue is full; 'value' is left untouched then.
+    bool tryPush(T& value)
+    {
+        Cell* cell;
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &cells_[pos & mask_];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+            if (difference == 0)
+            {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value)
+    {
+        Cell* cell;
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell = &cells_[pos & mask_];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+
+            if (difference == 0)
+            {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(cell->value);
+        cell->value = T();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Producers and consumers each hammer their own counter; keep the two
+    // on separate cache lines.
+    static const size_t cacheLine = 64;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t roundUp(size_t capacity)
+    {
+        size_t result = 2;
+        while (result < capacity)
+            result <<= 1;
+        return result;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    std::atomic<size_t> enqueuePos_;
+    char padding_[cacheLine];
+    std::atomic<size_t> dequeuePos_;
+
+    TaskQueue(const TaskQueue&) = delete;
+    TaskQueue& operator=(const TaskQueue&) = delete;
+};
+
+} // namespace detail
+} // namespace sqrew
+
+#endif // SQREW_TASKQUEUE_H
@@ -1,12 +1,37 @@
+#include <sqrew/BytecodeCache.h>
 #include <sqrew/Context.h>
+#include <sqrew/ContextPool.h>
+#include <sqrew/Scheduler.h>
+#include <sqrew/ScriptLoader.h>
+#include <sqrew/ScriptThreadPool.h>
 #include <sqrew/Interface.h>
 #include <sqrew/Class.h>
 #include <sqrew/Table.h>
 
 #include <sqrew/Instance.h>
 
+#include <sqstdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <array>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
 
 class TestInterface: public sqrew::Interface
 {
@@ -16,6 +41,136 @@ class TestInterface: public sqrew::Interface
     }
 };
 
+// Counts messages; the context's error handler reports through print.
+class MessageCounter: public sqrew::Interface
+{
+public:
+    explicit MessageCounter(int& count) : count_(count) {}
+
+    void print(const sqrew::String& /*message*/) override
+    {
+        ++count_;
+    }
+
+    void printError(const sqrew::String& /*message*/) override
+    {
+        ++count_;
+    }
+
+private:
+    int& count_;
+};
+
+// A fresh directory under the system temp path, removed with its files.
+class TemporaryDirectory
+{
+public:
+    TemporaryDirectory()
+    {
+#if !defined(_WIN32)
+        char path[] = "/tmp/sqrew_XXXXXX";
+        if (::mkdtemp(path) != nullptr)
+            path_ = path;
+#else
+        char base[MAX_PATH], path[MAX_PATH];
+        if (::GetTempPathA(MAX_PATH, base) != 0 && ::GetTempFileNameA(base, "sqr", 0, path) != 0
+            && ::DeleteFileA(path) && ::CreateDirectoryA(path, nullptr))
+            path_ = path;
+#endif
+    }
+
+    ~TemporaryDirectory()
+    {
+        if (path_.empty())
+            return;
+
+        for (const auto& file: list())
+            std::remove(file.c_str());
+#if !defined(_WIN32)
+        ::rmdir(path_.c_str());
+#else
+        ::RemoveDirectoryA(path_.c_str());
+#endif
+    }
+
+    const std::string& getPath() const { return path_; }
+
+    std::vector<std::string> list() const
+    {
+        std::vector<std::string> files;
+#if !defined(_WIN32)
+        if (auto dir = ::opendir(path_.c_str()))
+        {
+            while (auto entry = ::readdir(dir))
+            {
+                const std::string name = entry->d_name;
+                if (name != "." && name != "..")
+                    files.push_back(path_ + "/" + name);
+            }
+            ::closedir(dir);
+        }
+#else
+        WIN32_FIND_DATAA data;
+        auto find = ::FindFirstFileA((path_ + "\\*").c_str(), &data);
+        if (find != INVALID_HANDLE_VALUE)
+        {
+            do
+            {
+                const std::string name = data.cFileName;
+                if (name != "." && name != "..")
+                    files.push_back(path_ + "/" + name);
+            } while (::FindNextFileA(find, &data));
+            ::FindClose(find);
+        }
+#endif
+        return files;
+    }
+
+private:
+    std::string path_;
+
+    TemporaryDirectory(const TemporaryDirectory&) = delete;
+    TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+};
+
+enum class Mode { Off = 0, On = 1 };
+
+class Samples
+{
+public:
+    float mean(sqrew::Span<const float> values) const
+    {
+        float sum = 0;
+        for (auto value: values)
+            sum += value;
+        return values.empty() ? 0 : sum / values.size();
+    }
+
+    void scale(sqrew::Span<double> values, double factor) const
+    {
+        for (auto& value: values)
+            value *= factor;
+    }
+};
+
+class Packets
+{
+public:
+    int checksum(sqrew::Span<const unsigned char> bytes) const
+    {
+        int sum = 0;
+        for (auto byte: bytes)
+            sum += byte;
+        return sum;
+    }
+
+    void invert(sqrew::Span<unsigned char> bytes) const
+    {
+        for (auto& byte: bytes)
+            byte = static_cast<unsigned char>(~byte);
+    }
+};
+
 class ExposeTest
 {
 public:
@@ -25,6 +180,30 @@ public:
 
     void someMethod(std::string) {}
 
+    size_t length(const char* text) const { return std::string(text).size(); }
+    std::string concat(const std::string& a, sqrew::StringView b) const { return a + b.str(); }
+    bool negate(bool value) const { return !value; }
+    Mode toggle(Mode mode) const { return mode == Mode::On ? Mode::Off : Mode::On; }
+
+    int sum(const std::vector<int>& values) const
+    {
+        int result = 0;
+        for (auto value: values)
+            result += value;
+        return result;
+    }
+
+    std::map<std::string, int> count(const std::vector<std::string>& words) const
+    {
+        std::map<std::string, int> result;
+        for (const auto& word: words)
+            ++result[word];
+        return result;
+    }
+
+    int getOtherF(const ExposeTest& other) const { return other.f; }
+    ExposeTest* self() { return this; }
+
     static std::shared_ptr<ExposeTest> create()
     {
         return std::make_shared<ExposeTest>();
@@ -60,6 +239,25 @@ void extendTest(ExposeTest* expose, float xx)
     std::cout << "hello from extension method. you passed " << xx << ". and f value is " << expose->f << std::endl;
 }
 
+// Stands in for a slow service: requests stay pending until the test
+// answers them. Negative keys are answered right away, as from a cache.
+class FakeBackend
+{
+public:
+    std::vector<std::pair<int, sqrew::Promise<int>>> pending;
+
+    sqrew::Future<int> fetch(int key)
+    {
+        sqrew::Promise<int> promise;
+        if (key < 0)
+            promise.resolve(-key);
+        else
+            pending.emplace_back(key, promise);
+
+        return promise.getFuture();
+    }
+};
+
 template<class ClassT>
 struct MyDefaultAllocator
 {
@@ -88,6 +286,26 @@ struct SharedCreationAllocator
     inline static ClassT* castInstance(Pointer ptr) { return ptr->get(); }
 };
 
+static SQInteger appendBytes(SQUserPointer up, SQUserPointer data, SQInteger size)
+{
+    auto bytes = static_cast<std::vector<char>*>(up);
+    bytes->insert(bytes->end(), static_cast<char*>(data), static_cast<char*>(data) + size);
+    return size;
+}
+
+struct SourceReader
+{
+    const char* data;
+    size_t size;
+    size_t position;
+};
+
+static SQInteger readSourceChar(SQUserPointer up)
+{
+    auto reader = static_cast<SourceReader*>(up);
+    return reader->position < reader->size ? reader->data[reader->position++] : 0;
+}
+
 int main(int /*argc*/, char * /*argv*/[])
 {
     sqrew::Context context;
@@ -100,23 +318,888 @@ int main(int /*argc*/, char * /*argv*/[])
 
     sqrew::Class<ExposeTest>::expose(context, "ExposeTest")
         .setConstructor<int>()
-        .setMethod("getF", &ExposeTest::getF)
+        .setMethod<decltype(&ExposeTest::getF), &ExposeTest::getF>("getF")
         .setMethod("setF", &ExposeTest::setF)
         .setMethod("extendTest", extendTest)
+        .setMethod("someMethod", &ExposeTest::someMethod)
+        .setMethod("length", &ExposeTest::length)
+        .setMethod("concat", &ExposeTest::concat)
+        .setMethod("negate", &ExposeTest::negate)
+        .setMethod("toggle", &ExposeTest::toggle)
+        .setMethod("sum", &ExposeTest::sum)
+        .setMethod("count", &ExposeTest::count)
+        .setMethod("getOtherF", &ExposeTest::getOtherF)
+        .setMethod("self", &ExposeTest::self)
         .setField("f", &ExposeTest::setF, &ExposeTest::getF);
 
     auto table = sqrew::Table::create(context, "com.package.name");
     auto table1 = sqrew::Table::create(context, "com.package.name");
 
-    sqrew::Instance instance(context, "ExposeTest");
+    sqrew::Instance instance(context, "ExposeTest", 5);
 
     auto call = instance.getMethod("setF");
     if (call.isValid())
         call(12);
 
+    bool instanceResult = instance.isValid() && instance.getMethod<int>("getF")() == 12;
+
     //auto callResult = instance.call<int>("getF");
 
     bool result = context.executeBuffer("local foo = ExposeTest(6464); \n ::print(foo.f); \n foo.f = 32; \n foo.extendTest(27.4); \n foo.setF(17); \n local f = foo.getF(); \n ::print(f);");
+
+    bool marshalResult = context.executeBuffer(
+        "local foo = ExposeTest(3); \n"
+        "foo.someMethod(\"text\"); \n"
+        "if (foo.length(\"hello\") != 5) throw \"length\"; \n"
+        "if (foo.concat(\"ab\", \"cd\") != \"abcd\") throw \"concat\"; \n"
+        "if (foo.negate(false) != true) throw \"negate\"; \n"
+        "if (foo.toggle(0) != 1) throw \"toggle\"; \n"
+        "if (foo.sum([1, 2, 3]) != 6) throw \"sum\"; \n"
+        "if (foo.count([\"a\", \"b\", \"a\"]).a != 2) throw \"count\"; \n"
+        "if (foo.getOtherF(ExposeTest(42)) != 42) throw \"getOtherF\"; \n"
+        "if (foo.self().getF() != 3) throw \"self\"; \n"
+        "foo.f += 4; if (foo.f != 7 || foo.getF() != 7) throw \"property\"; foo.f = 3; \n"
+        "try { foo.sum(12); throw \"no error\"; } catch (e) { if (e == \"no error\") throw e; } \n"
+        "foreach (value in [1, \"true\", null, {}]) \n"
+        "    try { foo.negate(value); throw \"no error\"; } catch (e) { if (e == \"no error\") throw \"negate\"; }");
+
+    context.executeBuffer("function add(a, b) { return a + b; } \n function greet(name) { return \"hello \" + name; }");
+
+    auto root = sqrew::Table::getRoot(context);
+    auto add = root.getFunction<int>("add");
+    auto greet = root.getFunction<std::string>("greet");
+
+    bool functionResult = add.isValid() && add(2, 3) == 5 && greet("you") == "hello you"
+        && !root.getFunction("missing").isValid();
+
+    std::vector<std::tuple<int, int>> pairs = { std::make_tuple(1, 2), std::make_tuple(3, 4) };
+    std::vector<int> sums;
+    add.reserveStack(16);
+    add.callBatch(sqrew::makeSpan(pairs), std::back_inserter(sums));
+    functionResult = functionResult && sums == std::vector<int>({ 3, 7 });
+
+    context.executeBuffer("class Accumulator { total = 0; constructor(start) { total = start; } function add(x) { total += x; return total; } }");
+
+    sqrew::Instance accumulator(context, "Accumulator", 10);
+    auto accumulate = accumulator.getMethod<int>("add");
+    accumulate(5);
+    instanceResult = instanceResult && accumulate(5) == 20 && !accumulator.getMethod("missing").isValid();
+
+    // A missing class or a failing constructor is reported to the caller.
+    auto constructionError = [&](const char* className) -> std::string
+    {
+        try
+        {
+            sqrew::Instance failed(context, className, 1);
+        }
+        catch (const std::runtime_error& error)
+        {
+            return error.what();
+        }
+        return std::string();
+    };
+
+    context.executeBuffer("class Refusing { constructor(x) { throw \"refused \" + x; } }");
+    instanceResult = instanceResult && constructionError("MissingClass").find("MissingClass") != std::string::npos
+        && constructionError("Refusing") == "refused 1";
+
+    bool cacheResult = true;
+    {
+        const char* script = "cachedValue <- 40 + 2;";
+
+        auto cache = std::make_shared<sqrew::BytecodeCache>();
+        context.setBytecodeCache(cache);
+        cacheResult = context.executeBuffer(script, "cached.nut") && context.executeBuffer(script, "cached.nut");
+        cacheResult = cacheResult && cache->getStats().misses == 1 && cache->getStats().memoryHits == 1;
+
+        TemporaryDirectory directory;
+        cacheResult = cacheResult && !directory.getPath().empty();
+
+        context.setBytecodeCache(std::make_shared<sqrew::BytecodeCache>(directory.getPath()));
+        cacheResult = cacheResult && context.executeBuffer(script, "cached.nut");
+
+        auto diskCache = std::make_shared<sqrew::BytecodeCache>(directory.getPath());
+        context.setBytecodeCache(diskCache);
+        cacheResult = cacheResult && context.executeBuffer(script, "cached.nut") && diskCache->getStats().diskHits == 1;
+        cacheResult = cacheResult && sqrew::Table::getRoot(context).contains("cachedValue");
+
+        // A truncated entry is rejected, recompiled and written out again.
+        const auto files = directory.list();
+        cacheResult = cacheResult && files.size() == 1;
+        if (cacheResult)
+        {
+            std::string bytes;
+            {
+                std::ifstream in(files.front(), std::ios::binary);
+                bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            }
+            std::ofstream(files.front(), std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size() / 2);
+        }
+
+        context.setBytecodeCache(nullptr);
+        cacheResult = cacheResult && context.executeBuffer("delete cachedValue;", "uncache.nut")
+            && !sqrew::Table::getRoot(context).contains("cachedValue");
+
+        auto truncatedCache = std::make_shared<sqrew::BytecodeCache>(directory.getPath());
+        context.setBytecodeCache(truncatedCache);
+        cacheResult = cacheResult && context.executeBuffer(script, "cached.nut");
+        cacheResult = cacheResult && truncatedCache->getStats().rejected == 1 && truncatedCache->getStats().misses == 1
+            && truncatedCache->getStats().diskHits == 0 && sqrew::Table::getRoot(context).contains("cachedValue");
+
+        auto rewrittenCache = std::make_shared<sqrew::BytecodeCache>(directory.getPath());
+        context.setBytecodeCache(rewrittenCache);
+        cacheResult = cacheResult && context.executeBuffer(script, "cached.nut") && rewrittenCache->getStats().diskHits == 1;
+
+        context.setBytecodeCache(nullptr);
+    }
+
+    bool bytecodeResult = true;
+    {
+        const char* script =
+            "local scale = 2.5;\n"
+            "function label(n) { return \"item\" + n; }\n"
+            "loadedBytecode <- label(4) + \":\" + (scale * 4);";
+
+        auto v = context.getHandle();
+        std::vector<char> bytes;
+        if (SQ_SUCCEEDED( sq_compilebuffer(v, script, std::strlen(script), "bytecode.nut", SQTrue) ))
+        {
+            sq_writeclosure(v, appendBytes, &bytes);
+            sq_pop(v, 1);
+        }
+        bytecodeResult = !bytes.empty();
+
+        {
+            std::ofstream file("bytecode.cnut", std::ios::binary);
+            file.write(bytes.data(), bytes.size());
+        }
+        {
+            std::ofstream file("bytecode_empty.cnut", std::ios::binary);
+        }
+
+        bytecodeResult = bytecodeResult && context.executeBytecodeFile("bytecode.cnut")
+            && context.executeBuffer("if (loadedBytecode != \"item4:10\") throw \"bytecode\";")
+            && !context.executeBytecodeFile("bytecode_empty.cnut")
+            && !context.executeBytecodeFile("bytecode_missing.cnut");
+
+        std::remove("bytecode.cnut");
+        std::remove("bytecode_empty.cnut");
+
+        // The closure is read in place; every truncation of it has to fail
+        // without reading past the end or leaving anything on the stack.
+        const auto top = sq_gettop(v);
+        if (SQ_SUCCEEDED( sq_readclosurebuffer(v, bytes.data(), static_cast<SQInteger>(bytes.size())) ))
+            sq_pop(v, 1);
+        else
+            bytecodeResult = false;
+
+        for (size_t size = 0; size < bytes.size() && bytecodeResult; ++size)
+        {
+            std::vector<char> truncated(bytes.begin(), bytes.begin() + size);
+            bytecodeResult = SQ_FAILED( sq_readclosurebuffer(v, truncated.data(), static_cast<SQInteger>(size)) )
+                && sq_gettop(v) == top;
+        }
+    }
+
+    SQUnsignedInteger hits, misses;
+    sq_getinlinecachestats(context.getHandle(), &hits, &misses);
+
+    bool inlineCacheResult = context.executeBuffer(
+        "class Point { x = 1; y = 2; function sum() { return x + y; } } \n"
+        "local p = Point(), total = 0; \n"
+        "for (local i = 0; i < 10; ++i) total += p.x + p[\"y\"]; \n"
+        "Point.scaled <- function(k) { return sum() * k; }; \n"
+        "if (total != 30 || p.scaled(2) != 6 || p.sum() != 3) throw \"inline cache\";");
+
+    SQUnsignedInteger newHits, newMisses;
+    sq_getinlinecachestats(context.getHandle(), &newHits, &newMisses);
+    inlineCacheResult = inlineCacheResult && newHits > hits && newMisses > misses;
+
+    bool poolResult = true;
+    {
+        sqrew::Context pooled(1024, sqrew::Allocation::Pool);
+        pooled.initialize();
+
+        poolResult = pooled.executeBuffer("local items = []; for (local i = 0; i < 100; ++i) items.append({ name = \"item\" + i, value = i });");
+
+        const auto stats = pooled.getAllocationStats();
+        poolResult = poolResult && stats.bytesLive > 0 && stats.bytesPeak >= stats.bytesLive && !stats.sizeClasses.empty()
+            && context.getAllocationStats().bytesLive == 0;
+
+        // Blocks carry no header: pool blocks are found through their slab,
+        // whichever pool (or none) is current when they are freed.
+        auto heapBlock = static_cast<char*>(sq_malloc(24));
+        auto pool = sq_newallocator();
+        auto other = sq_newallocator();
+
+        sq_setallocator(pool);
+        auto small = static_cast<char*>(sq_malloc(40));
+        auto large = static_cast<char*>(sq_malloc(4096));
+        auto grown = static_cast<char*>(sq_malloc(16));
+        std::memset(grown, 7, 16);
+        sq_free(heapBlock, 24);
+
+        sq_setallocator(other);
+        grown = static_cast<char*>(sq_realloc(grown, 16, 300));
+        sq_free(small, 40);
+
+        SQAllocatorStats poolStats, otherStats;
+        sq_getallocatorstats(pool, &poolStats);
+        sq_getallocatorstats(other, &otherStats);
+        poolResult = poolResult && grown[15] == 7 && poolStats.bytes_live == 4096 + 300 && poolStats.large_bytes_live == 4096
+            && otherStats.bytes_live == 0 && poolStats.class_live[300 / SQ_ALLOCATOR_GRANULARITY] == 1;
+
+        sq_setallocator(pool);
+        sq_free(large, 4096);
+        sq_setallocator(nullptr);
+        sq_releaseallocator(pool);
+        sq_releaseallocator(other);
+        sq_free(grown, 300);
+    }
+
+    bool sortResult = context.executeBuffer(
+        "local a = [5, 3, 9, 1, 3]; a.sort(); if (a[0] != 1 || a[4] != 9) throw \"sort ints\"; \n"
+        "local s = [\"b\", \"c\", \"a\"]; s.sort(); if (s[0] != \"a\" || s[2] != \"c\") throw \"sort strings\"; \n"
+        "local p = [[1, 0], [0, 1], [1, 2], [0, 3]]; p.sort(@(x, y) x[0] <=> y[0]); \n"
+        "if (p[0][1] != 1 || p[1][1] != 3 || p[2][1] != 0 || p[3][1] != 2) throw \"sort stability\"; \n"
+        "try { a.sort(@(x, y) null); throw \"no error\"; } catch (e) { if (e == \"no error\") throw e; } \n"
+        "if (a[0] != 1 || a[4] != 9) throw \"sort error\";");
+
+    // Runs against both table engines; see the test_other_engine target.
+    bool tableResult = context.executeBuffer(
+        "local t = {}; \n"
+        "for (local i = 0; i < 5000; ++i) t[i] <- i * 2; \n"
+        "for (local i = 0; i < 5000; i += 2) delete t[i]; \n"
+        "if (t.len() != 2500 || 0 in t || !(1 in t) || t[4999] != 9998) throw \"table delete\"; \n"
+        "local count = 0, sum = 0; \n"
+        "foreach (k, v in t) { ++count; sum += v; if (v != k * 2) throw \"table iteration value\"; } \n"
+        "if (count != 2500 || sum != 12500000) throw \"table iteration\"; \n"
+        "for (local i = 1; i < 4999; i += 2) delete t[i]; \n"
+        "if (t.len() != 1 || t[4999] != 9998) throw \"table shrink\"; \n"
+        "try { delete t[0]; throw \"no error\"; } catch (e) { if (e == \"no error\") throw e; } \n"
+        "t.clear(); t.x <- 1; \n"
+        "if (t.len() != 1 || t.x != 1) throw \"table clear\"; \n"
+        "local churn = {}; \n"
+        "for (local i = 0; i < 20000; ++i) { churn[\"k\" + i] <- i; if (i >= 8) delete churn[\"k\" + (i - 8)]; } \n"
+        "if (churn.len() != 8 || churn.k19999 != 19999 || \"k19991\" in churn) throw \"table churn\"; \n"
+        "local copy = clone churn; delete copy.k19999; copy.extra <- 0; \n"
+        "if (churn.len() != 8 || copy.len() != 8 || \"extra\" in churn || !(\"k19999\" in churn)) throw \"table clone\"; \n"
+        "local small = {}; \n"
+        "for (local r = 0; r < 3; ++r) { for (local i = 0; i < 12; ++i) small[i] <- r; for (local i = 0; i < 12; ++i) delete small[i]; } \n"
+        "foreach (k, v in small) throw \"table empty iteration\"; \n"
+        "local key = {}, mixed = { name = \"string\" }; \n"
+        "mixed[7] <- \"int\"; mixed[1.5] <- \"float\"; mixed[true] <- \"bool\"; mixed[key] <- \"table\"; \n"
+        "if (mixed.len() != 5 || mixed.name != \"string\" || mixed[7] != \"int\" || mixed[1.5] != \"float\" \n"
+        "    || mixed[true] != \"bool\" || mixed[key] != \"table\" || {}.rawin(key)) throw \"table keys\";");
+
+    bool collectorResult = true;
+    {
+        sqrew::Context collected;
+        collected.initialize();
+
+        collectorResult = collected.executeBuffer(
+            "kept <- []; \n"
+            "local cycle = {}; cycle.self <- cycle; \n"
+            "probe <- cycle.weakref(); \n"
+            "for (local i = 0; i < 200; ++i) { local a = [], b = { a = a }; a.append(b); kept.append({ value = i }); }");
+
+        // The script keeps moving objects around while the cycle runs; the
+        // write barrier has to keep every one of them alive.
+        bool finished = false;
+        for (int i = 0; i < 10000 && !finished; ++i)
+        {
+            finished = collected.collectStep(1);
+            collectorResult = collectorResult && collected.executeBuffer(
+                "local last = kept.pop(); kept.insert(0, { value = last.value, tail = [last] }); last.tail <- null;");
+        }
+
+        collectorResult = collectorResult && finished && collected.executeBuffer(
+            "local sum = 0; foreach (item in kept) sum += item.value; \n"
+            "if (sum != 199 * 100 || probe != null) throw \"collector\";");
+
+        const auto stats = collected.getCollectorStats();
+        collectorResult = collectorResult && stats.cycles == 1 && stats.objectsFreed >= 401 && !stats.collecting && stats.steps > 0;
+    }
+
+    bool contextPoolResult = true;
+    {
+        sqrew::ContextPool pool(4, [](sqrew::Context& worker)
+        {
+            worker.executeBuffer("factor <- 10; function scaled(x) { return x * factor; }");
+        });
+
+        auto program = pool.compile("if (scaled(2) != 20) throw \"scaled\";", "pooled.nut");
+        auto failing = pool.compile("throw \"failing\";", "failing.nut");
+        contextPoolResult = program && failing && !pool.compile("if (", "broken.nut") && pool.getWorkerCount() == 4;
+
+        std::atomic<int> total(0);
+        for (int i = 0; i < 100 && contextPoolResult; ++i)
+        {
+            pool.submit(program);
+            pool.submit([&total](sqrew::Context& worker) { total += sqrew::Table::getRoot(worker).getFunction<int>("scaled")(1); });
+        }
+        pool.submit(failing);
+        pool.wait();
+
+        const auto stats = pool.getStats();
+        contextPoolResult = contextPoolResult && total == 1000 && stats.completed == 200 && stats.failed == 1;
+    }
+
+    bool schedulerResult = true;
+    {
+        FakeBackend backend;
+        sqrew::Class<FakeBackend>::expose(context, "FakeBackend")
+            .setMethod("fetch", &FakeBackend::fetch);
+
+        context.executeBuffer(
+            "asyncTotal <- 0; \n"
+            "function handleRequest(backend, key) { \n"
+            "    local value = backend.fetch(key); \n"
+            "    try { value += backend.fetch(key + 1000); } catch (e) { value += 1; } \n"
+            "    asyncTotal += value; \n"
+            "} \n"
+            "function cachedFetch(backend) { return backend.fetch(-7); }");
+
+        auto root = sqrew::Table::getRoot(context);
+        auto handleRequest = root.getFunction("handleRequest");
+
+        sqrew::Scheduler scheduler(context);
+        for (int key = 0; key < 50; ++key)
+            schedulerResult = schedulerResult && scheduler.spawn(handleRequest, &backend, key);
+
+        schedulerResult = schedulerResult && scheduler.getWaitingCount() == 50;
+
+        // Answers arrive on another thread while the scheduler sleeps.
+        while (schedulerResult && scheduler.getWaitingCount() > 0)
+        {
+            auto batch = std::move(backend.pending);
+            backend.pending.clear();
+
+            std::thread completer([&batch]()
+            {
+                for (auto& request: batch)
+                {
+                    if (request.first < 1000)
+                        request.second.resolve(request.first * 2);
+                    else
+                        request.second.reject("unavailable");
+                }
+            });
+
+            for (size_t resumed = 0; resumed < batch.size(); )
+                resumed += scheduler.wait();
+
+            completer.join();
+        }
+
+        const auto stats = scheduler.getStats();
+        schedulerResult = schedulerResult && stats.spawned == 50 && stats.finished == 50 && stats.failed == 0 && stats.suspensions == 100;
+        schedulerResult = schedulerResult && root.getFunction<int>("cachedFetch")(&backend) == 7
+            && context.executeBuffer("if (asyncTotal != 2500) throw \"scheduler\";");
+    }
+
+    bool threadPoolResult = true;
+    {
+        sqrew::ScriptThreadPool threads(context, 1);
+        context.executeBuffer("function square(x) { return x * x; } \n function pause(x) { ::suspend(x); }");
+
+        auto callOn = [](HSQUIRRELVM thread, const SQChar* name, SQInteger argument) -> SQInteger
+        {
+            sq_pushroottable(thread);
+            sq_pushstring(thread, name, -1);
+            sq_get(thread, -2);
+            sq_pushroottable(thread);
+            sq_pushinteger(thread, argument);
+
+            SQInteger value = -1;
+            if (SQ_SUCCEEDED( sq_call(thread, 2, SQTrue, SQTrue) ))
+                sq_getinteger(thread, -1, &value);
+            return value;
+        };
+
+        HSQOBJECT handle;
+        auto first = threads.acquire(handle);
+        threadPoolResult = callOn(first, "square", 7) == 49;
+        threads.release(handle);
+
+        auto second = threads.acquire(handle);
+        threadPoolResult = threadPoolResult && second == first && sq_gettop(second) == 0 && callOn(second, "square", 3) == 9;
+        threads.release(handle);
+
+        threads.acquire(handle);
+        callOn(handle._unVal.pThread, "pause", 0);
+        threads.release(handle);
+
+        const auto stats = threads.getStats();
+        threadPoolResult = threadPoolResult && stats.created == 1 && stats.reused == 3 && stats.discarded == 1 && threads.getIdleCount() == 0;
+    }
+
+    bool blobViewResult = true;
+    {
+        sqrew::Class<Packets>::expose(context, "Packets")
+            .setMethod("checksum", &Packets::checksum)
+            .setMethod("invert", &Packets::invert);
+
+        context.executeBuffer(
+            "function inspect(packets, view) {\n"
+            "    local sum = packets.checksum(view);\n"
+            "    local first = view.readn('b');\n"
+            "    view[1] = 200;\n"
+            "    packets.invert(view);\n"
+            "    return sum + first;\n"
+            "}\n"
+            "function isWritable(view) {\n"
+            "    try { view[0] = 1; } catch (e) { return false; }\n"
+            "    return true;\n"
+            "}\n"
+            "function keep(view) { kept <- view; return view.len(); }\n");
+
+        Packets packets;
+        auto root = sqrew::Table::getRoot(context);
+
+        std::vector<unsigned char> bytes = { 1, 2, 3, 4 };
+        blobViewResult = root.getFunction<int>("inspect")(&packets, sqrew::makeSpan(bytes)) == 11
+            && bytes == std::vector<unsigned char>({ 254, 55, 252, 251 });
+
+        const std::vector<unsigned char>& constant = bytes;
+        blobViewResult = blobViewResult
+            && !root.getFunction<bool>("isWritable")(sqrew::makeSpan(constant))
+            && root.getFunction<bool>("isWritable")(sqrew::makeSpan(bytes)) && bytes[0] == 1;
+
+        bool released = false;
+        auto owned = new unsigned char[16]();
+        blobViewResult = blobViewResult
+            && root.getFunction<int>("keep")(sqrew::BlobView(owned, 16, [&]() { released = true; delete[] owned; })) == 16
+            && !released;
+
+        context.executeBuffer("kept <- null;");
+        blobViewResult = blobViewResult && released;
+    }
+
+    bool bulkResult = true;
+    {
+        context.executeBuffer(
+            "function checkBulk() {\n"
+            "    local b = blob(200);\n"
+            "    for (local i = 0; i < 200; i++) b[i] = (i * 37 + 11) & 0xFF;\n"
+            "    local sum = 0, lo = 255, hi = 0;\n"
+            "    foreach (x in b) { sum += x; if (x < lo) lo = x; if (x > hi) hi = x; }\n"
+            "    local ok = b.sum() == sum && b.min() == lo && b.max() == hi && b.sum(1, 3) == b[1] + b[2];\n"
+            "    local digits = blob();\n"
+            "    foreach (c in \"123456789\") digits.writen(c, 'b');\n"
+            "    ok = ok && digits.crc32() == 0xCBF43926 && digits.crc32(0, 0) == 0;\n"
+            "    local large = blob(4099);\n"
+            "    for (local i = 0; i < 4099; i++) large[i] = (i * 131 + (i >> 7)) & 0xFF;\n"
+            "    ok = ok && large.crc32() == 0xF10838AE && large.crc32(3, 4000) == 0x10B69C2C && large.crc32(5, 70) == 0x85A3068C;\n"
+            "    local text = blob();\n"
+            "    foreach (c in \"hello world\") text.writen(c, 'b');\n"
+            "    ok = ok && text.find(\"world\") == 6 && text.find('o', 5) == 7 && text.find(\"xyz\") == null;\n"
+            "    b.fill(0, 0, 10);\n"
+            "    b.copy(0, text, 6);\n"
+            "    ok = ok && b.sum(0, 10) == text.sum(6) && b.find(text) == null;\n"
+            "    local words = blob(5);\n"
+            "    for (local i = 0; i < 5; i++) words[i] = i + 1;\n"
+            "    words.swap2();\n"
+            "    ok = ok && words[0] == 2 && words[1] == 1 && words[3] == 3 && words[4] == 5;\n"
+            "    local a = [1, 2, 3];\n"
+            "    ok = ok && a.sum() == 6 && [1, 2.5].sum() == 3.5 && a.min() == 1 && a.max() == 3 && [].min() == null;\n"
+            "    a.add(1).mul([2, 2, 0.5]).sub(1);\n"
+            "    ok = ok && a[0] == 3 && a[1] == 5 && a[2] == 1.0;\n"
+            "    a.fill(7, 1);\n"
+            "    try { [1, \"x\"].sum(); return false; } catch (e) {}\n"
+            "    return ok && a[0] == 3 && a[1] == 7 && a[2] == 7;\n"
+            "}\n");
+
+        bulkResult = sqrew::Table::getRoot(context).getFunction<bool>("checkBulk")();
+    }
+
+    bool typedArrayResult = true;
+    {
+        sqrew::Class<Samples>::expose(context, "Samples")
+            .setMethod("mean", &Samples::mean)
+            .setMethod("scale", &Samples::scale);
+
+        context.executeBuffer(
+            "function checkTyped(samples) {\n"
+            "    local f = float32array(4);\n"
+            "    for (local i = 0; i < 4; i++) f[i] = i + 0.5;\n"
+            "    local sum = 0.0;\n"
+            "    foreach (i, x in f) sum += x;\n"
+            "    local ok = typeof f == \"typedarray\" && f.len() == 4 && f.elementtype() == \"float32\"\n"
+            "        && sum == 8.0 && f.sum() == 8.0 && samples.mean(f) == 2.0;\n"
+            "    local d = float64array([1, 2, 3]);\n"
+            "    samples.scale(d, 2.0);\n"
+            "    ok = ok && d[2] == 6.0 && d.max() == 6.0 && d.min() == 2.0;\n"
+            "    local n = int32array(3, 7);\n"
+            "    n[0] = 0x100000001;\n"
+            "    n.add(int32array([1, 1, 1])).mul(2);\n"
+            "    ok = ok && n[0] == 4 && n[1] == 16 && n.toarray().len() == 3;\n"
+            "    local c = clone n;\n"
+            "    c[0] = 0;\n"
+            "    ok = ok && n[0] == 4;\n"
+            "    try { n[0] = \"x\"; return false; } catch (e) {}\n"
+            "    try { n[3]; return false; } catch (e) {}\n"
+            "    try { samples.mean(d); return false; } catch (e) {}\n"
+            "    try { float64array(0x2000000000000001); return false; } catch (e) {}\n"
+            "    local h = float32array([1, 2, 3]);\n"
+            "    try { h.add([1, \"x\", 2]); return false; } catch (e) {}\n"
+            "    ok = ok && h[0] == 1.0 && h[2] == 3.0;\n"
+            "    return ok;\n"
+            "}\n"
+            "function describe(values) { return values.len() + values[0]; }\n");
+
+        Samples samples;
+        auto root = sqrew::Table::getRoot(context);
+        std::vector<double> values = { 5, 1 };
+
+        typedArrayResult = root.getFunction<bool>("checkTyped")(&samples)
+            && root.getFunction<float>("describe")(sqrew::makeSpan(values)) == 7.0f;
+    }
+
+    bool optimizerResult = true;
+    {
+        const char* script =
+            "class Counter { n = 0; function add(a, b) { n += a * b; return n; } }\n"
+            "function gen(n) { for (local i = 0; i < n; i++) yield i * i; return null; }\n"
+            "function digest() {\n"
+            "    local out = [];\n"
+            "    out.append(2 + 3 * 4); out.append(0x7FFFFFFF + 1); out.append(\"a\" + \"b\");\n"
+            "    out.append(-16 >> 2); out.append(~5); out.append(7.0 / 2); out.append(!0); out.append(1 == 1.0);\n"
+            "    try { local q = 1 / 0; out.append(q); } catch (e) { out.append(e); }\n"
+            "    if (0) out.append(\"never\"); else out.append(\"else\");\n"
+            "    local s = 0;\n"
+            "    for (local i = 0; i < 100; ++i) { if (i % 7 == 0) continue; s += i; }\n"
+            "    for (local f = 0.5; f < 2; f += 0.5) s += f;\n"
+            "    out.append(s);\n"
+            "    local c = Counter();\n"
+            "    c.add(2, 3); c.add(c.n, 2);\n"
+            "    out.append(c.add(1, 1));\n"
+            "    local total = 0;\n"
+            "    local bump = function(d) { total += d; };\n"
+            "    bump(5); bump(6);\n"
+            "    out.append(total);\n"
+            "    foreach (v in gen(4)) out.append(v);\n"
+            "    foreach (i, v in [7, 8]) out.append(i + v);\n"
+            "    local result = \"\";\n"
+            "    foreach (v in out) result += v + \",\";\n"
+            "    return result;\n"
+            "}\n";
+
+        // The member lookup may run a _get metamethod that changes the
+        // arguments, so their loads must stay after it.
+        const char* lookupScript =
+            "local counter = 0;\n"
+            "local counting = {}.setdelegate({ function _get(k) { counter++; return function(x) { return x; }; } });\n"
+            "function probeOuter() { local r = counting.m(counter); return r; }\n"
+            "function probeCaptured() {\n"
+            "    local n = 0;\n"
+            "    local set = function() { n = 100; };\n"
+            "    local setting = {}.setdelegate({ function _get(k) { set(); return function(x) { return x; }; } });\n"
+            "    local r = setting.m(n);\n"
+            "    return r;\n"
+            "}\n";
+
+        auto cache = std::make_shared<sqrew::BytecodeCache>();
+        std::string digests[3];
+        const sqrew::OptimizationLevel levels[3] = {
+            sqrew::OptimizationLevel::None, sqrew::OptimizationLevel::Basic, sqrew::OptimizationLevel::Full };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            sqrew::Context optimized;
+            optimized.initialize();
+            optimized.setBytecodeCache(cache);
+            optimized.setOptimizationLevel(levels[i]);
+            optimizerResult = optimizerResult && optimized.getOptimizationLevel() == levels[i]
+                && optimized.executeBuffer(script, "optimizer");
+            digests[i] = sqrew::Table::getRoot(optimized).getFunction<std::string>("digest")();
+
+            optimizerResult = optimizerResult && optimized.executeBuffer(lookupScript, "lookup")
+                && sqrew::Table::getRoot(optimized).getFunction<int>("probeOuter")() == 1
+                && sqrew::Table::getRoot(optimized).getFunction<int>("probeCaptured")() == 100;
+        }
+
+        optimizerResult = optimizerResult && !digests[0].empty() && digests[0] == digests[1] && digests[0] == digests[2]
+            && cache->getStats().misses == 6;
+    }
+
+    bool quickeningResult = true;
+    {
+        context.executeBuffer(
+            "function mix(a, b) { return a * b - a + b; }\n"
+            "function add(a, b) { return a + b; }\n"
+            "function count(from, to) { local n = 0; for (local i = from; i < to; i += 1) n++; return n; }\n"
+            "function above(a, b) { if (a > b) return true; return false; }\n"
+            "function checkQuickening() {\n"
+            "    local ok = true;\n"
+            "    for (local i = 0; i < 20; i++) {\n"
+            "        ok = ok && mix(i, 2) == i + 2 && mix(0.5, 2.0) == 2.5 && mix(2, 0.5) == -0.5;\n"
+            "        ok = ok && add(i, 1) == i + 1 && add(0.25, 0.5) == 0.75 && add(\"a\", i) == \"a\" + i;\n"
+            "        ok = ok && count(0, 10) == 10 && count(0.5, 3.0) == 3 && count(0, 2.5) == 3;\n"
+            "        ok = ok && above(3, 2) && !above(2.0, 3.0) && above(0.0, -0.0) == (0.0 > -0.0) && above(2.5, 2);\n"
+            "    }\n"
+            "    try { add(null, 1); return false; } catch (e) {}\n"
+            "    return ok;\n"
+            "}\n");
+
+        // Saved bytecode must not depend on what the sites were quickened to.
+        auto v = context.getHandle();
+        std::vector<char> before, after;
+        sq_pushroottable(v);
+        sq_pushstring(v, "mix", -1);
+        sq_get(v, -2);
+        sq_writeclosure(v, appendBytes, &before);
+
+        quickeningResult = sqrew::Table::getRoot(context).getFunction<bool>("checkQuickening")();
+
+        sq_writeclosure(v, appendBytes, &after);
+        sq_pop(v, 2);
+
+        quickeningResult = quickeningResult && !before.empty() && before == after;
+    }
+
+    bool lexerResult = true;
+    {
+        const std::string script =
+            "\xEF\xBB\xBF// a byte order mark, then comments of each kind\n"
+            "# hash comment\n"
+            "/* block\n   comment ** / */ lexedName <- \"tab\\tquote\\\"hex\\x41\";\n"
+            "lexedVerbatim <- @\"two\n\"\"lines\"\"\";   \t\r\n"
+            "function lexedLine() { return getstackinfos(1).line; }\n"
+            "lexedChar <- 'x' + 0x10 + 1.5e1;";
+
+        {
+            std::ofstream file("lexer.nut", std::ios::binary);
+            file << script;
+        }
+
+        {
+            std::ofstream empty("lexer_empty.nut", std::ios::binary);
+        }
+
+        lexerResult = context.executeFile("lexer.nut") && context.executeFile("lexer_empty.nut")
+            && !context.executeFile("lexer_missing.nut");
+
+        // sqstd_loadfile reads the whole file into a buffer of its exact size.
+        auto v = context.getHandle();
+        for (auto name: { "lexer.nut", "lexer_empty.nut" })
+        {
+            const bool loaded = SQ_SUCCEEDED( sqstd_loadfile(v, name, SQTrue) );
+            if (loaded)
+                sq_pop(v, 1);
+            lexerResult = lexerResult && loaded;
+        }
+
+        std::remove("lexer.nut");
+        std::remove("lexer_empty.nut");
+
+        lexerResult = lexerResult && context.executeBuffer(
+            "if (lexedName != \"tab\\tquote\\\"hexA\") throw \"name\";\n"
+            "if (lexedVerbatim != \"two\\n\\\"lines\\\"\") throw \"verbatim\";\n"
+            "if (lexedLine() != 7 || lexedChar != 'x' + 31.0) throw \"line\";");
+
+        // The in-place lexer has to produce the same closure as the
+        // character-at-a-time one, line info included.
+        const std::string source = script.substr(3);
+        SourceReader reader = { source.data(), source.size(), 0 };
+        std::vector<char> buffered, streamed;
+
+        sq_enabledebuginfo(v, SQTrue);
+        if (SQ_SUCCEEDED( sq_compilebuffer(v, source.data(), source.size(), "lexer", SQTrue) ))
+        {
+            sq_writeclosure(v, appendBytes, &buffered);
+            sq_pop(v, 1);
+        }
+        if (SQ_SUCCEEDED( sq_compile(v, readSourceChar, &reader, "lexer", SQTrue) ))
+        {
+            sq_writeclosure(v, appendBytes, &streamed);
+            sq_pop(v, 1);
+        }
+        sq_enabledebuginfo(v, SQFalse);
+
+        lexerResult = lexerResult && !buffered.empty() && buffered == streamed;
+    }
+
+    bool loaderResult = true;
+    {
+        const char* const names[] = { "loader_a.nut", "loader_b.nut", "loader_c.nut", "loader_empty.nut" };
+        const char* const scripts[] = {
+            "loadedA <- 20;",
+            "loadedB <- loadedA * 2 + 2; // runs after loader_a.nut",
+            "loadedC <- ;",
+            "" };
+
+        for (int i = 0; i < 4; ++i)
+        {
+            std::ofstream file(names[i], std::ios::binary);
+            file << scripts[i];
+        }
+
+        sqrew::ScriptLoader loader(2);
+        auto results = loader.compile({ names[0], names[3], names[1], names[2], "loader_missing.nut" });
+
+        loaderResult = results.size() == 5 && results[0].program && results[1].program && results[2].program
+            && !results[3].program && results[3].error.find("loader_c.nut:1") != std::string::npos
+            && !results[4].program && !results[4].error.empty();
+
+        results.resize(3);
+        loaderResult = loaderResult && loader.execute(context, results)
+            && !loader.load(context, { names[0], names[2] })
+            && context.executeBuffer("if (loadedB != 42) throw \"order\";");
+
+        for (auto name: names)
+            std::remove(name);
+    }
+
+    bool moduleResult = true;
+    {
+        const char* const names[] = { "module_math.nut", "module_user.nut", "module_broken.nut", "module_throws.nut", "module_empty.nut" };
+        const char* const scripts[] = {
+            "::moduleLoads <- (\"moduleLoads\" in getroottable() ? ::moduleLoads : 0) + 1;\n"
+            "value <- 40;\n"
+            "function twice(x) { return x * 2; }",
+            "local math = require(\"module_math\");\n"
+            "total <- math.twice(math.value) + 2;\n"
+            "cyclic <- require(\"module_user\") == this;",
+            "broken <- ;",
+            "throw \"thrown\";",
+            "" };
+
+        for (int i = 0; i < 5; ++i)
+        {
+            std::ofstream file(names[i], std::ios::binary);
+            file << scripts[i];
+        }
+
+        context.setModulePaths({ "module_nowhere", "." });
+        moduleResult = context.require("module_user").contains("total")
+            && !context.require("module_missing").isValid()
+            && context.require("module_empty").isValid()
+            && context.executeBuffer(
+                "local user = require(\"module_user\");\n"
+                "if (user.total != 82 || !user.cyclic || moduleLoads != 1) throw \"modules\";\n"
+                "if (require(\"module_math\") != require(\"module_math\")) throw \"cache\";\n"
+                "if (\"value\" in getroottable()) throw \"leak\";\n"
+                "local fromThread = newthread(function() { return require(\"module_math\"); }).call();\n"
+                "if (fromThread != require(\"module_math\")) throw \"thread\";\n"
+                "foreach (name in [\"module_broken\", \"module_broken\", \"module_missing\"]) {\n"
+                "    local failed = false;\n"
+                "    try { require(name); } catch (e) { failed = true; }\n"
+                "    if (!failed) throw name;\n"
+                "}");
+
+        // Modules compiled in one context are found in the bytecode cache
+        // by the next.
+        auto cache = std::make_shared<sqrew::BytecodeCache>();
+        for (int i = 0; i < 2; ++i)
+        {
+            sqrew::Context modular;
+            modular.initialize();
+            modular.setBytecodeCache(cache);
+            modular.setModulePaths({ "." });
+            moduleResult = moduleResult && modular.require("module_math").contains("twice");
+        }
+        moduleResult = moduleResult && cache->getStats().misses == 1 && cache->getStats().memoryHits == 1;
+
+        // A module failing at run time is reported once, by require.
+        int messages = 0;
+        sqrew::Context reporting;
+        reporting.initialize();
+        reporting.setInterface<MessageCounter>(messages);
+        reporting.setModulePaths({ "." });
+        moduleResult = moduleResult && !reporting.require("module_throws").isValid() && messages == 1;
+
+        for (auto name: names)
+            std::remove(name);
+    }
+
+    bool stringTableResult = true;
+    {
+        // Interning must not depend on the seed, only the hashes do.
+        SQHash seededHashes[2];
+        const SQUnsignedInteger seeds[] = { 0, static_cast<SQUnsignedInteger>(0x9E3779B97F4A7C15ULL) };
+        for (int i = 0; i < 2; ++i)
+        {
+            sq_sethashseed(seeds[i]);
+            sqrew::Context seeded;
+            seeded.initialize();
+            auto v = seeded.getHandle();
+
+            const SQChar* first = nullptr;
+            const SQChar* second = nullptr;
+            sq_pushstring(v, "interned key", -1);
+            sq_pushstring(v, "interned key", -1);
+            sq_getstring(v, -2, &first);
+            sq_getstring(v, -1, &second);
+            seededHashes[i] = sq_gethash(v, -1);
+            sq_pop(v, 2);
+
+            stringTableResult = stringTableResult && first == second && seeded.executeBuffer(
+                "local t = {}; \n"
+                "for (local i = 0; i < 500; ++i) t[\"key\" + i] <- i; \n"
+                "local sum = 0; \n"
+                "for (local i = 0; i < 500; ++i) sum += t[\"ke\" + \"y\" + i]; \n"
+                "if (sum != 124750 || t.len() != 500 || !(\"key499\" in t)) throw \"interning\";");
+        }
+        sq_sethashseed(0);
+        stringTableResult = stringTableResult && seededHashes[0] != seededHashes[1];
+
+        // The table grows as soon as it holds more strings than the load factor allows.
+        SQStringTableStats loose, tight;
+        for (auto factor: { 4.0f, 0.5f })
+        {
+            sqrew::Context loaded;
+            loaded.initialize();
+            auto v = loaded.getHandle();
+
+            sq_setstringtableloadfactor(v, factor);
+            SQStringTableStats before;
+            sq_getstringtablestats(v, &before);
+
+            sq_newarray(v, 0);
+            for (int i = 0; i < 4000; ++i)
+            {
+                const std::string text = "grown" + std::to_string(i);
+                sq_pushstring(v, text.c_str(), static_cast<SQInteger>(text.size()));
+                sq_arrayappend(v, -2);
+            }
+
+            SQStringTableStats& stats = factor > 1 ? loose : tight;
+            sq_getstringtablestats(v, &stats);
+            sq_pop(v, 1);
+
+            stringTableResult = stringTableResult && stats.strings >= before.strings + 4000 && stats.slots > before.slots
+                && stats.strings <= stats.slots * factor && stats.used_slots <= stats.slots;
+        }
+        stringTableResult = stringTableResult && tight.slots > loose.slots && tight.longest_chain <= loose.longest_chain;
+
+        // Long strings that only differ near the end must not collide.
+        auto v = context.getHandle();
+        for (size_t length: { 17, 48, 49, 96, 100, 1000 })
+        {
+            std::vector<SQHash> hashes;
+            for (size_t position: { length - 1, length - 9, length - 17 })
+            {
+                for (char c = 'a'; c <= 'z'; ++c)
+                {
+                    std::string text(length, '-');
+                    text[position] = c;
+                    sq_pushstring(v, text.c_str(), static_cast<SQInteger>(text.size()));
+                    hashes.push_back(sq_gethash(v, -1));
+                    sq_pop(v, 1);
+                }
+            }
+            std::sort(hashes.begin(), hashes.end());
+            stringTableResult = stringTableResult && std::unique(hashes.begin(), hashes.end()) == hashes.end();
+        }
+    }
+
+    if (!result || !marshalResult || !functionResult || !instanceResult || !cacheResult || !bytecodeResult || !poolResult || !inlineCacheResult
+        || !sortResult || !tableResult || !collectorResult || !contextPoolResult || !schedulerResult
+        || !threadPoolResult || !blobViewResult || !bulkResult || !typedArrayResult || !optimizerResult || !quickeningResult
+        || !lexerResult || !loaderResult || !moduleResult || !stringTableResult)
+        return 1;
+
     int kp = 90;
     int nno = kp + 87;
     return 0;